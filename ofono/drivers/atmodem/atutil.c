@@ -33,6 +33,7 @@
 #define OFONO_API_SUBJECT_TO_CHANGE
 #include <ofono/log.h>
 #include <ofono/types.h>
+#include <ofono/trace.h>
 
 #include "atutil.h"
 #include "vendor.h"
@@ -698,3 +699,19 @@ char *at_util_get_cgdcont_command(guint cid, enum ofono_gprs_proto proto,
 	return g_strdup_printf("AT+CGDCONT=%u,\"%s\",\"%s\"", cid, pdp_type,
 									apn);
 }
+
+/*
+ * GAtTraceFunc callbacks for g_at_chat_set_trace and g_at_mux_set_trace,
+ * user_data is the struct ofono_modem the traffic belongs to.
+ */
+void at_util_trace_chat(gboolean in, const unsigned char *data, gsize size,
+							gpointer user_data)
+{
+	ofono_modem_trace(user_data, OFONO_TRACE_PROTO_AT, in, data, size);
+}
+
+void at_util_trace_mux(gboolean in, const unsigned char *data, gsize size,
+							gpointer user_data)
+{
+	ofono_modem_trace(user_data, OFONO_TRACE_PROTO_MUX, in, data, size);
+}
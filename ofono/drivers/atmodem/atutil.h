@@ -103,6 +103,11 @@ const char *at_util_gprs_proto_to_pdp_type(enum ofono_gprs_proto proto);
 char *at_util_get_cgdcont_command(guint cid, enum ofono_gprs_proto proto,
 							const char *apn);
 
+void at_util_trace_chat(gboolean in, const unsigned char *data, gsize size,
+							gpointer user_data);
+void at_util_trace_mux(gboolean in, const unsigned char *data, gsize size,
+							gpointer user_data);
+
 struct cb_data {
 	gint ref_count;
 	void *cb;
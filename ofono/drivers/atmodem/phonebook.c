@@ -43,6 +43,12 @@
 
 #define INDEX_INVALID -1
 
+/* Number of entries requested with one AT+CPBR */
+#define READ_CHUNK 50
+
+/* 27.007 "not found", what some modems say about an empty range */
+#define CME_ERROR_NOT_FOUND 22
+
 #define CHARSET_UTF8 1
 #define CHARSET_UCS2 2
 #define CHARSET_IRA  4
@@ -55,6 +61,8 @@ static const char *cpbs_prefix[] = { "+CPBS:", NULL };
 
 struct pb_data {
 	int index_min, index_max;
+	int index_next;			/* First entry of the next chunk */
+	struct ofono_error read_error;	/* Last chunk that failed */
 	char *old_charset;
 	int supported;
 	GAtChat *chat;
@@ -212,6 +220,8 @@ static void export_failed(struct cb_data *cbd)
 	}
 }
 
+static void at_read_entries(struct cb_data *cbd);
+
 static void at_read_entries_cb(gboolean ok, GAtResult *result,
 						gpointer user_data)
 {
@@ -220,11 +230,29 @@ static void at_read_entries_cb(gboolean ok, GAtResult *result,
 	struct pb_data *pbd = ofono_phonebook_get_data(pb);
 	ofono_phonebook_cb_t cb = cbd->cb;
 	const char *charset;
-	struct ofono_error error;
 	char buf[32];
 
-	decode_at_error(&error, g_at_result_final_response(result));
-	cb(&error, cbd->data);
+	/*
+	 * Some modems fail the read with "not found" if there are no
+	 * entries in the range. Anything else means that the phonebook
+	 * is incomplete, keep reading but report the error at the end.
+	 */
+	if (!ok) {
+		struct ofono_error error;
+
+		decode_at_error(&error, g_at_result_final_response(result));
+
+		if (error.type != OFONO_ERROR_TYPE_CME ||
+				error.error != CME_ERROR_NOT_FOUND)
+			pbd->read_error = error;
+	}
+
+	if (pbd->index_next <= pbd->index_max) {
+		at_read_entries(cbd);
+		return;
+	}
+
+	cb(&pbd->read_error, cbd->data);
 	g_free(cbd);
 
 	charset = best_charset(pbd->supported);
@@ -242,10 +270,20 @@ static void at_read_entries(struct cb_data *cbd)
 {
 	struct ofono_phonebook *pb = cbd->user;
 	struct pb_data *pbd = ofono_phonebook_get_data(pb);
+	int last = pbd->index_next + READ_CHUNK - 1;
 	char buf[32];
 
-	snprintf(buf, sizeof(buf), "AT+CPBR=%d,%d",
-			pbd->index_min, pbd->index_max);
+	/*
+	 * Reading the whole phonebook with a single command keeps the
+	 * channel busy for as long as it takes, so go in chunks and let
+	 * other commands through in between.
+	 */
+	if (last > pbd->index_max)
+		last = pbd->index_max;
+
+	snprintf(buf, sizeof(buf), "AT+CPBR=%d,%d", pbd->index_next, last);
+	pbd->index_next = last + 1;
+
 	if (g_at_chat_send_listing(pbd->chat, buf, cpbr_prefix,
 					at_cpbr_notify, at_read_entries_cb,
 					cbd, NULL) > 0)
@@ -336,6 +374,10 @@ static void at_list_indices_cb(gboolean ok, GAtResult *result,
 	if (!g_at_result_iter_close_list(&iter))
 		goto error;
 
+	pbd->index_next = pbd->index_min;
+	pbd->read_error.type = OFONO_ERROR_TYPE_NO_ERROR;
+	pbd->read_error.error = 0;
+
 	if (g_at_chat_send(pbd->chat, "AT+CSCS?", cscs_prefix,
 				at_read_charset_cb, cbd, NULL) > 0)
 		return;
@@ -58,6 +58,9 @@ static void at_cmgl_set_cpms(struct ofono_sms *sms, int store);
 #define MAX_CMGF_RETRIES 10
 #define MAX_CPMS_RETRIES 10
 
+/* Read stored messages with a single listing if at least this many */
+#define SMS_BATCH_MIN 2
+
 static const char *storages[] = {
 	"SM",
 	"ME",
@@ -77,6 +80,13 @@ struct sms_data {
 	guint timeout_source;
 	GAtChat *chat;
 	unsigned int vendor;
+	GArray *pending;	/* struct sms_index, announced by CMTI/CDSI */
+	guint flush_source;
+	GArray *batch;		/* Indexes being read by one AT+CMGL */
+	GArray *batch_read;	/* Indexes the listing has delivered */
+	int batch_store;
+	GArray *cmgl_read;	/* Indexes delivered by the initial AT+CMGL */
+	gboolean cmgl_partial;	/* Initial AT+CMGL left read messages */
 };
 
 struct cpms_request {
@@ -86,6 +96,17 @@ struct cpms_request {
 	gboolean expect_sr;
 };
 
+struct sms_index {
+	int store;
+	int index;
+	gboolean expect_sr;
+};
+
+struct cmgd_request {
+	struct ofono_sms *sms;
+	GArray *indexes;
+};
+
 static void at_csca_set_cb(gboolean ok, GAtResult *result, gpointer user_data)
 {
 	struct cb_data *cbd = user_data;
@@ -524,6 +545,89 @@ static void at_cmgd_cb(gboolean ok, GAtResult *result, gpointer user_data)
 		ofono_error("Unable to delete received SMS");
 }
 
+static void at_cmgd_each(struct ofono_sms *sms, GArray *indexes)
+{
+	struct sms_data *data = ofono_sms_get_data(sms);
+	char buf[32];
+	guint i;
+
+	for (i = 0; i < indexes->len; i++) {
+		snprintf(buf, sizeof(buf), "AT+CMGD=%d",
+				g_array_index(indexes, int, i));
+		g_at_chat_send(data->chat, buf, none_prefix,
+				at_cmgd_cb, NULL, NULL);
+	}
+}
+
+static void cmgd_request_free(gpointer user_data)
+{
+	struct cmgd_request *req = user_data;
+
+	g_array_free(req->indexes, TRUE);
+	g_free(req);
+}
+
+static void at_cmgd_read_cb(gboolean ok, GAtResult *result,
+				gpointer user_data)
+{
+	struct cmgd_request *req = user_data;
+
+	if (ok)
+		return;
+
+	DBG("Deleting %u messages one by one", req->indexes->len);
+	at_cmgd_each(req->sms, req->indexes);
+}
+
+/*
+ * Deletes messages which have been read and handed over to the core,
+ * which stores them before ofono_sms_deliver_notify returns. Delete
+ * flag 1 removes all read messages at once, leaving unread and MO
+ * messages alone, so it's only used if all_read says that the indexes
+ * are known to be all the read messages in the store. Otherwise, and
+ * on modems that don't support the flag, each message is deleted with
+ * its own AT+CMGD. Takes ownership of the array.
+ */
+static void at_cmgd_read(struct ofono_sms *sms, GArray *indexes,
+				gboolean all_read)
+{
+	struct sms_data *data = ofono_sms_get_data(sms);
+	struct cmgd_request *req;
+	char buf[32];
+
+	if (!all_read || indexes->len < 2) {
+		at_cmgd_each(sms, indexes);
+		g_array_free(indexes, TRUE);
+		return;
+	}
+
+	req = g_new0(struct cmgd_request, 1);
+	req->sms = sms;
+	req->indexes = indexes;
+
+	snprintf(buf, sizeof(buf), "AT+CMGD=%d,1",
+			g_array_index(indexes, int, 0));
+
+	if (g_at_chat_send(data->chat, buf, none_prefix, at_cmgd_read_cb,
+				req, cmgd_request_free) == 0)
+		cmgd_request_free(req);
+}
+
+static gboolean at_cmgl_entry(GAtResultIter *iter, int *index, int *status,
+				int *tpdu_len)
+{
+	if (!g_at_result_iter_next_number(iter, index))
+		return FALSE;
+
+	if (!g_at_result_iter_next_number(iter, status))
+		return FALSE;
+
+	if (!g_at_result_iter_skip_next(iter))
+		return FALSE;
+
+	return g_at_result_iter_next_number(iter, tpdu_len);
+}
+
 static void at_cmgr_cpms_cb(gboolean ok, GAtResult *result, gpointer user_data)
 {
 	struct cpms_request *req = user_data;
@@ -579,6 +683,217 @@ static void at_send_cmgr_cpms(struct ofono_sms *sms, int store, int index,
 	}
 }
 
+static gboolean at_sms_index_listed(GArray *indexes, int index)
+{
+	guint i;
+
+	for (i = 0; i < indexes->len; i++)
+		if (g_array_index(indexes, int, i) == index)
+			return TRUE;
+
+	return FALSE;
+}
+
+static void at_sms_flush_pending(struct ofono_sms *sms);
+
+static void at_sms_batch_done(struct ofono_sms *sms)
+{
+	struct sms_data *data = ofono_sms_get_data(sms);
+	GArray *batch = data->batch;
+	GArray *read = data->batch_read;
+	guint i;
+
+	DBG("%u of %u messages listed", read->len, batch->len);
+
+	data->batch = NULL;
+	data->batch_read = NULL;
+
+	/* Whatever the listing missed is read the usual way */
+	for (i = 0; i < batch->len; i++) {
+		int index = g_array_index(batch, int, i);
+
+		if (!at_sms_index_listed(read, index))
+			at_send_cmgr_cpms(sms, data->batch_store, index, FALSE);
+	}
+
+	g_array_free(batch, TRUE);
+
+	/*
+	 * AT+CMGL=0 doesn't tell which messages had been read before,
+	 * so only the ones just delivered can be deleted.
+	 */
+	at_cmgd_read(sms, read, FALSE);
+	at_sms_flush_pending(sms);
+}
+
+static void at_sms_batch_notify(GAtResult *result, gpointer user_data)
+{
+	struct ofono_sms *sms = user_data;
+	struct sms_data *data = ofono_sms_get_data(sms);
+	GAtResultIter iter;
+	const char *hexpdu;
+	unsigned char pdu[176];
+	long pdu_len;
+	int tpdu_len;
+	int index;
+	int status;
+
+	g_at_result_iter_init(&iter, result);
+
+	while (g_at_result_iter_next(&iter, "+CMGL:")) {
+		if (!at_cmgl_entry(&iter, &index, &status, &tpdu_len)) {
+			ofono_error("Unable to parse CMGL response");
+			return;
+		}
+
+		if (status != 0 && status != 1)
+			continue;
+
+		/* Leave the others to their own CMTI */
+		if (!at_sms_index_listed(data->batch, index))
+			continue;
+
+		hexpdu = g_at_result_pdu(result);
+
+		if (strlen(hexpdu) > sizeof(pdu) * 2)
+			continue;
+
+		DBG("Got PDU at index %d, with len: %d", index, tpdu_len);
+
+		decode_hex_own_buf(hexpdu, -1, &pdu_len, 0, pdu);
+		ofono_sms_deliver_notify(sms, pdu, pdu_len, tpdu_len);
+		g_array_append_val(data->batch_read, index);
+	}
+}
+
+static void at_sms_batch_cb(gboolean ok, GAtResult *result,
+				gpointer user_data)
+{
+	struct ofono_sms *sms = user_data;
+
+	if (!ok)
+		DBG("Listing unread messages failed");
+
+	at_sms_batch_done(sms);
+}
+
+static void at_sms_batch_cpms_cb(gboolean ok, GAtResult *result,
+					gpointer user_data)
+{
+	struct ofono_sms *sms = user_data;
+	struct sms_data *data = ofono_sms_get_data(sms);
+
+	if (!ok) {
+		ofono_error("Unable to select %s for reading",
+				storages[data->batch_store]);
+		at_sms_batch_done(sms);
+		return;
+	}
+
+	data->store = data->batch_store;
+
+	g_at_chat_send_pdu_listing(data->chat, "AT+CMGL=0", cmgl_prefix,
+					at_sms_batch_notify, at_sms_batch_cb,
+					sms, NULL);
+}
+
+/*
+ * Moves all pending messages in the given store into a batch and reads
+ * them with one AT+CMGL=0. CPMS is always sent because the single
+ * message path may have changed the storage behind data->store.
+ */
+static void at_sms_batch_start(struct ofono_sms *sms, int store)
+{
+	struct sms_data *data = ofono_sms_get_data(sms);
+	const char *incoming = storages[data->incoming];
+	char buf[128];
+	guint i = 0;
+
+	data->batch = g_array_new(FALSE, FALSE, sizeof(int));
+	data->batch_read = g_array_new(FALSE, FALSE, sizeof(int));
+	data->batch_store = store;
+
+	while (i < data->pending->len) {
+		struct sms_index *si = &g_array_index(data->pending,
+							struct sms_index, i);
+
+		if (si->store == store && !si->expect_sr) {
+			g_array_append_val(data->batch, si->index);
+			g_array_remove_index(data->pending, i);
+		} else {
+			i++;
+		}
+	}
+
+	DBG("Reading %u messages from %s", data->batch->len,
+						storages[store]);
+
+	snprintf(buf, sizeof(buf), "AT+CPMS=\"%s\",\"%s\",\"%s\"",
+			storages[store], storages[store], incoming);
+
+	if (g_at_chat_send(data->chat, buf, cpms_prefix, at_sms_batch_cpms_cb,
+				sms, NULL) == 0)
+		at_sms_batch_cpms_cb(FALSE, NULL, sms);
+}
+
+static void at_sms_flush_pending(struct ofono_sms *sms)
+{
+	struct sms_data *data = ofono_sms_get_data(sms);
+
+	while (data->pending->len && !data->batch) {
+		struct sms_index si = g_array_index(data->pending,
+							struct sms_index, 0);
+		guint count = 0;
+		guint i;
+
+		for (i = 0; i < data->pending->len && !si.expect_sr; i++) {
+			struct sms_index *p = &g_array_index(data->pending,
+							struct sms_index, i);
+
+			if (p->store == si.store && !p->expect_sr)
+				count++;
+		}
+
+		if (count >= SMS_BATCH_MIN) {
+			at_sms_batch_start(sms, si.store);
+			break;
+		}
+
+		g_array_remove_index(data->pending, 0);
+		at_send_cmgr_cpms(sms, si.store, si.index, si.expect_sr);
+	}
+}
+
+static gboolean at_sms_flush_cb(gpointer user_data)
+{
+	struct ofono_sms *sms = user_data;
+	struct sms_data *data = ofono_sms_get_data(sms);
+
+	data->flush_source = 0;
+	at_sms_flush_pending(sms);
+
+	return FALSE;
+}
+
+/*
+ * Indications are collected until the main loop gets idle, an SMSC
+ * flushing its backlog typically sends a whole bunch of them at once.
+ */
+static void at_sms_queue_index(struct ofono_sms *sms, int store, int index,
+				gboolean expect_sr)
+{
+	struct sms_data *data = ofono_sms_get_data(sms);
+	struct sms_index si;
+
+	si.store = store;
+	si.index = index;
+	si.expect_sr = expect_sr;
+	g_array_append_val(data->pending, si);
+
+	if (!data->batch && !data->flush_source)
+		data->flush_source = g_idle_add(at_sms_flush_cb, sms);
+}
+
 static void at_cmti_notify(GAtResult *result, gpointer user_data)
 {
 	struct ofono_sms *sms = user_data;
@@ -593,7 +908,7 @@ static void at_cmti_notify(GAtResult *result, gpointer user_data)
 		goto error;
 
 	DBG("Got a CMTI indication at %s, index: %d", storages[store], index);
-	at_send_cmgr_cpms(sms, store, index, FALSE);
+	at_sms_queue_index(sms, store, index, FALSE);
 	return;
 
 error:
@@ -616,7 +931,7 @@ static void at_cdsi_notify(GAtResult *result, gpointer user_data)
 		goto error;
 
 	DBG("Got a CDSI indication at %s, index: %d", storages[store], index);
-	at_send_cmgr_cpms(sms, store, index, TRUE);
+	at_sms_queue_index(sms, store, index, TRUE);
 	return;
 
 error:
@@ -660,23 +975,13 @@ static void at_cmgl_notify(GAtResult *result, gpointer user_data)
 	int tpdu_len;
 	int index;
 	int status;
-	char buf[16];
 
 	DBG("");
 
 	g_at_result_iter_init(&iter, result);
 
 	while (g_at_result_iter_next(&iter, "+CMGL:")) {
-		if (!g_at_result_iter_next_number(&iter, &index))
-			goto err;
-
-		if (!g_at_result_iter_next_number(&iter, &status))
-			goto err;
-
-		if (!g_at_result_iter_skip_next(&iter))
-			goto err;
-
-		if (!g_at_result_iter_next_number(&iter, &tpdu_len))
+		if (!at_cmgl_entry(&iter, &index, &status, &tpdu_len))
 			goto err;
 
 		/* Only MT messages */
@@ -688,29 +993,49 @@ static void at_cmgl_notify(GAtResult *result, gpointer user_data)
 		DBG("Found an old SMS PDU: %s, with len: %d",
 				hexpdu, tpdu_len);
 
-		if (strlen(hexpdu) > sizeof(pdu) * 2)
+		if (strlen(hexpdu) > sizeof(pdu) * 2) {
+			/* Marked as read, but must not be deleted */
+			data->cmgl_partial = TRUE;
 			continue;
+		}
 
 		decode_hex_own_buf(hexpdu, -1, &pdu_len, 0, pdu);
 		ofono_sms_deliver_notify(sms, pdu, pdu_len, tpdu_len);
 
-		/* We don't buffer SMS on the SIM/ME, send along a CMGD */
-		snprintf(buf, sizeof(buf), "AT+CMGD=%d", index);
-		g_at_chat_send(data->chat, buf, none_prefix,
-				at_cmgd_cb, NULL, NULL);
+		/* We don't buffer SMS on the SIM/ME, delete once listed */
+		if (!data->cmgl_read)
+			data->cmgl_read = g_array_new(FALSE, FALSE,
+								sizeof(int));
+
+		g_array_append_val(data->cmgl_read, index);
 	}
 	return;
 
 err:
+	data->cmgl_partial = TRUE;
 	ofono_error("Unable to parse CMGL response");
 }
 
 static void at_cmgl_cb(gboolean ok, GAtResult *result, gpointer user_data)
 {
 	struct ofono_sms *sms = user_data;
+	struct sms_data *data = ofono_sms_get_data(sms);
 
-	if (!ok)
+	if (!ok) {
 		DBG("Initial listing SMS storage failed!");
+		data->cmgl_partial = TRUE;
+	}
+
+	/*
+	 * AT+CMGL=4 has listed and marked as read all MT messages. If
+	 * all of them were delivered, nothing else in the store is read.
+	 */
+	if (data->cmgl_read) {
+		at_cmgd_read(sms, data->cmgl_read, !data->cmgl_partial);
+		data->cmgl_read = NULL;
+	}
+
+	data->cmgl_partial = FALSE;
 
 	at_cmgl_done(sms);
 }
@@ -1305,6 +1630,7 @@ static int at_sms_probe(struct ofono_sms *sms, unsigned int vendor,
 	data = g_new0(struct sms_data, 1);
 	data->chat = g_at_chat_clone(chat);
 	data->vendor = vendor;
+	data->pending = g_array_new(FALSE, FALSE, sizeof(struct sms_index));
 
 	ofono_sms_set_data(sms, data);
 
@@ -1323,7 +1649,21 @@ static void at_sms_remove(struct ofono_sms *sms)
 	if (data->timeout_source > 0)
 		g_source_remove(data->timeout_source);
 
+	if (data->flush_source > 0)
+		g_source_remove(data->flush_source);
+
 	g_at_chat_unref(data->chat);
+
+	g_array_free(data->pending, TRUE);
+
+	if (data->batch) {
+		g_array_free(data->batch, TRUE);
+		g_array_free(data->batch_read, TRUE);
+	}
+
+	if (data->cmgl_read)
+		g_array_free(data->cmgl_read, TRUE);
+
 	g_free(data);
 
 	ofono_sms_set_data(sms, NULL);
@@ -32,6 +32,8 @@
 #include "mbim-private.h"
 
 #define MAX_NESTING 2 /* a(uss) */
+#define MIN_BUF_SIZE 64
+#define BUFFER_POOL_MAX_FREE 8
 #define HEADER_SIZE (sizeof(struct mbim_message_header) + \
 					sizeof(struct mbim_fragment_header))
 
@@ -40,11 +42,20 @@ static const char CONTAINER_TYPE_STRUCT	= 'r';
 static const char CONTAINER_TYPE_DATABUF = 'd';
 static const char *simple_types = "syqut";
 
+struct mbim_buffer_pool {
+	int ref_count;
+	size_t buf_size;
+	unsigned int n_free;
+	void *free[BUFFER_POOL_MAX_FREE];
+};
+
 struct mbim_message {
 	int ref_count;
 	uint8_t header[HEADER_SIZE];
 	struct iovec *frags;
 	uint32_t n_frags;
+	struct iovec iov[2];	/* frags points here unless there are more */
+	struct mbim_buffer_pool *pool;	/* Owns iov[0].iov_base if set */
 	uint8_t uuid[16];
 	uint32_t cid;
 	union {
@@ -692,29 +703,83 @@ void mbim_message_unref(struct mbim_message *msg)
 	if (__sync_sub_and_fetch(&msg->ref_count, 1))
 		return;
 
-	for (i = 0; i < msg->n_frags; i++)
-		l_free(msg->frags[i].iov_base);
+	if (msg->pool) {
+		_mbim_buffer_pool_put(msg->pool, msg->frags[0].iov_base);
+		_mbim_buffer_pool_unref(msg->pool);
+	} else {
+		for (i = 0; i < msg->n_frags; i++)
+			l_free(msg->frags[i].iov_base);
+	}
+
+	if (msg->frags != msg->iov)
+		l_free(msg->frags);
 
-	l_free(msg->frags);
 	l_free(msg);
 }
 
-struct mbim_message *_mbim_message_build(const void *header,
-						struct iovec *frags,
-						uint32_t n_frags)
+struct mbim_buffer_pool *_mbim_buffer_pool_new(size_t buf_size)
 {
-	struct mbim_message *msg;
-	struct mbim_message_header *hdr = (struct mbim_message_header *) header;
-	struct mbim_message_iter iter;
-	bool r = false;
+	struct mbim_buffer_pool *pool = l_new(struct mbim_buffer_pool, 1);
 
-	msg = l_new(struct mbim_message, 1);
+	pool->ref_count = 1;
+	pool->buf_size = buf_size;
 
-	msg->ref_count = 1;
-	memcpy(msg->header, header, HEADER_SIZE);
-	msg->frags = frags;
-	msg->n_frags = n_frags;
-	msg->sealed = true;
+	return pool;
+}
+
+struct mbim_buffer_pool *_mbim_buffer_pool_ref(struct mbim_buffer_pool *pool)
+{
+	if (unlikely(!pool))
+		return NULL;
+
+	__sync_fetch_and_add(&pool->ref_count, 1);
+
+	return pool;
+}
+
+void _mbim_buffer_pool_unref(struct mbim_buffer_pool *pool)
+{
+	if (unlikely(!pool))
+		return;
+
+	if (__sync_sub_and_fetch(&pool->ref_count, 1))
+		return;
+
+	while (pool->n_free)
+		l_free(pool->free[--pool->n_free]);
+
+	l_free(pool);
+}
+
+size_t _mbim_buffer_pool_buf_size(struct mbim_buffer_pool *pool)
+{
+	return pool->buf_size;
+}
+
+void *_mbim_buffer_pool_get(struct mbim_buffer_pool *pool)
+{
+	if (pool->n_free)
+		return pool->free[--pool->n_free];
+
+	return l_malloc(pool->buf_size);
+}
+
+void _mbim_buffer_pool_put(struct mbim_buffer_pool *pool, void *buf)
+{
+	if (pool->n_free < BUFFER_POOL_MAX_FREE)
+		pool->free[pool->n_free++] = buf;
+	else
+		l_free(buf);
+}
+
+static bool message_parse_header(struct mbim_message *msg)
+{
+	struct mbim_message_header *hdr =
+				(struct mbim_message_header *) msg->header;
+	struct iovec *frags = msg->frags;
+	uint32_t n_frags = msg->n_frags;
+	struct mbim_message_iter iter;
+	bool r = false;
 
 	switch (L_LE32_TO_CPU(hdr->type)) {
 	case MBIM_COMMAND_DONE:
@@ -747,7 +812,24 @@ struct mbim_message *_mbim_message_build(const void *header,
 		break;
 	}
 
-	if (!r) {
+	return r;
+}
+
+struct mbim_message *_mbim_message_build(const void *header,
+						struct iovec *frags,
+						uint32_t n_frags)
+{
+	struct mbim_message *msg;
+
+	msg = l_new(struct mbim_message, 1);
+
+	msg->ref_count = 1;
+	memcpy(msg->header, header, HEADER_SIZE);
+	msg->frags = frags;
+	msg->n_frags = n_frags;
+	msg->sealed = true;
+
+	if (!message_parse_header(msg)) {
 		l_free(msg);
 		msg = NULL;
 	}
@@ -755,6 +837,36 @@ struct mbim_message *_mbim_message_build(const void *header,
 	return msg;
 }
 
+/*
+ * Builds the message on top of a single contiguous buffer, which is
+ * consumed even if parsing fails. If the pool is given, the buffer
+ * must have come from it and goes back there when the message is freed.
+ */
+struct mbim_message *_mbim_message_build_buffer(const void *header,
+						void *buf, size_t len,
+						struct mbim_buffer_pool *pool)
+{
+	struct mbim_message *msg;
+
+	msg = l_new(struct mbim_message, 1);
+
+	msg->ref_count = 1;
+	memcpy(msg->header, header, HEADER_SIZE);
+	msg->iov[0].iov_base = buf;
+	msg->iov[0].iov_len = len;
+	msg->frags = msg->iov;
+	msg->n_frags = 1;
+	msg->pool = _mbim_buffer_pool_ref(pool);
+	msg->sealed = true;
+
+	if (!message_parse_header(msg)) {
+		mbim_message_unref(msg);
+		msg = NULL;
+	}
+
+	return msg;
+}
+
 uint32_t mbim_message_get_error(struct mbim_message *message)
 {
 	struct mbim_message_header *hdr;
@@ -959,8 +1071,14 @@ static inline size_t grow_buf(void **buf, size_t *buf_size, size_t *pos,
 	size_t size = align_len(*pos, alignment);
 
 	if (size + len > *buf_size) {
-		*buf = l_realloc(*buf, size + len);
-		*buf_size = size + len;
+		/* Grow geometrically to keep the number of reallocs down */
+		size_t new_size = *buf_size ? *buf_size * 2 : MIN_BUF_SIZE;
+
+		while (new_size < size + len)
+			new_size *= 2;
+
+		*buf = l_realloc(*buf, new_size);
+		*buf_size = new_size;
 	}
 
 	if (size - *pos > 0)
@@ -1446,7 +1564,7 @@ struct mbim_message *mbim_message_builder_finalize(
 					root->sbuf + root->base_offset - 4);
 
 	builder->message->n_frags = 2;
-	builder->message->frags = l_new(struct iovec, 2);
+	builder->message->frags = builder->message->iov;
 	builder->message->frags[0].iov_base = root->sbuf;
 	builder->message->frags[0].iov_len = root->sbuf_pos;
 	builder->message->frags[1].iov_base = root->dbuf;
@@ -46,9 +46,31 @@ struct mbim_fragment_header {
 	__le32 cur_frag;
 } __attribute__ ((packed));
 
+struct mbim_buffer_pool;
+
+struct mbim_buffer_pool *_mbim_buffer_pool_new(size_t buf_size);
+struct mbim_buffer_pool *_mbim_buffer_pool_ref(struct mbim_buffer_pool *pool);
+void _mbim_buffer_pool_unref(struct mbim_buffer_pool *pool);
+size_t _mbim_buffer_pool_buf_size(struct mbim_buffer_pool *pool);
+void *_mbim_buffer_pool_get(struct mbim_buffer_pool *pool);
+void _mbim_buffer_pool_put(struct mbim_buffer_pool *pool, void *buf);
+
 struct mbim_message *_mbim_message_build(const void *header,
 						struct iovec *frags,
 						uint32_t n_frags);
+struct mbim_message *_mbim_message_build_buffer(const void *header,
+						void *buf, size_t len,
+						struct mbim_buffer_pool *pool);
+struct mbim_message_assembly;
+
+struct mbim_message_assembly *_mbim_message_assembly_new(
+					struct mbim_buffer_pool *pool);
+void _mbim_message_assembly_free(struct mbim_message_assembly *assembly);
+struct mbim_message *_mbim_message_assembly_add(
+					struct mbim_message_assembly *assembly,
+					const void *header,
+					void **segment, size_t frag_len);
+
 struct mbim_message *_mbim_message_new_command_done(const uint8_t *uuid,
 					uint32_t cid, uint32_t status);
 uint32_t _mbim_information_buffer_offset(uint32_t type);
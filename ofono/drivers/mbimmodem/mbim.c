@@ -121,57 +121,86 @@ const uint8_t mbim_context_type_local[] = {
 	0x03, 0x3C, 0x39, 0xF6, 0x0D, 0xB9,
 };
 
+/*
+ * Fragmented transactions are hashed by tid. Each one is reassembled
+ * into a single contiguous buffer, so that the message built from it
+ * is just as cheap to parse as a single fragment one.
+ */
+#define ASSEMBLY_TABLE_SIZE 16 /* Must be a power of 2 */
+#define MAX_ASSEMBLY_SIZE (1024 * 1024)
+
 struct message_assembly_node {
-	struct mbim_message_header msg_hdr;
-	struct mbim_fragment_header frag_hdr;
-	struct iovec *iov;
-	size_t n_iov;
-	size_t cur_iov;
-} __attribute((packed))__;
+	struct message_assembly_node *next;
+	uint8_t header[HEADER_SIZE];
+	uint32_t tid;
+	uint32_t n_frags;
+	uint32_t cur_frag;
+	uint8_t *buf;
+	size_t len;
+	size_t size;
+};
 
-struct message_assembly {
-	struct l_queue *transactions;
+struct mbim_message_assembly {
+	struct message_assembly_node *table[ASSEMBLY_TABLE_SIZE];
+	struct mbim_buffer_pool *pool;
 };
 
-static bool message_assembly_node_match_tid(const void *a, const void *b)
+static void message_assembly_node_free(struct message_assembly_node *node)
 {
-	const struct message_assembly_node *node = a;
-	uint32_t tid = L_PTR_TO_UINT(b);
-
-	return L_LE32_TO_CPU(node->msg_hdr.tid) == tid;
+	l_free(node->buf);
+	l_free(node);
 }
 
-static void message_assembly_node_free(void *data)
+static struct message_assembly_node **message_assembly_find(
+					struct mbim_message_assembly *assembly,
+					uint32_t tid)
 {
-	struct message_assembly_node *node = data;
-	size_t i;
+	struct message_assembly_node **link =
+			assembly->table + (tid & (ASSEMBLY_TABLE_SIZE - 1));
 
-	for (i = 0; i < node->n_iov; i++)
-		l_free(node->iov[i].iov_base);
+	while (*link && (*link)->tid != tid)
+		link = &(*link)->next;
 
-	l_free(node->iov);
-	l_free(node);
+	return link;
 }
 
-static struct message_assembly *message_assembly_new()
+struct mbim_message_assembly *_mbim_message_assembly_new(
+					struct mbim_buffer_pool *pool)
 {
-	struct message_assembly *assembly = l_new(struct message_assembly, 1);
+	struct mbim_message_assembly *assembly =
+				l_new(struct mbim_message_assembly, 1);
 
-	assembly->transactions = l_queue_new();
+	assembly->pool = _mbim_buffer_pool_ref(pool);
 
 	return assembly;
 }
 
-static void message_assembly_free(struct message_assembly *assembly)
+void _mbim_message_assembly_free(struct mbim_message_assembly *assembly)
 {
-	l_queue_destroy(assembly->transactions, message_assembly_node_free);
+	unsigned int i;
+
+	for (i = 0; i < ASSEMBLY_TABLE_SIZE; i++) {
+		while (assembly->table[i]) {
+			struct message_assembly_node *node = assembly->table[i];
+
+			assembly->table[i] = node->next;
+			message_assembly_node_free(node);
+		}
+	}
+
+	_mbim_buffer_pool_unref(assembly->pool);
 	l_free(assembly);
 }
 
-static struct mbim_message *message_assembly_add(
-					struct message_assembly *assembly,
+/*
+ * The segment must come from the pool. Single fragment messages take
+ * it over and it gets replaced with another buffer from the pool,
+ * fragments of the larger ones are copied out of it.
+ */
+struct mbim_message *_mbim_message_assembly_add(
+					struct mbim_message_assembly *assembly,
 					const void *header,
-					void *frag, size_t frag_len)
+					void **segment, size_t frag_len)
 {
 	const struct mbim_message_header *msg_hdr = header;
 	const struct mbim_fragment_header *frag_hdr = header +
@@ -180,64 +209,87 @@ static struct mbim_message *message_assembly_add(
 	uint32_t type = L_LE32_TO_CPU(msg_hdr->type);
 	uint32_t n_frags = L_LE32_TO_CPU(frag_hdr->num_frags);
 	uint32_t cur_frag = L_LE32_TO_CPU(frag_hdr->cur_frag);
+	struct message_assembly_node **link;
 	struct message_assembly_node *node;
 	struct mbim_message *message;
+	struct mbim_message_header *hdr;
+	struct mbim_fragment_header *frag;
 
 	if (unlikely(type != MBIM_COMMAND_DONE &&
 				type != MBIM_INDICATE_STATUS_MSG))
 		return NULL;
 
-	node = l_queue_find(assembly->transactions,
-				message_assembly_node_match_tid,
-				L_UINT_TO_PTR(tid));
+	link = message_assembly_find(assembly, tid);
+	node = *link;
 
 	if (!node) {
 		if (cur_frag != 0)
 			return NULL;
 
 		if (n_frags == 1) {
-			struct iovec *iov = l_new(struct iovec, 1);
-
-			iov[0].iov_base = frag;
-			iov[0].iov_len = frag_len;
-
-			return _mbim_message_build(header, iov, 1);
+			message = _mbim_message_build_buffer(header, *segment,
+							frag_len, assembly->pool);
+			*segment = _mbim_buffer_pool_get(assembly->pool);
+			return message;
 		}
 
+		/* All but the last fragment are normally full */
+		if (!frag_len || n_frags > MAX_ASSEMBLY_SIZE / frag_len)
+			return NULL;
+
 		node = l_new(struct message_assembly_node, 1);
-		memcpy(&node->msg_hdr, msg_hdr, sizeof(*msg_hdr));
-		memcpy(&node->frag_hdr, frag_hdr, sizeof(*frag_hdr));
-		node->iov = l_new(struct iovec, n_frags);
-		node->n_iov = n_frags;
-		node->cur_iov = cur_frag;
-		node->iov[node->cur_iov].iov_base = frag;
-		node->iov[node->cur_iov].iov_len = frag_len;
+		memcpy(node->header, header, HEADER_SIZE);
+		node->tid = tid;
+		node->n_frags = n_frags;
+		node->cur_frag = cur_frag;
+		node->size = n_frags * frag_len;
+		node->buf = l_malloc(node->size);
+		node->len = frag_len;
+		memcpy(node->buf, *segment, frag_len);
 
-		l_queue_push_head(assembly->transactions, node);
+		*link = node;
 
 		return NULL;
 	}
 
-	if (node->n_iov != n_frags)
+	if (node->n_frags != n_frags)
 		return NULL;
 
-	if (node->cur_iov + 1 != cur_frag)
+	if (node->cur_frag + 1 != cur_frag)
 		return NULL;
 
-	node->cur_iov = cur_frag;
-	node->iov[node->cur_iov].iov_base = frag;
-	node->iov[node->cur_iov].iov_len = frag_len;
+	if (node->len + frag_len > node->size) {
+		if (node->len + frag_len > MAX_ASSEMBLY_SIZE) {
+			*link = node->next;
+			message_assembly_node_free(node);
+			return NULL;
+		}
+
+		node->size *= 2;
+		if (node->size < node->len + frag_len)
+			node->size = node->len + frag_len;
+
+		node->buf = l_realloc(node->buf, node->size);
+	}
+
+	node->cur_frag = cur_frag;
+	memcpy(node->buf + node->len, *segment, frag_len);
+	node->len += frag_len;
 
-	if (node->cur_iov + 1 < node->n_iov)
+	if (node->cur_frag + 1 < node->n_frags)
 		return NULL;
 
-	l_queue_remove(assembly->transactions, node);
-	message = _mbim_message_build(&node->msg_hdr, node->iov, node->n_iov);
+	*link = node->next;
 
-	if (!message)
-		message_assembly_node_free(node);
-	else
-		l_free(node);
+	/* What's left is a single fragment message */
+	hdr = (struct mbim_message_header *) node->header;
+	hdr->len = L_CPU_TO_LE32(HEADER_SIZE + node->len);
+	frag = (struct mbim_fragment_header *) (node->header + sizeof(*hdr));
+	frag->num_frags = L_CPU_TO_LE32(1);
+
+	message = _mbim_message_build_buffer(node->header, node->buf,
+							node->len, NULL);
+	l_free(node);
 
 	return message;
 }
@@ -252,6 +304,8 @@ struct mbim_device {
 	mbim_device_debug_func_t debug_handler;
 	void *debug_data;
 	mbim_device_destroy_func_t debug_destroy;
+	mbim_device_trace_func_t trace_handler;
+	void *trace_data;
 	mbim_device_disconnect_func_t disconnect_handler;
 	void *disconnect_data;
 	mbim_device_destroy_func_t disconnect_destroy;
@@ -265,7 +319,8 @@ struct mbim_device {
 	struct l_queue *pending_commands;
 	struct l_queue *sent_commands;
 	struct l_queue *notifications;
-	struct message_assembly *assembly;
+	struct mbim_buffer_pool *pool;
+	struct mbim_message_assembly *assembly;
 	struct l_idle *close_io;
 
 	bool is_ready : 1;
@@ -494,6 +549,14 @@ static bool command_write_handler(struct l_io *io, void *user_data)
 
 		l_util_hexdump(false, buf, written, device->debug_handler,
 				device->debug_data);
+
+		if (device->trace_handler) {
+			struct iovec iov = { .iov_base = buf,
+						.iov_len = written };
+
+			device->trace_handler(false, &iov, 1,
+							device->trace_data);
+		}
 	} else {
 		/* TODO: Handle fragmented writes */
 		l_util_debug(device->debug_handler, device->debug_data,
@@ -689,11 +752,18 @@ static bool command_read_handler(struct l_io *io, void *user_data)
 	if (device->segment_bytes_remaining > 0)
 		return true;
 
+	if (device->trace_handler) {
+		iov[0].iov_base = device->header;
+		iov[0].iov_len = header_size;
+		iov[1].iov_base = device->segment;
+		iov[1].iov_len = L_LE32_TO_CPU(hdr->len) - header_size;
+		device->trace_handler(true, iov, 2, device->trace_data);
+	}
+
 	device->header_offset = 0;
-	message = message_assembly_add(device->assembly, device->header,
-					device->segment,
+	message = _mbim_message_assembly_add(device->assembly, device->header,
+					&device->segment,
 					L_LE32_TO_CPU(hdr->len) - header_size);
-	device->segment = l_malloc(device->max_segment_size - HEADER_SIZE);
 
 	if (!message)
 		return true;
@@ -907,7 +977,8 @@ struct mbim_device *mbim_device_new(int fd, uint32_t max_segment_size)
 	device->next_tid = 1;
 	device->next_notification = 1;
 
-	device->segment = l_malloc(max_segment_size - HEADER_SIZE);
+	device->pool = _mbim_buffer_pool_new(max_segment_size - HEADER_SIZE);
+	device->segment = _mbim_buffer_pool_get(device->pool);
 
 	device->io = l_io_new(fd);
 	l_io_set_disconnect_handler(device->io, disconnect_handler,
@@ -919,7 +990,7 @@ struct mbim_device *mbim_device_new(int fd, uint32_t max_segment_size)
 	device->pending_commands = l_queue_new();
 	device->sent_commands = l_queue_new();
 	device->notifications = l_queue_new();
-	device->assembly = message_assembly_new();
+	device->assembly = _mbim_message_assembly_new(device->pool);
 
 	return mbim_device_ref(device);
 }
@@ -949,7 +1020,7 @@ void mbim_device_unref(struct mbim_device *device)
 		device->io = NULL;
 	}
 
-	l_free(device->segment);
+	_mbim_buffer_pool_put(device->pool, device->segment);
 
 	if (device->debug_destroy)
 		device->debug_destroy(device->debug_data);
@@ -960,7 +1031,8 @@ void mbim_device_unref(struct mbim_device *device)
 	l_queue_destroy(device->pending_commands, pending_command_free);
 	l_queue_destroy(device->sent_commands, pending_command_free);
 	l_queue_destroy(device->notifications, notification_free);
-	message_assembly_free(device->assembly);
+	_mbim_message_assembly_free(device->assembly);
+	_mbim_buffer_pool_unref(device->pool);
 	l_free(device);
 }
 
@@ -1020,6 +1092,18 @@ bool mbim_device_set_debug(struct mbim_device *device,
 	return true;
 }
 
+bool mbim_device_set_trace(struct mbim_device *device,
+				mbim_device_trace_func_t func, void *user_data)
+{
+	if (unlikely(!device))
+		return false;
+
+	device->trace_handler = func;
+	device->trace_data = user_data;
+
+	return true;
+}
+
 bool mbim_device_set_close_on_unref(struct mbim_device *device, bool do_close)
 {
 	if (unlikely(!device))
@@ -87,7 +87,11 @@ enum mbim_data_class {
 	MBIM_DATA_CLASS_CUSTOM		= 0x80000000,
 };
 
+struct iovec;
+
 typedef void (*mbim_device_debug_func_t) (const char *str, void *user_data);
+typedef void (*mbim_device_trace_func_t) (bool in, const struct iovec *iov,
+						size_t n_iov, void *user_data);
 typedef void (*mbim_device_disconnect_func_t) (void *user_data);
 typedef void (*mbim_device_destroy_func_t) (void *user_data);
 typedef void (*mbim_device_ready_func_t) (void *user_data);
@@ -123,6 +127,8 @@ bool mbim_device_set_max_outstanding(struct mbim_device *device, uint32_t max);
 bool mbim_device_set_debug(struct mbim_device *device,
 				mbim_device_debug_func_t func, void *user_data,
 				mbim_device_destroy_func_t destroy);
+bool mbim_device_set_trace(struct mbim_device *device,
+				mbim_device_trace_func_t func, void *user_data);
 bool mbim_device_set_disconnect_handler(struct mbim_device *device,
 					mbim_device_disconnect_func_t function,
 					void *user_data,
@@ -43,6 +43,14 @@
 typedef void (*qmi_message_func_t)(uint16_t message, uint16_t length,
 					const void *buffer, void *user_data);
 
+#define QMI_RX_BUFFER_SIZE	16384
+#define QMI_REQUEST_POOL_SIZE	8
+#define QMI_REQUEST_BUF_SIZE	256	/* Fits nearly every request */
+#define QMI_PARAM_BUF_SIZE	64
+
+#define NOTIFY_KEY(type, message) \
+	GUINT_TO_POINTER((type) | ((unsigned int) (message) << 8))
+
 struct discovery {
 	qmi_destroy_func_t destroy;
 };
@@ -69,12 +77,20 @@ struct qmi_device {
 	uint16_t next_service_tid;
 	qmi_debug_func_t debug_func;
 	void *debug_data;
+	qmi_trace_func_t trace_func;
+	void *trace_data;
 	uint16_t control_major;
 	uint16_t control_minor;
 	char *version_str;
 	struct qmi_version *version_list;
 	uint8_t version_count;
 	GHashTable *service_list;
+	GHashTable *service_create;	/* Client allocations in flight */
+	GHashTable *notify_index;	/* (type, message) => notify array */
+	struct qmi_request *request_pool[QMI_REQUEST_POOL_SIZE];
+	unsigned int request_pool_count;
+	size_t rx_len;
+	unsigned char rx_buf[QMI_RX_BUFFER_SIZE];
 	unsigned int release_users;
 	qmi_shutdown_func_t shutdown_func;
 	void *shutdown_user_data;
@@ -98,6 +114,8 @@ struct qmi_service {
 struct qmi_param {
 	void *data;
 	uint16_t length;
+	uint16_t size;
+	unsigned char buf[QMI_PARAM_BUF_SIZE];
 };
 
 struct qmi_result {
@@ -115,11 +133,13 @@ struct qmi_request {
 	size_t len;
 	qmi_message_func_t callback;
 	void *user_data;
+	unsigned char data[QMI_REQUEST_BUF_SIZE];
 };
 
 struct qmi_notify {
 	uint16_t id;
 	uint16_t message;
+	struct qmi_service *service;
 	qmi_result_func_t callback;
 	void *user_data;
 	qmi_destroy_func_t destroy;
@@ -165,7 +185,8 @@ void qmi_free(void *ptr)
 	free(ptr);
 }
 
-static struct qmi_request *__request_alloc(uint8_t service,
+static struct qmi_request *__request_alloc(struct qmi_device *device,
+				uint8_t service,
 				uint8_t client, uint16_t message,
 				const void *data,
 				uint16_t length, qmi_message_func_t func,
@@ -176,16 +197,23 @@ static struct qmi_request *__request_alloc(uint8_t service,
 	struct qmi_message_hdr *msg;
 	uint16_t headroom;
 
-	req = g_new0(struct qmi_request, 1);
+	if (device->request_pool_count)
+		req = device->request_pool[--device->request_pool_count];
+	else
+		req = g_new(struct qmi_request, 1);
 
 	if (service == QMI_SERVICE_CONTROL)
 		headroom = QMI_CONTROL_HDR_SIZE;
 	else
 		headroom = QMI_SERVICE_HDR_SIZE;
 
+	req->tid = 0;
 	req->len = QMI_MUX_HDR_SIZE + headroom + QMI_MESSAGE_HDR_SIZE + length;
 
-	req->buf = g_malloc(req->len);
+	if (req->len <= sizeof(req->data))
+		req->buf = req->data;
+	else
+		req->buf = g_malloc(req->len);
 
 	req->client = client;
 
@@ -212,12 +240,22 @@ static struct qmi_request *__request_alloc(uint8_t service,
 	return req;
 }
 
+/* Requests go back to the pool of the device passed as user_data */
 static void __request_free(gpointer data, gpointer user_data)
 {
 	struct qmi_request *req = data;
+	struct qmi_device *device = user_data;
+
+	if (!req)
+		return;
+
+	if (req->buf != req->data)
+		g_free(req->buf);
 
-	g_free(req->buf);
-	g_free(req);
+	if (device && device->request_pool_count < QMI_REQUEST_POOL_SIZE)
+		device->request_pool[device->request_pool_count++] = req;
+	else
+		g_free(req);
 }
 
 static gint __request_compare(gconstpointer a, gconstpointer b)
@@ -660,6 +698,10 @@ static gboolean can_write_data(GIOChannel *channel, GIOCondition cond,
 	__hexdump('>', req->buf, bytes_written,
 				device->debug_func, device->debug_data);
 
+	if (device->trace_func)
+		device->trace_func(false, req->buf, bytes_written,
+							device->trace_data);
+
 	__debug_msg(' ', req->buf, bytes_written,
 				device->debug_func, device->debug_data);
 
@@ -670,7 +712,10 @@ static gboolean can_write_data(GIOChannel *channel, GIOCondition cond,
 	else
 		g_queue_push_tail(device->service_queue, req);
 
-	g_free(req->buf);
+	/* Only the header is needed to match the response */
+	if (req->buf != req->data)
+		g_free(req->buf);
+
 	req->buf = NULL;
 
 	if (g_queue_get_length(device->req_queue) > 0)
@@ -729,52 +774,42 @@ static uint16_t __request_submit(struct qmi_device *device,
 	return req->tid;
 }
 
-static void service_notify(gpointer key, gpointer value, gpointer user_data)
-{
-	struct qmi_service *service = value;
-	struct qmi_result *result = user_data;
-	GList *list;
-
-	for (list = g_list_first(service->notify_list); list;
-						list = g_list_next(list)) {
-		struct qmi_notify *notify = list->data;
-
-		if (notify->message == result->message)
-			notify->callback(result, notify->user_data);
-	}
-}
-
 static void handle_indication(struct qmi_device *device,
 			uint8_t service_type, uint8_t client_id,
 			uint16_t message, uint16_t length, const void *data)
 {
-	struct qmi_service *service;
+	GPtrArray *notifies;
 	struct qmi_result result;
-	unsigned int hash_id;
+	unsigned int i;
 
 	if (service_type == QMI_SERVICE_CONTROL)
 		return;
 
+	notifies = g_hash_table_lookup(device->notify_index,
+					NOTIFY_KEY(service_type, message));
+	if (!notifies)
+		return;
+
 	result.result = 0;
 	result.error = 0;
 	result.message = message;
 	result.data = data;
 	result.length = length;
 
-	if (client_id == 0xff) {
-		g_hash_table_foreach(device->service_list,
-						service_notify, &result);
-		return;
-	}
+	/*
+	 * Callbacks may unregister themselves or others. Move on only if
+	 * the current entry is still in place, otherwise the next one has
+	 * taken its slot.
+	 */
+	for (i = 0; i < notifies->len; ) {
+		struct qmi_notify *notify = notifies->pdata[i];
 
-	hash_id = service_type | (client_id << 8);
+		if (client_id == 0xff || notify->service->client_id == client_id)
+			notify->callback(&result, notify->user_data);
 
-	service = g_hash_table_lookup(device->service_list,
-					GUINT_TO_POINTER(hash_id));
-	if (!service)
-		return;
-
-	service_notify(NULL, service, &result);
+		if (i < notifies->len && notifies->pdata[i] == notify)
+			i++;
+	}
 }
 
 static void handle_packet(struct qmi_device *device,
@@ -851,48 +886,67 @@ static void handle_packet(struct qmi_device *device,
 	if (req->callback)
 		req->callback(message, length, data, req->user_data);
 
-	__request_free(req, NULL);
+	__request_free(req, device);
 }
 
+/*
+ * Messages are handled in place, straight from the receive buffer.
+ * Whatever is left of an incomplete frame is kept for the next read.
+ */
 static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 							gpointer user_data)
 {
 	struct qmi_device *device = user_data;
+	unsigned char *buf = device->rx_buf;
 	struct qmi_mux_hdr *hdr;
-	unsigned char buf[2048];
 	ssize_t bytes_read;
-	uint16_t offset;
+	size_t offset;
+	size_t total;
 
 	if (cond & G_IO_NVAL)
 		return FALSE;
 
-	bytes_read = read(device->fd, buf, sizeof(buf));
+	bytes_read = read(device->fd, buf + device->rx_len,
+					sizeof(device->rx_buf) - device->rx_len);
 	if (bytes_read < 0)
 		return TRUE;
 
-	__hexdump('<', buf, bytes_read,
+	__hexdump('<', buf + device->rx_len, bytes_read,
 				device->debug_func, device->debug_data);
 
+	if (device->trace_func && bytes_read > 0)
+		device->trace_func(true, buf + device->rx_len, bytes_read,
+							device->trace_data);
+
+	total = device->rx_len + bytes_read;
 	offset = 0;
 
-	while (offset < bytes_read) {
+	/* Callbacks may drop the last reference to the device */
+	qmi_device_ref(device);
+
+	while (offset < total) {
 		uint16_t len;
 
 		/* Check if QMI mux header fits into packet */
-		if (bytes_read - offset < QMI_MUX_HDR_SIZE)
+		if (total - offset < QMI_MUX_HDR_SIZE)
 			break;
 
 		hdr = (void *) (buf + offset);
 
-		/* Check for fixed frame and flags value */
-		if (hdr->frame != 0x01 || hdr->flags != 0x80)
+		/* Check for fixed frame and flags value, resync if broken */
+		if (hdr->frame != 0x01 || hdr->flags != 0x80) {
+			offset = total;
 			break;
+		}
 
 		len = GUINT16_FROM_LE(hdr->length) + 1;
 
-		/* Check that packet size matches frame size */
-		if (bytes_read - offset < len)
+		/* Wait for the rest of the frame, unless it can't fit */
+		if (total - offset < len) {
+			if (len > sizeof(device->rx_buf))
+				offset = total;
 			break;
+		}
 
 		__debug_msg(' ', buf + offset, len,
 				device->debug_func, device->debug_data);
@@ -900,8 +954,21 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 		handle_packet(device, hdr, buf + offset + QMI_MUX_HDR_SIZE);
 
 		offset += len;
+
+		/* Nobody else is interested in this device anymore */
+		if (device->ref_count == 1) {
+			offset = total;
+			break;
+		}
 	}
 
+	if (offset < total && offset > 0)
+		memmove(buf, buf + offset, total - offset);
+
+	device->rx_len = total - offset;
+
+	qmi_device_unref(device);
+
 	return TRUE;
 }
 
@@ -984,6 +1051,11 @@ struct qmi_device *qmi_device_new(int fd)
 
 	device->service_list = g_hash_table_new_full(g_direct_hash,
 					g_direct_equal, NULL, service_destroy);
+	device->service_create = g_hash_table_new(g_direct_hash,
+							g_direct_equal);
+	device->notify_index = g_hash_table_new_full(g_direct_hash,
+				g_direct_equal, NULL,
+				(GDestroyNotify) g_ptr_array_unref);
 
 	device->next_control_tid = 1;
 	device->next_service_tid = 256;
@@ -1022,6 +1094,11 @@ void qmi_device_unref(struct qmi_device *device)
 
 	g_queue_foreach(device->discovery_queue, __discovery_free, NULL);
 	g_queue_free(device->discovery_queue);
+	g_hash_table_destroy(device->service_create);
+	g_hash_table_destroy(device->notify_index);
+
+	while (device->request_pool_count)
+		g_free(device->request_pool[--device->request_pool_count]);
 
 	if (device->write_watch > 0)
 		g_source_remove(device->write_watch);
@@ -1056,6 +1133,16 @@ void qmi_device_set_debug(struct qmi_device *device,
 	device->debug_data = user_data;
 }
 
+void qmi_device_set_trace(struct qmi_device *device,
+				qmi_trace_func_t func, void *user_data)
+{
+	if (device == NULL)
+		return;
+
+	device->trace_func = func;
+	device->trace_data = user_data;
+}
+
 void qmi_device_set_close_on_unref(struct qmi_device *device, bool do_close)
 {
 	if (!device)
@@ -1278,7 +1365,7 @@ static gboolean discover_reply(gpointer user_data)
 		data->func(data->user_data);
 
 	__qmi_device_discovery_complete(data->device, &data->super);
-	__request_free(req, NULL);
+	__request_free(req, device);
 
 	return FALSE;
 }
@@ -1311,7 +1398,7 @@ bool qmi_device_discover(struct qmi_device *device, qmi_discover_func_t func,
 		return true;
 	}
 
-	req = __request_alloc(QMI_SERVICE_CONTROL, 0x00,
+	req = __request_alloc(device, QMI_SERVICE_CONTROL, 0x00,
 			QMI_CTL_GET_VERSION_INFO,
 			NULL, 0, discover_callback, data);
 
@@ -1332,7 +1419,7 @@ static void release_client(struct qmi_device *device,
 	unsigned char release_req[] = { 0x01, 0x02, 0x00, type, client_id };
 	struct qmi_request *req;
 
-	req = __request_alloc(QMI_SERVICE_CONTROL, 0x00,
+	req = __request_alloc(device, QMI_SERVICE_CONTROL, 0x00,
 			QMI_CTL_RELEASE_CLIENT_ID,
 			release_req, sizeof(release_req),
 			func, user_data);
@@ -1426,7 +1513,7 @@ bool qmi_device_sync(struct qmi_device *device,
 	func_data->func = func;
 	func_data->user_data = user_data;
 
-	req = __request_alloc(QMI_SERVICE_CONTROL, 0x00,
+	req = __request_alloc(device, QMI_SERVICE_CONTROL, 0x00,
 			QMI_CTL_SYNC,
 			NULL, 0,
 			qmi_device_sync_callback, func_data);
@@ -1650,6 +1737,9 @@ struct qmi_param *qmi_param_new(void)
 	if (!param)
 		return NULL;
 
+	param->data = param->buf;
+	param->size = sizeof(param->buf);
+
 	return param;
 }
 
@@ -1658,7 +1748,9 @@ void qmi_param_free(struct qmi_param *param)
 	if (!param)
 		return;
 
-	g_free(param->data);
+	if (param->data != param->buf)
+		g_free(param->data);
+
 	g_free(param);
 }
 
@@ -1666,7 +1758,7 @@ bool qmi_param_append(struct qmi_param *param, uint8_t type,
 					uint16_t length, const void *data)
 {
 	struct qmi_tlv_hdr *tlv;
-	void *ptr;
+	size_t needed;
 
 	if (!param || !type)
 		return false;
@@ -1677,23 +1769,38 @@ bool qmi_param_append(struct qmi_param *param, uint8_t type,
 	if (!data)
 		return false;
 
-	if (param->data)
-		ptr = g_try_realloc(param->data,
-				param->length + QMI_TLV_HDR_SIZE + length);
-	else
-		ptr = g_try_malloc(QMI_TLV_HDR_SIZE + length);
-
-	if (!ptr)
+	needed = param->length + QMI_TLV_HDR_SIZE + length;
+	if (needed > G_MAXUINT16)
 		return false;
 
-	tlv = ptr + param->length;
+	/* Small parameters stay in the inline buffer */
+	if (needed > param->size) {
+		size_t size = MIN(MAX(needed, (size_t) param->size * 2),
+								G_MAXUINT16);
+		void *ptr;
+
+		if (param->data == param->buf) {
+			ptr = g_try_malloc(size);
+			if (ptr)
+				memcpy(ptr, param->buf, param->length);
+		} else {
+			ptr = g_try_realloc(param->data, size);
+		}
+
+		if (!ptr)
+			return false;
+
+		param->data = ptr;
+		param->size = size;
+	}
+
+	tlv = param->data + param->length;
 
 	tlv->type = type;
 	tlv->length = GUINT16_TO_LE(length);
 	memcpy(tlv->value, data, length);
 
-	param->data = ptr;
-	param->length += QMI_TLV_HDR_SIZE + length;
+	param->length = needed;
 
 	return true;
 }
@@ -1929,41 +2036,132 @@ bool qmi_result_get_uint64(struct qmi_result *result, uint8_t type,
 	return true;
 }
 
+struct service_create_waiter {
+	qmi_create_func_t func;
+	void *user_data;
+	qmi_destroy_func_t destroy;
+};
+
+/*
+ * One client allocation per service type is in flight at any time.
+ * Everyone asking for the same type while it is pending is added to
+ * the waiters and gets the same service once it has been created.
+ */
 struct service_create_data {
 	struct discovery super;
 	struct qmi_device *device;
 	uint8_t type;
 	uint16_t major;
 	uint16_t minor;
-	qmi_create_func_t func;
-	void *user_data;
-	qmi_destroy_func_t destroy;
+	uint16_t tid;
+	gint64 start;
+	GSList *waiters;
 	guint timeout;
 };
 
+static void service_create_waiter_free(gpointer user_data)
+{
+	struct service_create_waiter *waiter = user_data;
+
+	if (waiter->destroy)
+		waiter->destroy(waiter->user_data);
+
+	g_free(waiter);
+}
+
 static void service_create_data_free(gpointer user_data)
 {
 	struct service_create_data *data = user_data;
+	GHashTable *pending = data->device->service_create;
+	gpointer key = GUINT_TO_POINTER(data->type);
 
 	if (data->timeout) {
 		g_source_remove(data->timeout);
 		data->timeout = 0;
 	}
 
-	if (data->destroy)
-		data->destroy(data->user_data);
+	if (g_hash_table_lookup(pending, key) == data)
+		g_hash_table_remove(pending, key);
 
+	g_slist_free_full(data->waiters, service_create_waiter_free);
 	g_free(data);
 }
 
+static bool service_create_add_waiter(struct service_create_data *data,
+				qmi_create_func_t func, void *user_data,
+				qmi_destroy_func_t destroy)
+{
+	struct service_create_waiter *waiter;
+
+	waiter = g_try_new0(struct service_create_waiter, 1);
+	if (!waiter)
+		return false;
+
+	waiter->func = func;
+	waiter->user_data = user_data;
+	waiter->destroy = destroy;
+
+	data->waiters = g_slist_append(data->waiters, waiter);
+
+	return true;
+}
+
+static void service_create_done(struct service_create_data *data,
+						struct qmi_service *service)
+{
+	struct qmi_device *device = qmi_device_ref(data->device);
+	GSList *l;
+
+	/*
+	 * From now on the type is either shared or has to be created anew,
+	 * unless a newer allocation of the same type has taken our place.
+	 */
+	if (g_hash_table_lookup(device->service_create,
+				GUINT_TO_POINTER(data->type)) == data)
+		g_hash_table_remove(device->service_create,
+					GUINT_TO_POINTER(data->type));
+
+	for (l = data->waiters; l; l = l->next) {
+		struct service_create_waiter *waiter = l->data;
+
+		waiter->func(service, waiter->user_data);
+	}
+
+	__qmi_device_discovery_complete(device, &data->super);
+	qmi_device_unref(device);
+}
+
 static gboolean service_create_reply(gpointer user_data)
 {
 	struct service_create_data *data = user_data;
+	struct qmi_device *device = data->device;
+	unsigned int tid = data->tid;
+	struct qmi_request *req = NULL;
+	GList *list;
 
 	data->timeout = 0;
-	data->func(NULL, data->user_data);
 
-	__qmi_device_discovery_complete(data->device, &data->super);
+	__debug_device(device, "service create [type=%d] timed out",
+								data->type);
+
+	/* Don't let a late reply find the request */
+	list = g_queue_find_custom(device->req_queue,
+				GUINT_TO_POINTER(tid), __request_compare);
+	if (list) {
+		req = list->data;
+		g_queue_delete_link(device->req_queue, list);
+	} else {
+		list = g_queue_find_custom(device->control_queue,
+				GUINT_TO_POINTER(tid), __request_compare);
+		if (list) {
+			req = list->data;
+			g_queue_delete_link(device->control_queue, list);
+		}
+	}
+
+	__request_free(req, device);
+
+	service_create_done(data, NULL);
 
 	return FALSE;
 }
@@ -2009,8 +2207,11 @@ static void service_create_callback(uint16_t message, uint16_t length,
 
 	service->client_id = client_id->client;
 
-	__debug_device(device, "service created [client=%d,type=%d]",
-					service->client_id, service->type);
+	__debug_device(device, "service created [client=%d,type=%d] "
+			"in %u ms for %u users", service->client_id,
+			service->type, (unsigned int)
+			((g_get_monotonic_time() - data->start) / 1000),
+			g_slist_length(data->waiters));
 
 	hash_id = service->type | (service->client_id << 8);
 
@@ -2018,10 +2219,8 @@ static void service_create_callback(uint16_t message, uint16_t length,
 				GUINT_TO_POINTER(hash_id), service);
 
 done:
-	data->func(service, data->user_data);
+	service_create_done(data, service);
 	qmi_service_unref(service);
-
-	__qmi_device_discovery_complete(data->device, &data->super);
 }
 
 static bool service_create(struct qmi_device *device,
@@ -2033,19 +2232,22 @@ static bool service_create(struct qmi_device *device,
 	struct qmi_request *req;
 	int i;
 
+	if (!device->version_list)
+		return false;
+
 	data = g_try_new0(struct service_create_data, 1);
 	if (!data)
 		return false;
 
-	if (!device->version_list)
+	if (!service_create_add_waiter(data, func, user_data, destroy)) {
+		g_free(data);
 		return false;
+	}
 
 	data->super.destroy = service_create_data_free;
 	data->device = device;
 	data->type = type;
-	data->func = func;
-	data->user_data = user_data;
-	data->destroy = destroy;
+	data->start = g_get_monotonic_time();
 
 	__debug_device(device, "service create [type=%d]", type);
 
@@ -2057,15 +2259,17 @@ static bool service_create(struct qmi_device *device,
 		}
 	}
 
-	req = __request_alloc(QMI_SERVICE_CONTROL, 0x00,
+	req = __request_alloc(device, QMI_SERVICE_CONTROL, 0x00,
 			QMI_CTL_GET_CLIENT_ID,
 			client_req, sizeof(client_req),
 			service_create_callback, data);
 
-	__request_submit(device, req);
+	data->tid = __request_submit(device, req);
 
 	data->timeout = g_timeout_add_seconds(8, service_create_reply, data);
 	__qmi_device_discovery_started(device, &data->super);
+	g_hash_table_insert(device->service_create,
+					GUINT_TO_POINTER(type), data);
 
 	return true;
 }
@@ -2114,6 +2318,7 @@ bool qmi_service_create_shared(struct qmi_device *device,
 				void *user_data, qmi_destroy_func_t destroy)
 {
 	struct qmi_service *service;
+	struct service_create_data *pending;
 	unsigned int type_val = type;
 
 	if (!device || !func)
@@ -2142,7 +2347,16 @@ bool qmi_service_create_shared(struct qmi_device *device,
 					service_create_shared_reply, data);
 		__qmi_device_discovery_started(device, &data->super);
 
-		return 0;
+		return true;
+	}
+
+	pending = g_hash_table_lookup(device->service_create,
+					GUINT_TO_POINTER(type_val));
+	if (pending) {
+		__debug_device(device, "service create [type=%d] pending",
+									type);
+		return service_create_add_waiter(pending, func, user_data,
+								destroy);
 	}
 
 	return service_create(device, type, func, user_data, destroy);
@@ -2300,7 +2514,7 @@ uint16_t qmi_service_send(struct qmi_service *service,
 	data->user_data = user_data;
 	data->destroy = destroy;
 
-	req = __request_alloc(service->type, service->client_id,
+	req = __request_alloc(device, service->type, service->client_id,
 				message,
 				param ? param->data : NULL,
 				param ? param->length : 0,
@@ -2349,12 +2563,13 @@ bool qmi_service_cancel(struct qmi_service *service, uint16_t id)
 
 	service_send_free(req->user_data);
 
-	__request_free(req, NULL);
+	__request_free(req, device);
 
 	return true;
 }
 
-static GQueue *remove_client(GQueue *queue, uint8_t client)
+static GQueue *remove_client(struct qmi_device *device, GQueue *queue,
+							uint8_t client)
 {
 	GQueue *new_queue;
 	GList *list;
@@ -2377,7 +2592,7 @@ static GQueue *remove_client(GQueue *queue, uint8_t client)
 
 		service_send_free(req->user_data);
 
-		__request_free(req, NULL);
+		__request_free(req, device);
 	}
 
 	g_queue_free(queue);
@@ -2399,15 +2614,54 @@ bool qmi_service_cancel_all(struct qmi_service *service)
 	if (!device)
 		return false;
 
-	device->req_queue = remove_client(device->req_queue,
+	device->req_queue = remove_client(device, device->req_queue,
 						service->client_id);
 
-	device->service_queue = remove_client(device->service_queue,
+	device->service_queue = remove_client(device, device->service_queue,
 							service->client_id);
 
 	return true;
 }
 
+static void notify_index_add(struct qmi_device *device,
+					struct qmi_notify *notify)
+{
+	gpointer key;
+	GPtrArray *notifies;
+
+	if (!device)
+		return;
+
+	key = NOTIFY_KEY(notify->service->type, notify->message);
+	notifies = g_hash_table_lookup(device->notify_index, key);
+	if (!notifies) {
+		notifies = g_ptr_array_new();
+		g_hash_table_insert(device->notify_index, key, notifies);
+	}
+
+	g_ptr_array_add(notifies, notify);
+}
+
+static void notify_index_remove(struct qmi_device *device,
+					struct qmi_notify *notify)
+{
+	GPtrArray *notifies;
+
+	if (!device)
+		return;
+
+	/* Keeps the order, and the array itself, for handle_indication */
+	notifies = g_hash_table_lookup(device->notify_index,
+			NOTIFY_KEY(notify->service->type, notify->message));
+	if (notifies)
+		g_ptr_array_remove(notifies, notify);
+}
+
+static void notify_index_unlink(gpointer data, gpointer user_data)
+{
+	notify_index_remove(user_data, data);
+}
+
 uint16_t qmi_service_register(struct qmi_service *service,
 				uint16_t message, qmi_result_func_t func,
 				void *user_data, qmi_destroy_func_t destroy)
@@ -2426,11 +2680,13 @@ uint16_t qmi_service_register(struct qmi_service *service,
 
 	notify->id = service->next_notify_id++;
 	notify->message = message;
+	notify->service = service;
 	notify->callback = func;
 	notify->user_data = user_data;
 	notify->destroy = destroy;
 
 	service->notify_list = g_list_append(service->notify_list, notify);
+	notify_index_add(service->device, notify);
 
 	return notify->id;
 }
@@ -2453,6 +2709,7 @@ bool qmi_service_unregister(struct qmi_service *service, uint16_t id)
 
 	service->notify_list = g_list_delete_link(service->notify_list, list);
 
+	notify_index_remove(service->device, notify);
 	__notify_free(notify, NULL);
 
 	return true;
@@ -2463,6 +2720,8 @@ bool qmi_service_unregister_all(struct qmi_service *service)
 	if (!service)
 		return false;
 
+	g_list_foreach(service->notify_list, notify_index_unlink,
+							service->device);
 	g_list_foreach(service->notify_list, __notify_free, NULL);
 	g_list_free(service->notify_list);
 
@@ -69,6 +69,8 @@ typedef void (*qmi_destroy_func_t)(void *user_data);
 struct qmi_device;
 
 typedef void (*qmi_debug_func_t)(const char *str, void *user_data);
+typedef void (*qmi_trace_func_t)(bool in, const void *buf, size_t len,
+							void *user_data);
 typedef void (*qmi_sync_func_t)(void *user_data);
 typedef void (*qmi_shutdown_func_t)(void *user_data);
 typedef void (*qmi_discover_func_t)(void *user_data);
@@ -80,6 +82,8 @@ void qmi_device_unref(struct qmi_device *device);
 
 void qmi_device_set_debug(struct qmi_device *device,
 				qmi_debug_func_t func, void *user_data);
+void qmi_device_set_trace(struct qmi_device *device,
+				qmi_trace_func_t func, void *user_data);
 
 void qmi_device_set_close_on_unref(struct qmi_device *device, bool do_close);
 
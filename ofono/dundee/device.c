@@ -48,6 +48,16 @@ struct ipv4_settings {
 	char **nameservers;
 };
 
+/* Time spent in each phase of the last connect, in milliseconds */
+struct connect_stats {
+	guint32 channel;
+	guint32 dial;
+	guint32 negotiation;
+	guint32 total;
+	gboolean channel_reused;
+	gboolean valid;
+};
+
 struct dundee_device {
 	char *path;
 	struct dundee_device_driver *driver;
@@ -60,6 +70,22 @@ struct dundee_device {
 	gboolean active;
 	struct ipv4_settings settings;
 
+	/*
+	 * With fast_reconnect the channel and its GAtChat survive the PPP
+	 * session, and the addresses of the last session are offered to
+	 * the peer as the first IPCP request on the next one.
+	 */
+	gboolean fast_reconnect;
+	char *ipcp_local;
+	char *ipcp_dns1;
+	char *ipcp_dns2;
+
+	gint64 connect_start;
+	gint64 channel_ready;
+	gint64 dialed;
+	gboolean channel_reused;
+	struct connect_stats last_connect;
+
 	DBusMessage *pending;
 	guint connect_timeout;
 	void *data;
@@ -129,11 +155,102 @@ static void settings_append_dict(struct dundee_device *device,
 	dbus_message_iter_close_container(dict, &entry);
 }
 
+static void last_connect_append(struct dundee_device *device,
+					DBusMessageIter *iter)
+{
+	const struct connect_stats *stats = &device->last_connect;
+	DBusMessageIter variant;
+	DBusMessageIter array;
+
+	dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&variant);
+
+	dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY,
+					"{sv}", &array);
+
+	ofono_dbus_dict_append(&array, "Channel", DBUS_TYPE_UINT32,
+					&stats->channel);
+	ofono_dbus_dict_append(&array, "Dial", DBUS_TYPE_UINT32,
+					&stats->dial);
+	ofono_dbus_dict_append(&array, "Negotiation", DBUS_TYPE_UINT32,
+					&stats->negotiation);
+	ofono_dbus_dict_append(&array, "Total", DBUS_TYPE_UINT32,
+					&stats->total);
+	ofono_dbus_dict_append(&array, "ChannelReused", DBUS_TYPE_BOOLEAN,
+					&stats->channel_reused);
+
+	dbus_message_iter_close_container(&variant, &array);
+
+	dbus_message_iter_close_container(iter, &variant);
+}
+
+static void last_connect_changed(struct dundee_device *device)
+{
+	DBusConnection *conn = ofono_dbus_get_connection();
+	DBusMessage *signal;
+	DBusMessageIter iter;
+	const char *key = "LastConnect";
+
+	signal = dbus_message_new_signal(device->path,
+					DUNDEE_DEVICE_INTERFACE,
+					"PropertyChanged");
+
+	if (signal == NULL)
+		return;
+
+	dbus_message_iter_init_append(signal, &iter);
+	dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &key);
+
+	last_connect_append(device, &iter);
+
+	g_dbus_send_message(conn, signal);
+}
+
+static guint32 elapsed_ms(gint64 from, gint64 to)
+{
+	return (from && to > from) ? (guint32) ((to - from) / 1000) : 0;
+}
+
+static void last_connect_update(struct dundee_device *device)
+{
+	struct connect_stats *stats = &device->last_connect;
+	const gint64 now = g_get_monotonic_time();
+
+	stats->channel = elapsed_ms(device->connect_start,
+					device->channel_ready);
+	stats->dial = elapsed_ms(device->channel_ready, device->dialed);
+	stats->negotiation = elapsed_ms(device->dialed, now);
+	stats->total = elapsed_ms(device->connect_start, now);
+	stats->channel_reused = device->channel_reused;
+	stats->valid = TRUE;
+
+	DBG("%s channel %u dial %u ppp %u total %u ms%s", device->path,
+			stats->channel, stats->dial, stats->negotiation,
+			stats->total, stats->channel_reused ? " (reused)" : "");
+
+	last_connect_changed(device);
+}
+
 void __dundee_device_append_properties(struct dundee_device *device,
 					DBusMessageIter *dict)
 {
 	settings_append_dict(device, dict);
 
+	if (device->last_connect.valid) {
+		DBusMessageIter entry;
+		const char *key = "LastConnect";
+
+		dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY,
+							NULL, &entry);
+		dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+		last_connect_append(device, &entry);
+		dbus_message_iter_close_container(dict, &entry);
+	}
+
+	ofono_dbus_dict_append(dict, "FastReconnect", DBUS_TYPE_BOOLEAN,
+				&device->fast_reconnect);
+
 	ofono_dbus_dict_append(dict, "Name", DBUS_TYPE_STRING,
 				&device->name);
 
@@ -244,6 +361,13 @@ static void ppp_connect(const char *iface, const char *local, const char *peer,
 	if (device->settings.nameservers == NULL)
 		goto err;
 
+	g_free(device->ipcp_local);
+	g_free(device->ipcp_dns1);
+	g_free(device->ipcp_dns2);
+	device->ipcp_local = g_strdup(local);
+	device->ipcp_dns1 = g_strdup(dns1);
+	device->ipcp_dns2 = g_strdup(dns2);
+
 	__ofono_dbus_pending_reply(&device->pending,
 			dbus_message_new_method_return(device->pending));
 	device->pending = NULL;
@@ -255,6 +379,7 @@ static void ppp_connect(const char *iface, const char *local, const char *peer,
 					DUNDEE_DEVICE_INTERFACE, "Active",
 					DBUS_TYPE_BOOLEAN, &device->active);
 
+	last_connect_update(device);
 	return;
 
 err:
@@ -324,6 +449,7 @@ static void ppp_disconnect(GAtPPPDisconnectReason reason, gpointer user_data)
 {
 	DBusConnection *conn = ofono_dbus_get_connection();
 	struct dundee_device *device = user_data;
+	gboolean was_active = device->active;
 
 	DBG("%p", device);
 	DBG("PPP Link down: %d\n", reason);
@@ -331,6 +457,11 @@ static void ppp_disconnect(GAtPPPDisconnectReason reason, gpointer user_data)
 	g_at_ppp_unref(device->ppp);
 	device->ppp = NULL;
 
+	if (device->connect_timeout > 0) {
+		g_source_remove(device->connect_timeout);
+		device->connect_timeout = 0;
+	}
+
 	g_at_chat_resume(device->chat);
 
 	g_free(device->settings.interface);
@@ -347,6 +478,30 @@ static void ppp_disconnect(GAtPPPDisconnectReason reason, gpointer user_data)
 					DUNDEE_DEVICE_INTERFACE, "Active",
 					DBUS_TYPE_BOOLEAN, &device->active);
 
+	/*
+	 * After an orderly LCP termination the modem is back in command
+	 * mode and the channel can carry the next ATD as it is.
+	 */
+	if (device->fast_reconnect && device->chat != NULL &&
+			(reason == G_AT_PPP_REASON_LOCAL_CLOSE ||
+				reason == G_AT_PPP_REASON_PEER_CLOSED)) {
+		DBG("%s keeping the channel", device->path);
+
+		if (device->pending == NULL)
+			return;
+
+		/* Pending is either our Active=false or a failed connect */
+		if (was_active)
+			__ofono_dbus_pending_reply(&device->pending,
+				dbus_message_new_method_return(device->pending));
+		else
+			__ofono_dbus_pending_reply(&device->pending,
+					__dundee_error_failed(device->pending));
+
+		device->pending = NULL;
+		return;
+	}
+
 	device->driver->disconnect(device, disconnect_callback, device);
 }
 
@@ -355,6 +510,8 @@ static void dial_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	struct dundee_device *device = user_data;
 	GAtIO *io;
 
+	device->dialed = g_get_monotonic_time();
+
 	if (!ok) {
 		DBG("Unable to define context\n");
 		goto err;
@@ -377,6 +534,10 @@ static void dial_cb(gboolean ok, GAtResult *result, gpointer user_data)
 	}
 	g_at_ppp_set_debug(device->ppp, debug, "PPP");
 
+	if (device->fast_reconnect && device->ipcp_local != NULL)
+		g_at_ppp_set_ipcp_hint(device->ppp, device->ipcp_local,
+					device->ipcp_dns1, device->ipcp_dns2);
+
 	device->connect_timeout = g_timeout_add_seconds(PPP_TIMEOUT,
 						ppp_connect_timeout, device);
 
@@ -397,6 +558,27 @@ err:
 	device->driver->disconnect(device, disconnect_callback, device);
 }
 
+static void chat_disconnected(gpointer user_data)
+{
+	struct dundee_device *device = user_data;
+
+	DBG("%s", device->path);
+
+	g_at_chat_unref(device->chat);
+	device->chat = NULL;
+
+	/* PPP notices the hangup itself and takes care of the rest */
+	if (device->ppp == NULL)
+		device->driver->disconnect(device, disconnect_callback,
+								device);
+}
+
+static void device_dial(struct dundee_device *device)
+{
+	g_at_chat_send(device->chat, "ATD*99#", none_prefix, dial_cb,
+			device, NULL);
+}
+
 static int device_dial_setup(struct dundee_device *device, int fd)
 {
 	GAtSyntax *syntax;
@@ -415,9 +597,10 @@ static int device_dial_setup(struct dundee_device *device, int fd)
 		return -EIO;
 
 	g_at_chat_set_debug(device->chat, debug, "Control");
+	g_at_chat_set_disconnect_function(device->chat, chat_disconnected,
+						device);
 
-	g_at_chat_send(device->chat, "ATD*99#", none_prefix, dial_cb,
-			device, NULL);
+	device_dial(device);
 
 	return 0;
 }
@@ -433,6 +616,8 @@ static void connect_callback(const struct dundee_error *error,
 	if (error->type != DUNDEE_ERROR_TYPE_NO_ERROR)
 		goto err;
 
+	device->channel_ready = g_get_monotonic_time();
+
 	err = device_dial_setup(device, fd);
 	if (err < 0)
 		goto err;
@@ -461,12 +646,63 @@ static DBusMessage *set_property_active(struct dundee_device *device,
 
 	dbus_message_iter_get_basic(var, &active);
 
+	/* Nothing to tear down while idling on a kept channel */
+	if (!active && device->ppp == NULL && device->chat != NULL)
+		return dbus_message_new_method_return(msg);
+
 	device->pending = dbus_message_ref(msg);
 
-	if (active)
+	if (!active) {
+		if (device->ppp)
+			g_at_ppp_shutdown(device->ppp);
+
+		return NULL;
+	}
+
+	device->connect_start = g_get_monotonic_time();
+	device->channel_ready = 0;
+	device->dialed = 0;
+
+	if (device->chat != NULL && device->ppp == NULL) {
+		device->channel_reused = TRUE;
+		device->channel_ready = device->connect_start;
+		device_dial(device);
+	} else {
+		device->channel_reused = FALSE;
 		device->driver->connect(device, connect_callback, device);
-	else if (device->ppp)
-		g_at_ppp_shutdown(device->ppp);
+	}
+
+	return NULL;
+}
+
+static DBusMessage *set_property_fast_reconnect(struct dundee_device *device,
+						DBusMessage *msg,
+						DBusMessageIter *var)
+{
+	DBusConnection *conn = ofono_dbus_get_connection();
+	ofono_bool_t value;
+
+	if (dbus_message_iter_get_arg_type(var) != DBUS_TYPE_BOOLEAN)
+		return __dundee_error_invalid_args(msg);
+
+	dbus_message_iter_get_basic(var, &value);
+
+	if (device->fast_reconnect == value)
+		return dbus_message_new_method_return(msg);
+
+	device->fast_reconnect = value;
+
+	/* Release a channel that is only being kept for the next connect */
+	if (!value && device->chat != NULL && device->ppp == NULL &&
+						device->pending == NULL)
+		device->driver->disconnect(device, disconnect_callback, device);
+
+	g_dbus_send_reply(conn, msg, DBUS_TYPE_INVALID);
+
+	ofono_dbus_signal_property_changed(conn, device->path,
+					DUNDEE_DEVICE_INTERFACE,
+					"FastReconnect", DBUS_TYPE_BOOLEAN,
+					&device->fast_reconnect);
 
 	return NULL;
 }
@@ -495,6 +731,9 @@ static DBusMessage *device_set_property(DBusConnection *conn,
 	if (g_str_equal(name, "Active"))
 		return set_property_active(device, msg, &var);
 
+	if (g_str_equal(name, "FastReconnect"))
+		return set_property_fast_reconnect(device, msg, &var);
+
 	return __dundee_error_invalid_args(msg);
 }
 
@@ -587,6 +826,10 @@ static void destroy_device(gpointer user)
 	g_free(device->settings.ip);
 	g_strfreev(device->settings.nameservers);
 
+	g_free(device->ipcp_local);
+	g_free(device->ipcp_dns1);
+	g_free(device->ipcp_dns2);
+
 	g_free(device->path);
 	g_free(device->name);
 
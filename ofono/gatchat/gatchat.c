@@ -90,6 +90,8 @@ struct at_chat {
 	gboolean suspended;			/* Are we suspended? */
 	GAtDebugFunc debugf;			/* debugging output function */
 	gpointer debug_data;			/* Data to pass to debug func */
+	GAtTraceFunc tracef;			/* raw traffic recorder */
+	gpointer trace_data;			/* Data to pass to trace func */
 	char *pdu_notify;			/* Unsolicited Resp w/ PDU */
 	GSList *response_lines;			/* char * lines of the response */
 	char *wakeup;				/* command sent to wakeup modem */
@@ -938,6 +940,7 @@ static void at_chat_suspend(struct at_chat *chat)
 	g_at_io_set_write_handler(chat->io, NULL, NULL);
 	g_at_io_set_read_handler(chat->io, NULL, NULL);
 	g_at_io_set_debug(chat->io, NULL, NULL);
+	g_at_io_set_trace(chat->io, NULL, NULL);
 }
 
 static void at_chat_resume(struct at_chat *chat)
@@ -952,6 +955,7 @@ static void at_chat_resume(struct at_chat *chat)
 	g_at_io_set_disconnect_function(chat->io, io_disconnect, chat);
 
 	g_at_io_set_debug(chat->io, chat->debugf, chat->debug_data);
+	g_at_io_set_trace(chat->io, chat->tracef, chat->trace_data);
 	g_at_io_set_read_handler(chat->io, new_bytes, chat);
 
 	if (g_queue_get_length(chat->command_queue) > 0)
@@ -1003,6 +1007,18 @@ static gboolean at_chat_set_debug(struct at_chat *chat,
 	return TRUE;
 }
 
+static gboolean at_chat_set_trace(struct at_chat *chat,
+					GAtTraceFunc func, gpointer user_data)
+{
+	chat->tracef = func;
+	chat->trace_data = user_data;
+
+	if (chat->io && !chat->suspended)
+		g_at_io_set_trace(chat->io, func, user_data);
+
+	return TRUE;
+}
+
 static gboolean at_chat_set_wakeup_command(struct at_chat *chat,
 						const char *cmd,
 						unsigned int timeout,
@@ -1468,6 +1484,15 @@ gboolean g_at_chat_set_debug(GAtChat *chat,
 	return at_chat_set_debug(chat->parent, func, user_data);
 }
 
+gboolean g_at_chat_set_trace(GAtChat *chat,
+				GAtTraceFunc func, gpointer user_data)
+{
+	if (chat == NULL || chat->group != 0)
+		return FALSE;
+
+	return at_chat_set_trace(chat->parent, func, user_data);
+}
+
 void g_at_chat_add_terminator(GAtChat *chat, char *terminator,
 					int len, gboolean success)
 {
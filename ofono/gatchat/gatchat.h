@@ -82,6 +82,13 @@ gboolean g_at_chat_set_disconnect_function(GAtChat *chat,
 gboolean g_at_chat_set_debug(GAtChat *chat,
 				GAtDebugFunc func, gpointer user_data);
 
+/*!
+ * If the function is not NULL, it gets called with the raw bytes read from
+ * or written to the GIOChannel, for recording the traffic in binary form.
+ */
+gboolean g_at_chat_set_trace(GAtChat *chat,
+				GAtTraceFunc func, gpointer user_data);
+
 /*!
  * Queue an AT command for execution.  The command contents are given
  * in cmd.  Once the command executes, the callback function given by
@@ -40,6 +40,8 @@
 
 #define BUFFER_SIZE	(2 * 2048)
 #define MAX_BUFFERS	64	/* Maximum number of in-flight write buffers */
+#define HIGH_WATERMARK	48	/* Ask the sender to stop at this many... */
+#define LOW_WATERMARK	16	/* ...and to go on again at this many */
 #define HDLC_OVERHEAD	256	/* Rough estimate of HDLC protocol overhead */
 
 #define HDLC_FLAG	0x7e	/* Flag sequence */
@@ -78,6 +80,11 @@ struct _GAtHDLC {
 	guint suspend_source;
 	GTimer *timer;
 	guint num_plus;
+	GAtFlowFunc flow_func;
+	gpointer flow_data;
+	gboolean flow_stopped;
+	guint flow_stops;	/* Number of times the sender was stopped */
+	guint xmit_drops;	/* Number of frames that didn't fit */
 };
 
 static inline void hdlc_record(GAtHDLC *hdlc, gboolean in,
@@ -496,6 +503,14 @@ static gboolean can_write_data(gpointer data)
 		write_buffer = g_queue_pop_head(hdlc->write_queue);
 		ring_buffer_free(write_buffer);
 		write_buffer = g_queue_peek_head(hdlc->write_queue);
+
+		if (hdlc->flow_stopped && g_queue_get_length(hdlc->write_queue)
+							<= LOW_WATERMARK) {
+			hdlc->flow_stopped = FALSE;
+
+			if (hdlc->flow_func)
+				hdlc->flow_func(FALSE, hdlc->flow_data);
+		}
 	}
 
 	if (ring_buffer_len(write_buffer) > 0)
@@ -530,7 +545,8 @@ GAtIO *g_at_hdlc_get_io(GAtHDLC *hdlc)
 
 #define NEED_ESCAPE(xmit_accm, c) xmit_accm[c >> 5] & (1 << (c & 0x1f))
 
-gboolean g_at_hdlc_send(GAtHDLC *hdlc, const unsigned char *data, gsize size)
+static gboolean hdlc_encode(GAtHDLC *hdlc, const unsigned char *data,
+								gsize size)
 {
 	struct ring_buffer* write_buffer = g_queue_peek_tail(hdlc->write_queue);
 
@@ -637,11 +653,55 @@ gboolean g_at_hdlc_send(GAtHDLC *hdlc, const unsigned char *data, gsize size)
 
 	ring_buffer_write_advance(write_buffer, pos);
 
+	return TRUE;
+}
+
+gboolean g_at_hdlc_send(GAtHDLC *hdlc, const unsigned char *data, gsize size)
+{
+	if (!hdlc_encode(hdlc, data, size)) {
+		hdlc->xmit_drops++;
+		return FALSE;
+	}
+
 	g_at_io_set_write_handler(hdlc->io, can_write_data, hdlc);
 
+	/*
+	 * Stop the sender well before the queue is full. Frames that
+	 * are already on their way still fit and don't get dropped.
+	 */
+	if (!hdlc->flow_stopped && hdlc->flow_func &&
+			g_queue_get_length(hdlc->write_queue) >=
+							HIGH_WATERMARK) {
+		hdlc->flow_stopped = TRUE;
+		hdlc->flow_stops++;
+		hdlc->flow_func(TRUE, hdlc->flow_data);
+	}
+
 	return TRUE;
 }
 
+void g_at_hdlc_set_flow_function(GAtHDLC *hdlc, GAtFlowFunc func,
+							gpointer user_data)
+{
+	if (hdlc == NULL)
+		return;
+
+	hdlc->flow_func = func;
+	hdlc->flow_data = user_data;
+}
+
+void g_at_hdlc_get_xmit_stats(GAtHDLC *hdlc, guint *stops, guint *drops)
+{
+	if (hdlc == NULL)
+		return;
+
+	if (stops)
+		*stops = hdlc->flow_stops;
+
+	if (drops)
+		*drops = hdlc->xmit_drops;
+}
+
 void g_at_hdlc_set_start_frame_marker(GAtHDLC *hdlc, gboolean marker)
 {
 	if (hdlc == NULL)
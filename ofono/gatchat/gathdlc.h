@@ -61,6 +61,10 @@ void g_at_hdlc_set_no_carrier_detect(GAtHDLC *hdlc, gboolean detect);
 void g_at_hdlc_set_suspend_function(GAtHDLC *hdlc, GAtSuspendFunc func,
 							gpointer user_data);
 
+void g_at_hdlc_set_flow_function(GAtHDLC *hdlc, GAtFlowFunc func,
+							gpointer user_data);
+void g_at_hdlc_get_xmit_stats(GAtHDLC *hdlc, guint *stops, guint *drops);
+
 void g_at_hdlc_suspend(GAtHDLC *hdlc);
 void g_at_hdlc_resume(GAtHDLC *hdlc);
 
@@ -52,21 +52,36 @@ struct _GAtIO {
 	gpointer write_data;			/* Write callback userdata */
 	GAtDebugFunc debugf;			/* debugging output function */
 	gpointer debug_data;			/* Data to pass to debug func */
+	GAtTraceFunc tracef;			/* raw traffic recorder */
+	gpointer trace_data;			/* Data to pass to trace func */
 	GAtDisconnectFunc write_done_func;	/* tx empty notifier */
 	gpointer write_done_data;		/* tx empty data */
 	gboolean destroyed;			/* Re-entrancy guard */
+	gboolean read_paused;			/* Reading is on hold */
+	gboolean read_pausing;			/* Paused watch not gone yet */
 };
 
 static void read_watcher_destroy_notify(gpointer user_data)
 {
 	GAtIO *io = user_data;
 
+	/* The watch was removed to pause reading, keep everything */
+	if (io->read_pausing) {
+		io->read_pausing = FALSE;
+
+		if (!io->destroyed || io->read_watch > 0)
+			return;
+	}
+
 	ring_buffer_free(io->buf);
 	io->buf = NULL;
 
 	io->debugf = NULL;
 	io->debug_data = NULL;
 
+	io->tracef = NULL;
+	io->trace_data = NULL;
+
 	io->read_watch = 0;
 	io->read_handler = NULL;
 	io->read_data = NULL;
@@ -108,6 +123,9 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 		g_at_util_debug_chat(TRUE, (char *)buf, rbytes,
 					io->debugf, io->debug_data);
 
+		if (io->tracef && rbytes > 0)
+			io->tracef(TRUE, buf, rbytes, io->trace_data);
+
 		read_count++;
 
 		total_read += rbytes;
@@ -143,13 +161,23 @@ gsize g_at_io_write(GAtIO *io, const gchar *data, gsize count)
 						count, &bytes_written, NULL);
 
 	if (status != G_IO_STATUS_NORMAL) {
-		g_source_remove(io->read_watch);
+		/* Go through the read watch to report the disconnect */
+		if (io->read_paused)
+			g_at_io_set_read_paused(io, FALSE);
+
+		if (io->read_watch > 0)
+			g_source_remove(io->read_watch);
+
 		return 0;
 	}
 
 	g_at_util_debug_chat(FALSE, data, bytes_written,
 				io->debugf, io->debug_data);
 
+	if (io->tracef && bytes_written > 0)
+		io->tracef(FALSE, (const unsigned char *) data, bytes_written,
+							io->trace_data);
+
 	return bytes_written;
 }
 
@@ -182,6 +210,14 @@ static gboolean can_write_data(GIOChannel *channel, GIOCondition cond,
 	return io->write_handler(io->write_data);
 }
 
+static guint add_read_watch(GAtIO *io)
+{
+	return g_io_add_watch_full(io->channel, G_PRIORITY_DEFAULT,
+				G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+				received_data, io,
+				read_watcher_destroy_notify);
+}
+
 static GAtIO *create_io(GIOChannel *channel, GIOFlags flags)
 {
 	GAtIO *io;
@@ -213,10 +249,7 @@ static GAtIO *create_io(GIOChannel *channel, GIOFlags flags)
 		goto error;
 
 	io->channel = channel;
-	io->read_watch = g_io_add_watch_full(channel, G_PRIORITY_DEFAULT,
-				G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
-				received_data, io,
-				read_watcher_destroy_notify);
+	io->read_watch = add_read_watch(io);
 
 	return io;
 
@@ -349,10 +382,45 @@ void g_at_io_unref(GAtIO *io)
 	 * destroyed already.  We have to wait until the read_watcher
 	 * destroy function gets called
 	 */
-	if (io->read_watch > 0)
+	if (io->read_watch > 0 || io->read_pausing) {
 		io->destroyed = TRUE;
-	else
+	} else {
+		/* Paused, the buffer wasn't released by the watch */
+		if (io->buf)
+			ring_buffer_free(io->buf);
+
 		g_free(io);
+	}
+}
+
+/*
+ * While paused, nothing is read from the channel and the data stays
+ * in the kernel buffers, which pushes back on the sender. Hangups
+ * aren't noticed until reading is resumed.
+ */
+gboolean g_at_io_set_read_paused(GAtIO *io, gboolean paused)
+{
+	if (io == NULL || io->channel == NULL)
+		return FALSE;
+
+	if (io->read_paused == paused)
+		return TRUE;
+
+	io->read_paused = paused;
+
+	if (paused) {
+		if (io->read_watch > 0) {
+			guint watch = io->read_watch;
+
+			io->read_watch = 0;
+			io->read_pausing = TRUE;
+			g_source_remove(watch);
+		}
+	} else if (io->read_watch == 0) {
+		io->read_watch = add_read_watch(io);
+	}
+
+	return TRUE;
 }
 
 gboolean g_at_io_set_disconnect_function(GAtIO *io,
@@ -378,6 +446,17 @@ gboolean g_at_io_set_debug(GAtIO *io, GAtDebugFunc func, gpointer user_data)
 	return TRUE;
 }
 
+gboolean g_at_io_set_trace(GAtIO *io, GAtTraceFunc func, gpointer user_data)
+{
+	if (io == NULL)
+		return FALSE;
+
+	io->tracef = func;
+	io->trace_data = user_data;
+
+	return TRUE;
+}
+
 void g_at_io_set_write_done(GAtIO *io, GAtDisconnectFunc func,
 				gpointer user_data)
 {
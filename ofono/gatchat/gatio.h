@@ -47,6 +47,7 @@ void g_at_io_unref(GAtIO *io);
 
 gboolean g_at_io_set_read_handler(GAtIO *io, GAtIOReadFunc read_handler,
 					gpointer user_data);
+gboolean g_at_io_set_read_paused(GAtIO *io, gboolean paused);
 gboolean g_at_io_set_write_handler(GAtIO *io, GAtIOWriteFunc write_handler,
 					gpointer user_data);
 void g_at_io_set_write_done(GAtIO *io, GAtDisconnectFunc func,
@@ -60,6 +61,7 @@ gboolean g_at_io_set_disconnect_function(GAtIO *io,
 			GAtDisconnectFunc disconnect, gpointer user_data);
 
 gboolean g_at_io_set_debug(GAtIO *io, GAtDebugFunc func, gpointer user_data);
+gboolean g_at_io_set_trace(GAtIO *io, GAtTraceFunc func, gpointer user_data);
 
 #ifdef __cplusplus
 }
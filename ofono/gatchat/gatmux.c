@@ -83,6 +83,8 @@ struct _GAtMux {
 	gpointer user_disconnect_data;		/* user disconnect data */
 	GAtDebugFunc debugf;			/* debugging output function */
 	gpointer debug_data;			/* Data to pass to debug func */
+	GAtTraceFunc tracef;			/* raw traffic recorder */
+	gpointer trace_data;			/* Data to pass to trace func */
 	GAtMuxChannel *dlcs[MAX_CHANNELS];	/* DLCs opened by the MUX */
 	guint8 newdata[BITMAP_SIZE];		/* Channels that got new data */
 	const GAtMuxDriver *driver;		/* Driver functions */
@@ -242,6 +244,10 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 					sizeof(mux->buf) - mux->buf_used,
 					&bytes_read, NULL);
 
+	if (mux->tracef && bytes_read > 0)
+		mux->tracef(TRUE, (unsigned char *) mux->buf + mux->buf_used,
+					bytes_read, mux->trace_data);
+
 	mux->buf_used += bytes_read;
 
 	if (bytes_read > 0 && mux->driver->feed_data) {
@@ -359,6 +365,9 @@ int g_at_mux_raw_write(GAtMux *mux, const void *data, int towrite)
 	g_io_channel_write_chars(mux->channel, (gchar *) data,
 					count, &bytes_written, NULL);
 
+	if (mux->tracef && bytes_written > 0)
+		mux->tracef(FALSE, data, bytes_written, mux->trace_data);
+
 	return bytes_written;
 }
 
@@ -728,6 +737,17 @@ gboolean g_at_mux_set_debug(GAtMux *mux, GAtDebugFunc func, gpointer user_data)
 	return TRUE;
 }
 
+gboolean g_at_mux_set_trace(GAtMux *mux, GAtTraceFunc func, gpointer user_data)
+{
+	if (mux == NULL)
+		return FALSE;
+
+	mux->tracef = func;
+	mux->trace_data = user_data;
+
+	return TRUE;
+}
+
 GIOChannel *g_at_mux_create_channel(GAtMux *mux)
 {
 	GAtMuxChannel *mux_channel;
@@ -68,6 +68,7 @@ gboolean g_at_mux_set_disconnect_function(GAtMux *mux,
 			GAtDisconnectFunc disconnect, gpointer user_data);
 
 gboolean g_at_mux_set_debug(GAtMux *mux, GAtDebugFunc func, gpointer user_data);
+gboolean g_at_mux_set_trace(GAtMux *mux, GAtTraceFunc func, gpointer user_data);
 
 GIOChannel *g_at_mux_create_channel(GAtMux *mux);
 
@@ -85,6 +85,7 @@ struct _GAtPPP {
 	gboolean suspended;
 	gboolean xmit_acfc;
 	gboolean xmit_pfc;
+	gboolean xmit_throttled;
 };
 
 void ppp_debug(GAtPPP *ppp, const char *str)
@@ -421,6 +422,8 @@ void ppp_ipcp_up_notify(GAtPPP *ppp, const char *local, const char *peer,
 	if (ppp_net_set_mtu(ppp->net, ppp->mtu) == FALSE)
 		DBG(ppp, "Unable to set MTU");
 
+	ppp_net_set_throttled(ppp->net, ppp->xmit_throttled);
+
 	ppp_enter_phase(ppp, PPP_PHASE_LINK_UP);
 
 	if (ppp->connect_cb)
@@ -541,6 +544,21 @@ static void ppp_proxy_suspend_net_interface(gpointer user_data)
 		ppp->suspend_func(ppp->suspend_data);
 }
 
+static void ppp_hdlc_flow(gboolean stop, gpointer user_data)
+{
+	GAtPPP *ppp = user_data;
+	guint stops = 0;
+	guint drops = 0;
+
+	g_at_hdlc_get_xmit_stats(ppp->hdlc, &stops, &drops);
+	DBG(ppp, "%s (stopped %u times, %u frames dropped)",
+				stop ? "stop" : "go", stops, drops);
+
+	/* Leave the packets in tun until the modem catches up */
+	ppp->xmit_throttled = stop;
+	ppp_net_set_throttled(ppp->net, stop);
+}
+
 gboolean g_at_ppp_listen(GAtPPP *ppp, GAtIO *io)
 {
 	ppp->hdlc = g_at_hdlc_new_from_io(io);
@@ -551,6 +569,7 @@ gboolean g_at_ppp_listen(GAtPPP *ppp, GAtIO *io)
 	g_at_hdlc_set_receive(ppp->hdlc, ppp_receive, ppp);
 	g_at_hdlc_set_suspend_function(ppp->hdlc,
 					ppp_proxy_suspend_net_interface, ppp);
+	g_at_hdlc_set_flow_function(ppp->hdlc, ppp_hdlc_flow, ppp);
 	g_at_io_set_disconnect_function(io, io_disconnect, ppp);
 
 	ppp_enter_phase(ppp, PPP_PHASE_ESTABLISHMENT);
@@ -570,6 +589,7 @@ gboolean g_at_ppp_open(GAtPPP *ppp, GAtIO *io)
 	g_at_hdlc_set_suspend_function(ppp->hdlc,
 					ppp_proxy_suspend_net_interface, ppp);
 	g_at_hdlc_set_no_carrier_detect(ppp->hdlc, TRUE);
+	g_at_hdlc_set_flow_function(ppp->hdlc, ppp_hdlc_flow, ppp);
 	g_at_io_set_disconnect_function(io, io_disconnect, ppp);
 
 	/* send an UP & OPEN events to the lcp layer */
@@ -806,6 +826,25 @@ void g_at_ppp_set_server_info(GAtPPP *ppp, const char *remote,
 	ipcp_set_server_info(ppp->ipcp, r, d1, d2);
 }
 
+void g_at_ppp_set_ipcp_hint(GAtPPP *ppp, const char *local,
+				const char *dns1, const char *dns2)
+{
+	guint32 l = 0;
+	guint32 d1 = 0;
+	guint32 d2 = 0;
+
+	if (local)
+		inet_pton(AF_INET, local, &l);
+
+	if (dns1)
+		inet_pton(AF_INET, dns1, &d1);
+
+	if (dns2)
+		inet_pton(AF_INET, dns2, &d2);
+
+	ipcp_set_client_hint(ppp->ipcp, l, d1, d2);
+}
+
 void g_at_ppp_set_acfc_enabled(GAtPPP *ppp, gboolean enabled)
 {
 	lcp_set_acfc_enabled(ppp->lcp, enabled);
@@ -35,6 +35,10 @@
 #include "ringbuffer.h"
 #include "gatrawip.h"
 
+/* Free space in the tun read buffer to stop and to resume reading at */
+#define TUN_STOP_SPACE		4096
+#define TUN_RESUME_SPACE	6144
+
 struct _GAtRawIP {
 	gint ref_count;
 	GAtIO *io;
@@ -44,6 +48,8 @@ struct _GAtRawIP {
 	struct ring_buffer *tun_write_buffer;
 	GAtDebugFunc debugf;
 	gpointer debug_data;
+	gboolean tun_stopped;
+	guint tun_stops;
 };
 
 GAtRawIP *g_at_rawip_new(GIOChannel *channel)
@@ -109,6 +115,26 @@ void g_at_rawip_unref(GAtRawIP *rawip)
 	g_free(rawip);
 }
 
+static void tun_flow(GAtRawIP *rawip, gboolean stop)
+{
+	if (rawip->tun_stopped == stop)
+		return;
+
+	rawip->tun_stopped = stop;
+	g_at_io_set_read_paused(rawip->tun_io, stop);
+
+	if (stop)
+		rawip->tun_stops++;
+
+	if (rawip->debugf) {
+		char *str = g_strdup_printf("tun %s (stopped %u times)",
+				stop ? "stop" : "go", rawip->tun_stops);
+
+		rawip->debugf(str, rawip->debug_data);
+		g_free(str);
+	}
+}
+
 static gboolean can_write_data(gpointer data)
 {
 	GAtRawIP *rawip = data;
@@ -125,6 +151,10 @@ static gboolean can_write_data(gpointer data)
 	bytes_written = g_at_io_write(rawip->io, (gchar *) buf, len);
 	ring_buffer_drain(rawip->write_buffer, bytes_written);
 
+	if (rawip->tun_stopped && ring_buffer_avail(rawip->write_buffer) >=
+							TUN_RESUME_SPACE)
+		tun_flow(rawip, FALSE);
+
 	if (ring_buffer_len(rawip->write_buffer) > 0)
 		return TRUE;
 
@@ -172,6 +202,14 @@ static void tun_bytes(struct ring_buffer *rbuf, gpointer user_data)
 
 	rawip->write_buffer = rbuf;
 
+	/*
+	 * The modem is slower than the network stack. Leave the packets
+	 * in tun rather than overflowing the buffer, which would take the
+	 * interface down.
+	 */
+	if (ring_buffer_avail(rbuf) < TUN_STOP_SPACE)
+		tun_flow(rawip, TRUE);
+
 	g_at_io_set_write_handler(rawip->io, can_write_data, rawip);
 }
 
@@ -235,6 +273,7 @@ void g_at_rawip_shutdown(GAtRawIP *rawip)
 
 	rawip->write_buffer = NULL;
 	rawip->tun_write_buffer = NULL;
+	rawip->tun_stopped = FALSE;
 
 	g_at_io_unref(rawip->tun_io);
 	rawip->tun_io = NULL;
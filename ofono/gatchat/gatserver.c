@@ -36,6 +36,8 @@
 #define BUF_SIZE 4096
 /* <cr><lf> + the max length of information text + <cr><lf> */
 #define MAX_TEXT_SIZE 2052
+/* Number of drained write buffers kept around for reuse */
+#define WRITE_POOL_SIZE 2
 /* #define WRITE_SCHEDULER_DEBUG 1 */
 
 enum ParserState {
@@ -116,11 +118,15 @@ struct _GAtServer {
 	GAtDebugFunc debugf;			/* Debugging output function */
 	gpointer debug_data;			/* Data to pass to debug func */
 	GHashTable *command_list;		/* List of AT commands */
+	struct at_command *basic[2][26];	/* [&]A-Z, owned by the above */
 	GQueue *write_queue;			/* Write buffer queue */
+	struct ring_buffer *write_pool[WRITE_POOL_SIZE];
+	guint write_pool_len;
 	guint max_read_attempts;		/* Max reads per select */
 	enum ParserState parser_state;
 	gboolean destroyed;			/* Re-entrancy guard */
 	char *last_line;			/* Last read line */
+	unsigned int line_size;			/* Allocated for last_line */
 	unsigned int cur_pos;			/* Where we are on the line */
 	GAtServerResult last_result;
 	gboolean final_sent;
@@ -135,7 +141,12 @@ static void server_parse_line(GAtServer *server);
 
 static struct ring_buffer *allocate_next(GAtServer *server)
 {
-	struct ring_buffer *buf = ring_buffer_new(BUF_SIZE);
+	struct ring_buffer *buf;
+
+	if (server->write_pool_len > 0)
+		buf = server->write_pool[--server->write_pool_len];
+	else
+		buf = ring_buffer_new(BUF_SIZE);
 
 	if (buf == NULL)
 		return NULL;
@@ -145,6 +156,40 @@ static struct ring_buffer *allocate_next(GAtServer *server)
 	return buf;
 }
 
+static void release_buffer(GAtServer *server, struct ring_buffer *buf)
+{
+	if (server->write_pool_len < WRITE_POOL_SIZE)
+		server->write_pool[server->write_pool_len++] = buf;
+	else
+		ring_buffer_free(buf);
+}
+
+static struct at_command **basic_command_slot(GAtServer *server,
+							const char *prefix)
+{
+	if (prefix[0] == '&') {
+		if (prefix[1] >= 'A' && prefix[1] <= 'Z' && prefix[2] == '\0')
+			return &server->basic[1][prefix[1] - 'A'];
+	} else if (prefix[0] >= 'A' && prefix[0] <= 'Z' && prefix[1] == '\0')
+		return &server->basic[0][prefix[0] - 'A'];
+
+	return NULL;
+}
+
+static struct at_command *command_lookup(GAtServer *server,
+							const char *prefix)
+{
+	struct at_command **slot = basic_command_slot(server, prefix);
+
+	if (slot != NULL)
+		return *slot;
+
+	if (server->command_list == NULL)
+		return NULL;
+
+	return g_hash_table_lookup(server->command_list, prefix);
+}
+
 static void send_common(GAtServer *server, const char *buf, unsigned int len)
 {
 	gsize towrite = len;
@@ -589,21 +634,21 @@ static void at_command_notify(GAtServer *server, char *command,
 				char *prefix, GAtServerRequestType type)
 {
 	struct at_command *node;
+	GSList line = { command, NULL };
 	GAtResult result;
 
-	node = g_hash_table_lookup(server->command_list, prefix);
+	node = command_lookup(server, prefix);
 
 	if (node == NULL) {
 		g_at_server_send_final(server, G_AT_SERVER_RESULT_ERROR);
 		return;
 	}
 
-	result.lines = g_slist_prepend(NULL, command);
+	/* The result only lives for the duration of the callback */
+	result.lines = &line;
 	result.final_or_pdu = 0;
 
 	node->notify(server, type, &result, node->user_data);
-
-	g_slist_free(result.lines);
 }
 
 static unsigned int parse_extended_command(GAtServer *server, char *buf)
@@ -935,7 +980,7 @@ out:
 	return res;
 }
 
-static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
+static gboolean extract_line(GAtServer *p, struct ring_buffer *rbuf)
 {
 	unsigned int wrap = ring_buffer_len_no_wrap(rbuf);
 	unsigned int pos = 0;
@@ -968,10 +1013,17 @@ static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
 	/* We will strip AT and S3 */
 	line_length -= 3;
 
-	line = g_try_new(char, line_length + 1);
+	/* Reuse the previous line buffer if it's big enough */
+	if ((unsigned int) line_length + 1 > p->line_size) {
+		g_free(p->last_line);
+		p->last_line = g_try_new(char, line_length + 1);
+		p->line_size = p->last_line ? line_length + 1 : 0;
+	}
+
+	line = p->last_line;
 	if (line == NULL) {
 		ring_buffer_drain(rbuf, p->read_so_far);
-		return NULL;
+		return FALSE;
 	}
 
 	/* Strip leading whitespace + AT */
@@ -1006,7 +1058,7 @@ static char *extract_line(GAtServer *p, struct ring_buffer *rbuf)
 
 	line[i] = '\0';
 
-	return line;
+	return TRUE;
 }
 
 static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
@@ -1055,12 +1107,9 @@ static void new_bytes(struct ring_buffer *rbuf, gpointer user_data)
 
 		case PARSER_RESULT_COMMAND:
 		{
-			g_free(p->last_line);
-
-			p->last_line = extract_line(p, rbuf);
 			p->cur_pos = 0;
 
-			if (p->last_line)
+			if (extract_line(p, rbuf))
 				server_parse_line(p);
 			else
 				g_at_server_send_final(p,
@@ -1155,7 +1204,7 @@ static gboolean can_write_data(gpointer data)
 	if ((ring_buffer_len(write_buf) == 0) &&
 			(g_queue_get_length(server->write_queue) > 1)) {
 		write_buf = g_queue_pop_head(server->write_queue);
-		ring_buffer_free(write_buf);
+		release_buffer(server, write_buf);
 		write_buf = g_queue_peek_head(server->write_queue);
 	}
 
@@ -1180,6 +1229,10 @@ static void g_at_server_cleanup(GAtServer *server)
 	/* Cleanup pending data to write */
 	write_queue_free(server->write_queue);
 
+	while (server->write_pool_len > 0)
+		ring_buffer_free(server->write_pool[--server->write_pool_len]);
+
+	memset(server->basic, 0, sizeof(server->basic));
 	g_hash_table_destroy(server->command_list);
 	server->command_list = NULL;
 
@@ -1432,6 +1485,7 @@ gboolean g_at_server_register(GAtServer *server, const char *prefix,
 					GDestroyNotify destroy_notify)
 {
 	struct at_command *node;
+	struct at_command **slot;
 
 	if (server == NULL || server->command_list == NULL)
 		return FALSE;
@@ -1452,12 +1506,17 @@ gboolean g_at_server_register(GAtServer *server, const char *prefix,
 
 	g_hash_table_replace(server->command_list, g_strdup(prefix), node);
 
+	slot = basic_command_slot(server, prefix);
+	if (slot != NULL)
+		*slot = node;
+
 	return TRUE;
 }
 
 gboolean g_at_server_unregister(GAtServer *server, const char *prefix)
 {
 	struct at_command *node;
+	struct at_command **slot;
 
 	if (server == NULL || server->command_list == NULL)
 		return FALSE;
@@ -1469,6 +1528,10 @@ gboolean g_at_server_unregister(GAtServer *server, const char *prefix)
 	if (node == NULL)
 		return FALSE;
 
+	slot = basic_command_slot(server, prefix);
+	if (slot != NULL)
+		*slot = NULL;
+
 	g_hash_table_remove(server->command_list, prefix);
 
 	return TRUE;
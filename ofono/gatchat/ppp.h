@@ -96,6 +96,8 @@ void lcp_set_pfc_enabled(struct pppcp_data *pppcp, gboolean enabled);
 /* IPCP related functions */
 struct pppcp_data *ipcp_new(GAtPPP *ppp, gboolean is_server, guint32 ip);
 void ipcp_free(struct pppcp_data *data);
+void ipcp_set_client_hint(struct pppcp_data *ipcp, guint32 local_addr,
+				guint32 dns1, guint32 dns2);
 void ipcp_set_server_info(struct pppcp_data *ipcp, guint32 peer_addr,
 				guint32 dns1, guint32 dns2);
 
@@ -127,6 +129,7 @@ void ppp_net_free(struct ppp_net *net);
 gboolean ppp_net_set_mtu(struct ppp_net *net, guint16 mtu);
 void ppp_net_suspend_interface(struct ppp_net *net);
 void ppp_net_resume_interface(struct ppp_net *net);
+void ppp_net_set_throttled(struct ppp_net *net, gboolean throttled);
 
 /* PPP functions related to main GAtPPP object */
 void ppp_debug(GAtPPP *ppp, const char *str);
@@ -141,6 +141,30 @@ void ipcp_set_server_info(struct pppcp_data *pppcp, guint32 peer_addr,
 	ipcp->dns2 = dns2;
 }
 
+/*
+ * Seeds the first Configure-Request with the values the peer handed out
+ * last time. A peer that still agrees can Ack straight away instead of
+ * going through a Nak round trip; if it doesn't, the usual Nak handling
+ * corrects the values.
+ */
+void ipcp_set_client_hint(struct pppcp_data *pppcp, guint32 local_addr,
+				guint32 dns1, guint32 dns2)
+{
+	struct ipcp_data *ipcp = pppcp_get_data(pppcp);
+
+	if (ipcp->is_server || local_addr == 0)
+		return;
+
+	ipcp->local_addr = local_addr;
+	ipcp->dns1 = dns1;
+	ipcp->dns2 = dns2;
+	ipcp->req_options = REQ_OPTION_IPADDR | REQ_OPTION_DNS1 |
+				REQ_OPTION_DNS2;
+
+	ipcp_generate_config_options(ipcp);
+	pppcp_set_local_options(pppcp, ipcp->options, ipcp->options_len);
+}
+
 static void ipcp_up(struct pppcp_data *pppcp)
 {
 	struct ipcp_data *ipcp = pppcp_get_data(pppcp);
@@ -47,6 +47,8 @@ struct ppp_net {
 	guint watch;
 	gint mtu;
 	struct ppp_header *ppp_packet;
+	gboolean suspended;
+	gboolean throttled;
 };
 
 gboolean ppp_net_set_mtu(struct ppp_net *net, guint16 mtu)
@@ -109,8 +111,10 @@ static gboolean ppp_net_callback(GIOChannel *channel, GIOCondition cond,
 	gsize bytes_read;
 	gchar *buf = (gchar *) net->ppp_packet->info;
 
-	if (cond & (G_IO_NVAL | G_IO_ERR | G_IO_HUP))
+	if (cond & (G_IO_NVAL | G_IO_ERR | G_IO_HUP)) {
+		net->watch = 0;
 		return FALSE;
+	}
 
 	if (cond & G_IO_IN) {
 		/* leave space to add PPP protocol field */
@@ -120,12 +124,30 @@ static gboolean ppp_net_callback(GIOChannel *channel, GIOCondition cond,
 			ppp_transmit(net->ppp, (guint8 *) net->ppp_packet,
 					bytes_read);
 
-		if (status != G_IO_STATUS_NORMAL && status != G_IO_STATUS_AGAIN)
+		if (status != G_IO_STATUS_NORMAL &&
+					status != G_IO_STATUS_AGAIN) {
+			net->watch = 0;
 			return FALSE;
+		}
 	}
 	return TRUE;
 }
 
+/* Only read from tun while the link is up and the modem keeps up */
+static void ppp_net_update_watch(struct ppp_net *net)
+{
+	if (net->suspended || net->throttled) {
+		if (net->watch) {
+			g_source_remove(net->watch);
+			net->watch = 0;
+		}
+	} else if (net->watch == 0) {
+		net->watch = g_io_add_watch(net->channel,
+				G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+				ppp_net_callback, net);
+	}
+}
+
 const char *ppp_net_get_interface(struct ppp_net *net)
 {
 	return net->if_name;
@@ -187,10 +209,8 @@ struct ppp_net *ppp_net_new(GAtPPP *ppp, int fd)
 	g_io_channel_set_buffered(channel, FALSE);
 
 	net->channel = channel;
-	net->watch = g_io_add_watch(channel,
-			G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
-			ppp_net_callback, net);
 	net->ppp = ppp;
+	ppp_net_update_watch(net);
 
 	net->mtu = MAX_PACKET;
 	return net;
@@ -229,19 +249,24 @@ void ppp_net_suspend_interface(struct ppp_net *net)
 	if (net == NULL || net->channel == NULL)
 		return;
 
-	if (net->watch == 0)
+	net->suspended = TRUE;
+	ppp_net_update_watch(net);
+}
+
+void ppp_net_resume_interface(struct ppp_net *net)
+{
+	if (net == NULL || net->channel == NULL)
 		return;
 
-	g_source_remove(net->watch);
-	net->watch = 0;
+	net->suspended = FALSE;
+	ppp_net_update_watch(net);
 }
 
-void ppp_net_resume_interface(struct ppp_net *net)
+void ppp_net_set_throttled(struct ppp_net *net, gboolean throttled)
 {
 	if (net == NULL || net->channel == NULL)
 		return;
 
-	net->watch = g_io_add_watch(net->channel,
-			G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
-			ppp_net_callback, net);
+	net->throttled = throttled;
+	ppp_net_update_watch(net);
 }
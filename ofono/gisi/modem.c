@@ -42,15 +42,24 @@
 	if ((m) != NULL && (m)->debug != NULL)		\
 		m->debug("gisi: "fmt, ##__VA_ARGS__);
 
+/*
+ * Pending operations are indexed the way the incoming messages are
+ * dispatched: responses by UTID, subscriptions (REQ, IND and NTF) by
+ * message ID. Version queries are few and stay in a list.
+ */
 struct _GIsiServiceMux {
 	GIsiModem *modem;
-	GSList *pending;
+	GIsiPending *resp[256];		/* By UTID */
+	GPtrArray *subs[256];		/* By message ID */
+	GSList *common;
 	GIsiVersion version;
 	uint8_t resource;
 	uint8_t last_utid;
 	uint16_t object;
 	unsigned subscriptions;
 	unsigned registrations;
+	unsigned dispatching;
+	gboolean compact;
 	gboolean reachable;
 	gboolean version_pending;
 };
@@ -60,6 +69,7 @@ struct _GIsiModem {
 	unsigned index;
 	uint8_t device;
 	GHashTable *services;
+	GIsiServiceMux *mux[256];	/* By resource */
 	gboolean subs_source;
 	int req_fd;
 	int ind_fd;
@@ -88,7 +98,7 @@ static GIsiServiceMux *service_get(GIsiModem *modem, uint8_t resource)
 	GIsiServiceMux *mux;
 	int key = resource;
 
-	mux = g_hash_table_lookup(modem->services, GINT_TO_POINTER(key));
+	mux = modem->mux[resource];
 	if (mux != NULL)
 		return mux;
 
@@ -97,6 +107,7 @@ static GIsiServiceMux *service_get(GIsiModem *modem, uint8_t resource)
 		return NULL;
 
 	g_hash_table_insert(modem->services, GINT_TO_POINTER(key), mux);
+	modem->mux[resource] = mux;
 
 	mux->modem = modem;
 	mux->resource = resource;
@@ -108,12 +119,85 @@ static GIsiServiceMux *service_get(GIsiModem *modem, uint8_t resource)
 	return mux;
 }
 
-static gint utid_equal(gconstpointer a, gconstpointer b)
+static gboolean service_utid_busy(GIsiServiceMux *mux, uint8_t utid)
+{
+	GSList *l;
+
+	if (mux->resp[utid] != NULL)
+		return TRUE;
+
+	for (l = mux->common; l != NULL; l = l->next) {
+		GIsiPending *op = l->data;
+
+		if (op->utid == utid)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void service_add_pending(GIsiServiceMux *mux, GIsiPending *op)
+{
+	switch (op->type) {
+	case GISI_MESSAGE_TYPE_RESP:
+		mux->resp[op->utid] = op;
+		break;
+	case GISI_MESSAGE_TYPE_COMMON:
+		mux->common = g_slist_prepend(mux->common, op);
+		break;
+	default:
+		if (mux->subs[op->msgid] == NULL)
+			mux->subs[op->msgid] = g_ptr_array_new();
+
+		g_ptr_array_add(mux->subs[op->msgid], op);
+		break;
+	}
+}
+
+static void service_remove_pending(GIsiServiceMux *mux, GIsiPending *op)
+{
+	GPtrArray *subs;
+	guint i;
+
+	switch (op->type) {
+	case GISI_MESSAGE_TYPE_RESP:
+		if (mux->resp[op->utid] == op)
+			mux->resp[op->utid] = NULL;
+		break;
+	case GISI_MESSAGE_TYPE_COMMON:
+		mux->common = g_slist_remove(mux->common, op);
+		break;
+	default:
+		subs = mux->subs[op->msgid];
+		if (subs == NULL)
+			break;
+
+		/* Don't shift the array from under service_dispatch() */
+		for (i = 0; i < subs->len; i++) {
+			if (subs->pdata[i] != op)
+				continue;
+
+			if (mux->dispatching) {
+				subs->pdata[i] = NULL;
+				mux->compact = TRUE;
+			} else {
+				g_ptr_array_remove_index(subs, i);
+			}
+			break;
+		}
+		break;
+	}
+}
+
+static void service_compact(GIsiServiceMux *mux)
 {
-	const GIsiPending *pa = a;
-	const GIsiPending *pb = b;
+	unsigned i;
+
+	mux->compact = FALSE;
 
-	return pa->utid - pb->utid;
+	for (i = 0; i < G_N_ELEMENTS(mux->subs); i++)
+		if (mux->subs[i] != NULL)
+			while (g_ptr_array_remove(mux->subs[i], NULL));
 }
 
 static const char *pend_type_to_str(enum GIsiMessageType type)
@@ -154,7 +238,7 @@ static void pending_remove_and_dispatch(GIsiPending *op, GIsiMessage *msg)
 {
 	GIsiModem *modem;
 
-	op->service->pending = g_slist_remove(op->service->pending, op);
+	service_remove_pending(op->service, op);
 
 	if (op->notify == NULL || msg == NULL)
 		goto destroy;
@@ -184,48 +268,61 @@ static void service_dispatch(GIsiServiceMux *mux, GIsiMessage *msg,
 {
 	uint8_t msgid = g_isi_msg_id(msg);
 	uint8_t utid = g_isi_msg_utid(msg);
+	GPtrArray *subs = mux->subs[msgid];
+	GIsiPending *resp;
+	guint i, n;
 
-	GSList *l = mux->pending;
+	/*
+	 * Version query responses are dispatched based on the pending
+	 * type and the message ID. Some of these may be synthesized, but
+	 * nevertheless need to be removed.
+	 */
+	if (msgid == COMMON_MESSAGE) {
+		GSList *l = mux->common;
 
-	while (l != NULL) {
-		GSList *next = l->next;
-		GIsiPending *pend = l->data;
+		while (l != NULL) {
+			GSList *next = l->next;
+			GIsiPending *pend = l->data;
 
-		/*
-		 * REQs, NTFs and INDs are dispatched on message ID.  While
-		 * INDs have the unique transaction ID set to zero, NTFs
-		 * typically mirror the UTID of the request that set up the
-		 * session, and REQs can naturally have any transaction ID.
-		 *
-		 * RESPs are dispatched on unique transaction ID, explicitly
-		 * ignoring the msgid.  A RESP also completes a transaction,
-		 * so it needs to be removed after being notified of.
-		 *
-		 * Version query responses are dispatched in a similar fashion
-		 * as RESPs, but based on the pending type and the message ID.
-		 * Some of these may be synthesized, but nevertheless need to
-		 * be removed.
-		 */
-		if (pend->type < GISI_MESSAGE_TYPE_RESP
-				&& pend->msgid == msgid) {
+			if (pend->msgid == COMM_ISI_VERSION_GET_REQ)
+				pending_remove_and_dispatch(pend, msg);
 
-			pending_dispatch(pend, msg);
+			l = next;
+		}
+	}
 
-		} else if (pend->type == GISI_MESSAGE_TYPE_RESP &&
-				!is_indication && pend->utid == utid) {
+	/*
+	 * RESPs are dispatched on unique transaction ID, explicitly
+	 * ignoring the msgid.  A RESP also completes a transaction,
+	 * so it needs to be removed after being notified of. Nobody
+	 * else gets to see it.
+	 */
+	resp = is_indication ? NULL : mux->resp[utid];
+	if (resp != NULL) {
+		pending_remove_and_dispatch(resp, msg);
+		return;
+	}
 
-			pending_remove_and_dispatch(pend, msg);
-			break;
+	/*
+	 * REQs, NTFs and INDs are dispatched on message ID.  While
+	 * INDs have the unique transaction ID set to zero, NTFs
+	 * typically mirror the UTID of the request that set up the
+	 * session, and REQs can naturally have any transaction ID.
+	 */
+	if (subs == NULL)
+		return;
 
-		} else if (pend->type == GISI_MESSAGE_TYPE_COMMON &&
-				msgid == COMMON_MESSAGE &&
-				pend->msgid == COMM_ISI_VERSION_GET_REQ) {
+	mux->dispatching++;
 
-			pending_remove_and_dispatch(pend, msg);
-		}
+	for (i = 0, n = subs->len; i < n; i++) {
+		GIsiPending *pend = subs->pdata[i];
 
-		l = next;
+		if (pend != NULL)
+			pending_dispatch(pend, msg);
 	}
+
+	if (!--mux->dispatching && mux->compact)
+		service_compact(mux);
 }
 
 static void common_message_decode(GIsiServiceMux *mux, GIsiMessage *msg)
@@ -312,8 +409,7 @@ static gboolean isi_callback(GIOChannel *channel, GIOCondition cond,
 			modem->trace(&msg, NULL);
 
 		key = addr.spn_resource;
-		mux = g_hash_table_lookup(modem->services,
-						GINT_TO_POINTER(key));
+		mux = modem->mux[key];
 		if (mux == NULL) {
 			/*
 			 * Unfortunately, the FW report has the wrong
@@ -458,6 +554,7 @@ static void service_finalize(gpointer value)
 {
 	GIsiServiceMux *mux = value;
 	GIsiModem *modem = mux->modem;
+	unsigned i;
 
 	if (mux->subscriptions > 0)
 		modem_subs_update_when_idle(modem);
@@ -465,8 +562,21 @@ static void service_finalize(gpointer value)
 	if (mux->registrations > 0)
 		service_name_deregister(mux);
 
-	g_slist_foreach(mux->pending, pending_destroy, NULL);
-	g_slist_free(mux->pending);
+	modem->mux[mux->resource] = NULL;
+
+	for (i = 0; i < G_N_ELEMENTS(mux->resp); i++)
+		pending_destroy(mux->resp[i], NULL);
+
+	for (i = 0; i < G_N_ELEMENTS(mux->subs); i++) {
+		if (mux->subs[i] == NULL)
+			continue;
+
+		g_ptr_array_foreach(mux->subs[i], pending_destroy, NULL);
+		g_ptr_array_free(mux->subs[i], TRUE);
+	}
+
+	g_slist_foreach(mux->common, pending_destroy, NULL);
+	g_slist_free(mux->common);
 	g_free(mux);
 }
 
@@ -781,7 +891,7 @@ GIsiPending *g_isi_request_vsendto(GIsiModem *modem, struct sockaddr_pn *dst,
 	resp->destroy = destroy;
 	resp->data = data;
 
-	if (g_slist_find_custom(mux->pending, resp, utid_equal)) {
+	if (service_utid_busy(mux, resp->utid)) {
 		/*
 		 * FIXME: perhaps retry with randomized access after
 		 * initial miss. Although if the rate at which
@@ -814,7 +924,7 @@ GIsiPending *g_isi_request_vsendto(GIsiModem *modem, struct sockaddr_pn *dst,
 		goto error;
 	}
 
-	mux->pending = g_slist_prepend(mux->pending, resp);
+	service_add_pending(mux, resp);
 
 	if (timeout > 0)
 		resp->timeout = g_timeout_add_seconds(timeout, resp_timeout,
@@ -853,7 +963,7 @@ void g_isi_pending_remove(GIsiPending *op)
 		return;
 	}
 
-	op->service->pending = g_slist_remove(op->service->pending, op);
+	service_remove_pending(op->service, op);
 
 	pending_destroy(op, NULL);
 }
@@ -885,32 +995,44 @@ void g_isi_pending_set_owner(GIsiPending *op, gpointer owner)
 	op->owner = owner;
 }
 
+static GSList *owned_prepend(GSList *owned, GIsiPending *op,
+				gpointer owner)
+{
+	if (op == NULL || op->owner != owner)
+		return owned;
+
+	return g_slist_prepend(owned, op);
+}
+
 void g_isi_remove_pending_by_owner(GIsiModem *modem, uint8_t resource,
 					gpointer owner)
 {
 	GIsiServiceMux *mux;
 	GSList *l;
-	GSList *next;
 	GIsiPending *op;
 	GSList *owned = NULL;
+	unsigned i, j;
 
 	mux = service_get(modem, resource);
 	if (mux == NULL)
 		return;
 
-	for (l = mux->pending; l != NULL; l = next) {
-		next = l->next;
-		op = l->data;
+	for (l = mux->common; l != NULL; l = l->next)
+		owned = owned_prepend(owned, l->data, owner);
 
-		if (op->owner != owner)
-			continue;
+	for (i = 0; i < G_N_ELEMENTS(mux->resp); i++)
+		owned = owned_prepend(owned, mux->resp[i], owner);
 
-		mux->pending = g_slist_remove_link(mux->pending, l);
+	for (i = 0; i < G_N_ELEMENTS(mux->subs); i++) {
+		GPtrArray *subs = mux->subs[i];
 
-		l->next = owned;
-		owned = l;
+		for (j = 0; subs != NULL && j < subs->len; j++)
+			owned = owned_prepend(owned, subs->pdata[j], owner);
 	}
 
+	for (l = owned; l != NULL; l = l->next)
+		service_remove_pending(mux, l->data);
+
 	for (l = owned; l != NULL; l = l->next) {
 		op = l->data;
 
@@ -946,7 +1068,7 @@ GIsiPending *g_isi_ntf_subscribe(GIsiModem *modem, uint8_t resource,
 	ntf->destroy = destroy;
 	ntf->msgid = msgid;
 
-	mux->pending = g_slist_append(mux->pending, ntf);
+	service_add_pending(mux, ntf);
 
 	ISIDBG(modem, "Subscribed to %s (%p) [res=0x%02X, id=0x%02X]",
 		pend_type_to_str(ntf->type), ntf, resource, msgid);
@@ -980,7 +1102,7 @@ GIsiPending *g_isi_service_bind(GIsiModem *modem, uint8_t resource,
 	srv->destroy = destroy;
 	srv->msgid = msgid;
 
-	mux->pending = g_slist_append(mux->pending, srv);
+	service_add_pending(mux, srv);
 
 	ISIDBG(modem, "Bound service for %s (%p) [res=0x%02X, id=0x%02X]",
 		pend_type_to_str(srv->type), srv, resource, msgid);
@@ -1016,7 +1138,7 @@ GIsiPending *g_isi_ind_subscribe(GIsiModem *modem, uint8_t resource,
 	ind->destroy = destroy;
 	ind->msgid = msgid;
 
-	mux->pending = g_slist_append(mux->pending, ind);
+	service_add_pending(mux, ind);
 
 	ISIDBG(modem, "Subscribed for %s (%p) [res=0x%02X, id=0x%02X]",
 		pend_type_to_str(ind->type), ind, resource, msgid);
@@ -1164,7 +1286,7 @@ static int version_get_send(GIsiModem *modem, GIsiPending *ping)
 	};
 	ssize_t ret;
 
-	if (g_slist_find_custom(mux->pending, ping, utid_equal))
+	if (service_utid_busy(mux, ping->utid))
 		return -EBUSY;
 
 	ret = sendto(modem->req_fd, msg, sizeof(msg), MSG_NOSIGNAL,
@@ -1246,7 +1368,7 @@ GIsiPending *g_isi_resource_ping(GIsiModem *modem, uint8_t resource,
 
 	ping->timeout = g_timeout_add_seconds(COMMON_TIMEOUT, resp_timeout,
 						ping);
-	mux->pending = g_slist_prepend(mux->pending, ping);
+	service_add_pending(mux, ping);
 	mux->version_pending = TRUE;
 
 	ISIDBG(modem, "Ping sent %s (%p) [res=0x%02X]",
@@ -748,6 +748,7 @@ static void ril_suspend(struct ril_s *ril)
 	g_ril_io_set_write_handler(ril->io, NULL, NULL);
 	g_ril_io_set_read_handler(ril->io, NULL, NULL);
 	g_ril_io_set_debug(ril->io, NULL, NULL);
+	g_ril_io_set_trace(ril->io, NULL, NULL);
 }
 
 static gboolean ril_set_debug(struct ril_s *ril,
@@ -761,6 +762,17 @@ static gboolean ril_set_debug(struct ril_s *ril,
 	return TRUE;
 }
 
+static gboolean ril_set_tracef(struct ril_s *ril,
+				GRilTraceFunc func, gpointer user_data)
+{
+	if (ril->io == NULL)
+		return FALSE;
+
+	g_ril_io_set_trace(ril->io, func, user_data);
+
+	return TRUE;
+}
+
 static void ril_unref(struct ril_s *ril)
 {
 	gboolean is_zero;
@@ -1226,6 +1238,14 @@ gboolean g_ril_set_debugf(GRil *ril,
 	return ril_set_debug(ril->parent, func, user_data);
 }
 
+gboolean g_ril_set_tracef(GRil *ril, GRilTraceFunc func, gpointer user_data)
+{
+	if (ril == NULL || ril->group != 0)
+		return FALSE;
+
+	return ril_set_tracef(ril->parent, func, user_data);
+}
+
 gboolean g_ril_set_vendor_print_msg_id_funcs(GRil *ril,
 					GRilMsgIdToStrFunc req_to_string,
 					GRilMsgIdToStrFunc unsol_to_string)
@@ -138,6 +138,12 @@ gboolean g_ril_set_slot(GRil *ril, int slot);
  */
 gboolean g_ril_set_debugf(GRil *ril, GRilDebugFunc func, gpointer user_data);
 
+/*!
+ * If the function is not NULL, it gets called with the raw bytes read from
+ * or written to the GIOChannel, for recording the traffic in binary form.
+ */
+gboolean g_ril_set_tracef(GRil *ril, GRilTraceFunc func, gpointer user_data);
+
 gboolean g_ril_set_vendor_print_msg_id_funcs(GRil *ril,
 					GRilMsgIdToStrFunc req_to_string,
 					GRilMsgIdToStrFunc unsol_to_string);
@@ -52,6 +52,8 @@ struct _GRilIO {
 	gpointer write_data;			/* Write callback userdata */
 	GRilDebugFunc debugf;			/* debugging output function */
 	gpointer debug_data;			/* Data to pass to debug func */
+	GRilTraceFunc tracef;			/* raw traffic recorder */
+	gpointer trace_data;			/* Data to pass to trace func */
 	GRilDisconnectFunc write_done_func;	/* tx empty notifier */
 	gpointer write_done_data;		/* tx empty data */
 	gboolean destroyed;			/* Re-entrancy guard */
@@ -67,6 +69,9 @@ static void read_watcher_destroy_notify(gpointer user_data)
 	io->debugf = NULL;
 	io->debug_data = NULL;
 
+	io->tracef = NULL;
+	io->trace_data = NULL;
+
 	io->read_watch = 0;
 	io->read_handler = NULL;
 	io->read_data = NULL;
@@ -109,6 +114,9 @@ static gboolean received_data(GIOChannel *channel, GIOCondition cond,
 		g_ril_util_debug_hexdump(TRUE, (guchar *) buf, rbytes,
 						io->debugf, io->debug_data);
 
+		if (io->tracef && rbytes > 0)
+			io->tracef(TRUE, buf, rbytes, io->trace_data);
+
 		read_count++;
 
 		total_read += rbytes;
@@ -151,6 +159,10 @@ gsize g_ril_io_write(GRilIO *io, const gchar *data, gsize count)
 	g_ril_util_debug_hexdump(FALSE, (guchar *) data, bytes_written,
 				io->debugf, io->debug_data);
 
+	if (io->tracef && bytes_written > 0)
+		io->tracef(FALSE, (const unsigned char *) data, bytes_written,
+							io->trace_data);
+
 	return bytes_written;
 }
 
@@ -381,6 +393,17 @@ gboolean g_ril_io_set_debug(GRilIO *io, GRilDebugFunc func, gpointer user_data)
 	return TRUE;
 }
 
+gboolean g_ril_io_set_trace(GRilIO *io, GRilTraceFunc func, gpointer user_data)
+{
+	if (io == NULL)
+		return FALSE;
+
+	io->tracef = func;
+	io->trace_data = user_data;
+
+	return TRUE;
+}
+
 void g_ril_io_set_write_done(GRilIO *io, GRilDisconnectFunc func,
 				gpointer user_data)
 {
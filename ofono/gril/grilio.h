@@ -63,6 +63,7 @@ gboolean g_ril_io_set_disconnect_function(GRilIO *io,
 			GRilDisconnectFunc disconnect, gpointer user_data);
 
 gboolean g_ril_io_set_debug(GRilIO *io, GRilDebugFunc func, gpointer user_data);
+gboolean g_ril_io_set_trace(GRilIO *io, GRilTraceFunc func, gpointer user_data);
 
 #ifdef __cplusplus
 }
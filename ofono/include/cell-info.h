@@ -129,6 +129,9 @@ void ofono_cell_info_set_enabled(struct ofono_cell_info *ci, ofono_bool_t on);
 int ofono_cell_compare_location(const struct ofono_cell *c1,
 					const struct ofono_cell *c2);
 
+/* Since 1.29+git9 */
+unsigned int ofono_cell_hash_location(const struct ofono_cell *cell);
+
 #ifdef __cplusplus
 }
 #endif
@@ -110,6 +110,12 @@ void ofono_emulator_set_hf_indicator_active(struct ofono_emulator *em,
 						int indicator,
 						ofono_bool_t active);
 
+/* Since 1.29+git9 */
+void ofono_emulator_set_indicator_interval(struct ofono_emulator *em,
+							unsigned int ms);
+unsigned int ofono_emulator_get_suppressed_indicators(
+					struct ofono_emulator *em);
+
 void ofono_emulator_set_handsfree_card(struct ofono_emulator *em,
 					struct ofono_handsfree_card *card);
 
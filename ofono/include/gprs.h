@@ -91,6 +91,10 @@ const struct ofono_gprs_primary_context *ofono_gprs_context_settings_by_type
 /* Since mer/1.24+git2 */
 ofono_bool_t ofono_gprs_get_roaming_allowed(struct ofono_gprs *gprs);
 
+/* Since 1.29+git9 */
+void ofono_gprs_set_max_activations(struct ofono_gprs *gprs,
+							unsigned int max);
+
 #ifdef __cplusplus
 }
 #endif
@@ -118,6 +118,10 @@ void ofono_netreg_status_notify(struct ofono_netreg *netreg, int status,
 void ofono_netreg_time_notify(struct ofono_netreg *netreg,
 				struct ofono_network_time *info);
 
+/* Partial result of a list_operators request that is still running */
+void ofono_netreg_operator_found(struct ofono_netreg *netreg,
+				const struct ofono_network_operator *op);
+
 int ofono_netreg_driver_register(const struct ofono_netreg_driver *d);
 void ofono_netreg_driver_unregister(const struct ofono_netreg_driver *d);
 
@@ -0,0 +1,59 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef __OFONO_TRACE_H
+#define __OFONO_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <ofono/types.h>
+
+/* This API exists since 1.29+git9 */
+
+struct ofono_modem;
+
+/* These values end up in the trace dumps, don't renumber them */
+enum ofono_trace_proto {
+	OFONO_TRACE_PROTO_AT = 1,
+	OFONO_TRACE_PROTO_QMI = 2,
+	OFONO_TRACE_PROTO_MBIM = 3,
+	OFONO_TRACE_PROTO_RIL = 4,
+	OFONO_TRACE_PROTO_MUX = 5
+};
+
+/*
+ * Records a raw frame in the modem's trace buffer. The buffer has fixed
+ * size, the oldest frames get overwritten. The contents of the buffer
+ * are written to STORAGEDIR/trace/<modem>.trace on SIGUSR2.
+ */
+void ofono_modem_trace(struct ofono_modem *modem,
+			enum ofono_trace_proto proto, ofono_bool_t in,
+			const void *data, unsigned int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OFONO_TRACE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -118,6 +118,8 @@ static GAtChat *open_device(struct ofono_modem *modem,
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, alcatel_debug, debug);
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	return chat;
 }
 
@@ -56,6 +56,7 @@
 #include <ofono/voicecall.h>
 #include <ofono/stk.h>
 
+#include <drivers/atmodem/atutil.h>
 #include <drivers/atmodem/vendor.h>
 
 #define CALYPSO_POWER_PATH "/sys/bus/platform/devices/gta02-pm-gsm.0/power_on"
@@ -266,6 +267,8 @@ static void mux_setup(GAtMux *mux, gpointer user_data)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_mux_set_debug(data->mux, calypso_debug, "MUX: ");
 
+	g_at_mux_set_trace(data->mux, at_util_trace_mux, modem);
+
 	g_at_mux_start(mux);
 
 	for (i = 0; i < NUM_DLC; i++) {
@@ -280,6 +283,8 @@ static void mux_setup(GAtMux *mux, gpointer user_data)
 			g_at_chat_set_debug(data->dlcs[i], calypso_debug,
 							debug_prefixes[i]);
 
+		g_at_chat_set_trace(data->dlcs[i], at_util_trace_chat, modem);
+
 		g_at_chat_set_wakeup_command(data->dlcs[i], "AT\r", 500, 5000);
 	}
 
@@ -330,6 +335,8 @@ static void modem_initialize(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG") != NULL)
 		g_at_chat_set_debug(chat, calypso_debug, "Setup: ");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	g_at_chat_set_wakeup_command(chat, "AT\r", 500, 5000);
 
 	g_at_chat_send(chat, "ATE0", NULL, NULL, NULL, NULL);
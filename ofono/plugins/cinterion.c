@@ -123,6 +123,8 @@ static int cinterion_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, cinterion_debug, "");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	ofono_modem_set_data(modem, chat);
 
 	return 0;
@@ -48,6 +48,7 @@
 #include <ofono/ussd.h>
 #include <ofono/voicecall.h>
 
+#include <drivers/atmodem/atutil.h>
 #include <drivers/atmodem/vendor.h>
 
 static void g1_debug(const char *str, void *user_data)
@@ -116,6 +117,8 @@ static int g1_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, g1_debug, "");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	ofono_modem_set_data(modem, chat);
 
 	/* ensure modem is in a known state; verbose on, echo/quiet off */
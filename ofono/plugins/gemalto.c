@@ -422,6 +422,9 @@ static void gemalto_initialize(struct ofono_modem *modem)
 		g_at_chat_set_debug(data->mdm, gemalto_debug, "Mdm");
 	}
 
+	g_at_chat_set_trace(data->app, at_util_trace_chat, modem);
+	g_at_chat_set_trace(data->mdm, at_util_trace_chat, modem);
+
 	g_at_chat_send(data->mdm, "ATE0", none_prefix, NULL, NULL, NULL);
 	g_at_chat_send(data->app, "ATE0 +CMEE=1", none_prefix,
 			NULL, NULL, NULL);
@@ -47,6 +47,7 @@
 #include <ofono/location-reporting.h>
 #include <ofono/log.h>
 #include <ofono/message-waiting.h>
+#include <ofono/trace.h>
 
 #include <drivers/qmimodem/qmi.h>
 #include <drivers/qmimodem/dms.h>
@@ -65,14 +66,48 @@
 #define GOBI_VOICE	(1 << 9)
 #define GOBI_WDA	(1 << 10)
 
+/*
+ * Services that several atoms share. Their clients are allocated
+ * together with DMS, so that the atoms find them ready to be shared.
+ * The other services get a client of their own from each atom, there's
+ * no point in allocating them here.
+ */
+static const struct {
+	unsigned long feature;
+	uint8_t type;
+} gobi_clients[] = {
+	{ GOBI_NAS, QMI_SERVICE_NAS },
+	{ GOBI_WDS, QMI_SERVICE_WDS },
+};
+
 struct gobi_data {
 	struct qmi_device *device;
 	struct qmi_service *dms;
+	GSList *clients;
+	unsigned int clients_pending;
 	unsigned long features;
 	unsigned int discover_attempts;
 	uint8_t oper_mode;
+	gint64 enable_time;
 };
 
+static void gobi_timing(struct gobi_data *data, const char *stage)
+{
+	if (!data->enable_time)
+		return;
+
+	DBG("%s %u ms after enable", stage, (unsigned int)
+		((g_get_monotonic_time() - data->enable_time) / 1000));
+}
+
+static void gobi_release_clients(struct gobi_data *data)
+{
+	g_slist_free_full(data->clients,
+				(GDestroyNotify) qmi_service_unref);
+	data->clients = NULL;
+	data->clients_pending = 0;
+}
+
 static void gobi_debug(const char *str, void *user_data)
 {
 	const char *prefix = user_data;
@@ -80,6 +115,11 @@ static void gobi_debug(const char *str, void *user_data)
 	ofono_info("%s%s", prefix, str);
 }
 
+static void gobi_trace(bool in, const void *buf, size_t len, void *user_data)
+{
+	ofono_modem_trace(user_data, OFONO_TRACE_PROTO_QMI, in, buf, len);
+}
+
 static int gobi_probe(struct ofono_modem *modem)
 {
 	struct gobi_data *data;
@@ -104,6 +144,7 @@ static void gobi_remove(struct ofono_modem *modem)
 	ofono_modem_set_data(modem, NULL);
 
 	qmi_service_unref(data->dms);
+	gobi_release_clients(data);
 
 	qmi_device_unref(data->device);
 
@@ -118,7 +159,9 @@ static void shutdown_cb(void *user_data)
 	DBG("");
 
 	data->discover_attempts = 0;
+	data->enable_time = 0;
 
+	gobi_release_clients(data);
 	qmi_device_unref(data->device);
 	data->device = NULL;
 
@@ -133,6 +176,7 @@ static void shutdown_device(struct ofono_modem *modem)
 
 	qmi_service_unref(data->dms);
 	data->dms = NULL;
+	gobi_release_clients(data);
 
 	qmi_device_shutdown(data->device, shutdown_cb, modem, NULL);
 }
@@ -140,6 +184,7 @@ static void shutdown_device(struct ofono_modem *modem)
 static void power_reset_cb(struct qmi_result *result, void *user_data)
 {
 	struct ofono_modem *modem = user_data;
+	struct gobi_data *data = ofono_modem_get_data(modem);
 
 	DBG("");
 
@@ -148,6 +193,7 @@ static void power_reset_cb(struct qmi_result *result, void *user_data)
 		return;
 	}
 
+	gobi_timing(data, "powered");
 	ofono_modem_set_powered(modem, TRUE);
 }
 
@@ -178,6 +224,7 @@ static void get_oper_mode_cb(struct qmi_result *result, void *user_data)
 	 * it back alive.
 	 */
 	if (ofono_modem_get_boolean(modem, "AlwaysOnline")) {
+		gobi_timing(data, "powered");
 		ofono_modem_set_powered(modem, TRUE);
 		return;
 	}
@@ -198,6 +245,7 @@ static void get_oper_mode_cb(struct qmi_result *result, void *user_data)
 		shutdown_device(modem);
 		break;
 	default:
+		gobi_timing(data, "powered");
 		ofono_modem_set_powered(modem, TRUE);
 		break;
 	}
@@ -234,6 +282,27 @@ error:
 	shutdown_device(modem);
 }
 
+static void create_client_done(struct gobi_data *data)
+{
+	if (data->clients_pending && !--data->clients_pending)
+		gobi_timing(data, "QMI clients allocated");
+}
+
+static void create_client_cb(struct qmi_service *service, void *user_data)
+{
+	struct ofono_modem *modem = user_data;
+	struct gobi_data *data = ofono_modem_get_data(modem);
+
+	DBG("%s", service ? qmi_service_get_identifier(service) : "failed");
+
+	/* The atoms will try again on their own if this one failed */
+	if (service)
+		data->clients = g_slist_prepend(data->clients,
+						qmi_service_ref(service));
+
+	create_client_done(data);
+}
+
 static void create_dms_cb(struct qmi_service *service, void *user_data)
 {
 	struct ofono_modem *modem = user_data;
@@ -241,6 +310,8 @@ static void create_dms_cb(struct qmi_service *service, void *user_data)
 
 	DBG("");
 
+	create_client_done(data);
+
 	if (!service)
 		goto error;
 
@@ -258,9 +329,24 @@ static void create_shared_dms(void *user_data)
 {
 	struct ofono_modem *modem = user_data;
 	struct gobi_data *data = ofono_modem_get_data(modem);
+	unsigned int i;
+
+	gobi_timing(data, "discovery done");
 
-	qmi_service_create_shared(data->device, QMI_SERVICE_DMS,
-				  create_dms_cb, modem, NULL);
+	if (qmi_service_create_shared(data->device, QMI_SERVICE_DMS,
+						create_dms_cb, modem, NULL))
+		data->clients_pending++;
+
+	/* The requests are queued back to back, not one after another */
+	for (i = 0; i < G_N_ELEMENTS(gobi_clients); i++) {
+		if (!(data->features & gobi_clients[i].feature))
+			continue;
+
+		if (qmi_service_create_shared(data->device,
+					gobi_clients[i].type,
+					create_client_cb, modem, NULL))
+			data->clients_pending++;
+	}
 }
 
 static void discover_cb(void *user_data)
@@ -338,8 +424,10 @@ static int gobi_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_QMI_DEBUG"))
 		qmi_device_set_debug(data->device, gobi_debug, "QMI: ");
 
+	qmi_device_set_trace(data->device, gobi_trace, modem);
 	qmi_device_set_close_on_unref(data->device, true);
 
+	data->enable_time = g_get_monotonic_time();
 	qmi_device_discover(data->device, discover_cb, modem, NULL);
 
 	return -EINPROGRESS;
@@ -499,6 +587,8 @@ static void gobi_post_online(struct ofono_modem *modem)
 
 	DBG("%p", modem);
 
+	gobi_timing(data, "online");
+
 	if (data->features & GOBI_NAS) {
 		ofono_netreg_create(modem, 0, "qmimodem", data->device);
 		ofono_netmon_create(modem, 0, "qmimodem", data->device);
@@ -46,6 +46,8 @@
 #include <ofono/handsfree.h>
 #include <ofono/siri.h>
 
+#include <drivers/atmodem/atutil.h>
+
 #include <drivers/hfpmodem/slc.h>
 
 #include "bluez4.h"
@@ -153,6 +155,8 @@ static int service_level_connection(struct ofono_modem *modem, int fd)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, hfp_debug, "");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	data->info.chat = chat;
 	hfp_slc_establish(&data->info, slc_established, slc_failed, modem);
 
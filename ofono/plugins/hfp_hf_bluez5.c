@@ -168,6 +168,8 @@ static int service_level_connection(struct ofono_modem *modem,
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, hfp_debug, "");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	hfp_slc_info_init(info, version);
 	info->chat = chat;
 
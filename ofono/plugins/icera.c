@@ -131,6 +131,8 @@ static GAtChat *open_device(struct ofono_modem *modem,
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, icera_debug, debug);
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	return chat;
 }
 
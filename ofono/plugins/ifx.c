@@ -283,6 +283,8 @@ static GAtChat *create_chat(GIOChannel *channel, struct ofono_modem *modem,
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, ifx_debug, debug);
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	g_at_chat_set_disconnect_function(chat, dlc_disconnect, modem);
 
 	return chat;
@@ -438,6 +440,8 @@ static void setup_internal_mux(struct ofono_modem *modem)
 	if (getenv("OFONO_MUX_DEBUG"))
 		g_at_mux_set_debug(data->mux, ifx_debug, "MUX: ");
 
+	g_at_mux_set_trace(data->mux, at_util_trace_mux, modem);
+
 	g_at_mux_start(data->mux);
 
 	for (i = 0; i < NUM_DLC; i++) {
@@ -570,6 +574,8 @@ static int ifx_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, ifx_debug, "Master: ");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	g_at_chat_send(chat, "ATE0 +CMEE=1", NULL,
 					NULL, NULL, NULL);
 
@@ -31,6 +31,8 @@
 #include <linux/types.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
 
 #define OFONO_API_SUBJECT_TO_CHANGE
 #include <ofono/plugin.h>
@@ -42,6 +44,7 @@
 #include <ofono/sms.h>
 #include <ofono/gprs.h>
 #include <ofono/gprs-context.h>
+#include <ofono/trace.h>
 
 #include <ell/ell.h>
 
@@ -64,6 +67,34 @@ static void mbim_debug(const char *str, void *user_data)
 	ofono_info("%s%s", prefix, str);
 }
 
+static void mbim_trace(bool in, const struct iovec *iov, size_t n_iov,
+							void *user_data)
+{
+	struct ofono_modem *modem = user_data;
+	uint8_t buf[2048];
+	size_t len = 0;
+	size_t i;
+
+	if (n_iov == 1) {
+		ofono_modem_trace(modem, OFONO_TRACE_PROTO_MBIM, in,
+					iov[0].iov_base, iov[0].iov_len);
+		return;
+	}
+
+	/* Only the beginning of the frame ends up in the trace anyway */
+	for (i = 0; i < n_iov && len < sizeof(buf); i++) {
+		size_t n = iov[i].iov_len;
+
+		if (n > sizeof(buf) - len)
+			n = sizeof(buf) - len;
+
+		memcpy(buf + len, iov[i].iov_base, n);
+		len += n;
+	}
+
+	ofono_modem_trace(modem, OFONO_TRACE_PROTO_MBIM, in, buf, len);
+}
+
 static int mbim_parse_descriptors(struct mbim_data *md, const char *file)
 {
 	void *data;
@@ -300,6 +331,7 @@ static int mbim_enable(struct ofono_modem *modem)
 	mbim_device_set_disconnect_handler(md->device,
 					mbim_device_closed, modem, NULL);
 	mbim_device_set_debug(md->device, mbim_debug, "MBIM:", NULL);
+	mbim_device_set_trace(md->device, mbim_trace, modem);
 
 	return -EINPROGRESS;
 }
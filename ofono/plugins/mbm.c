@@ -339,6 +339,8 @@ static int mbm_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(data->modem_port, mbm_debug, "Modem: ");
 
+	g_at_chat_set_trace(data->modem_port, at_util_trace_chat, modem);
+
 	data->data_port = create_port(data_dev);
 	if (data->data_port == NULL) {
 		g_at_chat_unref(data->modem_port);
@@ -350,6 +352,8 @@ static int mbm_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(data->data_port, mbm_debug, "Data: ");
 
+	g_at_chat_set_trace(data->data_port, at_util_trace_chat, modem);
+
 	g_at_chat_register(data->modem_port, "*EMRDY:", emrdy_notifier,
 					FALSE, modem, NULL);
 
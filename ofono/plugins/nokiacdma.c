@@ -122,6 +122,8 @@ static int nokiacdma_enable(struct ofono_modem *modem)
 		g_at_chat_set_debug(data->chat, nokiacdma_debug,
 					"CDMA Device: ");
 
+	g_at_chat_set_trace(data->chat, at_util_trace_chat, modem);
+
 	return 0;
 }
 
@@ -44,6 +44,7 @@
 #include <ofono/gprs-context.h>
 #include <ofono/sms.h>
 
+#include <drivers/atmodem/atutil.h>
 #include <drivers/atmodem/vendor.h>
 
 struct palmpre_data {
@@ -130,6 +131,8 @@ static int palmpre_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(data->chat, palmpre_debug, "");
 
+	g_at_chat_set_trace(data->chat, at_util_trace_chat, modem);
+
 	/* Ensure terminal is in a known state */
 	g_at_chat_send(data->chat, "ATZ E0 +CMEE=1", NULL, NULL, NULL, NULL);
 
@@ -619,6 +619,8 @@ static void mux_setup(GAtMux *mux, gpointer user_data)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_mux_set_debug(data->mux, phonesim_debug, "");
 
+	g_at_mux_set_trace(data->mux, at_util_trace_mux, modem);
+
 	g_at_mux_start(mux);
 	io = g_at_mux_create_channel(mux);
 
@@ -634,6 +636,8 @@ static void mux_setup(GAtMux *mux, gpointer user_data)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(data->chat, phonesim_debug, "");
 
+	g_at_chat_set_trace(data->chat, at_util_trace_chat, modem);
+
 	if (data->calypso)
 		g_at_chat_set_wakeup_command(data->chat, "AT\r", 500, 5000);
 
@@ -731,6 +735,8 @@ static int phonesim_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(data->chat, phonesim_debug, "");
 
+	g_at_chat_set_trace(data->chat, at_util_trace_chat, modem);
+
 	g_at_chat_set_disconnect_function(data->chat,
 						phonesim_disconnected, modem);
 
@@ -1001,6 +1007,8 @@ static int localhfp_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, phonesim_debug, "LocalHfp: ");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	g_at_chat_set_disconnect_function(chat, slc_failed, modem);
 
 	hfp_slc_info_init(info, HFP_VERSION_LATEST);
@@ -95,6 +95,12 @@ static void ril_debug(const char *str, void *user_data)
 	ofono_info("%s%s", prefix, str);
 }
 
+static void ril_trace(gboolean in, const unsigned char *data, gsize size,
+							gpointer user_data)
+{
+	ofono_modem_trace(user_data, OFONO_TRACE_PROTO_RIL, in, data, size);
+}
+
 static void ril_radio_state_changed(struct ril_msg *message, gpointer user_data)
 {
 	struct ofono_modem *modem = user_data;
@@ -369,6 +375,8 @@ static int create_gril(struct ofono_modem *modem)
 	if (getenv("OFONO_RIL_HEX_TRACE"))
 		g_ril_set_debugf(rd->ril, ril_debug, GRIL_HEX_PREFIX[slot_id]);
 
+	g_ril_set_tracef(rd->ril, ril_trace, modem);
+
 	g_ril_register(rd->ril, RIL_UNSOL_RIL_CONNECTED,
 			ril_connected, modem);
 
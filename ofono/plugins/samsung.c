@@ -190,6 +190,8 @@ static int samsung_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(data->chat, samsung_debug, "Device: ");
 
+	g_at_chat_set_trace(data->chat, at_util_trace_chat, modem);
+
 	g_at_chat_send(data->chat, "ATE0", NULL, NULL, NULL, NULL);
 	g_at_chat_send(data->chat, "AT+CMEE=1", NULL, NULL, NULL, NULL);
 
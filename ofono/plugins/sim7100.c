@@ -56,6 +56,7 @@
 #include <ofono/gprs.h>
 #include <ofono/gprs-context.h>
 
+#include <drivers/atmodem/atutil.h>
 #include <drivers/atmodem/vendor.h>
 
 struct sim7100_data {
@@ -144,6 +145,8 @@ static int open_device(struct ofono_modem *modem, const char *devkey,
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, sim7100_debug, "");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	*chatp = chat;
 	return 0;
 }
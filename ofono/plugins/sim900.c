@@ -46,6 +46,7 @@
 #include <ofono/log.h>
 #include <ofono/voicecall.h>
 #include <ofono/call-volume.h>
+#include <drivers/atmodem/atutil.h>
 #include <drivers/atmodem/vendor.h>
 
 #define NUM_DLC 5
@@ -204,6 +205,8 @@ static GAtChat *open_device(struct ofono_modem *modem,
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, sim900_debug, debug);
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	return chat;
 }
 
@@ -227,6 +230,8 @@ static GAtChat *create_chat(GIOChannel *channel, struct ofono_modem *modem,
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, sim900_debug, debug);
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	return chat;
 }
 
@@ -271,6 +276,8 @@ static void setup_internal_mux(struct ofono_modem *modem)
 	if (getenv("OFONO_MUX_DEBUG"))
 		g_at_mux_set_debug(data->mux, sim900_debug, "MUX: ");
 
+	g_at_mux_set_trace(data->mux, at_util_trace_mux, modem);
+
 	if (!g_at_mux_start(data->mux)) {
 		g_at_mux_shutdown(data->mux);
 		g_at_mux_unref(data->mux);
@@ -345,6 +345,8 @@ static int ste_enable(struct ofono_modem *modem)
 			g_at_chat_set_debug(data->chat[i], ste_debug,
 						chat_prefixes[i]);
 
+		g_at_chat_set_trace(data->chat[i], at_util_trace_chat, modem);
+
 		g_at_chat_send(data->chat[i], "AT&F E0 V1 X4 &C1 +CMEE=1",
 				NULL, NULL, NULL, NULL);
 
@@ -152,6 +152,8 @@ static int stktest_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(data->chat, stktest_debug, "");
 
+	g_at_chat_set_trace(data->chat, at_util_trace_chat, modem);
+
 	g_at_chat_set_disconnect_function(data->chat,
 						stktest_disconnected, modem);
 
@@ -48,6 +48,7 @@
 #include <ofono/ussd.h>
 #include <ofono/voicecall.h>
 
+#include <drivers/atmodem/atutil.h>
 #include <drivers/atmodem/vendor.h>
 
 
@@ -116,6 +117,8 @@ static int wavecom_enable(struct ofono_modem *modem)
 	if (getenv("OFONO_AT_DEBUG"))
 		g_at_chat_set_debug(chat, wavecom_debug, "");
 
+	g_at_chat_set_trace(chat, at_util_trace_chat, modem);
+
 	ofono_modem_set_data(modem, chat);
 
 	return 0;
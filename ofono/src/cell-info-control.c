@@ -22,12 +22,29 @@
 
 #include <limits.h>
 
+/*
+ * When the cell environment doesn't change for CELL_INFO_STABLE_POLLS
+ * update intervals in a row, the interval gets doubled, up to
+ * CELL_INFO_MAX_BACKOFF_MS (unless the requested interval is longer
+ * than that). Any change in the location of the cells (or in the
+ * serving cell), as well as cell_info_control_kick(), brings it back
+ * to the requested interval.
+ */
+#define CELL_INFO_STABLE_POLLS (3)
+#define CELL_INFO_MAX_BACKOFF_MS (60000)
+
 typedef struct cell_info_control_object {
 	CellInfoControl pub;
 	int refcount;
 	char* path;
 	GHashTable *enabled;
 	GHashTable *set_interval;
+	gulong cells_changed_id;
+	guint location_hash;
+	guint backoff_id;
+	int backoff;
+	int backoff_interval;
+	gint64 backoff_start;
 } CellInfoControlObject;
 
 static GHashTable *cell_info_control_table = NULL;
@@ -56,21 +73,159 @@ static int cell_info_control_get_interval(CellInfoControlObject *self)
 	return interval;
 }
 
+static int cell_info_control_backoff_interval(int interval, int backoff)
+{
+	if (backoff && interval < CELL_INFO_MAX_BACKOFF_MS) {
+		/* Shift in 64 bits, capped long before it could overflow */
+		const gint64 ms = (backoff < 32) ?
+			((gint64)interval << backoff) :
+			CELL_INFO_MAX_BACKOFF_MS;
+
+		return (int)MIN(ms, CELL_INFO_MAX_BACKOFF_MS);
+	} else {
+		return interval;
+	}
+}
+
+static int cell_info_control_effective_interval(CellInfoControlObject *self)
+{
+	return cell_info_control_backoff_interval
+		(cell_info_control_get_interval(self), self->backoff);
+}
+
+static gboolean cell_info_control_can_back_off(CellInfoControlObject *self)
+{
+	const int interval = cell_info_control_effective_interval(self);
+
+	return self->enabled && self->pub.info && interval > 0 &&
+		interval <= CELL_INFO_MAX_BACKOFF_MS / 2;
+}
+
+static void cell_info_control_count_skipped(CellInfoControlObject *self)
+{
+	/*
+	 * Polls which would have happened at the interval requested when
+	 * the backoff started. The requests may have already changed by
+	 * now, so don't look at the set_interval table here.
+	 */
+	const int interval = self->backoff_interval;
+
+	if (self->backoff && interval > 0 && interval < INT_MAX) {
+		const gint64 now = g_get_monotonic_time();
+		const gint64 ms = (now - self->backoff_start) / 1000;
+
+		self->pub.skipped_polls += ms / interval - ms /
+			cell_info_control_backoff_interval(interval,
+				self->backoff);
+		self->backoff_start = now;
+	}
+}
+
+static gboolean cell_info_control_backoff_cb(gpointer data);
+
+static void cell_info_control_restart_backoff(CellInfoControlObject *self)
+{
+	if (self->backoff_id) {
+		g_source_remove(self->backoff_id);
+		self->backoff_id = 0;
+	}
+	if (cell_info_control_can_back_off(self)) {
+		self->backoff_id = g_timeout_add(CELL_INFO_STABLE_POLLS *
+			cell_info_control_effective_interval(self),
+			cell_info_control_backoff_cb, self);
+	}
+}
+
+static void cell_info_control_apply_interval(CellInfoControlObject *self)
+{
+	const int interval = cell_info_control_effective_interval(self);
+
+	if (self->pub.update_interval != interval) {
+		self->pub.update_interval = interval;
+		if (interval == INT_MAX) {
+			DBG("maximum");
+		} else {
+			DBG("%d ms", interval);
+		}
+		ofono_cell_info_set_update_interval(self->pub.info, interval);
+	}
+}
+
+static gboolean cell_info_control_backoff_cb(gpointer data)
+{
+	CellInfoControlObject *self = data;
+
+	self->backoff_id = 0;
+	cell_info_control_count_skipped(self);
+	if (!self->backoff) {
+		self->backoff_interval = cell_info_control_get_interval(self);
+		self->backoff_start = g_get_monotonic_time();
+	}
+	self->backoff++;
+	DBG("%s stable, backing off", self->path);
+	cell_info_control_apply_interval(self);
+	cell_info_control_restart_backoff(self);
+	return G_SOURCE_REMOVE;
+}
+
+static void cell_info_control_reset_backoff(CellInfoControlObject *self)
+{
+	cell_info_control_count_skipped(self);
+	if (self->backoff) {
+		DBG("%s back to %d ms", self->path,
+			cell_info_control_get_interval(self));
+		self->backoff = 0;
+		cell_info_control_apply_interval(self);
+	}
+	cell_info_control_restart_backoff(self);
+}
+
+static guint cell_info_control_location_hash(struct ofono_cell_info *info)
+{
+	guint hash = 0;
+	const ofono_cell_ptr *c;
+
+	/* Doesn't depend on the order of cells */
+	for (c = info->cells; c && *c; c++) {
+		const guint h = ofono_cell_hash_location(*c);
+
+		hash += (*c)->registered ? ~h : h;
+	}
+	return hash;
+}
+
+static void cell_info_control_cells_changed(struct ofono_cell_info *info,
+	void *data)
+{
+	CellInfoControlObject *self = data;
+	const guint hash = cell_info_control_location_hash(info);
+
+	/* Signal strength changes alone don't count */
+	if (self->location_hash != hash) {
+		self->location_hash = hash;
+		cell_info_control_reset_backoff(self);
+	}
+}
+
 static void cell_info_control_update_all(CellInfoControlObject *self)
 {
 	struct ofono_cell_info *cellinfo = self->pub.info;
 
+	cell_info_control_count_skipped(self);
+	self->backoff = 0;
+	self->pub.update_interval = cell_info_control_get_interval(self);
 	if (cellinfo) {
 		if (self->enabled) {
 			ofono_cell_info_set_update_interval(cellinfo,
-				cell_info_control_get_interval(self));
+				self->pub.update_interval);
 			ofono_cell_info_set_enabled(cellinfo, TRUE);
 		} else {
 			ofono_cell_info_set_enabled(cellinfo, FALSE);
 			ofono_cell_info_set_update_interval(cellinfo,
-				cell_info_control_get_interval(self));
+				self->pub.update_interval);
 		}
 	}
+	cell_info_control_restart_backoff(self);
 }
 
 static void cell_info_control_drop_all_requests_internal
@@ -97,6 +252,10 @@ static void cell_info_control_free(CellInfoControlObject *self)
 	}
 
 	cell_info_control_drop_all_requests_internal(self);
+	if (self->backoff_id) {
+		g_source_remove(self->backoff_id);
+	}
+	ofono_cell_info_remove_handler(self->pub.info, self->cells_changed_id);
 	ofono_cell_info_unref(self->pub.info);
 	g_free(self->path);
 	g_free(self);
@@ -118,6 +277,7 @@ CellInfoControl *cell_info_control_get(const char* path)
 			/* Create a new one */
 			self = g_new0(CellInfoControlObject, 1);
 			self->pub.path = self->path = g_strdup(path);
+			self->pub.update_interval = INT_MAX;
 			self->refcount = 1;
 
 			/* Create the table if necessary */
@@ -160,8 +320,14 @@ void cell_info_control_set_cell_info(CellInfoControl *ctl,
 	CellInfoControlObject *self = cell_info_control_object_cast(ctl);
 
 	if (self && ctl->info != ci) {
+		ofono_cell_info_remove_handler(ctl->info,
+			self->cells_changed_id);
 		ofono_cell_info_unref(ctl->info);
 		ctl->info = ofono_cell_info_ref(ci);
+		self->cells_changed_id = ofono_cell_info_add_change_handler(ci,
+			cell_info_control_cells_changed, self);
+		self->location_hash = ci ?
+			cell_info_control_location_hash(ci) : 0;
 		cell_info_control_update_all(self);
 	}
 }
@@ -187,19 +353,19 @@ void cell_info_control_drop_requests(CellInfoControl *ctl, void *tag)
 			g_hash_table_unref(self->enabled);
 			self->enabled = NULL;
 			ofono_cell_info_set_enabled(ctl->info, FALSE);
+			cell_info_control_reset_backoff(self);
 		}
 		if (self->set_interval &&
-			g_hash_table_remove(self->set_interval, tag)) {
-			int ms;
-
-			if (g_hash_table_size(self->set_interval)) {
-				ms = cell_info_control_get_interval(self);
-			} else {
+			g_hash_table_contains(self->set_interval, tag)) {
+			cell_info_control_count_skipped(self);
+			g_hash_table_remove(self->set_interval, tag);
+			if (!g_hash_table_size(self->set_interval)) {
 				g_hash_table_unref(self->set_interval);
 				self->set_interval = NULL;
-				ms = INT_MAX;
 			}
-			ofono_cell_info_set_update_interval(ctl->info, ms);
+			self->backoff = 0;
+			cell_info_control_apply_interval(self);
+			cell_info_control_restart_backoff(self);
 		}
 	}
 }
@@ -230,6 +396,7 @@ void cell_info_control_set_enabled(CellInfoControl *ctl,
 		is_enabled = (self->enabled != NULL);
 		if (is_enabled != was_enabled) {
 			ofono_cell_info_set_enabled(ctl->info, is_enabled);
+			cell_info_control_reset_backoff(self);
 		}
 	}
 }
@@ -241,7 +408,6 @@ void cell_info_control_set_update_interval(CellInfoControl *ctl,
 
 	if (self && tag) {
 		int old_interval = cell_info_control_get_interval(self);
-		int new_interval;
 
 		if (ms >= 0 && ms < INT_MAX) {
 			if (!self->set_interval) {
@@ -260,19 +426,25 @@ void cell_info_control_set_update_interval(CellInfoControl *ctl,
 			}
 		}
 
-		new_interval = cell_info_control_get_interval(self);
-		if (new_interval != old_interval) {
-			if (new_interval == INT_MAX) {
-				DBG("maximum");
-			} else {
-				DBG("%d ms", new_interval);
-			}
-			ofono_cell_info_set_update_interval(ctl->info,
-				new_interval);
+		if (cell_info_control_get_interval(self) != old_interval) {
+			/* Start over with the new interval */
+			cell_info_control_count_skipped(self);
+			self->backoff = 0;
+			cell_info_control_apply_interval(self);
+			cell_info_control_restart_backoff(self);
 		}
 	}
 }
 
+void cell_info_control_kick(CellInfoControl *ctl)
+{
+	CellInfoControlObject *self = cell_info_control_object_cast(ctl);
+
+	if (self) {
+		cell_info_control_reset_backoff(self);
+	}
+}
+
 /*
  * Local Variables:
  * mode: C
@@ -23,6 +23,8 @@ struct ofono_cell_info;
 typedef struct cell_info_control {
 	const char* path;
 	struct ofono_cell_info *info;
+	int update_interval;		/* Including the backoff */
+	unsigned int skipped_polls;	/* Saved by the backoff */
 } CellInfoControl;
 
 CellInfoControl *cell_info_control_get(const char* path);
@@ -41,6 +43,12 @@ void cell_info_control_set_enabled(CellInfoControl *ctl, void *tag,
 void cell_info_control_set_update_interval(CellInfoControl *ctl, void *tag,
 				int ms);
 
+/*
+ * While the cells stay where they are, the update interval backs off.
+ * Kicking drops it back to the requested value.
+ */
+void cell_info_control_kick(CellInfoControl *ctl);
+
 #endif /* CELL_INFO_CONTROL_H */
 
 /*
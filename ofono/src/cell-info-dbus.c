@@ -27,6 +27,7 @@
 
 typedef struct cell_entry {
 	guint cell_id;
+	guint update_seq;
 	char *path;
 	struct ofono_cell cell;
 } CellEntry;
@@ -38,14 +39,29 @@ typedef struct cell_info_dbus {
 	char *path;
 	gulong handler_id;
 	guint next_cell_id;
-	GSList *entries;
+	gboolean cell_id_wrapped;
+	guint update_seq;
+	GQueue entries;
+	GHashTable *entry_table;
+	GPtrArray *matched;
+	guint delta_seq;
 	struct ofono_dbus_clients *clients;
+	struct ofono_dbus_clients *delta_clients;
 } CellInfoDBus;
 
+typedef struct cell_change {
+	const CellEntry *entry;
+	int mask;
+} CellChange;
+
 #define CELL_INFO_DBUS_INTERFACE            "org.nemomobile.ofono.CellInfo"
 #define CELL_INFO_DBUS_CELLS_ADDED_SIGNAL   "CellsAdded"
 #define CELL_INFO_DBUS_CELLS_REMOVED_SIGNAL "CellsRemoved"
 #define CELL_INFO_DBUS_UNSUBSCRIBED_SIGNAL  "Unsubscribed"
+#define CELL_INFO_DBUS_CELLS_UPDATED_SIGNAL "CellsUpdated"
+
+#define CELL_INFO_DBUS_CELL_SIGNATURE       "(osba{sv})"
+#define CELL_INFO_DBUS_CHANGE_SIGNATURE     "(oa{sv})"
 
 #define CELL_DBUS_INTERFACE_VERSION         (1)
 #define CELL_DBUS_INTERFACE                 "org.nemomobile.ofono.Cell"
@@ -135,6 +151,14 @@ static void cell_info_dbus_set_updates_enabled(CellInfoDBus *dbus, gboolean on)
 	cell_info_control_set_update_interval(dbus->ctl, dbus, on ? 5000 : -1);
 }
 
+static void cell_info_dbus_check_updates_enabled(CellInfoDBus *dbus)
+{
+	if (!ofono_dbus_clients_count(dbus->clients) &&
+			!ofono_dbus_clients_count(dbus->delta_clients)) {
+		cell_info_dbus_set_updates_enabled(dbus, FALSE);
+	}
+}
+
 static const char *cell_info_dbus_cell_type_str(enum ofono_cell_type type)
 {
 	switch (type) {
@@ -321,9 +345,9 @@ static const GDBusSignalTable cell_info_dbus_cell_signals[] = {
 
 static CellEntry *cell_info_dbus_find_id(CellInfoDBus *dbus, guint id)
 {
-	GSList *l;
+	GList *l;
 
-	for (l = dbus->entries; l; l = l->next) {
+	for (l = dbus->entries.head; l; l = l->next) {
 		CellEntry *entry = l->data;
 
 		if (entry->cell_id == id) {
@@ -335,40 +359,32 @@ static CellEntry *cell_info_dbus_find_id(CellInfoDBus *dbus, guint id)
 
 static guint cell_info_dbus_next_cell_id(CellInfoDBus *dbus)
 {
-	while (cell_info_dbus_find_id(dbus, dbus->next_cell_id)) {
-		dbus->next_cell_id++;
+	/* Until the counter wraps around, the ids are known to be unique */
+	if (dbus->cell_id_wrapped) {
+		while (cell_info_dbus_find_id(dbus, dbus->next_cell_id)) {
+			dbus->next_cell_id++;
+		}
+	}
+	if (dbus->next_cell_id == G_MAXUINT) {
+		dbus->cell_id_wrapped = TRUE;
 	}
 	return dbus->next_cell_id++;
 }
 
-static const struct ofono_cell *cell_info_dbus_find_ofono_cell
-	(struct ofono_cell_info *info, const struct ofono_cell *cell)
+static guint cell_info_dbus_cell_hash(gconstpointer key)
 {
-	const ofono_cell_ptr *c;
+	return ofono_cell_hash_location(key);
+}
 
-	for (c = info->cells; *c; c++) {
-		if (!ofono_cell_compare_location(*c, cell)) {
-			return *c;
-		}
-	}
-	return NULL;
+static gboolean cell_info_dbus_cell_equal(gconstpointer a, gconstpointer b)
+{
+	return !ofono_cell_compare_location(a, b);
 }
 
 static CellEntry *cell_info_dbus_find_cell(CellInfoDBus *dbus,
 	const struct ofono_cell *cell)
 {
-	if (cell) {
-		GSList *l;
-
-		for (l = dbus->entries; l; l = l->next) {
-			CellEntry *e = l->data;
-
-			if (!ofono_cell_compare_location(&e->cell, cell)) {
-				return e;
-			}
-		}
-	}
-	return NULL;
+	return g_hash_table_lookup(dbus->entry_table, cell);
 }
 
 static void cell_info_dbus_emit_path_list(CellInfoDBus *dbus, const char *name,
@@ -476,22 +492,138 @@ static void cell_info_dbus_property_changed(CellInfoDBus *dbus,
 	}
 }
 
+static void cell_info_dbus_append_cell(DBusMessageIter *it,
+	const CellEntry *entry)
+{
+	DBusMessageIter st;
+
+	dbus_message_iter_open_container(it, DBUS_TYPE_STRUCT, NULL, &st);
+	dbus_message_iter_append_basic(&st, DBUS_TYPE_OBJECT_PATH,
+		&entry->path);
+	cell_info_dbus_append_type(&st, entry);
+	cell_info_dbus_append_registered(&st, entry);
+	cell_info_dbus_append_properties(&st, entry);
+	dbus_message_iter_close_container(it, &st);
+}
+
+static void cell_info_dbus_append_change(DBusMessageIter *it,
+	const CellChange *change)
+{
+	int i, n, mask = change->mask;
+	DBusMessageIter st, dict;
+	const CellEntry *entry = change->entry;
+	const struct ofono_cell *cell = &entry->cell;
+	const struct cell_property *prop =
+		cell_info_dbus_cell_properties(cell->type, &n);
+
+	dbus_message_iter_open_container(it, DBUS_TYPE_STRUCT, NULL, &st);
+	dbus_message_iter_append_basic(&st, DBUS_TYPE_OBJECT_PATH,
+		&entry->path);
+	dbus_message_iter_open_container(&st, DBUS_TYPE_ARRAY, "{sv}", &dict);
+	if (mask & CELL_PROPERTY_REGISTERED) {
+		const dbus_bool_t registered = (cell->registered != FALSE);
+
+		ofono_dbus_dict_append(&dict, "registered",
+			DBUS_TYPE_BOOLEAN, &registered);
+		mask &= ~CELL_PROPERTY_REGISTERED;
+	}
+	for (i = 0; i < n && mask; i++) {
+		if (mask & prop[i].flag) {
+			ofono_dbus_dict_append(&dict, prop[i].name,
+				prop[i].type,
+				G_STRUCT_MEMBER_P(&cell->info, prop[i].off));
+			mask &= ~prop[i].flag;
+		}
+	}
+	dbus_message_iter_close_container(&st, &dict);
+	dbus_message_iter_close_container(it, &st);
+}
+
+static void cell_info_dbus_emit_delta(CellInfoDBus *dbus,
+	GPtrArray *removed, GPtrArray *added, GArray *changed)
+{
+	guint i;
+	dbus_uint32_t seq = ++(dbus->delta_seq);
+	DBusMessageIter it, a;
+	DBusMessage *signal = dbus_message_new_signal(dbus->path,
+		CELL_INFO_DBUS_INTERFACE, CELL_INFO_DBUS_CELLS_UPDATED_SIGNAL);
+
+	dbus_message_iter_init_append(signal, &it);
+	dbus_message_iter_append_basic(&it, DBUS_TYPE_UINT32, &seq);
+
+	dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY, "o", &a);
+	for (i = 0; removed && i < removed->len; i++) {
+		const char *path = removed->pdata[i];
+
+		dbus_message_iter_append_basic(&a, DBUS_TYPE_OBJECT_PATH,
+			&path);
+	}
+	dbus_message_iter_close_container(&it, &a);
+
+	dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+		CELL_INFO_DBUS_CELL_SIGNATURE, &a);
+	for (i = 0; added && i < added->len; i++) {
+		cell_info_dbus_append_cell(&a, added->pdata[i]);
+	}
+	dbus_message_iter_close_container(&it, &a);
+
+	dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+		CELL_INFO_DBUS_CHANGE_SIGNATURE, &a);
+	for (i = 0; i < changed->len; i++) {
+		cell_info_dbus_append_change(&a,
+			&g_array_index(changed, CellChange, i));
+	}
+	dbus_message_iter_close_container(&it, &a);
+
+	ofono_dbus_clients_signal(dbus->delta_clients, signal);
+	dbus_message_unref(signal);
+}
+
 static void cell_info_dbus_update_entries(CellInfoDBus *dbus, gboolean emit)
 {
-	GSList *l;
+	GList *l;
 	GPtrArray* added = NULL;
 	GPtrArray* removed = NULL;
+	GPtrArray* matched = dbus->matched;
+	GPtrArray* delta_added = NULL;
+	GArray* delta_changed = NULL;
 	const ofono_cell_ptr *c;
+	const guint seq = ++(dbus->update_seq);
+	guint i;
+
+	/* Delta subscribers get one signal per update */
+	if (emit && ofono_dbus_clients_count(dbus->delta_clients)) {
+		delta_added = g_ptr_array_new();
+		delta_changed = g_array_new(FALSE, FALSE, sizeof(CellChange));
+	}
+
+	/*
+	 * Match the cells against the existing entries in one pass. The
+	 * entries which haven't been matched are left with the old update
+	 * sequence number and get removed. Removal happens before adding
+	 * and updating, same way as it used to when the lists were being
+	 * compared element by element.
+	 */
+	g_ptr_array_set_size(matched, 0);
+	for (c = dbus->info->cells; *c; c++) {
+		CellEntry *entry = cell_info_dbus_find_cell(dbus, *c);
+
+		if (entry) {
+			entry->update_seq = seq;
+		}
+		g_ptr_array_add(matched, entry);
+	}
 
 	/* Remove non-existent cells */
-	l = dbus->entries;
+	l = dbus->entries.head;
 	while (l) {
-		GSList *next = l->next;
+		GList *next = l->next;
 		CellEntry *entry = l->data;
 
-		if (!cell_info_dbus_find_ofono_cell(dbus->info, &entry->cell)) {
+		if (entry->update_seq != seq) {
 			DBG("%s removed", entry->path);
-			dbus->entries = g_slist_delete_link(dbus->entries, l);
+			g_hash_table_remove(dbus->entry_table, &entry->cell);
+			g_queue_delete_link(&dbus->entries, l);
 			cell_info_dbus_emit_signal(dbus, entry->path,
 				CELL_DBUS_INTERFACE,
 				CELL_DBUS_REMOVED_SIGNAL,
@@ -513,9 +645,14 @@ static void cell_info_dbus_update_entries(CellInfoDBus *dbus, gboolean emit)
 	}
 
 	/* Add new cells */
-	for (c = dbus->info->cells; *c; c++) {
+	for (c = dbus->info->cells, i = 0; *c; c++, i++) {
 		const struct ofono_cell *cell = *c;
-		CellEntry *entry = cell_info_dbus_find_cell(dbus, cell);
+		CellEntry *entry = matched->pdata[i];
+
+		if (!entry) {
+			/* Duplicate of the cell that has just been added? */
+			entry = cell_info_dbus_find_cell(dbus, cell);
+		}
 
 		if (entry) {
 			if (emit) {
@@ -525,16 +662,27 @@ static void cell_info_dbus_update_entries(CellInfoDBus *dbus, gboolean emit)
 				entry->cell = *cell;
 				cell_info_dbus_property_changed(dbus, entry,
 					diff);
+				if (delta_changed && diff > 0) {
+					CellChange change;
+
+					change.entry = entry;
+					change.mask = diff;
+					g_array_append_val(delta_changed,
+						change);
+				}
 			} else {
 				entry->cell = *cell;
 			}
 		} else {
 			entry = g_new0(CellEntry, 1);
 			entry->cell = *cell;
+			entry->update_seq = seq;
 			entry->cell_id = cell_info_dbus_next_cell_id(dbus);
 			entry->path = g_strdup_printf("%s/cell_%u", dbus->path,
 				entry->cell_id);
-			dbus->entries = g_slist_append(dbus->entries, entry);
+			g_queue_push_tail(&dbus->entries, entry);
+			g_hash_table_insert(dbus->entry_table, &entry->cell,
+				entry);
 			DBG("%s added", entry->path);
 			g_dbus_register_interface(dbus->conn, entry->path,
 				CELL_DBUS_INTERFACE,
@@ -547,7 +695,20 @@ static void cell_info_dbus_update_entries(CellInfoDBus *dbus, gboolean emit)
 				}
 				g_ptr_array_add(added, entry->path);
 			}
+			if (delta_added) {
+				g_ptr_array_add(delta_added, entry);
+			}
+		}
+	}
+	g_ptr_array_set_size(matched, 0);
+
+	if (delta_changed) {
+		if (removed || delta_added->len || delta_changed->len) {
+			cell_info_dbus_emit_delta(dbus, removed, delta_added,
+				delta_changed);
 		}
+		g_ptr_array_free(delta_added, TRUE);
+		g_array_free(delta_changed, TRUE);
 	}
 
 	if (removed) {
@@ -583,15 +744,17 @@ static DBusMessage *cell_info_dbus_get_cells(DBusConnection *conn,
 	CellInfoDBus *dbus = data;
 	const char *sender = dbus_message_get_sender(msg);
 
+	/* Switching from delta updates back to individual signals */
+	ofono_dbus_clients_remove(dbus->delta_clients, sender);
 	if (ofono_dbus_clients_add(dbus->clients, sender)) {
 		DBusMessage *reply = dbus_message_new_method_return(msg);
 		DBusMessageIter it, a;
-		GSList *l;
+		GList *l;
 
 		cell_info_dbus_set_updates_enabled(dbus, TRUE);
 		dbus_message_iter_init_append(reply, &it);
 		dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY, "o", &a);
-		for (l = dbus->entries; l; l = l->next) {
+		for (l = dbus->entries.head; l; l = l->next) {
 			const CellEntry *entry = l->data;
 
 			dbus_message_iter_append_basic(&a,
@@ -603,6 +766,39 @@ static DBusMessage *cell_info_dbus_get_cells(DBusConnection *conn,
 	return cell_info_dbus_error_failed(msg, "Operation failed");
 }
 
+static DBusMessage *cell_info_dbus_subscribe_delta(DBusConnection *conn,
+	DBusMessage *msg, void *data)
+{
+	CellInfoDBus *dbus = data;
+	const char *sender = dbus_message_get_sender(msg);
+
+	/*
+	 * Returns the sequence number of the last CellsUpdated signal and
+	 * the full list of cells. The client is expected to call it again
+	 * if it notices a gap in the sequence numbers.
+	 */
+	DBG("%s", sender);
+	ofono_dbus_clients_remove(dbus->clients, sender);
+	if (ofono_dbus_clients_add(dbus->delta_clients, sender)) {
+		DBusMessage *reply = dbus_message_new_method_return(msg);
+		const dbus_uint32_t seq = dbus->delta_seq;
+		DBusMessageIter it, a;
+		GList *l;
+
+		cell_info_dbus_set_updates_enabled(dbus, TRUE);
+		dbus_message_iter_init_append(reply, &it);
+		dbus_message_iter_append_basic(&it, DBUS_TYPE_UINT32, &seq);
+		dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+				CELL_INFO_DBUS_CELL_SIGNATURE, &a);
+		for (l = dbus->entries.head; l; l = l->next) {
+			cell_info_dbus_append_cell(&a, l->data);
+		}
+		dbus_message_iter_close_container(&it, &a);
+		return reply;
+	}
+	return cell_info_dbus_error_failed(msg, "Operation failed");
+}
+
 static DBusMessage *cell_info_dbus_unsubscribe(DBusConnection *conn,
 	DBusMessage *msg, void *data)
 {
@@ -610,14 +806,13 @@ static DBusMessage *cell_info_dbus_unsubscribe(DBusConnection *conn,
 	const char *sender = dbus_message_get_sender(msg);
 
 	DBG("%s", sender);
-	if (ofono_dbus_clients_remove(dbus->clients, sender)) {
+	if (ofono_dbus_clients_remove(dbus->clients, sender) ||
+		ofono_dbus_clients_remove(dbus->delta_clients, sender)) {
 		DBusMessage *signal = dbus_message_new_signal(dbus->path,
 			CELL_INFO_DBUS_INTERFACE,
 			CELL_INFO_DBUS_UNSUBSCRIBED_SIGNAL);
 
-		if (!ofono_dbus_clients_count(dbus->clients)) {
-			cell_info_dbus_set_updates_enabled(dbus, FALSE);
-		}
+		cell_info_dbus_check_updates_enabled(dbus);
 		dbus_message_set_destination(signal, sender);
 		g_dbus_send_message(dbus->conn, signal);
 		return dbus_message_new_method_return(msg);
@@ -631,6 +826,10 @@ static const GDBusMethodTable cell_info_dbus_methods[] = {
 			cell_info_dbus_get_cells) },
 	{ GDBUS_METHOD("Unsubscribe", NULL, NULL,
 			cell_info_dbus_unsubscribe) },
+	{ GDBUS_METHOD("SubscribeDelta", NULL,
+			GDBUS_ARGS({ "sequence", "u" },
+				{ "cells", "a" CELL_INFO_DBUS_CELL_SIGNATURE }),
+			cell_info_dbus_subscribe_delta) },
 	{ }
 };
 
@@ -641,16 +840,18 @@ static const GDBusSignalTable cell_info_dbus_signals[] = {
 			GDBUS_ARGS({ "paths", "ao" })) },
 	{ GDBUS_SIGNAL(CELL_INFO_DBUS_UNSUBSCRIBED_SIGNAL,
 			GDBUS_ARGS({})) },
+	{ GDBUS_SIGNAL(CELL_INFO_DBUS_CELLS_UPDATED_SIGNAL,
+			GDBUS_ARGS({ "sequence", "u" },
+				{ "removed", "ao" },
+				{ "added", "a" CELL_INFO_DBUS_CELL_SIGNATURE },
+				{ "changed",
+					"a" CELL_INFO_DBUS_CHANGE_SIGNATURE })) },
 	{ }
 };
 
 static void cell_info_dbus_disconnect_cb(const char *name, void *data)
 {
-	CellInfoDBus *dbus = data;
-
-	if (!ofono_dbus_clients_count(dbus->clients)) {
-		cell_info_dbus_set_updates_enabled(dbus, FALSE);
-	}
+	cell_info_dbus_check_updates_enabled((CellInfoDBus *) data);
 }
 
 CellInfoDBus *cell_info_dbus_new(struct ofono_modem *modem,
@@ -665,6 +866,9 @@ CellInfoDBus *cell_info_dbus_new(struct ofono_modem *modem,
 		dbus->conn = dbus_connection_ref(ofono_dbus_get_connection());
 		dbus->info = ofono_cell_info_ref(info);
 		dbus->ctl = cell_info_control_ref(ctl);
+		dbus->entry_table = g_hash_table_new(cell_info_dbus_cell_hash,
+			cell_info_dbus_cell_equal);
+		dbus->matched = g_ptr_array_new();
 		dbus->handler_id = ofono_cell_info_add_change_handler(info,
 			cell_info_dbus_cells_changed_cb, dbus);
 
@@ -679,6 +883,8 @@ CellInfoDBus *cell_info_dbus_new(struct ofono_modem *modem,
 			cell_info_dbus_update_entries(dbus, FALSE);
 			dbus->clients = ofono_dbus_clients_new(dbus->conn,
 				cell_info_dbus_disconnect_cb, dbus);
+			dbus->delta_clients = ofono_dbus_clients_new(dbus->conn,
+				cell_info_dbus_disconnect_cb, dbus);
 			return dbus;
 		} else {
 			ofono_error("CellInfo D-Bus register failed");
@@ -691,15 +897,16 @@ CellInfoDBus *cell_info_dbus_new(struct ofono_modem *modem,
 void cell_info_dbus_free(CellInfoDBus *dbus)
 {
 	if (dbus) {
-		GSList *l;
+		GList *l;
 
 		DBG("%s", dbus->path);
 		ofono_dbus_clients_free(dbus->clients);
+		ofono_dbus_clients_free(dbus->delta_clients);
 		g_dbus_unregister_interface(dbus->conn, dbus->path,
 			CELL_INFO_DBUS_INTERFACE);
 
 		/* Unregister cells */
-		l = dbus->entries;
+		l = dbus->entries.head;
 		while (l) {
 			CellEntry *entry = l->data;
 			g_dbus_unregister_interface(dbus->conn, entry->path,
@@ -707,7 +914,9 @@ void cell_info_dbus_free(CellInfoDBus *dbus)
 			cell_info_destroy_entry(entry);
 			l = l->next;
 		}
-		g_slist_free(dbus->entries);
+		g_queue_clear(&dbus->entries);
+		g_hash_table_destroy(dbus->entry_table);
+		g_ptr_array_free(dbus->matched, TRUE);
 
 		dbus_connection_unref(dbus->conn);
 
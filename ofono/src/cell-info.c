@@ -81,7 +81,8 @@ int ofono_cell_compare_location(const struct ofono_cell *c1,
 			} else if (n1->mnc != n2->mnc) {
 				return n1->mnc - n2->mnc;
 			} else if (n1->nci != n2->nci) {
-				return n1->nci - n2->nci;
+				/* 36 bits, the difference may not fit */
+				return n1->nci < n2->nci ? -1 : 1;
 			} else if (n1->pci != n2->pci) {
 				return n1->pci - n2->pci;
 			} else {
@@ -100,6 +101,52 @@ int ofono_cell_compare_location(const struct ofono_cell *c1,
 	}
 }
 
+/* Hashes exactly the fields compared by ofono_cell_compare_location */
+#define CELL_HASH_ADD(h,v) ((h) = (h) * 31 + (unsigned int)(v))
+
+unsigned int ofono_cell_hash_location(const struct ofono_cell *cell)
+{
+	unsigned int h = 0;
+
+	if (cell) {
+		h = cell->type + 1;
+		if (cell->type == OFONO_CELL_TYPE_GSM) {
+			const struct ofono_cell_info_gsm *g = &cell->info.gsm;
+
+			CELL_HASH_ADD(h, g->mcc);
+			CELL_HASH_ADD(h, g->mnc);
+			CELL_HASH_ADD(h, g->lac);
+			CELL_HASH_ADD(h, g->cid);
+		} else if (cell->type == OFONO_CELL_TYPE_WCDMA) {
+			const struct ofono_cell_info_wcdma *w =
+				&cell->info.wcdma;
+
+			CELL_HASH_ADD(h, w->mcc);
+			CELL_HASH_ADD(h, w->mnc);
+			CELL_HASH_ADD(h, w->lac);
+			CELL_HASH_ADD(h, w->cid);
+		} else if (cell->type == OFONO_CELL_TYPE_LTE) {
+			const struct ofono_cell_info_lte *l = &cell->info.lte;
+
+			CELL_HASH_ADD(h, l->mcc);
+			CELL_HASH_ADD(h, l->mnc);
+			CELL_HASH_ADD(h, l->ci);
+			CELL_HASH_ADD(h, l->pci);
+			CELL_HASH_ADD(h, l->tac);
+		} else if (cell->type == OFONO_CELL_TYPE_NR) {
+			const struct ofono_cell_info_nr *n = &cell->info.nr;
+
+			CELL_HASH_ADD(h, n->mcc);
+			CELL_HASH_ADD(h, n->mnc);
+			CELL_HASH_ADD(h, n->nci);
+			CELL_HASH_ADD(h, n->nci >> 32);
+			CELL_HASH_ADD(h, n->pci);
+			CELL_HASH_ADD(h, n->tac);
+		}
+	}
+	return h;
+}
+
 struct ofono_cell_info *ofono_cell_info_ref(struct ofono_cell_info *ci)
 {
 	if (ci && ci->proc->ref) {
@@ -19,7 +19,107 @@
 #include <errno.h>
 #include <string.h>
 
+/*
+ * Access decisions are cached per unique bus name. A unique name is
+ * never reused by the bus daemon, so the only things that can change
+ * the outcome for the same (sender, intf, method, arg) are the set of
+ * registered plugins and the lifetime of the sender itself. The cache
+ * is flushed on plugin (un)registration and the sender's entries are
+ * dropped when the sender disappears from the bus.
+ */
+#define DBUS_ACCESS_CACHE_MAX_SENDERS (256)
+
+struct dbus_access_key {
+	enum ofono_dbus_access_intf intf;
+	int method;
+	const char *arg;
+};
+
 static GSList *dbus_access_plugins = NULL;
+static GHashTable *dbus_access_cache = NULL;
+static guint dbus_access_cached_count = 0;
+static guint dbus_access_evaluated_count = 0;
+
+static guint dbus_access_key_hash(gconstpointer data)
+{
+	const struct dbus_access_key *key = data;
+	guint h = (key->intf << 8) ^ key->method;
+
+	return key->arg ? (h * 31 + g_str_hash(key->arg)) : h;
+}
+
+static gboolean dbus_access_key_equal(gconstpointer a, gconstpointer b)
+{
+	const struct dbus_access_key *k1 = a;
+	const struct dbus_access_key *k2 = b;
+
+	return k1->intf == k2->intf && k1->method == k2->method &&
+				!g_strcmp0(k1->arg, k2->arg);
+}
+
+static struct dbus_access_key *dbus_access_key_new
+				(const struct dbus_access_key *key)
+{
+	/* Key and the argument are allocated as a single block */
+	const gsize arglen = key->arg ? (strlen(key->arg) + 1) : 0;
+	struct dbus_access_key *copy = g_malloc(sizeof(*copy) + arglen);
+
+	copy->intf = key->intf;
+	copy->method = key->method;
+	if (key->arg) {
+		char *arg = (char *)(copy + 1);
+
+		memcpy(arg, key->arg, arglen);
+		copy->arg = arg;
+	} else {
+		copy->arg = NULL;
+	}
+	return copy;
+}
+
+static void dbus_access_cache_clear(void)
+{
+	if (dbus_access_cache) {
+		g_hash_table_destroy(dbus_access_cache);
+		dbus_access_cache = NULL;
+	}
+}
+
+static GHashTable *dbus_access_cache_lookup(const char *sender)
+{
+	/* Only unique names are safe to cache */
+	if (!sender || sender[0] != ':')
+		return NULL;
+
+	if (!dbus_access_cache)
+		dbus_access_cache = g_hash_table_new_full(g_str_hash,
+				g_str_equal, g_free,
+				(GDestroyNotify) g_hash_table_destroy);
+
+	return g_hash_table_lookup(dbus_access_cache, sender);
+}
+
+static void dbus_access_cache_insert(GHashTable *decisions,
+			const char *sender, const struct dbus_access_key *key,
+			ofono_bool_t allowed)
+{
+	if (!decisions) {
+		if (g_hash_table_size(dbus_access_cache) >=
+					DBUS_ACCESS_CACHE_MAX_SENDERS) {
+			/* Missed NameOwnerChanged signals? Start over */
+			DBG("too many senders, flushing the cache");
+			g_hash_table_remove_all(dbus_access_cache);
+		}
+
+		decisions = g_hash_table_new_full(dbus_access_key_hash,
+					dbus_access_key_equal, g_free, NULL);
+		g_hash_table_insert(dbus_access_cache, g_strdup(sender),
+								decisions);
+	}
+
+	g_hash_table_insert(decisions, dbus_access_key_new(key),
+						GINT_TO_POINTER(allowed + 1));
+}
 
 const char *ofono_dbus_access_intf_name(enum ofono_dbus_access_intf intf)
 {
@@ -208,7 +308,7 @@ const char *ofono_dbus_access_method_name(enum ofono_dbus_access_intf intf,
 	return NULL;
 }
 
-ofono_bool_t ofono_dbus_access_method_allowed(const char *sender,
+static ofono_bool_t dbus_access_method_evaluate(const char *sender,
 					enum ofono_dbus_access_intf intf,
 					int method, const char *arg)
 {
@@ -233,6 +333,53 @@ ofono_bool_t ofono_dbus_access_method_allowed(const char *sender,
 	return TRUE;
 }
 
+ofono_bool_t ofono_dbus_access_method_allowed(const char *sender,
+					enum ofono_dbus_access_intf intf,
+					int method, const char *arg)
+{
+	struct dbus_access_key key;
+	GHashTable *decisions;
+	ofono_bool_t allowed;
+
+	/* Nothing to evaluate (and therefore nothing to cache) */
+	if (!dbus_access_plugins)
+		return TRUE;
+
+	key.intf = intf;
+	key.method = method;
+	key.arg = arg;
+
+	decisions = dbus_access_cache_lookup(sender);
+	if (decisions) {
+		gpointer value = g_hash_table_lookup(decisions, &key);
+
+		if (value) {
+			dbus_access_cached_count++;
+			return GPOINTER_TO_INT(value) - 1;
+		}
+	}
+
+	allowed = dbus_access_method_evaluate(sender, intf, method, arg);
+	dbus_access_evaluated_count++;
+	DBG("%s %s.%s(%s) %s (%u cached, %u evaluated)", sender,
+			ofono_dbus_access_intf_name(intf),
+			ofono_dbus_access_method_name(intf, method),
+			arg ? arg : "", allowed ? "allowed" : "denied",
+			dbus_access_cached_count, dbus_access_evaluated_count);
+
+	if (dbus_access_cache && sender && sender[0] == ':')
+		dbus_access_cache_insert(decisions, sender, &key, allowed);
+
+	return allowed;
+}
+
+void __ofono_dbus_access_name_owner_changed(const char *name)
+{
+	if (dbus_access_cache && name &&
+			g_hash_table_remove(dbus_access_cache, name))
+		DBG("%s is gone", name);
+}
+
 /**
  * Returns 0 if both are equal;
  * <0 if a comes before b;
@@ -264,6 +411,7 @@ int ofono_dbus_access_plugin_register
 		return -EALREADY;
 	} else {
 		DBG("%s", plugin->name);
+		dbus_access_cache_clear();
 		dbus_access_plugins = g_slist_insert_sorted(dbus_access_plugins,
 				(void*)plugin, ofono_dbus_access_plugin_sort);
 		return 0;
@@ -275,6 +423,7 @@ void ofono_dbus_access_plugin_unregister
 {
 	if (plugin) {
 		DBG("%s", plugin->name);
+		dbus_access_cache_clear();
 		dbus_access_plugins = g_slist_remove(dbus_access_plugins,
 								plugin);
 	}
@@ -41,6 +41,9 @@
 
 #define RING_TIMEOUT 3
 
+/* Default window for coalescing +CIEV of non-call indicators, in ms */
+#define INDICATOR_INTERVAL 1000
+
 #define CVSD_OFFSET 0
 #define MSBC_OFFSET 1
 #define CODECS_COUNT (MSBC_OFFSET + 1)
@@ -60,6 +63,10 @@ struct ofono_emulator {
 	int l_features;
 	int r_features;
 	GSList *indicators;
+	guint indicator_source;
+	gint64 indicator_flush;		/* When indicator_source fires */
+	unsigned int indicator_interval;
+	unsigned int indicators_suppressed;
 	guint callsetup_source;
 	int pns_id;
 	struct ofono_handsfree_card *card;
@@ -85,8 +92,11 @@ struct indicator {
 	int min;
 	int max;
 	gboolean deferred;
+	gboolean pending;	/* Held back by the rate limit */
 	gboolean active;
 	gboolean mandatory;
+	int reported;		/* Value the HF last saw */
+	gint64 reported_time;
 };
 
 static void emulator_debug(const char *str, void *data)
@@ -374,11 +384,38 @@ static struct ofono_call *find_call_with_status(struct ofono_emulator *em,
 	return __ofono_voicecall_find_call_with_status(vc, status);
 }
 
+static gboolean indicator_enabled(struct ofono_emulator *em,
+						struct indicator *ind)
+{
+	return em->events_mode == 3 && em->events_ind && em->slc &&
+								ind->active;
+}
+
+static void send_indicator(struct ofono_emulator *em, struct indicator *ind,
+								int index)
+{
+	char buf[20];
+
+	sprintf(buf, "+CIEV: %d,%d", index, ind->value);
+	g_at_server_send_unsolicited(em->server, buf);
+
+	ind->reported = ind->value;
+	ind->reported_time = g_get_monotonic_time();
+}
+
+static void report_indicator(struct ofono_emulator *em, struct indicator *ind,
+								int index)
+{
+	if (!g_at_server_command_pending(em->server))
+		send_indicator(em, ind, index);
+	else
+		ind->deferred = TRUE;
+}
+
 static void notify_deferred_indicators(GAtServer *server, void *user_data)
 {
 	struct ofono_emulator *em = user_data;
 	int i;
-	char buf[20];
 	GSList *l;
 	struct indicator *ind;
 
@@ -388,16 +425,106 @@ static void notify_deferred_indicators(GAtServer *server, void *user_data)
 		if (!ind->deferred)
 			continue;
 
-		if (em->events_mode == 3 && em->events_ind && em->slc &&
-				ind->active) {
-			sprintf(buf, "+CIEV: %d,%d", i, ind->value);
-			g_at_server_send_unsolicited(em->server, buf);
-		}
+		if (indicator_enabled(em, ind))
+			send_indicator(em, ind, i);
 
 		ind->deferred = FALSE;
 	}
 }
 
+static gboolean flush_indicators(gpointer user_data);
+
+static void schedule_indicators(struct ofono_emulator *em, gint64 when)
+{
+	const gint64 now = g_get_monotonic_time();
+
+	if (em->indicator_source) {
+		if (em->indicator_flush <= when)
+			return;
+
+		g_source_remove(em->indicator_source);
+	}
+
+	em->indicator_flush = when;
+	em->indicator_source = g_timeout_add(when > now ?
+					(when - now + 999) / 1000 : 0,
+					flush_indicators, em);
+}
+
+static gboolean flush_indicators(gpointer user_data)
+{
+	struct ofono_emulator *em = user_data;
+	const gint64 now = g_get_monotonic_time();
+	const gint64 interval = (gint64) em->indicator_interval * 1000;
+	gint64 next = 0;
+	GSList *l;
+	int i;
+
+	em->indicator_source = 0;
+
+	for (i = 1, l = em->indicators; l; l = l->next, i++) {
+		struct indicator *ind = l->data;
+		const gint64 due = ind->reported_time + interval;
+
+		if (!ind->pending)
+			continue;
+
+		if (due > now) {
+			if (!next || due < next)
+				next = due;
+
+			continue;
+		}
+
+		ind->pending = FALSE;
+
+		/*
+		 * The HF may have disabled the indicator in the meantime,
+		 * or the value may have come back to what it already has.
+		 */
+		if (!indicator_enabled(em, ind) || ind->value == ind->reported) {
+			em->indicators_suppressed++;
+			continue;
+		}
+
+		report_indicator(em, ind, i);
+	}
+
+	if (next)
+		schedule_indicators(em, next);
+
+	return FALSE;
+}
+
+static void indicator_changed(struct ofono_emulator *em,
+					struct indicator *ind, int index)
+{
+	if (!indicator_enabled(em, ind))
+		return;
+
+	/*
+	 * Call related indicators drive the call state machine on the
+	 * HF side and always go out right away. The rest (signal, service,
+	 * roaming, battery) are reported at most once per interval, with
+	 * the latest value winning.
+	 */
+	if (!ind->mandatory && em->indicator_interval) {
+		const gint64 due = ind->reported_time +
+				(gint64) em->indicator_interval * 1000;
+
+		if (ind->pending || due > g_get_monotonic_time()) {
+			if (ind->pending)
+				em->indicators_suppressed++;
+
+			ind->pending = TRUE;
+			schedule_indicators(em, due);
+			return;
+		}
+	}
+
+	report_indicator(em, ind, index);
+}
+
 static gboolean notify_ccwa(void *user_data)
 {
 	struct ofono_emulator *em = user_data;
@@ -535,6 +662,7 @@ static void cind_cb(GAtServer *server, GAtServerRequestType type,
 					l == em->indicators ? "" : ",",
 					ind->value);
 			tmp = tmp + len;
+			ind->reported = ind->value;
 		}
 
 		g_at_server_send_info(em->server, buf, TRUE);
@@ -1158,6 +1286,7 @@ static void emulator_add_indicator(struct ofono_emulator *em, const char* name,
 	ind->min = min;
 	ind->max = max;
 	ind->value = dflt;
+	ind->reported = dflt;
 	ind->active = TRUE;
 	ind->mandatory = mandatory;
 
@@ -1189,6 +1318,13 @@ static void emulator_unregister(struct ofono_atom *atom)
 		em->callsetup_source = 0;
 	}
 
+	if (em->indicator_source) {
+		g_source_remove(em->indicator_source);
+		em->indicator_source = 0;
+	}
+
+	DBG("%u indicator updates suppressed", em->indicators_suppressed);
+
 	for (l = em->indicators; l; l = l->next) {
 		struct indicator *ind = l->data;
 
@@ -1350,6 +1486,7 @@ struct ofono_emulator *ofono_emulator_create(enum ofono_emulator_type type)
 	em->l_features |= HFP_AG_FEATURE_CODEC_NEGOTIATION;
 	em->events_mode = 3;	/* default mode is forwarding events */
 	em->cmee_mode = 0;	/* CME ERROR disabled by default */
+	em->indicator_interval = INDICATOR_INTERVAL;
 
 	return em;
 }
@@ -1611,7 +1748,6 @@ void ofono_emulator_set_indicator(struct ofono_emulator *em,
 					const char *name, int value)
 {
 	int i;
-	char buf[20];
 	struct indicator *ind;
 	struct indicator *call_ind;
 	struct indicator *cs_ind;
@@ -1643,13 +1779,7 @@ void ofono_emulator_set_indicator(struct ofono_emulator *em,
 	if (waiting)
 		notify_ccwa(em);
 
-	if (em->events_mode == 3 && em->events_ind && em->slc && ind->active) {
-		if (!g_at_server_command_pending(em->server)) {
-			sprintf(buf, "+CIEV: %d,%d", i, ind->value);
-			g_at_server_send_unsolicited(em->server, buf);
-		} else
-			ind->deferred = TRUE;
-	}
+	indicator_changed(em, ind, i);
 
 	/*
 	 * Ring timer should be started when:
@@ -1691,7 +1821,6 @@ void __ofono_emulator_set_indicator_forced(struct ofono_emulator *em,
 {
 	int i;
 	struct indicator *ind;
-	char buf[20];
 
 	ind = find_indicator(em, name, &i);
 
@@ -1700,13 +1829,27 @@ void __ofono_emulator_set_indicator_forced(struct ofono_emulator *em,
 
 	ind->value = value;
 
-	if (em->events_mode == 3 && em->events_ind && em->slc && ind->active) {
-		if (!g_at_server_command_pending(em->server)) {
-			sprintf(buf, "+CIEV: %d,%d", i, ind->value);
-			g_at_server_send_unsolicited(em->server, buf);
-		} else
-			ind->deferred = TRUE;
-	}
+	if (indicator_enabled(em, ind))
+		report_indicator(em, ind, i);
+}
+
+void ofono_emulator_set_indicator_interval(struct ofono_emulator *em,
+							unsigned int ms)
+{
+	if (em == NULL)
+		return;
+
+	em->indicator_interval = ms;
+
+	/* Let whatever is being held back go out under the new rules */
+	if (em->indicator_source)
+		schedule_indicators(em, g_get_monotonic_time());
+}
+
+unsigned int ofono_emulator_get_suppressed_indicators(
+					struct ofono_emulator *em)
+{
+	return em ? em->indicators_suppressed : 0;
 }
 
 void __ofono_emulator_slc_condition(struct ofono_emulator *em,
@@ -18,6 +18,8 @@
 #include <errno.h>
 #include <string.h>
 
+#define GPRS_FILTER_MAX_SYNC (8)
+
 struct gprs_filter_request;
 struct gprs_filter_request_fn {
 	const char *name;
@@ -36,6 +38,8 @@ struct gprs_filter_request {
 	GSList *filter_link;
 	guint pending_id;
 	guint next_id;
+	GSourceFunc next_fn;
+	gboolean sync;
 	ofono_destroy_func destroy;
 	void* user_data;
 };
@@ -95,6 +99,7 @@ static void gprs_filter_request_cancel(struct gprs_filter_request *req)
 		g_source_remove(req->next_id);
 		req->next_id = 0;
 	}
+	req->next_fn = NULL;
 }
 
 static void gprs_filter_request_dispose(struct gprs_filter_request *req)
@@ -187,11 +192,39 @@ static void gprs_filter_request_process(struct gprs_filter_request *req)
 	gprs_filter_request_unref(req);
 }
 
+static gboolean gprs_filter_request_next_cb(gpointer data)
+{
+	struct gprs_filter_request *req = data;
+	int n;
+
+	/*
+	 * Steps completed synchronously by the filters are taken right
+	 * here, up to GPRS_FILTER_MAX_SYNC of them in a row. The first
+	 * step always comes from the idle callback so that the caller
+	 * never gets its completion callback invoked from under itself.
+	 */
+	req->next_id = 0;
+	gprs_filter_request_ref(req);
+	for (n = 0; req->next_fn && !req->next_id; n++) {
+		GSourceFunc fn = req->next_fn;
+
+		req->next_fn = NULL;
+		req->sync = (n + 1 < GPRS_FILTER_MAX_SYNC);
+		fn(req);
+	}
+	req->sync = FALSE;
+	gprs_filter_request_unref(req);
+	return G_SOURCE_REMOVE;
+}
+
 static void gprs_filter_request_next(struct gprs_filter_request *req,
 							GSourceFunc fn)
 {
 	req->pending_id = 0;
-	req->next_id = g_idle_add(fn, req);
+	req->next_fn = fn;
+	if (!req->sync) {
+		req->next_id = g_idle_add(gprs_filter_request_next_cb, req);
+	}
 }
 
 static gboolean gprs_filter_request_continue_cb(gpointer data)
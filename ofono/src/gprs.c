@@ -62,6 +62,10 @@
 #define MAX_CONTEXTS 256
 #define SUSPEND_TIMEOUT 8
 
+/* Activation latency buckets: < 250ms, < 500ms, ... < 16s, the rest */
+#define LATENCY_BUCKETS 8
+#define LATENCY_MIN_MS 250
+
 struct ofono_gprs {
 	GSList *contexts;
 	ofono_bool_t attached;
@@ -89,6 +93,12 @@ struct ofono_gprs {
 	struct ofono_atom *atom;
 	unsigned int spn_watch;
 	struct gprs_filter_chain *filters;
+	unsigned int max_activations;	/* 0 means no limit */
+	unsigned int activations;	/* Currently in progress */
+	GSList *activation_queue;	/* Contexts waiting for their turn */
+	guint activation_id;
+	unsigned int settings_batch;
+	ofono_bool_t settings_dirty;
 };
 
 struct ipv4_settings {
@@ -140,6 +150,12 @@ struct pri_context {
 	struct ofono_gprs_primary_context context;
 	struct ofono_gprs_context *context_driver;
 	struct ofono_gprs *gprs;
+	ofono_bool_t activating;	/* Counted in gprs->activations */
+	gint64 activate_time;
+	unsigned int activations_ok;
+	unsigned int activations_failed;
+	unsigned int last_latency;	/* ms */
+	unsigned int latency[LATENCY_BUCKETS];
 };
 
 /*
@@ -151,6 +167,7 @@ struct pri_context {
 
 static void gprs_netreg_update(struct ofono_gprs *gprs);
 static void gprs_deactivate_next(struct ofono_gprs *gprs);
+static void gprs_activate_next(struct ofono_gprs *gprs);
 static void write_context_settings(struct ofono_gprs *gprs,
 						struct pri_context *context);
 
@@ -308,11 +325,71 @@ static gboolean assign_context(struct pri_context *ctx, int use_cid)
 	return FALSE;
 }
 
+static void gprs_settings_sync(struct ofono_gprs *gprs)
+{
+	if (gprs->settings_batch)
+		gprs->settings_dirty = TRUE;
+	else
+		storage_sync(gprs->imsi, SETTINGS_STORE, gprs->settings);
+}
+
+/*
+ * Provisioning and resetting write a whole bunch of contexts in one go,
+ * there's no point in syncing the file after each one of them.
+ */
+static void gprs_settings_batch_begin(struct ofono_gprs *gprs)
+{
+	gprs->settings_batch++;
+}
+
+static void gprs_settings_batch_end(struct ofono_gprs *gprs)
+{
+	if (--gprs->settings_batch || !gprs->settings_dirty)
+		return;
+
+	gprs->settings_dirty = FALSE;
+
+	if (gprs->settings)
+		storage_sync(gprs->imsi, SETTINGS_STORE, gprs->settings);
+}
+
+static void pri_activation_done(struct pri_context *ctx, ofono_bool_t ok)
+{
+	struct ofono_gprs *gprs = ctx->gprs;
+
+	if (!ctx->activating)
+		return;
+
+	ctx->activating = FALSE;
+	gprs->activations--;
+
+	if (ok) {
+		const gint64 ms = (g_get_monotonic_time() -
+					ctx->activate_time) / 1000;
+		unsigned int i = 0;
+
+		while (i < LATENCY_BUCKETS - 1 && ms >= (LATENCY_MIN_MS << i))
+			i++;
+
+		ctx->latency[i]++;
+		ctx->last_latency = ms;
+		ctx->activations_ok++;
+		DBG("%s activated in %u ms", ctx->path, ctx->last_latency);
+	} else
+		ctx->activations_failed++;
+
+	if (gprs->activation_queue)
+		gprs_activate_next(gprs);
+}
+
 static void release_context(struct pri_context *ctx)
 {
 	if (ctx == NULL || ctx->gprs == NULL || ctx->context_driver == NULL)
 		return;
 
+	ctx->gprs->activation_queue =
+		g_slist_remove(ctx->gprs->activation_queue, ctx);
+
 	__ofono_gprs_filter_chain_cancel(ctx->gprs->filters,
 						ctx->context_driver);
 
@@ -321,6 +398,7 @@ static void release_context(struct pri_context *ctx)
 	ctx->context_driver->inuse = FALSE;
 	ctx->context_driver = NULL;
 	ctx->active = FALSE;
+	pri_activation_done(ctx, FALSE);
 }
 
 static struct pri_context *gprs_context_by_path(struct ofono_gprs *gprs,
@@ -1149,6 +1227,7 @@ static void pri_activate_callback(const struct ofono_error *error, void *data)
 
 	DBG("%p", ctx);
 
+	pri_activation_done(ctx, TRUE);
 	ctx->active = TRUE;
 	__ofono_dbus_pending_reply(&ctx->pending,
 				dbus_message_new_method_return(ctx->pending));
@@ -1562,6 +1641,7 @@ static void pri_request_free(void *user_data)
 	if (pri->pending && pri->pending == data->msg) {
 		__ofono_dbus_pending_reply(&pri->pending,
 				__ofono_error_canceled(pri->pending));
+		pri_activation_done(pri, FALSE);
 	}
 
 	g_free(data);
@@ -1579,10 +1659,156 @@ static void pri_activate_filt(const struct ofono_gprs_primary_context *ctx,
 
 		gc->driver->activate_primary(gc, ctx, pri_activate_callback,
 									pri);
-	} else if (pri->pending != NULL) {
-		__ofono_dbus_pending_reply(&pri->pending,
+	} else {
+		if (pri->pending != NULL)
+			__ofono_dbus_pending_reply(&pri->pending,
 				__ofono_error_access_denied(pri->pending));
+
+		pri_activation_done(pri, FALSE);
+	}
+}
+
+static void pri_activate_start(struct pri_context *ctx)
+{
+	struct ofono_gprs_context *gc = ctx->context_driver;
+
+	ctx->activating = TRUE;
+	ctx->gprs->activations++;
+
+	__ofono_gprs_filter_chain_activate(gc->gprs->filters, gc,
+				&ctx->context, pri_activate_filt,
+				pri_request_free, pri_request_new(ctx));
+}
+
+static gboolean gprs_activate_queued(gpointer user_data)
+{
+	struct ofono_gprs *gprs = user_data;
+
+	gprs->activation_id = 0;
+
+	while (gprs->activation_queue && (!gprs->max_activations ||
+			gprs->activations < gprs->max_activations)) {
+		struct pri_context *ctx = gprs->activation_queue->data;
+
+		gprs->activation_queue = g_slist_delete_link(
+				gprs->activation_queue, gprs->activation_queue);
+
+		/* Things may have changed while it was waiting */
+		if (!gprs->attached) {
+			ctx->activations_failed++;
+			__ofono_dbus_pending_reply(&ctx->pending,
+				__ofono_error_not_attached(ctx->pending));
+			context_settings_free(ctx->context_driver->settings);
+			release_context(ctx);
+			continue;
+		}
+
+		DBG("%s", ctx->path);
+		pri_activate_start(ctx);
+	}
+
+	return FALSE;
+}
+
+/*
+ * The next activation is started from a fresh main loop iteration,
+ * since we usually get here from somewhere deep inside the completion
+ * or cancellation of the previous one.
+ */
+static void gprs_activate_next(struct ofono_gprs *gprs)
+{
+	if (!gprs->activation_id)
+		gprs->activation_id = g_idle_add(gprs_activate_queued, gprs);
+}
+
+static void pri_activate(struct pri_context *ctx)
+{
+	struct ofono_gprs *gprs = ctx->gprs;
+
+	ctx->activate_time = g_get_monotonic_time();
+
+	if (gprs->max_activations &&
+			gprs->activations >= gprs->max_activations) {
+		DBG("%s waits, %u activations in progress", ctx->path,
+							gprs->activations);
+		gprs->activation_queue = g_slist_append(gprs->activation_queue,
+									ctx);
+		return;
+	}
+
+	pri_activate_start(ctx);
+}
+
+static void append_latency_histogram(struct pri_context *ctx,
+						DBusMessageIter *dict)
+{
+	const char *key = "Latency";
+	DBusMessageIter entry;
+	DBusMessageIter var;
+	DBusMessageIter array;
+	unsigned int i;
+
+	dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY,
+						NULL, &entry);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &key);
+	dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT,
+					DBUS_TYPE_ARRAY_AS_STRING
+					DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+					DBUS_TYPE_UINT32_AS_STRING
+					DBUS_TYPE_UINT32_AS_STRING
+					DBUS_STRUCT_END_CHAR_AS_STRING, &var);
+	dbus_message_iter_open_container(&var, DBUS_TYPE_ARRAY,
+					DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+					DBUS_TYPE_UINT32_AS_STRING
+					DBUS_TYPE_UINT32_AS_STRING
+					DBUS_STRUCT_END_CHAR_AS_STRING, &array);
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		/* The last bucket has no upper limit */
+		const dbus_uint32_t limit = (i < LATENCY_BUCKETS - 1) ?
+						(LATENCY_MIN_MS << i) : 0;
+		const dbus_uint32_t count = ctx->latency[i];
+		DBusMessageIter st;
+
+		dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT,
+								NULL, &st);
+		dbus_message_iter_append_basic(&st, DBUS_TYPE_UINT32, &limit);
+		dbus_message_iter_append_basic(&st, DBUS_TYPE_UINT32, &count);
+		dbus_message_iter_close_container(&array, &st);
 	}
+
+	dbus_message_iter_close_container(&var, &array);
+	dbus_message_iter_close_container(&entry, &var);
+	dbus_message_iter_close_container(dict, &entry);
+}
+
+static DBusMessage *pri_get_activation_stats(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	struct pri_context *ctx = data;
+	DBusMessage *reply;
+	DBusMessageIter iter;
+	DBusMessageIter dict;
+
+	reply = dbus_message_new_method_return(msg);
+	if (reply == NULL)
+		return NULL;
+
+	dbus_message_iter_init_append(reply, &iter);
+
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&dict);
+	ofono_dbus_dict_append(&dict, "Succeeded", DBUS_TYPE_UINT32,
+						&ctx->activations_ok);
+	ofono_dbus_dict_append(&dict, "Failed", DBUS_TYPE_UINT32,
+						&ctx->activations_failed);
+	ofono_dbus_dict_append(&dict, "LastLatency", DBUS_TYPE_UINT32,
+						&ctx->last_latency);
+	append_latency_histogram(ctx, &dict);
+	dbus_message_iter_close_container(&iter, &dict);
+
+	return reply;
 }
 
 static DBusMessage *pri_set_property(DBusConnection *conn,
@@ -1614,8 +1840,6 @@ static DBusMessage *pri_set_property(DBusConnection *conn,
 	dbus_message_iter_recurse(&iter, &var);
 
 	if (g_str_equal(property, "Active")) {
-		struct ofono_gprs_context *gc;
-
 		if (ctx->gprs->pending)
 			return __ofono_error_busy(msg);
 
@@ -1639,17 +1863,14 @@ static DBusMessage *pri_set_property(DBusConnection *conn,
 		if (value && assign_context(ctx, 0) == FALSE)
 			return __ofono_error_not_implemented(msg);
 
-		gc = ctx->context_driver;
-
 		ctx->pending = dbus_message_ref(msg);
 
 		if (value)
-			__ofono_gprs_filter_chain_activate(gc->gprs->filters,
-				gc, &ctx->context, pri_activate_filt,
-				pri_request_free, pri_request_new(ctx));
+			pri_activate(ctx);
 		else
-			gc->driver->deactivate_primary(gc, ctx->context.cid,
-						pri_deactivate_callback, ctx);
+			ctx->context_driver->driver->deactivate_primary(
+					ctx->context_driver, ctx->context.cid,
+					pri_deactivate_callback, ctx);
 
 		return NULL;
 	}
@@ -1740,6 +1961,9 @@ static const GDBusMethodTable context_methods[] = {
 			NULL, pri_set_property) },
 	{ GDBUS_METHOD("ProvisionContext", NULL, NULL,
 			pri_provision_context) },
+	{ GDBUS_METHOD("GetActivationStatistics",
+			NULL, GDBUS_ARGS({ "statistics", "a{sv}" }),
+			pri_get_activation_stats) },
 	{ }
 };
 
@@ -2363,7 +2587,7 @@ static struct pri_context *add_context(struct ofono_gprs *gprs,
 
 	if (gprs->settings) {
 		write_context_settings(gprs, context);
-		storage_sync(gprs->imsi, SETTINGS_STORE, gprs->settings);
+		gprs_settings_sync(gprs);
 	}
 
 	gprs->contexts = g_slist_append(gprs->contexts, context);
@@ -2819,7 +3043,7 @@ static void provision_context(const struct ofono_gprs_provision_data *ap,
 
 	if (gprs->settings) {
 		write_context_settings(gprs, context);
-		storage_sync(gprs->imsi, SETTINGS_STORE, gprs->settings);
+		gprs_settings_sync(gprs);
 	}
 
 	gprs->contexts = g_slist_append(gprs->contexts, context);
@@ -2838,6 +3062,8 @@ static void provision_contexts(struct ofono_gprs *gprs, const char *mcc,
 		return;
 	}
 
+	gprs_settings_batch_begin(gprs);
+
 	for (i = 0; i < count; i++) {
 		const struct ofono_gprs_provision_data *ap = settings + i;
 
@@ -2846,6 +3072,7 @@ static void provision_contexts(struct ofono_gprs *gprs, const char *mcc,
 		}
 	}
 
+	gprs_settings_batch_end(gprs);
 	ofono_gprs_provision_free_settings(settings, count);
 }
 
@@ -2869,6 +3096,8 @@ static void configure_remaining_contexts(struct ofono_gprs *gprs)
 {
 	GSList *l;
 
+	gprs_settings_batch_begin(gprs);
+
 	for (l = gprs->context_drivers; l; l = l->next) {
 		struct ofono_gprs_context *gc = l->data;
 
@@ -2883,6 +3112,8 @@ static void configure_remaining_contexts(struct ofono_gprs *gprs)
 					OFONO_GPRS_CONTEXT_TYPE_INTERNET)) {
 		add_context(gprs, NULL, OFONO_GPRS_CONTEXT_TYPE_INTERNET);
 	}
+
+	gprs_settings_batch_end(gprs);
 }
 
 static void remove_non_active_context(struct ofono_gprs *gprs,
@@ -2893,7 +3124,7 @@ static void remove_non_active_context(struct ofono_gprs *gprs,
 
 	if (gprs->settings) {
 		g_key_file_remove_group(gprs->settings, ctx->key, NULL);
-		storage_sync(gprs->imsi, SETTINGS_STORE, gprs->settings);
+		gprs_settings_sync(gprs);
 	}
 
 	/* Make a backup copy of path for signal emission below */
@@ -2954,6 +3185,7 @@ static DBusMessage *gprs_reset_contexts(DBusConnection *conn,
 		return NULL;
 
 	/* Remove first the current contexts, re-provision after */
+	gprs_settings_batch_begin(gprs);
 
 	while (gprs->contexts != NULL) {
 		struct pri_context *ctx = gprs->contexts->data;
@@ -2966,6 +3198,7 @@ static DBusMessage *gprs_reset_contexts(DBusConnection *conn,
 				ofono_sim_get_mnc(sim), ofono_sim_get_spn(sim));
 
 	configure_remaining_contexts(gprs);
+	gprs_settings_batch_end(gprs);
 
 	for (l = gprs->contexts; l; l = l->next) {
 		struct pri_context *ctx = l->data;
@@ -3073,6 +3306,18 @@ void ofono_gprs_set_cid_range(struct ofono_gprs *gprs,
 	gprs->cid_map = idmap_new_from_range(min, max);
 }
 
+void ofono_gprs_set_max_activations(struct ofono_gprs *gprs,
+							unsigned int max)
+{
+	if (gprs == NULL)
+		return;
+
+	gprs->max_activations = max;
+
+	if (gprs->activation_queue)
+		gprs_activate_next(gprs);
+}
+
 static void gprs_context_unregister(struct ofono_atom *atom)
 {
 	struct ofono_gprs_context *gc = __ofono_atom_get_data(atom);
@@ -3096,8 +3341,11 @@ static void gprs_context_unregister(struct ofono_atom *atom)
 			__ofono_dbus_pending_reply(&ctx->pending,
 					__ofono_error_failed(ctx->pending));
 
-		if (ctx->active == FALSE)
+		if (ctx->active == FALSE) {
+			/* Activation in progress or waiting for its turn */
+			release_context(ctx);
 			break;
+		}
 
 		pri_reset_context_settings(ctx);
 		release_context(ctx);
@@ -3506,6 +3754,21 @@ static void free_contexts(struct ofono_gprs *gprs)
 {
 	GSList *l;
 
+	if (gprs->activation_id) {
+		g_source_remove(gprs->activation_id);
+		gprs->activation_id = 0;
+	}
+
+	for (l = gprs->activation_queue; l; l = l->next) {
+		struct pri_context *ctx = l->data;
+
+		__ofono_dbus_pending_reply(&ctx->pending,
+					__ofono_error_canceled(ctx->pending));
+	}
+
+	g_slist_free(gprs->activation_queue);
+	gprs->activation_queue = NULL;
+
 	if (gprs->settings) {
 		storage_close(gprs->imsi, SETTINGS_STORE,
 				gprs->settings, TRUE);
@@ -3578,6 +3841,11 @@ static void gprs_remove(struct ofono_atom *atom)
 	if (gprs->suspend_timeout)
 		g_source_remove(gprs->suspend_timeout);
 
+	if (gprs->activation_id)
+		g_source_remove(gprs->activation_id);
+
+	g_slist_free(gprs->activation_queue);
+
 	if (gprs->pid_map) {
 		idmap_free(gprs->pid_map);
 		gprs->pid_map = NULL;
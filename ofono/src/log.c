@@ -26,11 +26,19 @@
 
 #define _GNU_SOURCE
 #include <stdio.h>
+#include <errno.h>
 #include <unistd.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
 #include <syslog.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #ifdef __GLIBC__
 #include <execinfo.h>
 #endif
@@ -44,6 +52,158 @@ static GString *ofono_debug_str;
 static const char *program_exec;
 static const char *program_path;
 
+/*
+ * Asynchronous log sink.
+ *
+ * Messages are formatted by the caller straight into a slot of a
+ * preallocated ring, and a separate thread drains the ring in batches
+ * and does the actual, potentially blocking, output. Only the main
+ * thread ever produces records, so the ring needs no locks, just
+ * ordered head and tail updates. When the writer can't keep up, new
+ * records are dropped and counted instead of stalling the main loop.
+ *
+ * Messages from other threads, and everything logged before the sink
+ * is started or after it is stopped, go to syslog synchronously.
+ *
+ * Text that doesn't fit into a slot is allocated separately and freed
+ * by the log thread.
+ *
+ * The file target is reopened when the file gets renamed or removed
+ * by log rotation, copytruncate works as is thanks to O_APPEND.
+ */
+
+#define LOG_RING_SIZE (256)		/* Must be a power of 2 */
+#define LOG_TEXT_SIZE (1024)
+#define LOG_FIELD_SIZE (64)
+#define LOG_BATCH_SIZE (32768)
+#define LOG_CRASH_FLUSH_MS (200)
+#define LOG_JOURNAL_SOCKET "/run/systemd/journal/socket"
+
+enum log_target {
+	LOG_TARGET_SYSLOG,
+	LOG_TARGET_JOURNAL,
+	LOG_TARGET_FILE
+};
+
+struct log_record {
+	gint64 time;
+	int priority;
+	char file[LOG_FIELD_SIZE];
+	char subsystem[LOG_FIELD_SIZE];
+	char modem[LOG_FIELD_SIZE];
+	char *long_text;
+	char text[LOG_TEXT_SIZE];
+};
+
+static struct log_record *log_ring;
+static guint log_head;			/* Only written by the main thread */
+static guint log_tail;			/* Only written by the log thread */
+static gint log_dropped;
+static gint log_sleeping;
+static gint log_quit;
+static int log_wakeup_fd = -1;
+static int log_out_fd = -1;
+static char *log_out_path;
+static enum log_target log_target;
+static gboolean log_stderr;
+static GThread *log_main_thread;
+static GThread *log_thread;
+static const char *log_ident;
+static char log_modem[LOG_FIELD_SIZE];
+
+static void log_hook_printf(const struct ofono_debug_desc *desc,
+				int priority, const char *format, ...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	ofono_log_hook(desc, priority, format, ap);
+	va_end(ap);
+}
+
+static void log_sync(const struct ofono_debug_desc *desc, int priority,
+					const char *format, va_list ap)
+{
+	if (desc && ofono_debug_str) {
+		g_string_vprintf(ofono_debug_str, format, ap);
+		syslog(priority, "%s:%s", desc->file, ofono_debug_str->str);
+	} else {
+		vsyslog(priority, format, ap);
+	}
+}
+
+static struct log_record *log_reserve(void)
+{
+	const guint head = log_head;
+
+	if (head - g_atomic_int_get(&log_tail) >= LOG_RING_SIZE) {
+		g_atomic_int_inc(&log_dropped);
+		return NULL;
+	}
+
+	return log_ring + (head & (LOG_RING_SIZE - 1));
+}
+
+static void log_commit(void)
+{
+	g_atomic_int_set(&log_head, log_head + 1);
+
+	/* Only the first record after the log thread went idle wakes it */
+	if (g_atomic_int_compare_and_exchange(&log_sleeping, 1, 0))
+		eventfd_write(log_wakeup_fd, 1);
+}
+
+static void log_write(const struct ofono_debug_desc *desc, int priority,
+					const char *format, va_list ap)
+{
+	struct log_record *rec;
+	va_list cp;
+	int n;
+
+	if (!log_ring || g_thread_self() != log_main_thread) {
+		if (ofono_log_hook)
+			va_copy(cp, ap);
+
+		log_sync(desc, priority, format, ap);
+
+		if (ofono_log_hook) {
+			ofono_log_hook(desc, priority, format, cp);
+			va_end(cp);
+		}
+
+		return;
+	}
+
+	rec = log_reserve();
+	if (!rec) {
+		if (ofono_log_hook)
+			ofono_log_hook(desc, priority, format, ap);
+
+		return;
+	}
+
+	rec->time = g_get_real_time();
+	rec->priority = priority;
+	g_strlcpy(rec->file, (desc && desc->file) ? desc->file : "",
+							sizeof(rec->file));
+	g_strlcpy(rec->subsystem, (desc && desc->name) ? desc->name : "",
+						sizeof(rec->subsystem));
+	memcpy(rec->modem, log_modem, sizeof(rec->modem));
+
+	va_copy(cp, ap);
+	n = vsnprintf(rec->text, sizeof(rec->text), format, ap);
+	rec->long_text = (n >= (int) sizeof(rec->text)) ?
+					g_strdup_vprintf(format, cp) : NULL;
+	va_end(cp);
+
+	/* The hook gets the same text, no need to format it twice */
+	if (ofono_log_hook)
+		log_hook_printf(desc, priority, "%s", rec->long_text ?
+						rec->long_text : rec->text);
+
+	log_commit();
+}
+
 /**
  * ofono_info:
  * @format: format string
@@ -56,16 +216,8 @@ void ofono_info(const char *format, ...)
 	va_list ap;
 
 	va_start(ap, format);
-
-	vsyslog(LOG_INFO, format, ap);
-
+	log_write(NULL, LOG_INFO, format, ap);
 	va_end(ap);
-
-	if (ofono_log_hook) {
-		va_start(ap, format);
-		ofono_log_hook(NULL, LOG_INFO, format, ap);
-		va_end(ap);
-	}
 }
 
 /**
@@ -80,16 +232,8 @@ void ofono_warn(const char *format, ...)
 	va_list ap;
 
 	va_start(ap, format);
-
-	vsyslog(LOG_WARNING, format, ap);
-
+	log_write(NULL, LOG_WARNING, format, ap);
 	va_end(ap);
-
-	if (ofono_log_hook) {
-		va_start(ap, format);
-		ofono_log_hook(NULL, LOG_WARNING, format, ap);
-		va_end(ap);
-	}
 }
 
 /**
@@ -104,16 +248,8 @@ void ofono_error(const char *format, ...)
 	va_list ap;
 
 	va_start(ap, format);
-
-	vsyslog(LOG_ERR, format, ap);
-
+	log_write(NULL, LOG_ERR, format, ap);
 	va_end(ap);
-
-	if (ofono_log_hook) {
-		va_start(ap, format);
-		ofono_log_hook(NULL, LOG_ERR, format, ap);
-		va_end(ap);
-	}
 }
 
 /**
@@ -131,41 +267,415 @@ void ofono_debug(const char *format, ...)
 	va_list ap;
 
 	va_start(ap, format);
+	log_write(NULL, LOG_DEBUG, format, ap);
+	va_end(ap);
+}
 
-	vsyslog(LOG_DEBUG, format, ap);
+void ofono_dbg(const struct ofono_debug_desc *desc, const char *format, ...)
+{
+	va_list ap;
+
+	if (!(desc->flags & OFONO_DEBUG_FLAG_PRINT))
+		return;
 
+	va_start(ap, format);
+	log_write(desc, LOG_DEBUG, format, ap);
 	va_end(ap);
+}
+
+void __ofono_log_set_modem(const char *path)
+{
+	if (!path)
+		log_modem[0] = 0;
+	else if (strcmp(log_modem, path))
+		g_strlcpy(log_modem, path, sizeof(log_modem));
+}
 
-	if (ofono_log_hook) {
-		va_start(ap, format);
-		ofono_log_hook(NULL, LOG_DEBUG, format, ap);
-		va_end(ap);
+static inline const char *log_record_text(const struct log_record *rec)
+{
+	return rec->long_text ? rec->long_text : rec->text;
+}
+
+/* Longest possible line for the record, including the NUL */
+static gsize log_line_size(const struct log_record *rec)
+{
+	return strlen(log_record_text(rec)) + strlen(log_ident) +
+					3 * LOG_FIELD_SIZE + 64;
+}
+
+/* Appends a line in the traditional syslog-like format */
+static gsize log_format_line(char *buf, gsize size,
+					const struct log_record *rec)
+{
+	const time_t sec = rec->time / G_USEC_PER_SEC;
+	struct tm tm;
+	gsize len;
+	int n;
+
+	localtime_r(&sec, &tm);
+	len = strftime(buf, size, "%b %d %H:%M:%S", &tm);
+	n = snprintf(buf + len, size - len, ".%06u %s[%d]: %s%s%s%s%s\n",
+			(guint) (rec->time % G_USEC_PER_SEC), log_ident,
+			(int) getpid(), rec->modem, rec->modem[0] ? " " : "",
+			rec->file, rec->file[0] ? ":" : "",
+			log_record_text(rec));
+
+	/* Truncated lines still end with a newline */
+	if (n < 0)
+		return len;
+
+	len += n;
+	if (len >= size) {
+		len = size - 1;
+		buf[len - 1] = '\n';
 	}
+
+	return len;
 }
 
-void ofono_dbg(const struct ofono_debug_desc *desc, const char *format, ...)
+static void log_write_fd(int fd, const char *buf, gsize len)
+{
+	while (len > 0) {
+		const ssize_t n = write(fd, buf, len);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		if (n <= 0)
+			break;
+
+		buf += n;
+		len -= n;
+	}
+}
+
+/* Appends a newline terminated field, len never goes past the end */
+static gsize log_append_field(char *buf, gsize size, gsize len,
+					const char *format, ...)
+					G_GNUC_PRINTF(4, 5);
+
+static gsize log_append_field(char *buf, gsize size, gsize len,
+					const char *format, ...)
 {
 	va_list ap;
+	int n;
 
-	if (!(desc->flags & OFONO_DEBUG_FLAG_PRINT))
-		return;
+	if (len + 1 >= size)
+		return len;
 
 	va_start(ap, format);
+	n = vsnprintf(buf + len, size - len, format, ap);
+	va_end(ap);
 
-	if (ofono_debug_str) {
-		g_string_vprintf(ofono_debug_str, format, ap);
-		syslog(LOG_DEBUG, "%s:%s", desc->file, ofono_debug_str->str);
+	if (n < 0)
+		return len;
+
+	len += n;
+	if (len >= size) {
+		len = size - 1;
+		buf[len - 1] = '\n';
+	}
+
+	return len;
+}
+
+static void log_send_journal(const struct log_record *rec)
+{
+	static const char message[] = "MESSAGE\n";
+	char fields[4 * LOG_FIELD_SIZE + 128];
+	const char *text = log_record_text(rec);
+	const guint64 len = GUINT64_TO_LE(strlen(text));
+	struct iovec iov[5];
+	struct msghdr msg;
+	gsize n;
+
+	n = log_append_field(fields, sizeof(fields), 0, "PRIORITY=%d\n"
+			"SYSLOG_IDENTIFIER=%s\nSYSLOG_PID=%d\n"
+			"OFONO_TIMESTAMP=%" G_GINT64_FORMAT "\n",
+			rec->priority, log_ident, (int) getpid(), rec->time);
+
+	if (rec->file[0])
+		n = log_append_field(fields, sizeof(fields), n,
+					"CODE_FILE=%s\n", rec->file);
+
+	if (rec->subsystem[0])
+		n = log_append_field(fields, sizeof(fields), n,
+				"OFONO_SUBSYSTEM=%s\n", rec->subsystem);
+
+	if (rec->modem[0])
+		n = log_append_field(fields, sizeof(fields), n,
+					"OFONO_MODEM=%s\n", rec->modem);
+
+	/* MESSAGE uses the length-prefixed form, it may contain newlines */
+	iov[0].iov_base = fields;
+	iov[0].iov_len = n;
+	iov[1].iov_base = (void *) message;
+	iov[1].iov_len = sizeof(message) - 1;
+	iov[2].iov_base = (void *) &len;
+	iov[2].iov_len = sizeof(len);
+	iov[3].iov_base = (void *) text;
+	iov[3].iov_len = strlen(text);
+	iov[4].iov_base = (void *) "\n";
+	iov[4].iov_len = 1;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = G_N_ELEMENTS(iov);
+	sendmsg(log_out_fd, &msg, MSG_NOSIGNAL);
+}
+
+static int log_open_file(const char *path)
+{
+	return open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+
+/* Switches to a new file if the old one has been rotated away */
+static void log_check_rotated(void)
+{
+	struct stat path_st, fd_st;
+	int fd;
+
+	if (!stat(log_out_path, &path_st) && !fstat(log_out_fd, &fd_st) &&
+			path_st.st_dev == fd_st.st_dev &&
+			path_st.st_ino == fd_st.st_ino)
+		return;
+
+	/* If that fails, keep writing where we were writing before */
+	fd = log_open_file(log_out_path);
+	if (fd < 0)
+		return;
+
+	close(log_out_fd);
+	log_out_fd = fd;
+}
+
+static void log_flush_batch(char *buf, gsize len)
+{
+	if (log_out_fd >= 0 && log_target == LOG_TARGET_FILE) {
+		log_check_rotated();
+		log_write_fd(log_out_fd, buf, len);
+	}
+
+	if (log_stderr)
+		log_write_fd(STDERR_FILENO, buf, len);
+}
+
+static void log_output(const struct log_record *rec, char *buf,
+							gsize *len)
+{
+	const char *text = log_record_text(rec);
+	gsize size;
+
+	switch (log_target) {
+	case LOG_TARGET_SYSLOG:
+		if (rec->file[0])
+			syslog(rec->priority, "%s:%s", rec->file, text);
+		else
+			syslog(rec->priority, "%s", text);
+		return;
+	case LOG_TARGET_JOURNAL:
+		log_send_journal(rec);
+		if (!log_stderr)
+			return;
+		break;
+	case LOG_TARGET_FILE:
+		break;
+	}
+
+	/* Collect the lines and write them out in one go */
+	size = log_line_size(rec);
+	if (*len + size > LOG_BATCH_SIZE) {
+		log_flush_batch(buf, *len);
+		*len = 0;
+	}
+
+	if (size <= LOG_BATCH_SIZE) {
+		*len += log_format_line(buf + *len, LOG_BATCH_SIZE - *len,
+									rec);
 	} else {
-		vsyslog(LOG_DEBUG, format, ap);
+		/* Too long for the batch buffer, write it out separately */
+		char *line = g_malloc(size);
+
+		log_flush_batch(line, log_format_line(line, size, rec));
+		g_free(line);
 	}
+}
 
-	va_end(ap);
+static void log_drain(char *buf)
+{
+	const gint dropped = g_atomic_int_get(&log_dropped);
+	const guint head = g_atomic_int_get(&log_head);
+	guint tail = log_tail;
+	gsize len = 0;
+
+	if (dropped > 0) {
+		struct log_record rec;
+
+		g_atomic_int_add(&log_dropped, -dropped);
+		memset(&rec, 0, sizeof(rec));
+		rec.time = g_get_real_time();
+		rec.priority = LOG_WARNING;
+		snprintf(rec.text, sizeof(rec.text),
+				"%d log messages dropped", dropped);
+		log_output(&rec, buf, &len);
+	}
+
+	while (tail != head) {
+		struct log_record *rec = log_ring + (tail & (LOG_RING_SIZE - 1));
+
+		log_output(rec, buf, &len);
+		g_free(rec->long_text);
+		rec->long_text = NULL;
+		tail++;
+	}
+
+	if (len > 0)
+		log_flush_batch(buf, len);
+
+	/* Hand the whole batch back to the producer at once */
+	g_atomic_int_set(&log_tail, tail);
+}
+
+static gpointer log_thread_run(gpointer data)
+{
+	char *buf = g_malloc(LOG_BATCH_SIZE);
+
+	while (TRUE) {
+		if (g_atomic_int_get(&log_head) != log_tail ||
+				g_atomic_int_get(&log_dropped)) {
+			log_drain(buf);
+			continue;
+		}
+
+		if (g_atomic_int_get(&log_quit))
+			break;
 
-	if (ofono_log_hook) {
-		va_start(ap, format);
-		ofono_log_hook(desc, LOG_DEBUG, format, ap);
-		va_end(ap);
+		/*
+		 * Announce that we are going to sleep, then look again.
+		 * A record committed before the flag was set is seen here,
+		 * one committed after it wakes us up.
+		 */
+		g_atomic_int_set(&log_sleeping, 1);
+		if (g_atomic_int_get(&log_head) == log_tail &&
+					!g_atomic_int_get(&log_quit)) {
+			eventfd_t value;
+
+			eventfd_read(log_wakeup_fd, &value);
+		}
+
+		g_atomic_int_set(&log_sleeping, 0);
+	}
+
+	g_free(buf);
+	return NULL;
+}
+
+/* Gives the log thread a chance to write out what's already queued */
+static void log_flush_wait(unsigned int ms)
+{
+	const gint64 deadline = g_get_monotonic_time() + ms * 1000;
+
+	while (g_atomic_int_get(&log_tail) != log_head &&
+				g_get_monotonic_time() < deadline)
+		g_usleep(1000);
+}
+
+static int log_open_target(const char *target)
+{
+	if (!target || !strcmp(target, "syslog")) {
+		log_target = LOG_TARGET_SYSLOG;
+		return 0;
+	}
+
+	if (!strcmp(target, "journal")) {
+		struct sockaddr_un addr;
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		g_strlcpy(addr.sun_path, LOG_JOURNAL_SOCKET,
+						sizeof(addr.sun_path));
+
+		log_out_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+		if (log_out_fd < 0)
+			return -errno;
+
+		if (connect(log_out_fd, (struct sockaddr *) &addr,
+							sizeof(addr)) < 0)
+			return -errno;
+
+		log_target = LOG_TARGET_JOURNAL;
+		return 0;
 	}
+
+	log_out_fd = log_open_file(target);
+	if (log_out_fd < 0)
+		return -errno;
+
+	log_out_path = g_strdup(target);
+	log_target = LOG_TARGET_FILE;
+	return 0;
+}
+
+static void log_close_target(void)
+{
+	if (log_out_fd >= 0) {
+		close(log_out_fd);
+		log_out_fd = -1;
+	}
+
+	g_free(log_out_path);
+	log_out_path = NULL;
+}
+
+int __ofono_log_start(const char *target)
+{
+	int err;
+
+	if (log_thread)
+		return -EALREADY;
+
+	err = log_open_target(target);
+	if (err < 0) {
+		ofono_error("Can't log to %s: %s", target, strerror(-err));
+		log_close_target();
+		return err;
+	}
+
+	log_wakeup_fd = eventfd(0, EFD_CLOEXEC);
+	if (log_wakeup_fd < 0) {
+		err = -errno;
+		ofono_error("eventfd failed: %s", strerror(errno));
+		log_close_target();
+		return err;
+	}
+
+	log_ring = g_new0(struct log_record, LOG_RING_SIZE);
+	log_head = log_tail = 0;
+	log_dropped = log_sleeping = log_quit = 0;
+	log_main_thread = g_thread_self();
+	log_thread = g_thread_new("ofono-log", log_thread_run, NULL);
+	return 0;
+}
+
+static void log_stop(void)
+{
+	if (!log_thread)
+		return;
+
+	/* Everything logged from now on goes to syslog directly */
+	log_main_thread = NULL;
+	g_atomic_int_set(&log_quit, 1);
+	eventfd_write(log_wakeup_fd, 1);
+	g_thread_join(log_thread);
+	log_thread = NULL;
+
+	close(log_wakeup_fd);
+	log_wakeup_fd = -1;
+
+	log_close_target();
+
+	g_free(log_ring);
+	log_ring = NULL;
 }
 
 #ifdef __GLIBC__
@@ -276,6 +786,12 @@ static void print_backtrace(unsigned int offset)
 
 static void signal_handler(int signo)
 {
+	/* Let the queued messages out first, then log synchronously */
+	if (log_thread) {
+		log_flush_wait(LOG_CRASH_FLUSH_MS);
+		log_main_thread = NULL;
+	}
+
 	ofono_error("Aborting (signal %d) [%s]", signo, program_exec);
 
 	print_backtrace(2);
@@ -372,12 +888,15 @@ int __ofono_log_init(const char *program, const char *debug,
 	if (detach == FALSE)
 		option |= LOG_PERROR;
 
+	log_ident = basename(program);
+	log_stderr = !detach;
+
 #ifdef __GLIBC__
 	if (backtrace == TRUE)
 		signal_setup(signal_handler);
 #endif
 
-	openlog(basename(program), option, LOG_DAEMON);
+	openlog(log_ident, option, LOG_DAEMON);
 
 	syslog(LOG_INFO, "oFono version %s", VERSION);
 
@@ -386,6 +905,8 @@ int __ofono_log_init(const char *program, const char *debug,
 
 void __ofono_log_cleanup(ofono_bool_t backtrace)
 {
+	log_stop();
+
 	syslog(LOG_INFO, "Exit");
 
 	closelog();
@@ -396,6 +917,7 @@ void __ofono_log_cleanup(ofono_bool_t backtrace)
 #endif
 
 	g_strfreev(enabled);
+	enabled = NULL;
 	g_string_free(ofono_debug_str, TRUE);
 	ofono_debug_str = NULL;
 }
@@ -0,0 +1,359 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <glib.h>
+#include <gdbus.h>
+
+#include "ofono.h"
+
+/*
+ * Main loop accounting.
+ *
+ * GLib has no hook around the dispatch of individual sources, so the
+ * poll function is wrapped instead: everything that runs between two
+ * polls is one dispatch round. Code that knows on whose behalf it is
+ * running (modem traffic, D-Bus messages, ELL events, signals) marks
+ * the round with a name, and the time the round took is split evenly
+ * between the names that were marked. Rounds that nobody claimed are
+ * accounted to "other".
+ */
+
+#define LOOPSTAT_MAX_ENTRIES (128)
+#define LOOPSTAT_MAX_ACTIVE (8)
+#define LOOPSTAT_SUMMARY_TOP (5)
+#define LOOPSTAT_OTHER "other"
+
+#define OFONO_DEBUG_INTERFACE OFONO_SERVICE ".Debug"
+#define OFONO_DEBUG_PATH "/"
+
+struct loopstat_entry {
+	char *name;
+	guint64 dispatches;
+	guint64 cpu_ns;
+	guint64 max_ns;		/* Longest round this entry was part of */
+};
+
+static GHashTable *loopstat_entries;
+static struct loopstat_entry *loopstat_other;
+static struct loopstat_entry *loopstat_active[LOOPSTAT_MAX_ACTIVE];
+static guint loopstat_nactive;
+static GPollFunc loopstat_poll_orig;
+static gint64 loopstat_wall_start;
+static gint64 loopstat_cpu_start;
+static guint loopstat_slow_ms;
+static guint loopstat_summary_id;
+static DBusConnection *loopstat_conn;
+
+static inline gint64 loopstat_clock(clockid_t id)
+{
+	struct timespec ts;
+
+	clock_gettime(id, &ts);
+	return (gint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void loopstat_entry_free(gpointer data)
+{
+	struct loopstat_entry *entry = data;
+
+	g_free(entry->name);
+	g_slice_free(struct loopstat_entry, entry);
+}
+
+static struct loopstat_entry *loopstat_entry_new(const char *name)
+{
+	struct loopstat_entry *entry = g_slice_new0(struct loopstat_entry);
+
+	entry->name = g_strdup(name);
+	g_hash_table_replace(loopstat_entries, entry->name, entry);
+	return entry;
+}
+
+static void loopstat_reset(void)
+{
+	loopstat_nactive = 0;
+	g_hash_table_remove_all(loopstat_entries);
+	loopstat_other = loopstat_entry_new(LOOPSTAT_OTHER);
+}
+
+void __ofono_loopstat_touch(const char *name)
+{
+	struct loopstat_entry *entry;
+	guint i;
+
+	if (!loopstat_entries || !name)
+		return;
+
+	entry = g_hash_table_lookup(loopstat_entries, name);
+	if (!entry) {
+		/* Names may come from the outside, don't let them pile up */
+		if (g_hash_table_size(loopstat_entries) < LOOPSTAT_MAX_ENTRIES)
+			entry = loopstat_entry_new(name);
+		else
+			entry = loopstat_other;
+	}
+
+	for (i = 0; i < loopstat_nactive; i++)
+		if (loopstat_active[i] == entry)
+			return;
+
+	if (loopstat_nactive < LOOPSTAT_MAX_ACTIVE)
+		loopstat_active[loopstat_nactive++] = entry;
+}
+
+static void loopstat_round_done(void)
+{
+	const gint64 wall = loopstat_clock(CLOCK_MONOTONIC) -
+							loopstat_wall_start;
+	const gint64 cpu = loopstat_clock(CLOCK_THREAD_CPUTIME_ID) -
+							loopstat_cpu_start;
+	guint i;
+
+	if (!loopstat_nactive)
+		loopstat_active[loopstat_nactive++] = loopstat_other;
+
+	for (i = 0; i < loopstat_nactive; i++) {
+		struct loopstat_entry *entry = loopstat_active[i];
+
+		entry->dispatches++;
+		entry->cpu_ns += cpu / loopstat_nactive;
+		if (entry->max_ns < (guint64) wall)
+			entry->max_ns = wall;
+	}
+
+	if (loopstat_slow_ms && wall >= (gint64) loopstat_slow_ms * 1000000) {
+		char names[256];
+
+		names[0] = 0;
+		for (i = 0; i < loopstat_nactive; i++) {
+			if (i)
+				g_strlcat(names, ", ", sizeof(names));
+
+			g_strlcat(names, loopstat_active[i]->name,
+							sizeof(names));
+		}
+
+		ofono_warn("Main loop blocked for %u ms (%u ms CPU): %s",
+				(guint) (wall / 1000000),
+				(guint) (cpu / 1000000), names);
+	}
+
+	loopstat_nactive = 0;
+}
+
+static gint loopstat_poll(GPollFD *ufds, guint nfds, gint timeout)
+{
+	gint ret;
+
+	if (loopstat_wall_start)
+		loopstat_round_done();
+
+	ret = loopstat_poll_orig(ufds, nfds, timeout);
+
+	/* Log records belong to a modem for one round at most */
+	__ofono_log_set_modem(NULL);
+
+	loopstat_wall_start = loopstat_clock(CLOCK_MONOTONIC);
+	loopstat_cpu_start = loopstat_clock(CLOCK_THREAD_CPUTIME_ID);
+	return ret;
+}
+
+static gint loopstat_compare_cpu(gconstpointer a, gconstpointer b)
+{
+	const struct loopstat_entry *e1 = *(void **) a;
+	const struct loopstat_entry *e2 = *(void **) b;
+
+	return (e1->cpu_ns < e2->cpu_ns) ? 1 :
+		(e1->cpu_ns > e2->cpu_ns) ? -1 : 0;
+}
+
+static GPtrArray *loopstat_sorted(void)
+{
+	GPtrArray *list = g_ptr_array_new();
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init(&iter, loopstat_entries);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		g_ptr_array_add(list, value);
+
+	g_ptr_array_sort(list, loopstat_compare_cpu);
+	return list;
+}
+
+static gboolean loopstat_summary(gpointer user_data)
+{
+	GPtrArray *list = loopstat_sorted();
+	GString *buf = g_string_new(NULL);
+	guint i;
+
+	for (i = 0; i < list->len && i < LOOPSTAT_SUMMARY_TOP; i++) {
+		const struct loopstat_entry *entry = list->pdata[i];
+
+		g_string_append_printf(buf, "%s%s %" G_GUINT64_FORMAT
+				"x %" G_GUINT64_FORMAT "ms (max %ums)",
+				i ? ", " : "", entry->name, entry->dispatches,
+				entry->cpu_ns / 1000000,
+				(guint) (entry->max_ns / 1000000));
+	}
+
+	ofono_info("Main loop: %s", buf->str);
+
+	g_string_free(buf, TRUE);
+	g_ptr_array_free(list, TRUE);
+	return G_SOURCE_CONTINUE;
+}
+
+static DBusHandlerResult loopstat_dbus_filter(DBusConnection *conn,
+					DBusMessage *msg, void *user_data)
+{
+	const char *interface = dbus_message_get_interface(msg);
+	char name[128];
+
+	if (interface) {
+		snprintf(name, sizeof(name), "dbus %s", interface);
+		__ofono_loopstat_touch(name);
+	}
+
+	return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+}
+
+static DBusMessage *loopstat_get_stats(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	GPtrArray *list = loopstat_sorted();
+	DBusMessage *reply;
+	DBusMessageIter iter;
+	DBusMessageIter array;
+	guint i;
+
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_iter_init_append(reply, &iter);
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					DBUS_STRUCT_BEGIN_CHAR_AS_STRING
+					DBUS_TYPE_STRING_AS_STRING
+					OFONO_PROPERTIES_ARRAY_SIGNATURE
+					DBUS_STRUCT_END_CHAR_AS_STRING,
+					&array);
+
+	for (i = 0; i < list->len; i++) {
+		const struct loopstat_entry *entry = list->pdata[i];
+		const dbus_uint64_t cpu = entry->cpu_ns / 1000;
+		const dbus_uint64_t max = entry->max_ns / 1000;
+		DBusMessageIter st;
+		DBusMessageIter dict;
+
+		dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT,
+								NULL, &st);
+		dbus_message_iter_append_basic(&st, DBUS_TYPE_STRING,
+								&entry->name);
+		dbus_message_iter_open_container(&st, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&dict);
+		ofono_dbus_dict_append(&dict, "Dispatches", DBUS_TYPE_UINT64,
+							&entry->dispatches);
+		ofono_dbus_dict_append(&dict, "CpuTime", DBUS_TYPE_UINT64,
+							&cpu);
+		ofono_dbus_dict_append(&dict, "MaxDispatchTime",
+						DBUS_TYPE_UINT64, &max);
+		dbus_message_iter_close_container(&st, &dict);
+		dbus_message_iter_close_container(&array, &st);
+	}
+
+	dbus_message_iter_close_container(&iter, &array);
+	g_ptr_array_free(list, TRUE);
+	return reply;
+}
+
+static DBusMessage *loopstat_reset_stats(DBusConnection *conn,
+					DBusMessage *msg, void *data)
+{
+	loopstat_reset();
+	return dbus_message_new_method_return(msg);
+}
+
+static const GDBusMethodTable loopstat_methods[] = {
+	{ GDBUS_METHOD("GetMainLoopStatistics",
+			NULL, GDBUS_ARGS({ "statistics", "a(sa{sv})" }),
+			loopstat_get_stats) },
+	{ GDBUS_METHOD("ResetMainLoopStatistics", NULL, NULL,
+			loopstat_reset_stats) },
+	{ }
+};
+
+void __ofono_loopstat_init(unsigned int slow_ms, unsigned int summary_sec)
+{
+	loopstat_entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+						NULL, loopstat_entry_free);
+	loopstat_reset();
+	loopstat_slow_ms = slow_ms;
+
+	loopstat_poll_orig = g_main_context_get_poll_func(NULL);
+	g_main_context_set_poll_func(NULL, loopstat_poll);
+
+	if (summary_sec)
+		loopstat_summary_id = g_timeout_add_seconds(summary_sec,
+							loopstat_summary, NULL);
+
+	loopstat_conn = ofono_dbus_get_connection();
+	if (loopstat_conn) {
+		dbus_connection_add_filter(loopstat_conn,
+					loopstat_dbus_filter, NULL, NULL);
+		g_dbus_register_interface(loopstat_conn, OFONO_DEBUG_PATH,
+					OFONO_DEBUG_INTERFACE,
+					loopstat_methods, NULL, NULL,
+					NULL, NULL);
+	}
+}
+
+void __ofono_loopstat_cleanup(void)
+{
+	if (loopstat_conn) {
+		g_dbus_unregister_interface(loopstat_conn, OFONO_DEBUG_PATH,
+						OFONO_DEBUG_INTERFACE);
+		dbus_connection_remove_filter(loopstat_conn,
+					loopstat_dbus_filter, NULL);
+		loopstat_conn = NULL;
+	}
+
+	if (loopstat_summary_id) {
+		g_source_remove(loopstat_summary_id);
+		loopstat_summary_id = 0;
+	}
+
+	g_main_context_set_poll_func(NULL, loopstat_poll_orig);
+	loopstat_wall_start = 0;
+	loopstat_nactive = 0;
+	loopstat_other = NULL;
+
+	g_hash_table_destroy(loopstat_entries);
+	loopstat_entries = NULL;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
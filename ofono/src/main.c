@@ -85,6 +85,10 @@ static gboolean signal_handler(GIOChannel *channel, GIOCondition cond,
 
 		__terminated = 1;
 		break;
+	case SIGUSR2:
+		__ofono_loopstat_touch("signal");
+		__ofono_modem_dump_traces();
+		break;
 	}
 
 	return TRUE;
@@ -100,6 +104,7 @@ static guint setup_signalfd(void)
 	sigemptyset(&mask);
 	sigaddset(&mask, SIGINT);
 	sigaddset(&mask, SIGTERM);
+	sigaddset(&mask, SIGUSR2);
 
 	if (sigprocmask(SIG_BLOCK, &mask, NULL) < 0) {
 		perror("Failed to set signal mask");
@@ -134,12 +139,34 @@ static void system_bus_disconnected(DBusConnection *conn, void *user_data)
 	g_main_loop_quit(event_loop);
 }
 
+static gboolean name_owner_changed(DBusConnection *conn, DBusMessage *msg,
+							void *user_data)
+{
+	const char *name, *old_owner, *new_owner;
+
+	if (!dbus_message_get_args(msg, NULL,
+				DBUS_TYPE_STRING, &name,
+				DBUS_TYPE_STRING, &old_owner,
+				DBUS_TYPE_STRING, &new_owner,
+				DBUS_TYPE_INVALID))
+		return TRUE;
+
+	/* Unique names are never reused, drop what's cached for them */
+	if (name[0] == ':' && !new_owner[0])
+		__ofono_dbus_access_name_owner_changed(name);
+
+	return TRUE;
+}
+
 static gchar *option_debug = NULL;
 static gchar *option_plugin = NULL;
 static gchar *option_noplugin = NULL;
 static gboolean option_detach = TRUE;
 static gboolean option_version = FALSE;
 static gboolean option_backtrace = TRUE;
+static gint option_slow_dispatch = 500;
+static gint option_loop_summary = 0;
+static gchar *option_log = NULL;
 
 static gboolean parse_debug(const char *key, const char *value,
 					gpointer user_data, GError **error)
@@ -177,6 +204,15 @@ static GOptionEntry options[] = {
 	{ "nobacktrace", 0, G_OPTION_FLAG_REVERSE,
 				G_OPTION_ARG_NONE, &option_backtrace,
 				"Don't print out backtrace information" },
+	{ "slow-dispatch", 0, 0, G_OPTION_ARG_INT, &option_slow_dispatch,
+				"Warn when the main loop is blocked longer "
+				"than this (0 = never)", "MS" },
+	{ "loop-summary", 0, 0, G_OPTION_ARG_INT, &option_loop_summary,
+				"Log main loop statistics this often "
+				"(0 = never)", "SEC" },
+	{ "log", 0, 0, G_OPTION_ARG_STRING, &option_log,
+				"Write log to syslog (default), journal "
+				"or a file", "TARGET" },
 	{ NULL },
 };
 
@@ -196,6 +232,11 @@ static gboolean event_prepare(GSource *source, gint *timeout)
 
 static gboolean event_check(GSource *source)
 {
+	struct ell_event_source *ell = (struct ell_event_source *) source;
+
+	if (ell->pollfd.revents)
+		__ofono_loopstat_touch("ell");
+
 	l_main_iterate(0);
 	return FALSE;
 }
@@ -212,6 +253,7 @@ int main(int argc, char **argv)
 	GError *err = NULL;
 	DBusConnection *conn;
 	DBusError error;
+	guint name_owner_watch;
 	guint signal;
 #ifdef HAVE_ELL
 	struct ell_event_source *source;
@@ -268,6 +310,7 @@ int main(int argc, char **argv)
 
 	__ofono_log_init(argv[0], option_debug, option_detach,
 							option_backtrace);
+	__ofono_log_start(option_log);
 
 	dbus_error_init(&error);
 
@@ -289,6 +332,14 @@ int main(int argc, char **argv)
 
 	__ofono_dbus_init(conn);
 
+	__ofono_loopstat_init(MAX(option_slow_dispatch, 0),
+					MAX(option_loop_summary, 0));
+
+	name_owner_watch = g_dbus_add_signal_watch(conn, DBUS_SERVICE_DBUS,
+				DBUS_PATH_DBUS, DBUS_INTERFACE_DBUS,
+				"NameOwnerChanged", name_owner_changed,
+				NULL, NULL);
+
 	__ofono_modemwatch_init();
 
 	__ofono_manager_init();
@@ -309,12 +360,18 @@ int main(int argc, char **argv)
 
 	__ofono_plugin_cleanup();
 
+	__ofono_phonebook_cleanup();
+
         __ofono_slot_manager_cleanup();
 
 	__ofono_manager_cleanup();
 
 	__ofono_modemwatch_cleanup();
 
+	g_dbus_remove_watch(conn, name_owner_watch);
+
+	__ofono_loopstat_cleanup();
+
 	__ofono_dbus_cleanup();
 	dbus_connection_unref(conn);
 
@@ -330,6 +387,7 @@ cleanup:
 	__ofono_log_cleanup(option_backtrace);
 
 	g_free(option_debug);
+	g_free(option_log);
 
 	return 0;
 }
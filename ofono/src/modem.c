@@ -36,6 +36,12 @@
 #include "common.h"
 
 #define DEFAULT_POWERED_TIMEOUT (20)
+#define TRACE_BUFFER_SIZE (64 * 1024)
+#define TRACE_DUMP_PATH STORAGEDIR "/trace%s.trace"
+
+static const char *trace_proto_names[] = {
+	"unknown", "at", "qmi", "mbim", "ril", "mux"
+};
 
 static GSList *g_devinfo_drivers;
 static GSList *g_driver_list;
@@ -92,6 +98,8 @@ struct ofono_modem {
 	void			*driver_data;
 	char			*driver_type;
 	char			*name;
+	struct ofono_trace	*trace;
+	char			*loop_names[OFONO_TRACE_PROTO_MUX + 1];
 };
 
 struct ofono_devinfo {
@@ -2201,6 +2209,8 @@ static void modem_unregister(struct ofono_modem *modem)
 
 void ofono_modem_remove(struct ofono_modem *modem)
 {
+	unsigned int i;
+
 	DBG("%p", modem);
 
 	if (modem == NULL)
@@ -2212,6 +2222,10 @@ void ofono_modem_remove(struct ofono_modem *modem)
 	g_modem_list = g_slist_remove(g_modem_list, modem);
 
 	g_hash_table_destroy(modem->properties);
+	__ofono_trace_free(modem->trace);
+	for (i = 0; i < G_N_ELEMENTS(modem->loop_names); i++)
+		g_free(modem->loop_names[i]);
+
 	g_free(modem->driver_type);
 	g_free(modem->name);
 	g_free(modem->path);
@@ -2306,6 +2320,53 @@ void __ofono_modem_shutdown(void)
 		__ofono_exit();
 }
 
+void ofono_modem_trace(struct ofono_modem *modem,
+			enum ofono_trace_proto proto, ofono_bool_t in,
+			const void *data, unsigned int len)
+{
+	if (modem == NULL)
+		return;
+
+	/* Main loop time spent on this traffic is charged to the modem */
+	if (proto < G_N_ELEMENTS(modem->loop_names)) {
+		if (modem->loop_names[proto] == NULL)
+			modem->loop_names[proto] = g_strconcat(modem->path, " ",
+						trace_proto_names[proto], NULL);
+
+		__ofono_loopstat_touch(modem->loop_names[proto]);
+	}
+
+	/* And so are the messages logged while handling it */
+	__ofono_log_set_modem(modem->path);
+
+	if (modem->trace == NULL)
+		modem->trace = __ofono_trace_new(TRACE_BUFFER_SIZE);
+
+	__ofono_trace_record(modem->trace, proto, in, data, len);
+}
+
+void __ofono_modem_dump_traces(void)
+{
+	GSList *l;
+
+	for (l = g_modem_list; l; l = l->next) {
+		struct ofono_modem *modem = l->data;
+		char *path;
+
+		if (modem->trace == NULL || modem->path == NULL)
+			continue;
+
+		path = g_strdup_printf(TRACE_DUMP_PATH, modem->path);
+
+		if (__ofono_trace_dump(modem->trace, path) < 0)
+			ofono_error("Failed to write %s", path);
+		else
+			ofono_info("Wrote %s", path);
+
+		g_free(path);
+	}
+}
+
 void __ofono_modem_foreach(ofono_modem_foreach_func func, void *userdata)
 {
 	struct ofono_modem *modem;
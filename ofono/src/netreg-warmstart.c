@@ -0,0 +1,116 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <ofono/netreg.h>
+
+#include "netreg-warmstart.h"
+
+/*
+ * Format: version, status, technology (0xff if unknown), MCC and MNC
+ * padded with zeros, name length, name.
+ */
+#define WARMSTART_VERSION 1
+#define WARMSTART_HEADER_SIZE (4 + OFONO_MAX_MCC_LENGTH + OFONO_MAX_MNC_LENGTH)
+
+static gboolean netreg_warmstart_status_valid(int status)
+{
+	return status == OFONO_NETREG_STATUS_REGISTERED ||
+				status == OFONO_NETREG_STATUS_ROAMING;
+}
+
+static gboolean netreg_warmstart_code_valid(const char *code)
+{
+	for (; *code; code++)
+		if (!g_ascii_isdigit(*code))
+			return FALSE;
+
+	return TRUE;
+}
+
+unsigned int netreg_warmstart_encode(const struct netreg_warmstart *ws,
+							unsigned char *buf)
+{
+	unsigned char *ptr = buf + 3;
+	const char *end;
+	unsigned int namelen;
+
+	/* The name may have been cut in the middle of a character */
+	g_utf8_validate(ws->name, -1, &end);
+	namelen = MIN(end - ws->name, NETREG_WARMSTART_MAX_NAME_LENGTH);
+
+	memset(buf, 0, WARMSTART_HEADER_SIZE);
+	buf[0] = WARMSTART_VERSION;
+	buf[1] = ws->status;
+	buf[2] = (ws->technology < 0) ? 0xff : ws->technology;
+	memcpy(ptr, ws->mcc, strlen(ws->mcc));
+	ptr += OFONO_MAX_MCC_LENGTH;
+	memcpy(ptr, ws->mnc, strlen(ws->mnc));
+	ptr += OFONO_MAX_MNC_LENGTH;
+	*ptr++ = namelen;
+	memcpy(ptr, ws->name, namelen);
+
+	return WARMSTART_HEADER_SIZE + namelen;
+}
+
+gboolean netreg_warmstart_decode(struct netreg_warmstart *ws,
+				const unsigned char *buf, unsigned int len)
+{
+	const unsigned char *ptr = buf + 3;
+	const char *end;
+	unsigned int namelen;
+
+	if (len < WARMSTART_HEADER_SIZE || buf[0] != WARMSTART_VERSION)
+		return FALSE;
+
+	namelen = buf[WARMSTART_HEADER_SIZE - 1];
+	if (len < WARMSTART_HEADER_SIZE + namelen)
+		return FALSE;
+
+	/* Only the registered state is worth serving */
+	if (!netreg_warmstart_status_valid(buf[1]))
+		return FALSE;
+
+	memset(ws, 0, sizeof(*ws));
+	ws->status = buf[1];
+	ws->technology = (buf[2] == 0xff) ? -1 : buf[2];
+	memcpy(ws->mcc, ptr, OFONO_MAX_MCC_LENGTH);
+	ptr += OFONO_MAX_MCC_LENGTH;
+	memcpy(ws->mnc, ptr, OFONO_MAX_MNC_LENGTH);
+	ptr += OFONO_MAX_MNC_LENGTH + 1;
+	memcpy(ws->name, ptr, namelen);
+
+	/* Don't let garbage anywhere near D-Bus */
+	if (!netreg_warmstart_code_valid(ws->mcc) ||
+			!netreg_warmstart_code_valid(ws->mnc))
+		return FALSE;
+
+	g_utf8_validate(ws->name, namelen, &end);
+	ws->name[end - ws->name] = '\0';
+	return TRUE;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -0,0 +1,50 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef NETREG_WARMSTART_H
+#define NETREG_WARMSTART_H
+
+#include <ofono/types.h>
+
+#include <glib.h>
+
+#define NETREG_WARMSTART_MAX_NAME_LENGTH 255
+#define NETREG_WARMSTART_MAX_SIZE (4 + OFONO_MAX_MCC_LENGTH + \
+		OFONO_MAX_MNC_LENGTH + NETREG_WARMSTART_MAX_NAME_LENGTH)
+
+/* Last known registration state */
+struct netreg_warmstart {
+	int status;
+	int technology;		/* -1 if unknown */
+	char mcc[OFONO_MAX_MCC_LENGTH + 1];
+	char mnc[OFONO_MAX_MNC_LENGTH + 1];
+	char name[NETREG_WARMSTART_MAX_NAME_LENGTH + 1];
+};
+
+/* buf must hold NETREG_WARMSTART_MAX_SIZE bytes, returns the length */
+unsigned int netreg_warmstart_encode(const struct netreg_warmstart *ws,
+							unsigned char *buf);
+gboolean netreg_warmstart_decode(struct netreg_warmstart *ws,
+				const unsigned char *buf, unsigned int len);
+
+#endif /* NETREG_WARMSTART_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -0,0 +1,73 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "network-scan-cache.h"
+
+void network_scan_cache_store(struct network_scan_cache *cache, gint64 now,
+				int location, const char *mcc,
+				const char *mnc)
+{
+	cache->time = now;
+	cache->location = location;
+
+	if (mcc && mnc) {
+		g_strlcpy(cache->mcc, mcc, sizeof(cache->mcc));
+		g_strlcpy(cache->mnc, mnc, sizeof(cache->mnc));
+	} else {
+		cache->mcc[0] = cache->mnc[0] = '\0';
+	}
+}
+
+void network_scan_cache_drop(struct network_scan_cache *cache)
+{
+	cache->time = 0;
+}
+
+/*
+ * The result of a scan stays valid for as long as the modem remains
+ * in the same location area of the same network, up to max_age.
+ * Anything else (no registration, a new cell cluster, a different
+ * PLMN) forces a fresh scan.
+ */
+gboolean network_scan_cache_valid(const struct network_scan_cache *cache,
+				gint64 now, int location, const char *mcc,
+				const char *mnc)
+{
+	if (!cache->time || !cache->max_age || location == -1)
+		return FALSE;
+
+	if (now - cache->time >= (gint64) cache->max_age * G_USEC_PER_SEC)
+		return FALSE;
+
+	if (!mcc || !mnc || !cache->mcc[0] || !cache->mnc[0])
+		return FALSE;
+
+	return cache->location == location && !strcmp(mcc, cache->mcc) &&
+						!strcmp(mnc, cache->mnc);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
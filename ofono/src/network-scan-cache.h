@@ -0,0 +1,49 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef NETWORK_SCAN_CACHE_H
+#define NETWORK_SCAN_CACHE_H
+
+#include <ofono/types.h>
+
+#include <glib.h>
+
+/* Where and when the last successful operator scan was made */
+struct network_scan_cache {
+	gint64 time;		/* Monotonic, 0 if nothing is cached */
+	int location;
+	char mcc[OFONO_MAX_MCC_LENGTH + 1];	/* Empty if not registered */
+	char mnc[OFONO_MAX_MNC_LENGTH + 1];
+	unsigned int max_age;	/* Seconds, 0 disables the cache */
+};
+
+/* mcc and mnc are NULL when there's no current operator */
+void network_scan_cache_store(struct network_scan_cache *cache, gint64 now,
+				int location, const char *mcc,
+				const char *mnc);
+void network_scan_cache_drop(struct network_scan_cache *cache);
+gboolean network_scan_cache_valid(const struct network_scan_cache *cache,
+				gint64 now, int location, const char *mcc,
+				const char *mnc);
+
+#endif /* NETWORK_SCAN_CACHE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
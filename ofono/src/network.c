@@ -26,6 +26,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <gdbus.h>
@@ -37,10 +38,26 @@
 #include "util.h"
 #include "storage.h"
 #include "dbus-queue.h"
+#include "network-scan-cache.h"
+#include "netreg-warmstart.h"
+
+#include <ofono/conf.h>
 
 #define SETTINGS_STORE "netreg"
 #define SETTINGS_GROUP "Settings"
 
+/*
+ * Last known registration state, written when the atom goes away and
+ * served over D-Bus until the modem reports the live state.
+ */
+#define WARMSTART_PATH STORAGEDIR "/%s/netreg-warmstart"
+#define WARMSTART_MODE 0600
+
+#define SCAN_CONFIG_FILE "main.conf"
+#define SCAN_CONFIG_GROUP "NetworkRegistration"
+#define SCAN_CONFIG_KEY_CACHE_TIME "ScanCacheTime"
+#define SCAN_CACHE_TIME_DEFAULT 0 /* seconds, disabled */
+
 #define NETWORK_REGISTRATION_FLAG_HOME_SHOW_PLMN	0x1
 #define NETWORK_REGISTRATION_FLAG_ROAMING_SHOW_SPN	0x2
 #define NETWORK_REGISTRATION_FLAG_READING_PNN		0x4
@@ -76,6 +93,12 @@ struct ofono_netreg {
 	struct ofono_atom *atom;
 	unsigned int hfp_watch;
 	unsigned int spn_watch;
+	struct netreg_warmstart *warmstart;
+	gint64 register_time;
+	gboolean properties_served;
+	gboolean scanning;
+	gboolean scan_changed;
+	struct network_scan_cache scan_cache;
 };
 
 struct network_operator_data {
@@ -771,6 +794,59 @@ static gboolean update_operator_list(struct ofono_netreg *netreg, int total,
 	return changed;
 }
 
+static DBusMessage *netreg_warmstart_get_properties(
+			struct ofono_netreg *netreg, DBusMessage *msg)
+{
+	const struct netreg_warmstart *ws = netreg->warmstart;
+	const char *status = registration_status_to_string(ws->status);
+	const char *mode = registration_mode_to_string(netreg->mode);
+	const char *operator = ws->name;
+	DBusMessage *reply;
+	DBusMessageIter iter;
+	DBusMessageIter dict;
+
+	reply = dbus_message_new_method_return(msg);
+	if (reply == NULL)
+		return NULL;
+
+	dbus_message_iter_init_append(reply, &iter);
+
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&dict);
+
+	ofono_dbus_dict_append(&dict, "Status", DBUS_TYPE_STRING, &status);
+	ofono_dbus_dict_append(&dict, "Mode", DBUS_TYPE_STRING, &mode);
+
+	if (ws->technology != -1) {
+		const char *technology =
+			registration_tech_to_string(ws->technology);
+
+		ofono_dbus_dict_append(&dict, "Technology", DBUS_TYPE_STRING,
+					&technology);
+	}
+
+	if (ws->mcc[0] != '\0') {
+		const char *mcc = ws->mcc;
+
+		ofono_dbus_dict_append(&dict, "MobileCountryCode",
+					DBUS_TYPE_STRING, &mcc);
+	}
+
+	if (ws->mnc[0] != '\0') {
+		const char *mnc = ws->mnc;
+
+		ofono_dbus_dict_append(&dict, "MobileNetworkCode",
+					DBUS_TYPE_STRING, &mnc);
+	}
+
+	ofono_dbus_dict_append(&dict, "Name", DBUS_TYPE_STRING, &operator);
+
+	dbus_message_iter_close_container(&iter, &dict);
+
+	return reply;
+}
+
 static DBusMessage *network_get_properties(DBusConnection *conn,
 						DBusMessage *msg, void *data)
 {
@@ -783,6 +859,18 @@ static DBusMessage *network_get_properties(DBusConnection *conn,
 	const char *operator;
 	const char *mode = registration_mode_to_string(netreg->mode);
 
+	if (!netreg->properties_served) {
+		netreg->properties_served = TRUE;
+		DBG("%s: first properties served %s after %d ms",
+			__ofono_atom_get_path(netreg->atom),
+			netreg->warmstart ? "from snapshot" : "live",
+			(int) ((g_get_monotonic_time() -
+					netreg->register_time) / 1000));
+	}
+
+	if (netreg->warmstart)
+		return netreg_warmstart_get_properties(netreg, msg);
+
 	reply = dbus_message_new_method_return(msg);
 	if (reply == NULL)
 		return NULL;
@@ -990,18 +1078,46 @@ static DBusMessage *operator_list_reply(DBusMessage *msg, gpointer user_data)
 	return reply;
 }
 
+static gboolean netreg_scan_cache_valid(struct ofono_netreg *netreg)
+{
+	struct network_operator_data *opd = netreg->current_operator;
+
+	return network_scan_cache_valid(&netreg->scan_cache,
+					g_get_monotonic_time(),
+					netreg->location,
+					opd ? opd->mcc : NULL,
+					opd ? opd->mnc : NULL);
+}
+
 static void operator_list_callback(const struct ofono_error *error, int total,
 				const struct ofono_network_operator *list,
 				void *data)
 {
 	struct ofono_netreg *netreg = data;
 
+	netreg->scanning = FALSE;
+
 	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
 		DBG("Error occurred during operator list");
+		network_scan_cache_drop(&netreg->scan_cache);
 		__ofono_dbus_queue_reply_all_failed(netreg-> q);
+
+		/* Operators reported so far are still worth announcing */
+		if (netreg->scan_changed)
+			network_signal_operators_changed(netreg);
 	} else {
+		struct network_operator_data *opd;
 		gboolean changed = update_operator_list(netreg, total, list);
 
+		changed |= netreg->scan_changed;
+
+		opd = netreg->current_operator;
+		network_scan_cache_store(&netreg->scan_cache,
+					g_get_monotonic_time(),
+					netreg->location,
+					opd ? opd->mcc : NULL,
+					opd ? opd->mnc : NULL);
+
 		__ofono_dbus_queue_reply_all_fn_param(netreg->q,
 						operator_list_reply, netreg);
 
@@ -1009,16 +1125,86 @@ static void operator_list_callback(const struct ofono_error *error, int total,
 		if (changed)
 			network_signal_operators_changed(netreg);
 	}
+
+	netreg->scan_changed = FALSE;
 }
 
 static DBusMessage *network_scan_cb(DBusMessage *msg, void *data)
 {
 	struct ofono_netreg *netreg = data;
 
+	if (netreg_scan_cache_valid(netreg)) {
+		DBG("using the operator list from the last scan");
+		return operator_list_reply(msg, netreg);
+	}
+
+	netreg->scanning = TRUE;
+	netreg->scan_changed = FALSE;
 	netreg->driver->list_operators(netreg, operator_list_callback, netreg);
 	return NULL;
 }
 
+void ofono_netreg_operator_found(struct ofono_netreg *netreg,
+				const struct ofono_network_operator *op)
+{
+	DBusConnection *conn = ofono_dbus_get_connection();
+	struct network_operator_data *opd;
+	const char *path;
+	DBusMessage *signal;
+	DBusMessageIter iter;
+	DBusMessageIter dict;
+	GSList *o;
+
+	if (netreg == NULL || op == NULL || !netreg->scanning)
+		return;
+
+	if (op->mcc[0] == '\0' || op->mnc[0] == '\0')
+		return;
+
+	o = g_slist_find_custom(netreg->operator_list, op,
+					network_operator_compare);
+
+	if (o) {
+		opd = o->data;
+
+		set_network_operator_status(opd, op->status);
+
+		if (op->tech != -1)
+			set_network_operator_techs(opd,
+						opd->techs | (1 << op->tech));
+
+		set_network_operator_name(opd, op->name);
+	} else {
+		opd = network_operator_create(op);
+
+		if (!network_operator_dbus_register(netreg, opd)) {
+			g_free(opd);
+			return;
+		}
+
+		netreg->operator_list = g_slist_append(netreg->operator_list,
+									opd);
+		netreg->scan_changed = TRUE;
+	}
+
+	path = network_operator_build_path(netreg, opd->mcc, opd->mnc);
+	signal = dbus_message_new_signal(__ofono_atom_get_path(netreg->atom),
+					OFONO_NETWORK_REGISTRATION_INTERFACE,
+					"OperatorFound");
+	if (signal == NULL)
+		return;
+
+	dbus_message_iter_init_append(signal, &iter);
+	dbus_message_iter_append_basic(&iter, DBUS_TYPE_OBJECT_PATH, &path);
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&dict);
+	append_operator_properties(opd, &dict);
+	dbus_message_iter_close_container(&iter, &dict);
+
+	g_dbus_send_message(conn, signal);
+}
+
 static DBusMessage *network_scan(DBusConnection *conn,
 					DBusMessage *msg, void *data)
 {
@@ -1084,6 +1270,9 @@ static const GDBusSignalTable network_registration_signals[] = {
 			GDBUS_ARGS({ "name", "s" }, { "value", "v" })) },
 	{ GDBUS_SIGNAL("OperatorsChanged",
 			GDBUS_ARGS({ "operators", "a(oa{sv})"})) },
+	{ GDBUS_SIGNAL("OperatorFound",
+			GDBUS_ARGS({ "path", "o" },
+					{ "properties", "a{sv}" })) },
 	{ }
 };
 
@@ -1385,6 +1574,97 @@ static void notify_emulator_status(struct ofono_atom *atom, void *data)
 	}
 }
 
+static void netreg_notify_emulator_status(struct ofono_netreg *netreg)
+{
+	struct ofono_modem *modem = __ofono_atom_get_modem(netreg->atom);
+
+	__ofono_modem_foreach_registered_atom(modem,
+					OFONO_ATOM_TYPE_EMULATOR_HFP,
+					notify_emulator_status,
+					GINT_TO_POINTER(netreg->status));
+}
+
+static void netreg_warmstart_load(struct ofono_netreg *netreg,
+							const char *imsi)
+{
+	unsigned char buf[NETREG_WARMSTART_MAX_SIZE];
+	struct netreg_warmstart *ws;
+	ssize_t len;
+
+	len = read_file(buf, sizeof(buf), WARMSTART_PATH, imsi);
+	if (len <= 0)
+		return;
+
+	ws = g_new(struct netreg_warmstart, 1);
+	if (!netreg_warmstart_decode(ws, buf, len)) {
+		g_free(ws);
+		return;
+	}
+
+	DBG("%s %s%s \"%s\"", registration_status_to_string(ws->status),
+					ws->mcc, ws->mnc, ws->name);
+	netreg->warmstart = ws;
+}
+
+static void netreg_warmstart_save(struct ofono_netreg *netreg,
+							const char *imsi)
+{
+	unsigned char buf[NETREG_WARMSTART_MAX_SIZE];
+	struct network_operator_data *opd = netreg->current_operator;
+	struct netreg_warmstart ws;
+
+	if (opd == NULL || (netreg->status !=
+				NETWORK_REGISTRATION_STATUS_REGISTERED &&
+				netreg->status !=
+				NETWORK_REGISTRATION_STATUS_ROAMING)) {
+		char *path = g_strdup_printf(WARMSTART_PATH, imsi);
+
+		unlink(path);
+		g_free(path);
+		return;
+	}
+
+	ws.status = netreg->status;
+	ws.technology = netreg->technology;
+	g_strlcpy(ws.mcc, opd->mcc, sizeof(ws.mcc));
+	g_strlcpy(ws.mnc, opd->mnc, sizeof(ws.mnc));
+	g_strlcpy(ws.name, get_operator_display_name(netreg), sizeof(ws.name));
+
+	write_file(buf, netreg_warmstart_encode(&ws, buf), WARMSTART_MODE,
+							WARMSTART_PATH, imsi);
+}
+
+static void netreg_warmstart_drop(struct ofono_netreg *netreg, int status)
+{
+	struct netreg_warmstart *ws = netreg->warmstart;
+	const int live_status = netreg->status;
+
+	DBG("%s: live status after %d ms", __ofono_atom_get_path(netreg->atom),
+			(int) ((g_get_monotonic_time() -
+					netreg->register_time) / 1000));
+
+	/*
+	 * Clients may have seen the snapshot. Pretend that it was our
+	 * state so that whatever differs in the live state gets signalled.
+	 */
+	netreg->warmstart = NULL;
+	netreg->status = ws->status;
+	netreg->technology = ws->technology;
+
+	/*
+	 * The HFP emulator has never seen the snapshot. If the live status
+	 * matches it, ofono_netreg_status_notify won't update the emulator.
+	 */
+	if (status == ws->status && status != live_status)
+		netreg_notify_emulator_status(netreg);
+
+	if (ws->name[0] && status != NETWORK_REGISTRATION_STATUS_REGISTERED &&
+			status != NETWORK_REGISTRATION_STATUS_ROAMING)
+		netreg_emit_operator_display_name(netreg);
+
+	g_free(ws);
+}
+
 void ofono_netreg_status_notify(struct ofono_netreg *netreg, int status,
 			int lac, int ci, int tech)
 {
@@ -1394,16 +1674,12 @@ void ofono_netreg_status_notify(struct ofono_netreg *netreg, int status,
 	DBG("%s status %d tech %d", __ofono_atom_get_path(netreg->atom),
 							status, tech);
 
-	if (netreg->status != status) {
-		struct ofono_modem *modem;
+	if (netreg->warmstart)
+		netreg_warmstart_drop(netreg, status);
 
+	if (netreg->status != status) {
 		set_registration_status(netreg, status);
-
-		modem = __ofono_atom_get_modem(netreg->atom);
-		__ofono_modem_foreach_registered_atom(modem,
-					OFONO_ATOM_TYPE_EMULATOR_HFP,
-					notify_emulator_status,
-					GINT_TO_POINTER(netreg->status));
+		netreg_notify_emulator_status(netreg);
 	}
 
 	if (netreg->location != lac)
@@ -1837,8 +2113,15 @@ static void netreg_unregister(struct ofono_atom *atom)
 	DBusConnection *conn = ofono_dbus_get_connection();
 	struct ofono_modem *modem = __ofono_atom_get_modem(atom);
 	const char *path = __ofono_atom_get_path(atom);
+	const char *imsi = ofono_sim_get_imsi(netreg->sim);
 	GSList *l;
 
+	if (imsi)
+		netreg_warmstart_save(netreg, imsi);
+
+	g_free(netreg->warmstart);
+	netreg->warmstart = NULL;
+
 	__ofono_modem_foreach_registered_atom(modem,
 						OFONO_ATOM_TYPE_EMULATOR_HFP,
 						notify_emulator_status,
@@ -1919,6 +2202,7 @@ static void netreg_remove(struct ofono_atom *atom)
 	sim_eons_free(netreg->eons);
 	sim_spdi_free(netreg->spdi);
 
+	g_free(netreg->warmstart);
 	g_free(netreg);
 }
 
@@ -1963,6 +2247,25 @@ struct ofono_netreg *ofono_netreg_create(struct ofono_modem *modem,
 	return netreg;
 }
 
+static void netreg_load_config(struct ofono_netreg *netreg)
+{
+	GKeyFile *conf = g_key_file_new();
+	char *fn = g_build_filename(ofono_config_dir(), SCAN_CONFIG_FILE, NULL);
+	int ival;
+
+	netreg->scan_cache.max_age = SCAN_CACHE_TIME_DEFAULT;
+
+	if (g_key_file_load_from_file(conf, fn, 0, NULL) &&
+			ofono_conf_get_integer(conf, SCAN_CONFIG_GROUP,
+					SCAN_CONFIG_KEY_CACHE_TIME, &ival))
+		netreg->scan_cache.max_age = MAX(ival, 0);
+
+	DBG("scan cache time %u s", netreg->scan_cache.max_age);
+
+	g_key_file_free(conf);
+	g_free(fn);
+}
+
 static void netreg_load_settings(struct ofono_netreg *netreg)
 {
 	const char *imsi;
@@ -2129,6 +2432,15 @@ void ofono_netreg_register(struct ofono_netreg *netreg)
 	DBusConnection *conn = ofono_dbus_get_connection();
 	struct ofono_modem *modem = __ofono_atom_get_modem(netreg->atom);
 	const char *path = __ofono_atom_get_path(netreg->atom);
+	struct ofono_sim *sim = __ofono_atom_find(OFONO_ATOM_TYPE_SIM, modem);
+	const char *imsi = ofono_sim_get_imsi(sim);
+
+	netreg->register_time = g_get_monotonic_time();
+	netreg_load_config(netreg);
+
+	/* Must be loaded before the driver gets a chance to report status */
+	if (imsi)
+		netreg_warmstart_load(netreg, imsi);
 
 	if (!g_dbus_register_interface(conn, path,
 					OFONO_NETWORK_REGISTRATION_INTERFACE,
@@ -2150,7 +2462,7 @@ void ofono_netreg_register(struct ofono_netreg *netreg)
 		netreg->driver->registration_status(netreg,
 					init_registration_status, netreg);
 
-	netreg->sim = __ofono_atom_find(OFONO_ATOM_TYPE_SIM, modem);
+	netreg->sim = sim;
 	if (netreg->sim != NULL) {
 		/* Assume that if sim atom exists, it is ready */
 		netreg->sim_context = ofono_sim_context_create(netreg->sim);
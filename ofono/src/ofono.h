@@ -43,6 +43,8 @@ int __ofono_log_init(const char *program, const char *debug,
 						ofono_bool_t detach,
 						ofono_bool_t backtrace);
 void __ofono_log_cleanup(ofono_bool_t backtrace);
+int __ofono_log_start(const char *target);
+void __ofono_log_set_modem(const char *path);
 void __ofono_log_enable(struct ofono_debug_desc *start,
 					struct ofono_debug_desc *stop);
 
@@ -121,6 +123,18 @@ void __ofono_modem_callid_hold(struct ofono_modem *modem, int id);
 void __ofono_modem_callid_release(struct ofono_modem *modem, int id);
 void __ofono_modem_append_properties(struct ofono_modem *modem,
 						DBusMessageIter *dict);
+void __ofono_modem_dump_traces(void);
+
+#include <ofono/trace.h>
+
+struct ofono_trace;
+
+struct ofono_trace *__ofono_trace_new(unsigned int size);
+void __ofono_trace_free(struct ofono_trace *trace);
+void __ofono_trace_record(struct ofono_trace *trace,
+			enum ofono_trace_proto proto, ofono_bool_t in,
+			const void *data, unsigned int len);
+int __ofono_trace_dump(struct ofono_trace *trace, const char *path);
 
 struct ofono_atom;
 
@@ -271,6 +285,9 @@ gboolean __ofono_call_settings_is_busy(struct ofono_call_settings *cs);
 #include <ofono/cbs.h>
 #include <ofono/devinfo.h>
 #include <ofono/phonebook.h>
+
+void __ofono_phonebook_cleanup(void);
+
 #include <ofono/gprs.h>
 #include <ofono/gprs-context.h>
 #include <ofono/radio-settings.h>
@@ -664,6 +681,13 @@ void __ofono_voicecall_filter_chain_incoming(struct voicecall_filter_chain *c,
 				ofono_destroy_func destroy, void *user_data);
 
 #include <ofono/dbus-access.h>
+
+void __ofono_dbus_access_name_owner_changed(const char *name);
+
+void __ofono_loopstat_init(unsigned int slow_ms, unsigned int summary_sec);
+void __ofono_loopstat_cleanup(void);
+void __ofono_loopstat_touch(const char *name);
+
 #include <ofono/slot.h>
 
 void __ofono_slot_manager_init(void);
@@ -28,6 +28,10 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <errno.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
 
 #include <glib.h>
 #include <gdbus.h>
@@ -39,10 +43,14 @@
 #define LEN_MAX 128
 #define TYPE_INTERNATIONAL 145
 
-#define PHONEBOOK_FLAG_CACHED 0x1
+#define PHONEBOOK_CACHE_MAX 4
+#define STREAM_CHUNK_SIZE (16 * 1024)
 
 static GSList *g_drivers = NULL;
 
+/* Completed exports by ICCID, shared by all modems */
+static GHashTable *phonebook_cache = NULL;
+
 enum phonebook_number_type {
 	TEL_TYPE_HOME,
 	TEL_TYPE_MOBILE,
@@ -54,9 +62,15 @@ enum phonebook_number_type {
 struct ofono_phonebook {
 	GSList *pending;
 	int storage_index; /* go through all supported storage */
-	int flags;
 	GString *vcards; /* entries with vcard 3.0 format */
+	GBytes *cache; /* vcards of the last complete export */
 	GSList *merge_list; /* cache the entries that may need a merge */
+	GHashTable *merge_index; /* merge_list entries by text */
+	GSList *streams;
+	gboolean export_failed; /* some storage couldn't be fully read */
+	char *export_iccid; /* the card being exported */
+	char *iccid;
+	unsigned int iccid_watch;
 	const struct ofono_phonebook_driver *driver;
 	void *driver_data;
 	struct ofono_atom *atom;
@@ -77,6 +91,22 @@ struct phonebook_person {
 	char *sip_uri;
 };
 
+struct phonebook_request {
+	DBusMessage *msg;
+	int fd; /* -1 unless it's a stream request */
+};
+
+struct phonebook_stream {
+	struct ofono_phonebook *pb;
+	DBusMessage *msg;
+	GBytes *data;
+	gsize offset;
+	gsize chunk;
+	int fd;
+	gboolean socket;
+	guint watch;
+};
+
 static const char *storage_support[] = { "SM", "ME", NULL };
 static void export_phonebook(struct ofono_phonebook *pb);
 
@@ -280,13 +310,15 @@ static DBusMessage *generate_export_entries_reply(struct ofono_phonebook *pb,
 {
 	DBusMessage *reply;
 	DBusMessageIter iter;
+	const char *str;
 
 	reply = dbus_message_new_method_return(msg);
 	if (reply == NULL)
 		return NULL;
 
+	str = g_bytes_get_data(pb->cache, NULL);
 	dbus_message_iter_init_append(reply, &iter);
-	dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, pb->vcards);
+	dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &str);
 
 	return reply;
 }
@@ -368,23 +400,25 @@ void ofono_phonebook_entry(struct ofono_phonebook *phonebook, int index,
 	 * are deemed as entries of one person.
 	 */
 	if (need_merge(text)) {
-		GSList *l;
 		size_t len_text = strlen(text) - 2;
+		char *key = g_strndup(text, len_text);
 		struct phonebook_person *person;
 
-		for (l = phonebook->merge_list; l; l = l->next) {
-			person = l->data;
-			if (!strncmp(text, person->text, len_text) &&
-					(strlen(person->text) == len_text))
-				break;
-		}
+		if (phonebook->merge_index == NULL)
+			phonebook->merge_index = g_hash_table_new(g_str_hash,
+								g_str_equal);
+
+		person = g_hash_table_lookup(phonebook->merge_index, key);
 
-		if (l == NULL) {
+		if (person == NULL) {
 			person = g_new0(struct phonebook_person, 1);
 			phonebook->merge_list =
 				g_slist_prepend(phonebook->merge_list, person);
-			person->text = g_strndup(text, len_text);
-		}
+			person->text = key;
+			g_hash_table_insert(phonebook->merge_index,
+							person->text, person);
+		} else
+			g_free(key);
 
 		merge_field_number(&(person->number_list), number, type,
 					text[len_text + 1]);
@@ -418,9 +452,11 @@ static void export_phonebook_cb(const struct ofono_error *error, void *data)
 {
 	struct ofono_phonebook *phonebook = data;
 
-	if (error->type != OFONO_ERROR_TYPE_NO_ERROR)
+	if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
 		ofono_error("export_entries_one_storage_cb with %s failed",
 				storage_support[phonebook->storage_index]);
+		phonebook->export_failed = TRUE;
+	}
 
 	/* convert the collected entries that are already merged to vcard */
 	phonebook->merge_list = g_slist_reverse(phonebook->merge_list);
@@ -429,30 +465,188 @@ static void export_phonebook_cb(const struct ofono_error *error, void *data)
 	g_slist_free_full(phonebook->merge_list, destroy_merged_entry);
 	phonebook->merge_list = NULL;
 
+	if (phonebook->merge_index) {
+		g_hash_table_destroy(phonebook->merge_index);
+		phonebook->merge_index = NULL;
+	}
+
 	phonebook->storage_index++;
 	export_phonebook(phonebook);
 	return;
 }
 
+static void phonebook_stream_free(struct phonebook_stream *stream,
+							DBusMessage *reply)
+{
+	struct ofono_phonebook *pb = stream->pb;
+
+	if (stream->watch)
+		g_source_remove(stream->watch);
+
+	pb->streams = g_slist_remove(pb->streams, stream);
+	__ofono_dbus_pending_reply(&stream->msg, reply);
+	close(stream->fd);
+	g_bytes_unref(stream->data);
+	g_free(stream);
+}
+
+static void phonebook_stream_cancel(gpointer data)
+{
+	struct phonebook_stream *stream = data;
+
+	phonebook_stream_free(stream, __ofono_error_canceled(stream->msg));
+}
+
+static gboolean phonebook_stream_write(GIOChannel *io, GIOCondition cond,
+							gpointer user_data)
+{
+	struct phonebook_stream *stream = user_data;
+	gsize size;
+	const char *data = g_bytes_get_data(stream->data, &size);
+	gsize chunk;
+	ssize_t written;
+
+	/* The terminating NUL is only there for Import() */
+	size--;
+
+	if (cond & (G_IO_ERR | G_IO_HUP | G_IO_NVAL))
+		goto fail;
+
+	chunk = MIN(size - stream->offset, stream->chunk);
+
+	if (stream->socket)
+		written = send(stream->fd, data + stream->offset, chunk,
+						MSG_NOSIGNAL | MSG_DONTWAIT);
+	else
+		written = write(stream->fd, data + stream->offset, chunk);
+
+	if (written < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return TRUE;
+
+		goto fail;
+	}
+
+	stream->offset += written;
+
+	if (stream->offset < size)
+		return TRUE;
+
+	DBG("%u bytes written", (unsigned int) size);
+
+	stream->watch = 0;
+	phonebook_stream_free(stream,
+			dbus_message_new_method_return(stream->msg));
+	return FALSE;
+
+fail:
+	ofono_error("Phonebook stream failed after %u bytes",
+					(unsigned int) stream->offset);
+	stream->watch = 0;
+	phonebook_stream_free(stream, __ofono_error_failed(stream->msg));
+	return FALSE;
+}
+
+static void phonebook_stream_start(struct ofono_phonebook *pb,
+					DBusMessage *msg, int fd)
+{
+	struct phonebook_stream *stream = g_new0(struct phonebook_stream, 1);
+	GIOChannel *io;
+	struct stat st;
+
+	stream->pb = pb;
+	stream->msg = msg;
+	stream->fd = fd;
+	stream->data = g_bytes_ref(pb->cache);
+	stream->chunk = STREAM_CHUNK_SIZE;
+
+	/*
+	 * The fd shares its file status flags with the client, so don't
+	 * touch O_NONBLOCK. Sockets get MSG_DONTWAIT instead, and a pipe
+	 * which has polled writable takes PIPE_BUF bytes without blocking.
+	 */
+	if (!fstat(fd, &st)) {
+		stream->socket = S_ISSOCK(st.st_mode);
+		if (!stream->socket && !S_ISREG(st.st_mode))
+			stream->chunk = PIPE_BUF;
+	}
+
+	io = g_io_channel_unix_new(fd);
+	stream->watch = g_io_add_watch(io,
+				G_IO_OUT | G_IO_ERR | G_IO_HUP | G_IO_NVAL,
+				phonebook_stream_write, stream);
+	g_io_channel_unref(io);
+
+	pb->streams = g_slist_prepend(pb->streams, stream);
+}
+
 static void phonebook_reply(gpointer data, gpointer user_data)
 {
-	DBusMessage *msg = data;
+	struct phonebook_request *req = data;
 	struct ofono_phonebook *phonebook = user_data;
-	DBusMessage *reply = generate_export_entries_reply(phonebook, msg);
 
-	__ofono_dbus_pending_reply(&msg, reply);
+	if (req->fd >= 0)
+		phonebook_stream_start(phonebook, req->msg, req->fd);
+	else
+		__ofono_dbus_pending_reply(&req->msg,
+			generate_export_entries_reply(phonebook, req->msg));
+
+	g_free(req);
 }
 
 static void phonebook_cancel(gpointer data)
 {
-	DBusMessage *msg = data;
+	struct phonebook_request *req = data;
+
+	if (req->fd >= 0)
+		close(req->fd);
+
+	__ofono_dbus_pending_reply(&req->msg,
+				__ofono_error_canceled(req->msg));
+	g_free(req);
+}
+
+static void phonebook_cache_store(struct ofono_phonebook *pb)
+{
+	/* The card may have been swapped while it was being read */
+	if (pb->iccid == NULL || g_strcmp0(pb->iccid, pb->export_iccid))
+		return;
+
+	if (phonebook_cache == NULL)
+		phonebook_cache = g_hash_table_new_full(g_str_hash,
+				g_str_equal, g_free,
+				(GDestroyNotify) g_bytes_unref);
+	else if (g_hash_table_size(phonebook_cache) >= PHONEBOOK_CACHE_MAX &&
+			!g_hash_table_contains(phonebook_cache, pb->iccid))
+		g_hash_table_remove_all(phonebook_cache);
+
+	g_hash_table_replace(phonebook_cache, g_strdup(pb->iccid),
+						g_bytes_ref(pb->cache));
+}
+
+static gboolean phonebook_cached(struct ofono_phonebook *pb)
+{
+	GBytes *data;
+
+	if (pb->cache)
+		return TRUE;
 
-	__ofono_dbus_pending_reply(&msg, __ofono_error_canceled(msg));
+	if (pb->iccid == NULL || phonebook_cache == NULL)
+		return FALSE;
+
+	data = g_hash_table_lookup(phonebook_cache, pb->iccid);
+	if (data == NULL)
+		return FALSE;
+
+	DBG("%s", pb->iccid);
+	pb->cache = g_bytes_ref(data);
+	return TRUE;
 }
 
 static void export_phonebook(struct ofono_phonebook *phonebook)
 {
 	const char *pb = storage_support[phonebook->storage_index];
+	gsize len;
 
 	if (pb) {
 		phonebook->driver->export_entries(phonebook, pb,
@@ -460,10 +654,47 @@ static void export_phonebook(struct ofono_phonebook *phonebook)
 		return;
 	}
 
+	/* Hand the buffer over to the cache, NUL and all */
+	len = phonebook->vcards->len + 1;
+	phonebook->cache = g_bytes_new_take(g_string_free(phonebook->vcards,
+							FALSE), len);
+	phonebook->vcards = g_string_new(NULL);
+
+	if (!phonebook->export_failed)
+		phonebook_cache_store(phonebook);
+
 	g_slist_foreach(phonebook->pending, phonebook_reply, phonebook);
 	g_slist_free(phonebook->pending);
 	phonebook->pending = NULL;
-	phonebook->flags |= PHONEBOOK_FLAG_CACHED;
+
+	/* Incomplete, or for another card. Good for these replies only */
+	if (phonebook->export_failed ||
+			g_strcmp0(phonebook->iccid, phonebook->export_iccid)) {
+		g_bytes_unref(phonebook->cache);
+		phonebook->cache = NULL;
+	}
+
+	g_free(phonebook->export_iccid);
+	phonebook->export_iccid = NULL;
+}
+
+static void phonebook_request(struct ofono_phonebook *phonebook,
+					DBusMessage *msg, int fd)
+{
+	struct phonebook_request *req = g_new0(struct phonebook_request, 1);
+	gboolean start = (phonebook->pending == NULL);
+
+	req->msg = dbus_message_ref(msg);
+	req->fd = fd;
+	phonebook->pending = g_slist_append(phonebook->pending, req);
+
+	if (start) {
+		g_string_set_size(phonebook->vcards, 0);
+		phonebook->storage_index = 0;
+		phonebook->export_failed = FALSE;
+		phonebook->export_iccid = g_strdup(phonebook->iccid);
+		export_phonebook(phonebook);
+	}
 }
 
 static DBusMessage *import_entries(DBusConnection *conn, DBusMessage *msg,
@@ -472,22 +703,30 @@ static DBusMessage *import_entries(DBusConnection *conn, DBusMessage *msg,
 	struct ofono_phonebook *phonebook = data;
 	DBusMessage *reply;
 
-	if (phonebook->flags & PHONEBOOK_FLAG_CACHED) {
+	if (phonebook_cached(phonebook)) {
 		reply = generate_export_entries_reply(phonebook, msg);
 		g_dbus_send_message(conn, reply);
 		return NULL;
 	}
 
-	if (phonebook->pending) {
-		phonebook->pending = g_slist_append(phonebook->pending,
-							dbus_message_ref(msg));
-	} else {
-		phonebook->pending = g_slist_append(NULL,
-							dbus_message_ref(msg));
-		g_string_set_size(phonebook->vcards, 0);
-		phonebook->storage_index = 0;
-		export_phonebook(phonebook);
-	}
+	phonebook_request(phonebook, msg, -1);
+	return NULL;
+}
+
+static DBusMessage *import_stream(DBusConnection *conn, DBusMessage *msg,
+					void *data)
+{
+	struct ofono_phonebook *phonebook = data;
+	int fd;
+
+	if (!dbus_message_get_args(msg, NULL, DBUS_TYPE_UNIX_FD, &fd,
+							DBUS_TYPE_INVALID))
+		return __ofono_error_invalid_args(msg);
+
+	if (phonebook_cached(phonebook))
+		phonebook_stream_start(phonebook, dbus_message_ref(msg), fd);
+	else
+		phonebook_request(phonebook, msg, fd);
 
 	return NULL;
 }
@@ -496,6 +735,9 @@ static const GDBusMethodTable phonebook_methods[] = {
 	{ GDBUS_ASYNC_METHOD("Import",
 			NULL, GDBUS_ARGS({ "entries", "s" }),
 			import_entries) },
+	{ GDBUS_ASYNC_METHOD("ImportToFile",
+			GDBUS_ARGS({ "fd", "h" }), NULL,
+			import_stream) },
 	{ }
 };
 
@@ -528,12 +770,23 @@ static void phonebook_unregister(struct ofono_atom *atom)
 	const char *path = __ofono_atom_get_path(pb->atom);
 	DBusConnection *conn = ofono_dbus_get_connection();
 	struct ofono_modem *modem = __ofono_atom_get_modem(pb->atom);
+	struct ofono_sim *sim = __ofono_atom_find(OFONO_ATOM_TYPE_SIM, modem);
 
 	if (pb->pending) {
 		g_slist_free_full(pb->pending, phonebook_cancel);
 		pb->pending = NULL;
 	}
 
+	while (pb->streams)
+		phonebook_stream_cancel(pb->streams->data);
+
+	if (pb->iccid_watch) {
+		if (sim)
+			ofono_sim_remove_iccid_watch(sim, pb->iccid_watch);
+
+		pb->iccid_watch = 0;
+	}
+
 	ofono_modem_remove_interface(modem, OFONO_PHONEBOOK_INTERFACE);
 	g_dbus_unregister_interface(conn, path, OFONO_PHONEBOOK_INTERFACE);
 }
@@ -551,6 +804,12 @@ static void phonebook_remove(struct ofono_atom *atom)
 		pb->driver->remove(pb);
 
 	g_string_free(pb->vcards, TRUE);
+
+	if (pb->cache)
+		g_bytes_unref(pb->cache);
+
+	g_free(pb->export_iccid);
+	g_free(pb->iccid);
 	g_free(pb);
 }
 
@@ -589,11 +848,31 @@ struct ofono_phonebook *ofono_phonebook_create(struct ofono_modem *modem,
 	return pb;
 }
 
+static void phonebook_iccid_changed(const char *iccid, void *data)
+{
+	struct ofono_phonebook *pb = data;
+
+	if (!g_strcmp0(pb->iccid, iccid))
+		return;
+
+	DBG("%s", iccid);
+
+	/* A different card, what we have exported is no longer valid */
+	g_free(pb->iccid);
+	pb->iccid = g_strdup(iccid);
+
+	if (pb->cache) {
+		g_bytes_unref(pb->cache);
+		pb->cache = NULL;
+	}
+}
+
 void ofono_phonebook_register(struct ofono_phonebook *pb)
 {
 	DBusConnection *conn = ofono_dbus_get_connection();
 	const char *path = __ofono_atom_get_path(pb->atom);
 	struct ofono_modem *modem = __ofono_atom_get_modem(pb->atom);
+	struct ofono_sim *sim = __ofono_atom_find(OFONO_ATOM_TYPE_SIM, modem);
 
 	if (!g_dbus_register_interface(conn, path, OFONO_PHONEBOOK_INTERFACE,
 					phonebook_methods, phonebook_signals,
@@ -606,6 +885,10 @@ void ofono_phonebook_register(struct ofono_phonebook *pb)
 
 	ofono_modem_add_interface(modem, OFONO_PHONEBOOK_INTERFACE);
 
+	if (sim)
+		pb->iccid_watch = ofono_sim_add_iccid_watch(sim,
+					phonebook_iccid_changed, pb, NULL);
+
 	__ofono_atom_register(pb->atom, phonebook_unregister);
 }
 
@@ -614,6 +897,14 @@ void ofono_phonebook_remove(struct ofono_phonebook *pb)
 	__ofono_atom_free(pb->atom);
 }
 
+void __ofono_phonebook_cleanup(void)
+{
+	if (phonebook_cache) {
+		g_hash_table_destroy(phonebook_cache);
+		phonebook_cache = NULL;
+	}
+}
+
 void ofono_phonebook_set_data(struct ofono_phonebook *pb, void *data)
 {
 	pb->driver_data = data;
@@ -42,6 +42,8 @@ enum watch_events {
 	WATCH_EVENT_MODEM,
 	WATCH_EVENT_ONLINE,
 	WATCH_EVENT_IMSI,
+	WATCH_EVENT_REG_STATUS,
+	WATCH_EVENT_REG_TECH,
 	WATCH_EVENT_COUNT
 };
 
@@ -79,6 +81,7 @@ struct ofono_slot_object {
 	char *imeisv;
 	GHashTable *errors;
 	int index;
+	char *imsi; /* The one this slot is indexed under */
 };
 
 struct ofono_slot_manager_object {
@@ -99,10 +102,20 @@ struct ofono_slot_manager_object {
 	char *default_data_imsi;
 	char *mms_imsi;
 	GKeyFile *storage;
+	guint storage_sync_id;
 	GHashTable *errors;
+	GHashTable *imsi_index; /* IMSI => struct slot_manager_imsi_entry */
+	guint imsi_slots; /* Number of slots with IMSI */
+	guint drivers_starting; /* Drivers with non-zero start_id */
+	guint slots_unknown; /* Slots with unknown SIM presence */
 	guint start_id;
 };
 
+struct slot_manager_imsi_entry {
+	OfonoSlotObject *slot; /* The first slot with this IMSI */
+	guint count; /* Number of slots with this IMSI */
+};
+
 struct ofono_slot_driver_reg {
 	OfonoSlotManagerObject *manager;
 	const struct ofono_slot_driver *driver;
@@ -130,6 +143,9 @@ struct ofono_slot_driver_reg {
 #define SM_STORE_SLOTS_SEP          ","
 #define SM_STORE_AUTO_DATA_SIM_DONE "AutoSelectDataSimDone"
 
+/* Settings changes are written to flash in batches */
+#define SM_STORE_SYNC_DELAY_MS      (500)
+
 /* The file where error statistics is stored. Again "rilerror" is historical */
 #define SM_ERROR_STORAGE            "rilerror" /* File name */
 #define SM_ERROR_COMMON_SECTION     "common"   /* Modem independent section */
@@ -182,6 +198,7 @@ static GQuark slot_base_property_quarks[MAX_PROPERTIES];
 static void slot_manager_reindex_slots(OfonoSlotManagerObject *mgr);
 static void slot_manager_emit_all_queued_signals(OfonoSlotManagerObject *mgr);
 static void slot_manager_update_ready(OfonoSlotManagerObject *mgr);
+static void slot_manager_slot_update_imsi(OfonoSlotObject *slot);
 static enum slot_manager_dbus_signal slot_manager_update_modem_paths
 	(OfonoSlotManagerObject *mgr, gboolean imsi_change)
 		G_GNUC_WARN_UNUSED_RESULT;
@@ -412,17 +429,27 @@ static void slot_manager_slot_modem_changed(struct ofono_watch *w, void *data)
 	OfonoSlotManagerObject *mgr = slot->manager;
 
 	slot_update_cell_info_dbus(slot);
+	slot_manager_slot_update_imsi(slot);
 	slot_manager_update_modem_paths_and_notify(mgr,
 		SLOT_MANAGER_DBUS_SIGNAL_NONE);
 	slot_manager_update_ready(mgr);
 	slot_manager_emit_all_queued_signals(mgr);
 }
 
+static void slot_manager_slot_reg_changed(struct ofono_watch *w, void *data)
+{
+	OfonoSlotObject *slot = OFONO_SLOT_OBJECT(data);
+
+	/* We may be on the move, poll cells at the full rate again */
+	cell_info_control_kick(slot->cellinfo_ctl);
+}
+
 static void slot_manager_slot_imsi_changed(struct ofono_watch *w, void *data)
 {
 	OfonoSlotObject *slot = OFONO_SLOT_OBJECT(data);
 	OfonoSlotManagerObject *mgr = slot->manager;
 
+	slot_manager_slot_update_imsi(slot);
 	slot_manager_dbus_signal(mgr->dbus,
 		slot_manager_update_modem_paths(mgr, TRUE));
 	slot_manager_emit_all_queued_signals(mgr);
@@ -455,6 +482,7 @@ static void slot_object_finalize(GObject* obj)
 	ofono_watch_unref(s->watch);
 	g_free(s->imei);
 	g_free(s->imeisv);
+	g_free(s->imsi);
 	G_OBJECT_CLASS(ofono_slot_object_parent_class)->finalize(obj);
 }
 
@@ -479,6 +507,9 @@ static struct ofono_slot *slot_add_internal(OfonoSlotManagerObject *mgr,
 	pub->imei = s->imei = g_strdup(imei);
 	pub->imeisv = s->imeisv = g_strdup(imeisv);
 	pub->sim_presence = sim_presence;
+	if (sim_presence == OFONO_SLOT_SIM_UNKNOWN) {
+		mgr->slots_unknown++;
+	}
 	DBG("%s", slot_debug_prefix(s));
 
 	/* Check if it's enabled */
@@ -497,6 +528,9 @@ static struct ofono_slot *slot_add_internal(OfonoSlotManagerObject *mgr,
 	mgr->slots = g_slist_insert_sorted(mgr->slots, s, slot_compare_path);
 	slot_manager_reindex_slots(mgr);
 
+	/* The SIM may already be there */
+	slot_manager_slot_update_imsi(s);
+
 	/* Register for events */
 	s->watch_event_id[WATCH_EVENT_MODEM] =
 		ofono_watch_add_modem_changed_handler(w,
@@ -507,6 +541,12 @@ static struct ofono_slot *slot_add_internal(OfonoSlotManagerObject *mgr,
 	s->watch_event_id[WATCH_EVENT_IMSI] =
 		ofono_watch_add_imsi_changed_handler(w,
 			slot_manager_slot_imsi_changed, s);
+	s->watch_event_id[WATCH_EVENT_REG_STATUS] =
+		ofono_watch_add_reg_status_changed_handler(w,
+			slot_manager_slot_reg_changed, s);
+	s->watch_event_id[WATCH_EVENT_REG_TECH] =
+		ofono_watch_add_reg_tech_changed_handler(w,
+			slot_manager_slot_reg_changed, s);
 
 	/* Clear queued signals */
 	mgr->base.queued_signals = 0;
@@ -613,6 +653,32 @@ static void slot_manager_update_dbus_block(OfonoSlotManagerObject *mgr)
 		SLOT_MANAGER_DBUS_BLOCK_ALL);
 }
 
+static gboolean slot_manager_storage_sync_cb(gpointer user_data)
+{
+	OfonoSlotManagerObject *mgr = OFONO_SLOT_MANAGER_OBJECT(user_data);
+
+	mgr->storage_sync_id = 0;
+	storage_sync(NULL, SM_STORE, mgr->storage);
+	return G_SOURCE_REMOVE;
+}
+
+static void slot_manager_storage_changed(OfonoSlotManagerObject *mgr)
+{
+	if (!mgr->storage_sync_id) {
+		mgr->storage_sync_id = g_timeout_add(SM_STORE_SYNC_DELAY_MS,
+			slot_manager_storage_sync_cb, mgr);
+	}
+}
+
+static void slot_manager_storage_flush(OfonoSlotManagerObject *mgr)
+{
+	if (mgr->storage_sync_id) {
+		g_source_remove(mgr->storage_sync_id);
+		mgr->storage_sync_id = 0;
+		storage_sync(NULL, SM_STORE, mgr->storage);
+	}
+}
+
 static void slot_manager_set_config_string(OfonoSlotManagerObject *mgr,
 	const char *key, const char *value)
 {
@@ -621,37 +687,106 @@ static void slot_manager_set_config_string(OfonoSlotManagerObject *mgr,
 	} else {
 		g_key_file_remove_key(mgr->storage, SM_STORE_GROUP, key, NULL);
 	}
-	storage_sync(NULL, SM_STORE, mgr->storage);
+	slot_manager_storage_changed(mgr);
 }
 
-struct slot_manager_imsi_slot_data {
-	OfonoSlotObject *slot;
-	const char *imsi; /* NULL if we are looking for any slot with IMSI */
-};
+/*
+ * The IMSI index maps each IMSI to the first slot (in path order) which
+ * has it. It's updated from the IMSI and modem change notifications, so
+ * that path selection doesn't have to walk all the slots every time.
+ */
 
-static gboolean slot_manager_find_slot_imsi_cb(OfonoSlotObject *slot,
-	void *user_data)
+static OfonoSlotObject *slot_manager_scan_slot_imsi
+	(OfonoSlotManagerObject *mgr, const char *imsi, OfonoSlotObject *skip)
 {
-	struct slot_manager_imsi_slot_data *data = user_data;
-	const char *slot_imsi = slot->watch->imsi;
+	GSList *l;
 
-	if (slot_imsi && (!data->imsi || !strcmp(slot_imsi, data->imsi))) {
-		data->slot = slot;
-		return SM_LOOP_DONE;
+	for (l = mgr->slots; l; l = l->next) {
+		OfonoSlotObject *slot = OFONO_SLOT_OBJECT(l->data);
+
+		if (slot != skip && slot->imsi &&
+				(!imsi || !strcmp(slot->imsi, imsi))) {
+			return slot;
+		}
+	}
+	return NULL;
+}
+
+static void slot_manager_imsi_index_add(OfonoSlotManagerObject *mgr,
+	OfonoSlotObject *slot)
+{
+	struct slot_manager_imsi_entry *entry =
+		g_hash_table_lookup(mgr->imsi_index, slot->imsi);
+
+	if (entry) {
+		entry->count++;
+		if (slot->index < entry->slot->index) {
+			entry->slot = slot;
+		}
 	} else {
-		return SM_LOOP_CONTINUE;
+		entry = g_slice_new(struct slot_manager_imsi_entry);
+		entry->slot = slot;
+		entry->count = 1;
+		g_hash_table_insert(mgr->imsi_index, g_strdup(slot->imsi),
+			entry);
+	}
+	mgr->imsi_slots++;
+}
+
+static void slot_manager_imsi_index_remove(OfonoSlotManagerObject *mgr,
+	OfonoSlotObject *slot)
+{
+	struct slot_manager_imsi_entry *entry =
+		g_hash_table_lookup(mgr->imsi_index, slot->imsi);
+
+	if (entry) {
+		if (!--entry->count) {
+			g_hash_table_remove(mgr->imsi_index, slot->imsi);
+		} else if (entry->slot == slot) {
+			/* Same SIM in two slots, should be pretty rare */
+			entry->slot = slot_manager_scan_slot_imsi(mgr,
+				slot->imsi, slot);
+		}
+		mgr->imsi_slots--;
+	}
+}
+
+static void slot_manager_slot_update_imsi(OfonoSlotObject *slot)
+{
+	OfonoSlotManagerObject *mgr = slot->manager;
+	const char *imsi = slot->watch->imsi;
+
+	if (g_strcmp0(slot->imsi, imsi)) {
+		if (mgr && slot->imsi) {
+			slot_manager_imsi_index_remove(mgr, slot);
+		}
+		g_free(slot->imsi);
+		slot->imsi = g_strdup(imsi);
+		if (mgr && slot->imsi) {
+			slot_manager_imsi_index_add(mgr, slot);
+		}
 	}
 }
 
+static void slot_manager_imsi_entry_free(gpointer data)
+{
+	g_slice_free(struct slot_manager_imsi_entry, data);
+}
+
+/* NULL imsi finds the first slot with any IMSI */
 static OfonoSlotObject *slot_manager_find_slot_imsi(OfonoSlotManagerObject *mgr,
 	const char *imsi)
 {
-	struct slot_manager_imsi_slot_data data;
+	if (imsi) {
+		struct slot_manager_imsi_entry *entry =
+			g_hash_table_lookup(mgr->imsi_index, imsi);
 
-	memset(&data, 0, sizeof(data));
-	data.imsi = imsi;
-	slot_manager_foreach_slot(mgr, slot_manager_find_slot_imsi_cb, &data);
-	return data.slot;
+		return entry ? entry->slot : NULL;
+	} else if (mgr->imsi_slots) {
+		return slot_manager_scan_slot_imsi(mgr, NULL, NULL);
+	} else {
+		return NULL;
+	}
 }
 
 static gboolean slot_manager_all_sims_are_initialized_cb(OfonoSlotObject *slot,
@@ -781,7 +916,7 @@ static enum slot_manager_dbus_signal slot_manager_update_modem_paths
 						SM_STORE_DEFAULT_DATA_SIM,
 						imsi);
 
-				storage_sync(NULL, SM_STORE, mgr->storage);
+				slot_manager_storage_changed(mgr);
 				slot_manager_queue_property_change(mgr,
 				OFONO_SLOT_MANAGER_PROPERTY_DEFAULT_DATA_IMSI);
 				mask |= SLOT_MANAGER_DBUS_SIGNAL_DATA_IMSI;
@@ -860,34 +995,16 @@ static enum slot_manager_dbus_signal slot_manager_update_modem_paths
 	return mask;
 }
 
-static gboolean slot_manager_update_ready_driver_cb(OfonoSlotDriverReg *reg,
-	void *unused)
-{
-	return reg->start_id ? SM_LOOP_DONE : SM_LOOP_CONTINUE;
-}
-
-static gboolean slot_manager_update_ready_slot_cb(OfonoSlotObject *slot,
-	void *unused)
-{
-	return (slot->pub.sim_presence == OFONO_SLOT_SIM_UNKNOWN) ?
-		SM_LOOP_DONE : SM_LOOP_CONTINUE;
-}
-
 static void slot_manager_update_ready(OfonoSlotManagerObject *mgr)
 {
 	struct ofono_slot_manager *m = &mgr->pub;
 
-	/* ready is a one-way flag */
-	if (!m->ready &&
-		/*
-		 * slot_manager_foreach_xxx return FALSE if either all
-		 * callbacks returned SM_LOOP_CONTINUE or there are no
-		 * drivers/slots. In either case we are ready.
-		 */
-		!slot_manager_foreach_driver(mgr,
-			slot_manager_update_ready_driver_cb, NULL) &&
-		!slot_manager_foreach_slot(mgr,
-			slot_manager_update_ready_slot_cb, NULL)) {
+	/*
+	 * ready is a one-way flag. We are ready when no driver is
+	 * still starting and every slot knows whether its SIM is
+	 * present (including the case of no drivers or no slots).
+	 */
+	if (!m->ready && !mgr->drivers_starting && !mgr->slots_unknown) {
 		m->ready = TRUE;
 		DBG("ready");
 		slot_manager_update_dbus_block(mgr);
@@ -909,6 +1026,9 @@ static gboolean slot_manager_start_driver_cb(OfonoSlotDriverReg *reg,
 	}
 	if (d->start) {
 		reg->start_id = d->start(reg->driver_data);
+		if (reg->start_id) {
+			mgr->drivers_starting++;
+		}
 	}
 	return SM_LOOP_CONTINUE;
 }
@@ -974,6 +1094,7 @@ static void ofono_slot_manager_object_finalize(GObject* obj)
 
 	/* Drivers are unregistered by __ofono_slot_manager_cleanup */
 	GASSERT(!mgr->drivers);
+	slot_manager_storage_flush(mgr);
 	g_slist_free_full(mgr->slots, g_object_unref);
 	g_free(mgr->pslots);
 	slot_manager_dbus_free(mgr->dbus);
@@ -983,6 +1104,7 @@ static void ofono_slot_manager_object_finalize(GObject* obj)
 	if (mgr->errors) {
 		g_hash_table_destroy(mgr->errors);
 	}
+	g_hash_table_destroy(mgr->imsi_index);
 	g_key_file_free(mgr->storage);
 	g_free(mgr->default_voice_imsi);
 	g_free(mgr->default_data_imsi);
@@ -1202,7 +1324,10 @@ void ofono_slot_driver_started(OfonoSlotDriverReg *reg)
 	if (reg) {
 		OfonoSlotManagerObject *mgr = reg->manager;
 
-		reg->start_id = 0;
+		if (reg->start_id) {
+			reg->start_id = 0;
+			mgr->drivers_starting--;
+		}
 		g_object_ref(mgr);
 		slot_manager_update_ready(mgr);
 		slot_manager_emit_all_queued_signals(mgr);
@@ -1366,6 +1491,11 @@ void ofono_slot_set_sim_presence(struct ofono_slot *s,
 		OfonoSlotObject *slot = slot_object_cast(s);
 		OfonoSlotManagerObject *mgr = slot->manager;
 
+		if (s->sim_presence == OFONO_SLOT_SIM_UNKNOWN) {
+			mgr->slots_unknown--;
+		} else if (sim_presence == OFONO_SLOT_SIM_UNKNOWN) {
+			mgr->slots_unknown++;
+		}
 		s->sim_presence = sim_presence;
 		slot_queue_property_change(slot,
 			OFONO_SLOT_PROPERTY_SIM_PRESENCE);
@@ -1426,6 +1556,9 @@ static void ofono_slot_manager_object_init(OfonoSlotManagerObject *mgr)
 	g_key_file_free(conf);
 	g_free(fn);
 
+	mgr->imsi_index = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, slot_manager_imsi_entry_free);
+
 	/* Load settings */
 	mgr->storage = storage_open(NULL, SM_STORE);
 	mgr->pub.default_voice_imsi = mgr->default_voice_imsi =
@@ -1500,6 +1633,7 @@ void __ofono_slot_manager_cleanup(void)
 		 * OfonoSlotManagerObject alive even after we drop our ref.
 		 */
 		slot_manager = NULL;
+		slot_manager_storage_flush(mgr);
 		slot_manager_foreach_slot(mgr, ofono_slot_manager_detach, NULL);
 		mgr->drivers = NULL;
 		g_slist_free_full(drivers,(GDestroyNotify)slot_driver_reg_free);
@@ -1535,6 +1669,9 @@ void ofono_slot_driver_unregister(OfonoSlotDriverReg *reg)
 		GSList* l = g_slist_find(slot_manager->drivers, reg);
 
 		if (l) {
+			if (reg->start_id) {
+				slot_manager->drivers_starting--;
+			}
 			slot_manager->drivers = g_slist_delete_link
 				(slot_manager->drivers, l);
 			slot_driver_reg_free(reg);
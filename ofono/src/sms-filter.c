@@ -23,6 +23,8 @@
 #define CAST(address,type,field) \
     ((type *)((guint8*)(address) - G_STRUCT_OFFSET(type,field)))
 
+#define SMS_FILTER_MAX_SYNC (8)
+
 /* We don't convert enums, assert that they match each other */
 #define ASSERT_ENUM_(x) G_STATIC_ASSERT((int)x == (int)OFONO_##x)
 
@@ -74,6 +76,8 @@ struct sms_filter_message {
 	GSList *filter_link;
 	guint pending_id;
 	guint continue_id;
+	GSourceFunc next_fn;
+	gboolean sync;
 };
 
 struct sms_filter_chain_send_text {
@@ -236,6 +240,7 @@ static void sms_filter_message_destroy(struct sms_filter_message *msg)
 		g_source_remove(msg->continue_id);
 		msg->continue_id = 0;
 	}
+	msg->next_fn = NULL;
 	if (!msg->destroyed) {
 		const struct sms_filter_message_fn *fn = msg->fn;
 
@@ -296,11 +301,41 @@ static void sms_filter_message_free(struct sms_filter_message *msg)
 	}
 }
 
+static gboolean sms_filter_message_next_cb(gpointer data)
+{
+	struct sms_filter_message *msg = data;
+	int n;
+
+	/*
+	 * A filter completing synchronously from the process callback
+	 * doesn't need another trip through the main loop, we can move
+	 * on to the next filter as soon as it returns. The number of
+	 * such steps per dispatch is limited, and the first one always
+	 * comes from here so the caller never sees the message passed
+	 * through (or dropped) before the chain function returns.
+	 */
+	msg->continue_id = 0;
+	msg->refcount++;
+	for (n = 0; msg->next_fn && !msg->continue_id; n++) {
+		GSourceFunc fn = msg->next_fn;
+
+		msg->next_fn = NULL;
+		msg->sync = (n + 1 < SMS_FILTER_MAX_SYNC);
+		fn(msg);
+	}
+	msg->sync = FALSE;
+	sms_filter_message_unref(msg);
+	return G_SOURCE_REMOVE;
+}
+
 static void sms_filter_message_next(struct sms_filter_message *msg,
 							GSourceFunc fn)
 {
 	msg->pending_id = 0;
-	msg->continue_id = g_idle_add(fn, msg);
+	msg->next_fn = fn;
+	if (!msg->sync) {
+		msg->continue_id = g_idle_add(sms_filter_message_next_cb, msg);
+	}
 }
 
 static gboolean sms_filter_message_continue(gpointer data)
@@ -51,6 +51,28 @@ struct stk_timer {
 	time_t start;
 };
 
+/*
+ * Envelopes are sent to the UICC one at a time. Whatever the user is
+ * waiting for goes out first, bulk data downloads (SMS-PP, CBS) last.
+ */
+enum envelope_class {
+	ENVELOPE_CLASS_INTERACTIVE = 0,
+	ENVELOPE_CLASS_EVENT,
+	ENVELOPE_CLASS_DOWNLOAD,
+	ENVELOPE_CLASS_COUNT
+};
+
+static const char *const envelope_class_name[ENVELOPE_CLASS_COUNT] = {
+	"Interactive", "Event", "Download"
+};
+
+struct envelope_stats {
+	unsigned int sent;
+	unsigned int failed;
+	guint64 latency_total;		/* Microseconds */
+	guint64 latency_max;
+};
+
 struct ofono_stk {
 	const struct ofono_stk_driver *driver;
 	void *driver_data;
@@ -58,6 +80,9 @@ struct ofono_stk {
 	struct stk_command *pending_cmd;
 	void (*cancel_cmd)(struct ofono_stk *stk);
 	GQueue *envelope_q;
+	struct envelope_stats envelope_stats[ENVELOPE_CLASS_COUNT];
+	unsigned int envelope_max_depth;
+	unsigned int envelope_merged;
 	DBusMessage *pending;
 
 	struct stk_timer timers[8];
@@ -86,6 +111,9 @@ struct envelope_op {
 	uint8_t tlv[256];
 	unsigned int tlv_len;
 	int retries;
+	enum envelope_class cls;
+	int event;			/* State event type, or -1 */
+	gint64 queued;
 	void (*cb)(struct ofono_stk *stk, gboolean ok,
 			const unsigned char *data, int length);
 };
@@ -182,6 +210,27 @@ static void send_simple_response(struct ofono_stk *stk,
 		stk_command_cb(&error, stk);
 }
 
+static void envelope_stats_update(struct ofono_stk *stk,
+					const struct envelope_op *op,
+					gboolean ok)
+{
+	struct envelope_stats *stats = stk->envelope_stats + op->cls;
+	guint64 latency = g_get_monotonic_time() - op->queued;
+
+	if (ok)
+		stats->sent++;
+	else
+		stats->failed++;
+
+	stats->latency_total += latency;
+	if (stats->latency_max < latency)
+		stats->latency_max = latency;
+
+	DBG("%s envelope done in %u ms, %u queued",
+		envelope_class_name[op->cls], (unsigned int) (latency / 1000),
+		g_queue_get_length(stk->envelope_q));
+}
+
 static void envelope_cb(const struct ofono_error *error, const uint8_t *data,
 			int length, void *user_data)
 {
@@ -201,6 +250,7 @@ static void envelope_cb(const struct ofono_error *error, const uint8_t *data,
 		result = FALSE;
 
 	g_queue_pop_head(stk->envelope_q);
+	envelope_stats_update(stk, op, result);
 
 	if (op->cb)
 		op->cb(stk, result, data, length);
@@ -221,6 +271,38 @@ static void envelope_queue_run(struct ofono_stk *stk)
 	}
 }
 
+static enum envelope_class envelope_class_get(const struct stk_envelope *e)
+{
+	switch (e->type) {
+	case STK_ENVELOPE_TYPE_MENU_SELECTION:
+	case STK_ENVELOPE_TYPE_TIMER_EXPIRATION:
+	case STK_ENVELOPE_TYPE_CALL_CONTROL:
+	case STK_ENVELOPE_TYPE_MO_SMS_CONTROL:
+		return ENVELOPE_CLASS_INTERACTIVE;
+	case STK_ENVELOPE_TYPE_EVENT_DOWNLOAD:
+		return ENVELOPE_CLASS_EVENT;
+	default:
+		return ENVELOPE_CLASS_DOWNLOAD;
+	}
+}
+
+/* Events that report a state, only the latest one is worth sending */
+static int envelope_event_get(const struct stk_envelope *e)
+{
+	if (e->type != STK_ENVELOPE_TYPE_EVENT_DOWNLOAD)
+		return -1;
+
+	switch (e->event_download.type) {
+	case STK_EVENT_TYPE_LOCATION_STATUS:
+	case STK_EVENT_TYPE_SINGLE_ACCESS_TECHNOLOGY_CHANGE:
+	case STK_EVENT_TYPE_MULTIPLE_ACCESS_TECHNOLOGIES_CHANGE:
+	case STK_EVENT_TYPE_NETWORK_SEARCH_MODE_CHANGE:
+		return e->event_download.type;
+	default:
+		return -1;
+	}
+}
+
 static int stk_send_envelope(struct ofono_stk *stk, struct stk_envelope *e,
 				void (*cb)(struct ofono_stk *stk, gboolean ok,
 						const uint8_t *data,
@@ -229,8 +311,9 @@ static int stk_send_envelope(struct ofono_stk *stk, struct stk_envelope *e,
 	const uint8_t *tlv;
 	unsigned int tlv_len;
 	struct envelope_op *op;
-
-	DBG("");
+	enum envelope_class cls;
+	int event;
+	GList *l;
 
 	if (stk->driver->envelope == NULL)
 		return -ENOSYS;
@@ -240,14 +323,49 @@ static int stk_send_envelope(struct ofono_stk *stk, struct stk_envelope *e,
 	if (tlv == NULL)
 		return -EINVAL;
 
+	cls = envelope_class_get(e);
+	event = envelope_event_get(e);
+
+	/* The head of the queue is with the driver already */
+	l = stk->envelope_q->head;
+	if (l)
+		l = l->next;
+
+	for (; l; l = l->next) {
+		op = l->data;
+
+		if (event >= 0 && op->event == event && op->cb == cb) {
+			DBG("event %d envelope superseded", event);
+			memcpy(op->tlv, tlv, tlv_len);
+			op->tlv_len = tlv_len;
+			stk->envelope_merged++;
+			return 0;
+		}
+
+		if (op->cls > cls)
+			break;
+	}
+
 	op = g_new0(struct envelope_op, 1);
 
 	op->cb = cb;
 	op->retries = retries;
+	op->cls = cls;
+	op->event = event;
+	op->queued = g_get_monotonic_time();
 	memcpy(op->tlv, tlv, tlv_len);
 	op->tlv_len = tlv_len;
 
-	g_queue_push_tail(stk->envelope_q, op);
+	if (l)
+		g_queue_insert_before(stk->envelope_q, l, op);
+	else
+		g_queue_push_tail(stk->envelope_q, op);
+
+	if (stk->envelope_max_depth < g_queue_get_length(stk->envelope_q))
+		stk->envelope_max_depth = g_queue_get_length(stk->envelope_q);
+
+	DBG("%s envelope, %u queued", envelope_class_name[cls],
+				g_queue_get_length(stk->envelope_q));
 
 	if (g_queue_get_length(stk->envelope_q) == 1)
 		envelope_queue_run(stk);
@@ -871,6 +989,73 @@ static DBusMessage *stk_select_item(DBusConnection *conn,
 	return NULL;
 }
 
+static void append_envelope_stats(DBusMessageIter *dict, const char *name,
+					const struct envelope_stats *stats)
+{
+	unsigned int count = stats->sent + stats->failed;
+	dbus_uint32_t avg = count ? stats->latency_total / count / 1000 : 0;
+	dbus_uint32_t max = stats->latency_max / 1000;
+	DBusMessageIter entry;
+	DBusMessageIter variant;
+	DBusMessageIter array;
+
+	dbus_message_iter_open_container(dict, DBUS_TYPE_DICT_ENTRY,
+						NULL, &entry);
+	dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+	dbus_message_iter_open_container(&entry, DBUS_TYPE_VARIANT,
+					"a" OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&variant);
+	dbus_message_iter_open_container(&variant, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&array);
+
+	ofono_dbus_dict_append(&array, "Sent", DBUS_TYPE_UINT32,
+						&stats->sent);
+	ofono_dbus_dict_append(&array, "Failed", DBUS_TYPE_UINT32,
+						&stats->failed);
+	ofono_dbus_dict_append(&array, "AverageLatency", DBUS_TYPE_UINT32,
+						&avg);
+	ofono_dbus_dict_append(&array, "MaxLatency", DBUS_TYPE_UINT32, &max);
+
+	dbus_message_iter_close_container(&variant, &array);
+	dbus_message_iter_close_container(&entry, &variant);
+	dbus_message_iter_close_container(dict, &entry);
+}
+
+static DBusMessage *stk_get_envelope_stats(DBusConnection *conn,
+						DBusMessage *msg, void *data)
+{
+	struct ofono_stk *stk = data;
+	dbus_uint32_t queued = g_queue_get_length(stk->envelope_q);
+	DBusMessage *reply;
+	DBusMessageIter iter;
+	DBusMessageIter dict;
+	int i;
+
+	reply = dbus_message_new_method_return(msg);
+	if (reply == NULL)
+		return NULL;
+
+	dbus_message_iter_init_append(reply, &iter);
+
+	dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+					OFONO_PROPERTIES_ARRAY_SIGNATURE,
+					&dict);
+	ofono_dbus_dict_append(&dict, "Queued", DBUS_TYPE_UINT32, &queued);
+	ofono_dbus_dict_append(&dict, "MaxQueued", DBUS_TYPE_UINT32,
+						&stk->envelope_max_depth);
+	ofono_dbus_dict_append(&dict, "Superseded", DBUS_TYPE_UINT32,
+						&stk->envelope_merged);
+
+	for (i = 0; i < ENVELOPE_CLASS_COUNT; i++)
+		append_envelope_stats(&dict, envelope_class_name[i],
+					stk->envelope_stats + i);
+
+	dbus_message_iter_close_container(&iter, &dict);
+
+	return reply;
+}
+
 static const GDBusMethodTable stk_methods[] = {
 	{ GDBUS_METHOD("GetProperties",
 			NULL, GDBUS_ARGS({ "properties", "a{sv}" }),
@@ -884,6 +1069,9 @@ static const GDBusMethodTable stk_methods[] = {
 	{ GDBUS_METHOD("UnregisterAgent",
 			GDBUS_ARGS({ "path", "o" }), NULL,
 			stk_unregister_agent) },
+	{ GDBUS_METHOD("GetEnvelopeStatistics",
+			NULL, GDBUS_ARGS({ "statistics", "a{sv}" }),
+			stk_get_envelope_stats) },
 	{ }
 };
 
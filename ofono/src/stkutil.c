@@ -25,6 +25,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <glib.h>
@@ -40,6 +41,7 @@ enum stk_data_object_flag {
 	DATAOBJ_FLAG_MINIMUM =		2,
 	DATAOBJ_FLAG_CR =		4,
 	DATAOBJ_FLAG_LIST =		8,
+	DATAOBJ_FLAG_SCRATCH =		16,
 };
 
 struct stk_file_iter {
@@ -73,6 +75,8 @@ struct gsm_sms_tpdu {
 	uint8_t tpdu[184];
 };
 
+#define STK_TEXT_UNPACK_BUF (255 * 8 / 7)
+
 #define CHECK_TEXT_AND_ICON(text, icon_id)			\
 	if (status != STK_PARSE_RESULT_OK)			\
 		return status;					\
@@ -91,17 +95,30 @@ static char *decode_text(uint8_t dcs, int len, const unsigned char *data)
 	switch (charset) {
 	case SMS_CHARSET_7BIT:
 	{
+		/* Enough for any text that fits in a short length TLV */
+		uint8_t buf[STK_TEXT_UNPACK_BUF];
 		long written;
 		unsigned long max_to_unpack = len * 8 / 7;
-		uint8_t *unpacked = unpack_7bit(data, len, 0, false,
+		uint8_t *unpacked;
+
+		if (max_to_unpack <= sizeof(buf))
+			unpacked = unpack_7bit_own_buf(data, len, 0, false,
+							max_to_unpack,
+							&written, 0, buf);
+		else
+			unpacked = unpack_7bit(data, len, 0, false,
 							max_to_unpack,
 							&written, 0);
+
 		if (unpacked == NULL)
 			return NULL;
 
 		utf8 = convert_gsm_to_utf8(unpacked, written,
 						NULL, NULL, 0);
-		g_free(unpacked);
+
+		if (unpacked != buf)
+			g_free(unpacked);
+
 		break;
 	}
 	case SMS_CHARSET_8BIT:
@@ -2053,193 +2070,126 @@ static bool parse_dataobj_broadcast_network_info(
 	return true;
 }
 
-static dataobj_handler handler_for_type(enum stk_data_object_type type)
-{
-	switch (type) {
-	case STK_DATA_OBJECT_TYPE_ADDRESS:
-		return parse_dataobj_address;
-	case STK_DATA_OBJECT_TYPE_ALPHA_ID:
-		return parse_dataobj_alpha_id;
-	case STK_DATA_OBJECT_TYPE_SUBADDRESS:
-		return parse_dataobj_subaddress;
-	case STK_DATA_OBJECT_TYPE_CCP:
-		return parse_dataobj_ccp;
-	case STK_DATA_OBJECT_TYPE_CBS_PAGE:
-		return parse_dataobj_cbs_page;
-	case STK_DATA_OBJECT_TYPE_DURATION:
-		return parse_dataobj_duration;
-	case STK_DATA_OBJECT_TYPE_ITEM:
-		return parse_dataobj_item;
-	case STK_DATA_OBJECT_TYPE_ITEM_ID:
-		return parse_dataobj_item_id;
-	case STK_DATA_OBJECT_TYPE_RESPONSE_LENGTH:
-		return parse_dataobj_response_len;
-	case STK_DATA_OBJECT_TYPE_RESULT:
-		return parse_dataobj_result;
-	case STK_DATA_OBJECT_TYPE_GSM_SMS_TPDU:
-		return parse_dataobj_gsm_sms_tpdu;
-	case STK_DATA_OBJECT_TYPE_SS_STRING:
-		return parse_dataobj_ss;
-	case STK_DATA_OBJECT_TYPE_TEXT:
-		return parse_dataobj_text;
-	case STK_DATA_OBJECT_TYPE_TONE:
-		return parse_dataobj_tone;
-	case STK_DATA_OBJECT_TYPE_USSD_STRING:
-		return parse_dataobj_ussd;
-	case STK_DATA_OBJECT_TYPE_FILE_LIST:
-		return parse_dataobj_file_list;
-	case STK_DATA_OBJECT_TYPE_LOCATION_INFO:
-		return parse_dataobj_location_info;
-	case STK_DATA_OBJECT_TYPE_IMEI:
-		return parse_dataobj_imei;
-	case STK_DATA_OBJECT_TYPE_HELP_REQUEST:
-		return parse_dataobj_help_request;
-	case STK_DATA_OBJECT_TYPE_NETWORK_MEASUREMENT_RESULTS:
-		return parse_dataobj_network_measurement_results;
-	case STK_DATA_OBJECT_TYPE_DEFAULT_TEXT:
-		return parse_dataobj_default_text;
-	case STK_DATA_OBJECT_TYPE_ITEMS_NEXT_ACTION_INDICATOR:
-		return parse_dataobj_items_next_action_indicator;
-	case STK_DATA_OBJECT_TYPE_EVENT_LIST:
-		return parse_dataobj_event_list;
-	case STK_DATA_OBJECT_TYPE_CAUSE:
-		return parse_dataobj_cause;
-	case STK_DATA_OBJECT_TYPE_LOCATION_STATUS:
-		return parse_dataobj_location_status;
-	case STK_DATA_OBJECT_TYPE_TRANSACTION_ID:
-		return parse_dataobj_transaction_id;
-	case STK_DATA_OBJECT_TYPE_BCCH_CHANNEL_LIST:
-		return parse_dataobj_bcch_channel_list;
-	case STK_DATA_OBJECT_TYPE_CALL_CONTROL_REQUESTED_ACTION:
-		return parse_dataobj_call_control_requested_action;
-	case STK_DATA_OBJECT_TYPE_ICON_ID:
-		return parse_dataobj_icon_id;
-	case STK_DATA_OBJECT_TYPE_ITEM_ICON_ID_LIST:
-		return parse_dataobj_item_icon_id_list;
-	case STK_DATA_OBJECT_TYPE_CARD_READER_STATUS:
-		return parse_dataobj_card_reader_status;
-	case STK_DATA_OBJECT_TYPE_CARD_ATR:
-		return parse_dataobj_card_atr;
-	case STK_DATA_OBJECT_TYPE_C_APDU:
-		return parse_dataobj_c_apdu;
-	case STK_DATA_OBJECT_TYPE_R_APDU:
-		return parse_dataobj_r_apdu;
-	case STK_DATA_OBJECT_TYPE_TIMER_ID:
-		return parse_dataobj_timer_id;
-	case STK_DATA_OBJECT_TYPE_TIMER_VALUE:
-		return parse_dataobj_timer_value;
-	case STK_DATA_OBJECT_TYPE_DATETIME_TIMEZONE:
-		return parse_dataobj_datetime_timezone;
-	case STK_DATA_OBJECT_TYPE_AT_COMMAND:
-		return parse_dataobj_at_command;
-	case STK_DATA_OBJECT_TYPE_AT_RESPONSE:
-		return parse_dataobj_at_response;
-	case STK_DATA_OBJECT_TYPE_BC_REPEAT_INDICATOR:
-		return parse_dataobj_bc_repeat_indicator;
-	case STK_DATA_OBJECT_TYPE_IMMEDIATE_RESPONSE:
-		return parse_dataobj_imm_resp;
-	case STK_DATA_OBJECT_TYPE_DTMF_STRING:
-		return parse_dataobj_dtmf_string;
-	case STK_DATA_OBJECT_TYPE_LANGUAGE:
-		return parse_dataobj_language;
-	case STK_DATA_OBJECT_TYPE_BROWSER_ID:
-		return parse_dataobj_browser_id;
-	case STK_DATA_OBJECT_TYPE_TIMING_ADVANCE:
-		return parse_dataobj_timing_advance;
-	case STK_DATA_OBJECT_TYPE_URL:
-		return parse_dataobj_url;
-	case STK_DATA_OBJECT_TYPE_BEARER:
-		return parse_dataobj_bearer;
-	case STK_DATA_OBJECT_TYPE_PROVISIONING_FILE_REF:
-		return parse_dataobj_provisioning_file_reference;
-	case STK_DATA_OBJECT_TYPE_BROWSER_TERMINATION_CAUSE:
-		return parse_dataobj_browser_termination_cause;
-	case STK_DATA_OBJECT_TYPE_BEARER_DESCRIPTION:
-		return parse_dataobj_bearer_description;
-	case STK_DATA_OBJECT_TYPE_CHANNEL_DATA:
-		return parse_dataobj_channel_data;
-	case STK_DATA_OBJECT_TYPE_CHANNEL_DATA_LENGTH:
-		return parse_dataobj_channel_data_length;
-	case STK_DATA_OBJECT_TYPE_BUFFER_SIZE:
-		return parse_dataobj_buffer_size;
-	case STK_DATA_OBJECT_TYPE_CHANNEL_STATUS:
-		return parse_dataobj_channel_status;
-	case STK_DATA_OBJECT_TYPE_CARD_READER_ID:
-		return parse_dataobj_card_reader_id;
-	case STK_DATA_OBJECT_TYPE_OTHER_ADDRESS:
-		return parse_dataobj_other_address;
-	case STK_DATA_OBJECT_TYPE_UICC_TE_INTERFACE:
-		return parse_dataobj_uicc_te_interface;
-	case STK_DATA_OBJECT_TYPE_AID:
-		return parse_dataobj_aid;
-	case STK_DATA_OBJECT_TYPE_ACCESS_TECHNOLOGY:
-		return parse_dataobj_access_technology;
-	case STK_DATA_OBJECT_TYPE_DISPLAY_PARAMETERS:
-		return parse_dataobj_display_parameters;
-	case STK_DATA_OBJECT_TYPE_SERVICE_RECORD:
-		return parse_dataobj_service_record;
-	case STK_DATA_OBJECT_TYPE_DEVICE_FILTER:
-		return parse_dataobj_device_filter;
-	case STK_DATA_OBJECT_TYPE_SERVICE_SEARCH:
-		return parse_dataobj_service_search;
-	case STK_DATA_OBJECT_TYPE_ATTRIBUTE_INFO:
-		return parse_dataobj_attribute_info;
-	case STK_DATA_OBJECT_TYPE_SERVICE_AVAILABILITY:
-		return parse_dataobj_service_availability;
-	case STK_DATA_OBJECT_TYPE_REMOTE_ENTITY_ADDRESS:
-		return parse_dataobj_remote_entity_address;
-	case STK_DATA_OBJECT_TYPE_ESN:
-		return parse_dataobj_esn;
-	case STK_DATA_OBJECT_TYPE_NETWORK_ACCESS_NAME:
-		return parse_dataobj_network_access_name;
-	case STK_DATA_OBJECT_TYPE_CDMA_SMS_TPDU:
-		return parse_dataobj_cdma_sms_tpdu;
-	case STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE:
-		return parse_dataobj_text_attr;
-	case STK_DATA_OBJECT_TYPE_PDP_ACTIVATION_PARAMETER:
-		return parse_dataobj_pdp_act_par;
-	case STK_DATA_OBJECT_TYPE_ITEM_TEXT_ATTRIBUTE_LIST:
-		return parse_dataobj_item_text_attribute_list;
-	case STK_DATA_OBJECT_TYPE_UTRAN_MEASUREMENT_QUALIFIER:
-		return parse_dataobj_utran_meas_qualifier;
-	case STK_DATA_OBJECT_TYPE_IMEISV:
-		return parse_dataobj_imeisv;
-	case STK_DATA_OBJECT_TYPE_NETWORK_SEARCH_MODE:
-		return parse_dataobj_network_search_mode;
-	case STK_DATA_OBJECT_TYPE_BATTERY_STATE:
-		return parse_dataobj_battery_state;
-	case STK_DATA_OBJECT_TYPE_BROWSING_STATUS:
-		return parse_dataobj_browsing_status;
-	case STK_DATA_OBJECT_TYPE_FRAME_LAYOUT:
-		return parse_dataobj_frame_layout;
-	case STK_DATA_OBJECT_TYPE_FRAMES_INFO:
-		return parse_dataobj_frames_info;
-	case STK_DATA_OBJECT_TYPE_FRAME_ID:
-		return parse_dataobj_frame_id;
-	case STK_DATA_OBJECT_TYPE_MEID:
-		return parse_dataobj_meid;
-	case STK_DATA_OBJECT_TYPE_MMS_REFERENCE:
-		return parse_dataobj_mms_reference;
-	case STK_DATA_OBJECT_TYPE_MMS_ID:
-		return parse_dataobj_mms_id;
-	case STK_DATA_OBJECT_TYPE_MMS_TRANSFER_STATUS:
-		return parse_dataobj_mms_transfer_status;
-	case STK_DATA_OBJECT_TYPE_MMS_CONTENT_ID:
-		return parse_dataobj_mms_content_id;
-	case STK_DATA_OBJECT_TYPE_MMS_NOTIFICATION:
-		return parse_dataobj_mms_notification;
-	case STK_DATA_OBJECT_TYPE_LAST_ENVELOPE:
-		return parse_dataobj_last_envelope;
-	case STK_DATA_OBJECT_TYPE_REGISTRY_APPLICATION_DATA:
-		return parse_dataobj_registry_application_data;
-	case STK_DATA_OBJECT_TYPE_ACTIVATE_DESCRIPTOR:
-		return parse_dataobj_activate_descriptor;
-	case STK_DATA_OBJECT_TYPE_BROADCAST_NETWORK_INFO:
-		return parse_dataobj_broadcast_network_info;
-	default:
-		return NULL;
-	}
-}
+/* Indexed by data object type, which always fits in 7 bits */
+static const dataobj_handler dataobj_handlers[0x80] = {
+	[STK_DATA_OBJECT_TYPE_ADDRESS] = parse_dataobj_address,
+	[STK_DATA_OBJECT_TYPE_ALPHA_ID] = parse_dataobj_alpha_id,
+	[STK_DATA_OBJECT_TYPE_SUBADDRESS] = parse_dataobj_subaddress,
+	[STK_DATA_OBJECT_TYPE_CCP] = parse_dataobj_ccp,
+	[STK_DATA_OBJECT_TYPE_CBS_PAGE] = parse_dataobj_cbs_page,
+	[STK_DATA_OBJECT_TYPE_DURATION] = parse_dataobj_duration,
+	[STK_DATA_OBJECT_TYPE_ITEM] = parse_dataobj_item,
+	[STK_DATA_OBJECT_TYPE_ITEM_ID] = parse_dataobj_item_id,
+	[STK_DATA_OBJECT_TYPE_RESPONSE_LENGTH] = parse_dataobj_response_len,
+	[STK_DATA_OBJECT_TYPE_RESULT] = parse_dataobj_result,
+	[STK_DATA_OBJECT_TYPE_GSM_SMS_TPDU] = parse_dataobj_gsm_sms_tpdu,
+	[STK_DATA_OBJECT_TYPE_SS_STRING] = parse_dataobj_ss,
+	[STK_DATA_OBJECT_TYPE_TEXT] = parse_dataobj_text,
+	[STK_DATA_OBJECT_TYPE_TONE] = parse_dataobj_tone,
+	[STK_DATA_OBJECT_TYPE_USSD_STRING] = parse_dataobj_ussd,
+	[STK_DATA_OBJECT_TYPE_FILE_LIST] = parse_dataobj_file_list,
+	[STK_DATA_OBJECT_TYPE_LOCATION_INFO] = parse_dataobj_location_info,
+	[STK_DATA_OBJECT_TYPE_IMEI] = parse_dataobj_imei,
+	[STK_DATA_OBJECT_TYPE_HELP_REQUEST] = parse_dataobj_help_request,
+	[STK_DATA_OBJECT_TYPE_NETWORK_MEASUREMENT_RESULTS] =
+		parse_dataobj_network_measurement_results,
+	[STK_DATA_OBJECT_TYPE_DEFAULT_TEXT] = parse_dataobj_default_text,
+	[STK_DATA_OBJECT_TYPE_ITEMS_NEXT_ACTION_INDICATOR] =
+		parse_dataobj_items_next_action_indicator,
+	[STK_DATA_OBJECT_TYPE_EVENT_LIST] = parse_dataobj_event_list,
+	[STK_DATA_OBJECT_TYPE_CAUSE] = parse_dataobj_cause,
+	[STK_DATA_OBJECT_TYPE_LOCATION_STATUS] = parse_dataobj_location_status,
+	[STK_DATA_OBJECT_TYPE_TRANSACTION_ID] = parse_dataobj_transaction_id,
+	[STK_DATA_OBJECT_TYPE_BCCH_CHANNEL_LIST] =
+		parse_dataobj_bcch_channel_list,
+	[STK_DATA_OBJECT_TYPE_CALL_CONTROL_REQUESTED_ACTION] =
+		parse_dataobj_call_control_requested_action,
+	[STK_DATA_OBJECT_TYPE_ICON_ID] = parse_dataobj_icon_id,
+	[STK_DATA_OBJECT_TYPE_ITEM_ICON_ID_LIST] =
+		parse_dataobj_item_icon_id_list,
+	[STK_DATA_OBJECT_TYPE_CARD_READER_STATUS] =
+		parse_dataobj_card_reader_status,
+	[STK_DATA_OBJECT_TYPE_CARD_ATR] = parse_dataobj_card_atr,
+	[STK_DATA_OBJECT_TYPE_C_APDU] = parse_dataobj_c_apdu,
+	[STK_DATA_OBJECT_TYPE_R_APDU] = parse_dataobj_r_apdu,
+	[STK_DATA_OBJECT_TYPE_TIMER_ID] = parse_dataobj_timer_id,
+	[STK_DATA_OBJECT_TYPE_TIMER_VALUE] = parse_dataobj_timer_value,
+	[STK_DATA_OBJECT_TYPE_DATETIME_TIMEZONE] =
+		parse_dataobj_datetime_timezone,
+	[STK_DATA_OBJECT_TYPE_AT_COMMAND] = parse_dataobj_at_command,
+	[STK_DATA_OBJECT_TYPE_AT_RESPONSE] = parse_dataobj_at_response,
+	[STK_DATA_OBJECT_TYPE_BC_REPEAT_INDICATOR] =
+		parse_dataobj_bc_repeat_indicator,
+	[STK_DATA_OBJECT_TYPE_IMMEDIATE_RESPONSE] = parse_dataobj_imm_resp,
+	[STK_DATA_OBJECT_TYPE_DTMF_STRING] = parse_dataobj_dtmf_string,
+	[STK_DATA_OBJECT_TYPE_LANGUAGE] = parse_dataobj_language,
+	[STK_DATA_OBJECT_TYPE_BROWSER_ID] = parse_dataobj_browser_id,
+	[STK_DATA_OBJECT_TYPE_TIMING_ADVANCE] = parse_dataobj_timing_advance,
+	[STK_DATA_OBJECT_TYPE_URL] = parse_dataobj_url,
+	[STK_DATA_OBJECT_TYPE_BEARER] = parse_dataobj_bearer,
+	[STK_DATA_OBJECT_TYPE_PROVISIONING_FILE_REF] =
+		parse_dataobj_provisioning_file_reference,
+	[STK_DATA_OBJECT_TYPE_BROWSER_TERMINATION_CAUSE] =
+		parse_dataobj_browser_termination_cause,
+	[STK_DATA_OBJECT_TYPE_BEARER_DESCRIPTION] =
+		parse_dataobj_bearer_description,
+	[STK_DATA_OBJECT_TYPE_CHANNEL_DATA] = parse_dataobj_channel_data,
+	[STK_DATA_OBJECT_TYPE_CHANNEL_DATA_LENGTH] =
+		parse_dataobj_channel_data_length,
+	[STK_DATA_OBJECT_TYPE_BUFFER_SIZE] = parse_dataobj_buffer_size,
+	[STK_DATA_OBJECT_TYPE_CHANNEL_STATUS] = parse_dataobj_channel_status,
+	[STK_DATA_OBJECT_TYPE_CARD_READER_ID] = parse_dataobj_card_reader_id,
+	[STK_DATA_OBJECT_TYPE_OTHER_ADDRESS] = parse_dataobj_other_address,
+	[STK_DATA_OBJECT_TYPE_UICC_TE_INTERFACE] =
+		parse_dataobj_uicc_te_interface,
+	[STK_DATA_OBJECT_TYPE_AID] = parse_dataobj_aid,
+	[STK_DATA_OBJECT_TYPE_ACCESS_TECHNOLOGY] =
+		parse_dataobj_access_technology,
+	[STK_DATA_OBJECT_TYPE_DISPLAY_PARAMETERS] =
+		parse_dataobj_display_parameters,
+	[STK_DATA_OBJECT_TYPE_SERVICE_RECORD] = parse_dataobj_service_record,
+	[STK_DATA_OBJECT_TYPE_DEVICE_FILTER] = parse_dataobj_device_filter,
+	[STK_DATA_OBJECT_TYPE_SERVICE_SEARCH] = parse_dataobj_service_search,
+	[STK_DATA_OBJECT_TYPE_ATTRIBUTE_INFO] = parse_dataobj_attribute_info,
+	[STK_DATA_OBJECT_TYPE_SERVICE_AVAILABILITY] =
+		parse_dataobj_service_availability,
+	[STK_DATA_OBJECT_TYPE_REMOTE_ENTITY_ADDRESS] =
+		parse_dataobj_remote_entity_address,
+	[STK_DATA_OBJECT_TYPE_ESN] = parse_dataobj_esn,
+	[STK_DATA_OBJECT_TYPE_NETWORK_ACCESS_NAME] =
+		parse_dataobj_network_access_name,
+	[STK_DATA_OBJECT_TYPE_CDMA_SMS_TPDU] = parse_dataobj_cdma_sms_tpdu,
+	[STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE] = parse_dataobj_text_attr,
+	[STK_DATA_OBJECT_TYPE_PDP_ACTIVATION_PARAMETER] =
+		parse_dataobj_pdp_act_par,
+	[STK_DATA_OBJECT_TYPE_ITEM_TEXT_ATTRIBUTE_LIST] =
+		parse_dataobj_item_text_attribute_list,
+	[STK_DATA_OBJECT_TYPE_UTRAN_MEASUREMENT_QUALIFIER] =
+		parse_dataobj_utran_meas_qualifier,
+	[STK_DATA_OBJECT_TYPE_IMEISV] = parse_dataobj_imeisv,
+	[STK_DATA_OBJECT_TYPE_NETWORK_SEARCH_MODE] =
+		parse_dataobj_network_search_mode,
+	[STK_DATA_OBJECT_TYPE_BATTERY_STATE] = parse_dataobj_battery_state,
+	[STK_DATA_OBJECT_TYPE_BROWSING_STATUS] = parse_dataobj_browsing_status,
+	[STK_DATA_OBJECT_TYPE_FRAME_LAYOUT] = parse_dataobj_frame_layout,
+	[STK_DATA_OBJECT_TYPE_FRAMES_INFO] = parse_dataobj_frames_info,
+	[STK_DATA_OBJECT_TYPE_FRAME_ID] = parse_dataobj_frame_id,
+	[STK_DATA_OBJECT_TYPE_MEID] = parse_dataobj_meid,
+	[STK_DATA_OBJECT_TYPE_MMS_REFERENCE] = parse_dataobj_mms_reference,
+	[STK_DATA_OBJECT_TYPE_MMS_ID] = parse_dataobj_mms_id,
+	[STK_DATA_OBJECT_TYPE_MMS_TRANSFER_STATUS] =
+		parse_dataobj_mms_transfer_status,
+	[STK_DATA_OBJECT_TYPE_MMS_CONTENT_ID] = parse_dataobj_mms_content_id,
+	[STK_DATA_OBJECT_TYPE_MMS_NOTIFICATION] =
+		parse_dataobj_mms_notification,
+	[STK_DATA_OBJECT_TYPE_LAST_ENVELOPE] = parse_dataobj_last_envelope,
+	[STK_DATA_OBJECT_TYPE_REGISTRY_APPLICATION_DATA] =
+		parse_dataobj_registry_application_data,
+	[STK_DATA_OBJECT_TYPE_ACTIVATE_DESCRIPTOR] =
+		parse_dataobj_activate_descriptor,
+	[STK_DATA_OBJECT_TYPE_BROADCAST_NETWORK_INFO] =
+		parse_dataobj_broadcast_network_info,
+};
 
 static void destroy_stk_item(gpointer pointer)
 {
@@ -2328,61 +2278,55 @@ static dataobj_handler list_handler_for_type(enum stk_data_object_type type)
 	}
 }
 
-struct dataobj_handler_entry {
+/*
+ * Each command describes the data objects it accepts with a static table,
+ * in the order TS 102.223 lists them. The objects are stored at the given
+ * offset into struct stk_command, or into a caller provided scratch area
+ * for the ones that only matter while the command is being parsed.
+ */
+struct dataobj_desc {
 	enum stk_data_object_type type;
 	int flags;
-	void *data;
+	size_t offset;
 };
 
+#define DATAOBJ(type, flags, field)					\
+	{ STK_DATA_OBJECT_TYPE_ ## type, flags,				\
+		offsetof(struct stk_command, field) }
+
+#define DATAOBJ_SCRATCH(type, flags, scratch, field)			\
+	{ STK_DATA_OBJECT_TYPE_ ## type,				\
+		(flags) | DATAOBJ_FLAG_SCRATCH, offsetof(scratch, field) }
+
 static enum stk_command_parse_result parse_dataobj(
 					struct comprehension_tlv_iter *iter,
-					enum stk_data_object_type type, ...)
+					const struct dataobj_desc *desc,
+					unsigned int n_desc,
+					struct stk_command *command,
+					void *scratch)
 {
-	GSList *entries = NULL;
-	GSList *l;
-	va_list args;
-	bool minimum_set = true;
+	unsigned int next = 0;
+	unsigned int i;
 	bool parse_error = false;
 
-	va_start(args, type);
-
-	while (type != STK_DATA_OBJECT_TYPE_INVALID) {
-		struct dataobj_handler_entry *entry;
-
-		entry = g_new0(struct dataobj_handler_entry, 1);
-
-		entry->type = type;
-		entry->flags = va_arg(args, int);
-		entry->data = va_arg(args, void *);
-
-		type = va_arg(args, enum stk_data_object_type);
-		entries = g_slist_prepend(entries, entry);
-	}
-
-	va_end(args);
-
-	entries = g_slist_reverse(entries);
-
-	l = entries;
 	while (comprehension_tlv_iter_next(iter) == TRUE) {
+		unsigned short tag = comprehension_tlv_iter_get_tag(iter);
+		const struct dataobj_desc *entry = NULL;
 		dataobj_handler handler;
-		struct dataobj_handler_entry *entry;
-		GSList *l2;
-
-		for (l2 = l; l2; l2 = l2->next) {
-			entry = l2->data;
+		uint8_t *base;
 
-			if (comprehension_tlv_iter_get_tag(iter) == entry->type)
+		for (i = next; i < n_desc; i++) {
+			if (tag == desc[i].type) {
+				entry = desc + i;
 				break;
+			}
 
 			/* Can't skip over mandatory objects */
-			if (entry->flags & DATAOBJ_FLAG_MANDATORY) {
-				l2 = NULL;
+			if (desc[i].flags & DATAOBJ_FLAG_MANDATORY)
 				break;
-			}
 		}
 
-		if (l2 == NULL) {
+		if (entry == NULL) {
 			if (comprehension_tlv_get_cr(iter) == TRUE)
 				parse_error = true;
 
@@ -2392,25 +2336,23 @@ static enum stk_command_parse_result parse_dataobj(
 		if (entry->flags & DATAOBJ_FLAG_LIST)
 			handler = list_handler_for_type(entry->type);
 		else
-			handler = handler_for_type(entry->type);
-
-		if (!handler(iter, entry->data))
-			parse_error = true;
+			handler = dataobj_handlers[entry->type];
 
-		l = l2->next;
-	}
+		if (entry->flags & DATAOBJ_FLAG_SCRATCH)
+			base = scratch;
+		else
+			base = (uint8_t *) command;
 
-	for (; l; l = l->next) {
-		struct dataobj_handler_entry *entry = l->data;
+		if (!handler(iter, base + entry->offset))
+			parse_error = true;
 
-		if (entry->flags & DATAOBJ_FLAG_MANDATORY)
-			minimum_set = false;
+		next = i + 1;
 	}
 
-	g_slist_free_full(entries, g_free);
+	for (i = next; i < n_desc; i++)
+		if (desc[i].flags & DATAOBJ_FLAG_MANDATORY)
+			return STK_PARSE_RESULT_MISSING_VALUE;
 
-	if (!minimum_set)
-		return STK_PARSE_RESULT_MISSING_VALUE;
 	if (parse_error)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
@@ -2426,6 +2368,15 @@ static enum stk_command_parse_result parse_display_text(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					display_text.text),
+		DATAOBJ(ICON_ID, 0, display_text.icon_id),
+		DATAOBJ(IMMEDIATE_RESPONSE, 0, display_text.immediate_response),
+		DATAOBJ(DURATION, 0, display_text.duration),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, display_text.text_attr),
+		DATAOBJ(FRAME_ID, 0, display_text.frame_id),
+	};
 	struct stk_command_display_text *obj = &command->display_text;
 	enum stk_command_parse_result status;
 
@@ -2437,20 +2388,7 @@ static enum stk_command_parse_result parse_display_text(
 
 	command->destructor = destroy_display_text;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_IMMEDIATE_RESPONSE, 0,
-				&obj->immediate_response,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -2466,6 +2404,14 @@ static enum stk_command_parse_result parse_get_inkey(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					get_inkey.text),
+		DATAOBJ(ICON_ID, 0, get_inkey.icon_id),
+		DATAOBJ(DURATION, 0, get_inkey.duration),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, get_inkey.text_attr),
+		DATAOBJ(FRAME_ID, 0, get_inkey.frame_id),
+	};
 	struct stk_command_get_inkey *obj = &command->get_inkey;
 	enum stk_command_parse_result status;
 
@@ -2477,18 +2423,7 @@ static enum stk_command_parse_result parse_get_inkey(
 
 	command->destructor = destroy_get_inkey;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -2505,6 +2440,17 @@ static enum stk_command_parse_result parse_get_input(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					get_input.text),
+		DATAOBJ(RESPONSE_LENGTH,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			get_input.resp_len),
+		DATAOBJ(DEFAULT_TEXT, 0, get_input.default_text),
+		DATAOBJ(ICON_ID, 0, get_input.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, get_input.text_attr),
+		DATAOBJ(FRAME_ID, 0, get_input.frame_id),
+	};
 	struct stk_command_get_input *obj = &command->get_input;
 	enum stk_command_parse_result status;
 
@@ -2516,21 +2462,7 @@ static enum stk_command_parse_result parse_get_input(
 
 	command->destructor = destroy_get_input;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_RESPONSE_LENGTH,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->resp_len,
-				STK_DATA_OBJECT_TYPE_DEFAULT_TEXT, 0,
-				&obj->default_text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -2559,6 +2491,14 @@ static enum stk_command_parse_result parse_play_tone(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, play_tone.alpha_id),
+		DATAOBJ(TONE, 0, play_tone.tone),
+		DATAOBJ(DURATION, 0, play_tone.duration),
+		DATAOBJ(ICON_ID, 0, play_tone.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, play_tone.text_attr),
+		DATAOBJ(FRAME_ID, 0, play_tone.frame_id),
+	};
 	struct stk_command_play_tone *obj = &command->play_tone;
 	enum stk_command_parse_result status;
 
@@ -2570,19 +2510,7 @@ static enum stk_command_parse_result parse_play_tone(
 
 	command->destructor = destroy_play_tone;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_TONE, 0,
-				&obj->tone,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -2593,7 +2521,10 @@ static enum stk_command_parse_result parse_poll_interval(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_poll_interval *obj = &command->poll_interval;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(DURATION, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					poll_interval.duration),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -2601,10 +2532,7 @@ static enum stk_command_parse_result parse_poll_interval(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_DURATION,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_setup_menu(struct stk_command *command)
@@ -2617,6 +2545,18 @@ static enum stk_command_parse_result parse_setup_menu(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					setup_menu.alpha_id),
+		DATAOBJ(ITEM, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
+					DATAOBJ_FLAG_LIST, setup_menu.items),
+		DATAOBJ(ITEMS_NEXT_ACTION_INDICATOR, 0, setup_menu.next_act),
+		DATAOBJ(ICON_ID, 0, setup_menu.icon_id),
+		DATAOBJ(ITEM_ICON_ID_LIST, 0, setup_menu.item_icon_id_list),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, setup_menu.text_attr),
+		DATAOBJ(ITEM_TEXT_ATTRIBUTE_LIST, 0,
+					setup_menu.item_text_attr_list),
+	};
 	struct stk_command_setup_menu *obj = &command->setup_menu;
 	enum stk_command_parse_result status;
 
@@ -2628,24 +2568,7 @@ static enum stk_command_parse_result parse_setup_menu(
 
 	command->destructor = destroy_setup_menu;
 
-	status = parse_dataobj(iter,
-			STK_DATA_OBJECT_TYPE_ALPHA_ID,
-			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-			&obj->alpha_id,
-			STK_DATA_OBJECT_TYPE_ITEM,
-			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
-			DATAOBJ_FLAG_LIST, &obj->items,
-			STK_DATA_OBJECT_TYPE_ITEMS_NEXT_ACTION_INDICATOR, 0,
-			&obj->next_act,
-			STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-			&obj->icon_id,
-			STK_DATA_OBJECT_TYPE_ITEM_ICON_ID_LIST, 0,
-			&obj->item_icon_id_list,
-			STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-			&obj->text_attr,
-			STK_DATA_OBJECT_TYPE_ITEM_TEXT_ATTRIBUTE_LIST, 0,
-			&obj->item_text_attr_list,
-			STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -2662,6 +2585,19 @@ static enum stk_command_parse_result parse_select_item(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, select_item.alpha_id),
+		DATAOBJ(ITEM, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
+					DATAOBJ_FLAG_LIST, select_item.items),
+		DATAOBJ(ITEMS_NEXT_ACTION_INDICATOR, 0, select_item.next_act),
+		DATAOBJ(ITEM_ID, 0, select_item.item_id),
+		DATAOBJ(ICON_ID, 0, select_item.icon_id),
+		DATAOBJ(ITEM_ICON_ID_LIST, 0, select_item.item_icon_id_list),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, select_item.text_attr),
+		DATAOBJ(ITEM_TEXT_ATTRIBUTE_LIST, 0,
+					select_item.item_text_attr_list),
+		DATAOBJ(FRAME_ID, 0, select_item.frame_id),
+	};
 	struct stk_command_select_item *obj = &command->select_item;
 	enum stk_command_parse_result status;
 
@@ -2671,27 +2607,7 @@ static enum stk_command_parse_result parse_select_item(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	status = parse_dataobj(iter,
-			STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-			&obj->alpha_id,
-			STK_DATA_OBJECT_TYPE_ITEM,
-			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM |
-			DATAOBJ_FLAG_LIST, &obj->items,
-			STK_DATA_OBJECT_TYPE_ITEMS_NEXT_ACTION_INDICATOR, 0,
-			&obj->next_act,
-			STK_DATA_OBJECT_TYPE_ITEM_ID, 0,
-			&obj->item_id,
-			STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-			&obj->icon_id,
-			STK_DATA_OBJECT_TYPE_ITEM_ICON_ID_LIST, 0,
-			&obj->item_icon_id_list,
-			STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-			&obj->text_attr,
-			STK_DATA_OBJECT_TYPE_ITEM_TEXT_ATTRIBUTE_LIST, 0,
-			&obj->item_text_attr_list,
-			STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-			&obj->frame_id,
-			STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	command->destructor = destroy_select_item;
 
@@ -2709,14 +2625,31 @@ static void destroy_send_sms(struct stk_command *command)
 	g_free(command->send_sms.cdma_sms.array);
 }
 
+/* Raw objects that parse_send_sms() turns into obj->gsm_sms */
+struct send_sms_raw {
+	struct stk_address sc_address;
+	struct gsm_sms_tpdu gsm_tpdu;
+};
+
 static enum stk_command_parse_result parse_send_sms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, send_sms.alpha_id),
+		DATAOBJ_SCRATCH(ADDRESS, 0, struct send_sms_raw, sc_address),
+		DATAOBJ_SCRATCH(GSM_SMS_TPDU, 0, struct send_sms_raw,
+					gsm_tpdu),
+		DATAOBJ(CDMA_SMS_TPDU, 0, send_sms.cdma_sms),
+		DATAOBJ(ICON_ID, 0, send_sms.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, send_sms.text_attr),
+		DATAOBJ(FRAME_ID, 0, send_sms.frame_id),
+	};
 	struct stk_command_send_sms *obj = &command->send_sms;
 	enum stk_command_parse_result status;
-	struct gsm_sms_tpdu gsm_tpdu;
-	struct stk_address sc_address = { 0, NULL };
+	struct send_sms_raw raw;
+	struct gsm_sms_tpdu *gsm_tpdu = &raw.gsm_tpdu;
+	struct stk_address *sc_address = &raw.sc_address;
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -2724,22 +2657,8 @@ static enum stk_command_parse_result parse_send_sms(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_NETWORK)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	memset(&gsm_tpdu, 0, sizeof(gsm_tpdu));
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ADDRESS, 0,
-				&sc_address,
-				STK_DATA_OBJECT_TYPE_GSM_SMS_TPDU, 0,
-				&gsm_tpdu,
-				STK_DATA_OBJECT_TYPE_CDMA_SMS_TPDU, 0,
-				&obj->cdma_sms,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	memset(&raw, 0, sizeof(raw));
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, &raw);
 
 	command->destructor = destroy_send_sms;
 
@@ -2751,12 +2670,12 @@ static enum stk_command_parse_result parse_send_sms(
 	if (status != STK_PARSE_RESULT_OK)
 		goto out;
 
-	if (gsm_tpdu.len == 0 && obj->cdma_sms.len == 0) {
+	if (gsm_tpdu->len == 0 && obj->cdma_sms.len == 0) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
 
-	if (gsm_tpdu.len > 0 && obj->cdma_sms.len > 0) {
+	if (gsm_tpdu->len > 0 && obj->cdma_sms.len > 0) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
@@ -2767,7 +2686,7 @@ static enum stk_command_parse_result parse_send_sms(
 
 	/* packing is needed */
 	if (command->qualifier & 0x01) {
-		if (!sms_decode_unpacked_stk_pdu(gsm_tpdu.tpdu, gsm_tpdu.len,
+		if (!sms_decode_unpacked_stk_pdu(gsm_tpdu->tpdu, gsm_tpdu->len,
 							&obj->gsm_sms)) {
 			status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 			goto out;
@@ -2776,8 +2695,8 @@ static enum stk_command_parse_result parse_send_sms(
 		goto set_addr;
 	}
 
-	if (sms_decode(gsm_tpdu.tpdu, gsm_tpdu.len, TRUE,
-				gsm_tpdu.len, &obj->gsm_sms) == FALSE) {
+	if (sms_decode(gsm_tpdu->tpdu, gsm_tpdu->len, TRUE,
+				gsm_tpdu->len, &obj->gsm_sms) == FALSE) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
@@ -2789,20 +2708,20 @@ static enum stk_command_parse_result parse_send_sms(
 	}
 
 set_addr:
-	if (sc_address.number == NULL)
+	if (sc_address->number == NULL)
 		goto out;
 
-	if (strlen(sc_address.number) > 20) {
+	if (strlen(sc_address->number) > 20) {
 		status = STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 		goto out;
 	}
 
-	strcpy(obj->gsm_sms.sc_addr.address, sc_address.number);
-	obj->gsm_sms.sc_addr.numbering_plan = sc_address.ton_npi & 15;
-	obj->gsm_sms.sc_addr.number_type = (sc_address.ton_npi >> 4) & 7;
+	strcpy(obj->gsm_sms.sc_addr.address, sc_address->number);
+	obj->gsm_sms.sc_addr.numbering_plan = sc_address->ton_npi & 15;
+	obj->gsm_sms.sc_addr.number_type = (sc_address->ton_npi >> 4) & 7;
 
 out:
-	g_free(sc_address.number);
+	g_free(sc_address->number);
 
 	return status;
 }
@@ -2816,7 +2735,15 @@ static void destroy_send_ss(struct stk_command *command)
 static enum stk_command_parse_result parse_send_ss(struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_send_ss *obj = &command->send_ss;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, send_ss.alpha_id),
+		DATAOBJ(SS_STRING,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_ss.ss),
+		DATAOBJ(ICON_ID, 0, send_ss.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, send_ss.text_attr),
+		DATAOBJ(FRAME_ID, 0, send_ss.frame_id),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -2826,18 +2753,7 @@ static enum stk_command_parse_result parse_send_ss(struct stk_command *command,
 
 	command->destructor = destroy_send_ss;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_SS_STRING,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->ss,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_send_ussd(struct stk_command *command)
@@ -2849,7 +2765,15 @@ static enum stk_command_parse_result parse_send_ussd(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_send_ussd *obj = &command->send_ussd;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, send_ussd.alpha_id),
+		DATAOBJ(USSD_STRING,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_ussd.ussd_string),
+		DATAOBJ(ICON_ID, 0, send_ussd.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, send_ussd.text_attr),
+		DATAOBJ(FRAME_ID, 0, send_ussd.frame_id),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -2859,18 +2783,7 @@ static enum stk_command_parse_result parse_send_ussd(
 
 	command->destructor = destroy_send_ussd;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_USSD_STRING,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->ussd_string,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_setup_call(struct stk_command *command)
@@ -2884,6 +2797,20 @@ static enum stk_command_parse_result parse_setup_call(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, setup_call.alpha_id_usr_cfm),
+		DATAOBJ(ADDRESS, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					setup_call.addr),
+		DATAOBJ(CCP, 0, setup_call.ccp),
+		DATAOBJ(SUBADDRESS, 0, setup_call.subaddr),
+		DATAOBJ(DURATION, 0, setup_call.duration),
+		DATAOBJ(ICON_ID, 0, setup_call.icon_id_usr_cfm),
+		DATAOBJ(ALPHA_ID, 0, setup_call.alpha_id_call_setup),
+		DATAOBJ(ICON_ID, 0, setup_call.icon_id_call_setup),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, setup_call.text_attr_usr_cfm),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, setup_call.text_attr_call_setup),
+		DATAOBJ(FRAME_ID, 0, setup_call.frame_id),
+	};
 	struct stk_command_setup_call *obj = &command->setup_call;
 	enum stk_command_parse_result status;
 
@@ -2895,30 +2822,7 @@ static enum stk_command_parse_result parse_setup_call(
 
 	command->destructor = destroy_setup_call;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id_usr_cfm,
-				STK_DATA_OBJECT_TYPE_ADDRESS,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->addr,
-				STK_DATA_OBJECT_TYPE_CCP, 0,
-				&obj->ccp,
-				STK_DATA_OBJECT_TYPE_SUBADDRESS, 0,
-				&obj->subaddr,
-				STK_DATA_OBJECT_TYPE_DURATION, 0,
-				&obj->duration,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id_usr_cfm,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id_call_setup,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id_call_setup,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr_usr_cfm,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr_call_setup,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id_usr_cfm, obj->icon_id_usr_cfm.id);
 	CHECK_TEXT_AND_ICON(obj->alpha_id_call_setup,
@@ -2937,6 +2841,14 @@ static enum stk_command_parse_result parse_refresh(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(FILE_LIST, 0, refresh.file_list),
+		DATAOBJ(AID, 0, refresh.aid),
+		DATAOBJ(ALPHA_ID, 0, refresh.alpha_id),
+		DATAOBJ(ICON_ID, 0, refresh.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, refresh.text_attr),
+		DATAOBJ(FRAME_ID, 0, refresh.frame_id),
+	};
 	struct stk_command_refresh *obj = &command->refresh;
 	enum stk_command_parse_result status;
 
@@ -2948,19 +2860,7 @@ static enum stk_command_parse_result parse_refresh(
 
 	command->destructor = destroy_refresh;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_FILE_LIST, 0,
-				&obj->file_list,
-				STK_DATA_OBJECT_TYPE_AID, 0,
-				&obj->aid,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -2997,7 +2897,11 @@ static enum stk_command_parse_result parse_setup_event_list(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_setup_event_list *obj = &command->setup_event_list;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(EVENT_LIST,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			setup_event_list.event_list),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3005,17 +2909,17 @@ static enum stk_command_parse_result parse_setup_event_list(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_EVENT_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->event_list,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static enum stk_command_parse_result parse_perform_card_apdu(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_perform_card_apdu *obj = &command->perform_card_apdu;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(C_APDU, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					perform_card_apdu.c_apdu),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3024,10 +2928,7 @@ static enum stk_command_parse_result parse_perform_card_apdu(
 			(command->dst > STK_DEVICE_IDENTITY_TYPE_CARD_READER_7))
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_C_APDU,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->c_apdu,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static enum stk_command_parse_result parse_power_off_card(
@@ -3087,8 +2988,18 @@ static enum stk_command_parse_result parse_timer_mgmt(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_timer_mgmt *obj = &command->timer_mgmt;
-	enum stk_data_object_flag value_flags = 0;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(TIMER_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					timer_mgmt.timer_id),
+		DATAOBJ(TIMER_VALUE, 0, timer_mgmt.timer_value),
+	};
+	/* Starting a timer needs the value too */
+	static const struct dataobj_desc start_objs[] = {
+		DATAOBJ(TIMER_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					timer_mgmt.timer_id),
+		DATAOBJ(TIMER_VALUE, DATAOBJ_FLAG_MANDATORY,
+					timer_mgmt.timer_value),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3096,15 +3007,11 @@ static enum stk_command_parse_result parse_timer_mgmt(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	if ((command->qualifier & 3) == 0) /* Start a timer */
-		value_flags = DATAOBJ_FLAG_MANDATORY;
+	if ((command->qualifier & 3) == 0)
+		return parse_dataobj(iter, start_objs,
+				G_N_ELEMENTS(start_objs), command, NULL);
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TIMER_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->timer_id,
-				STK_DATA_OBJECT_TYPE_TIMER_VALUE, value_flags,
-				&obj->timer_value,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_setup_idle_mode_text(struct stk_command *command)
@@ -3116,6 +3023,13 @@ static enum stk_command_parse_result parse_setup_idle_mode_text(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(TEXT, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					setup_idle_mode_text.text),
+		DATAOBJ(ICON_ID, 0, setup_idle_mode_text.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, setup_idle_mode_text.text_attr),
+		DATAOBJ(FRAME_ID, 0, setup_idle_mode_text.frame_id),
+	};
 	struct stk_command_setup_idle_mode_text *obj =
 					&command->setup_idle_mode_text;
 	enum stk_command_parse_result status;
@@ -3128,16 +3042,7 @@ static enum stk_command_parse_result parse_setup_idle_mode_text(
 
 	command->destructor = destroy_setup_idle_mode_text;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_TEXT,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->text,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->text, obj->icon_id.id);
 
@@ -3154,6 +3059,15 @@ static enum stk_command_parse_result parse_run_at_command(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, run_at_command.alpha_id),
+		DATAOBJ(AT_COMMAND,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			run_at_command.at_command),
+		DATAOBJ(ICON_ID, 0, run_at_command.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, run_at_command.text_attr),
+		DATAOBJ(FRAME_ID, 0, run_at_command.frame_id),
+	};
 	struct stk_command_run_at_command *obj = &command->run_at_command;
 	enum stk_command_parse_result status;
 
@@ -3165,18 +3079,7 @@ static enum stk_command_parse_result parse_run_at_command(
 
 	command->destructor = destroy_run_at_command;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_AT_COMMAND,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->at_command,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3193,6 +3096,15 @@ static enum stk_command_parse_result parse_send_dtmf(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, send_dtmf.alpha_id),
+		DATAOBJ(DTMF_STRING,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_dtmf.dtmf),
+		DATAOBJ(ICON_ID, 0, send_dtmf.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, send_dtmf.text_attr),
+		DATAOBJ(FRAME_ID, 0, send_dtmf.frame_id),
+	};
 	struct stk_command_send_dtmf *obj = &command->send_dtmf;
 	enum stk_command_parse_result status;
 
@@ -3204,18 +3116,7 @@ static enum stk_command_parse_result parse_send_dtmf(
 
 	command->destructor = destroy_send_dtmf;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_DTMF_STRING,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->dtmf,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3226,8 +3127,9 @@ static enum stk_command_parse_result parse_language_notification(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_language_notification *obj =
-					&command->language_notification;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(LANGUAGE, 0, language_notification.language),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3235,9 +3137,7 @@ static enum stk_command_parse_result parse_language_notification(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_LANGUAGE, 0,
-				&obj->language,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_launch_browser(struct stk_command *command)
@@ -3256,7 +3156,22 @@ static enum stk_command_parse_result parse_launch_browser(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_launch_browser *obj = &command->launch_browser;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(BROWSER_ID, 0, launch_browser.browser_id),
+		DATAOBJ(URL, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					launch_browser.url),
+		DATAOBJ(BEARER, 0, launch_browser.bearer),
+		DATAOBJ(PROVISIONING_FILE_REF, DATAOBJ_FLAG_LIST,
+					launch_browser.prov_file_refs),
+		DATAOBJ(TEXT, 0, launch_browser.text_gateway_proxy_id),
+		DATAOBJ(ALPHA_ID, 0, launch_browser.alpha_id),
+		DATAOBJ(ICON_ID, 0, launch_browser.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, launch_browser.text_attr),
+		DATAOBJ(FRAME_ID, 0, launch_browser.frame_id),
+		DATAOBJ(NETWORK_ACCESS_NAME, 0, launch_browser.network_name),
+		DATAOBJ(TEXT, 0, launch_browser.text_usr),
+		DATAOBJ(TEXT, 0, launch_browser.text_passwd),
+	};
 
 	if (command->qualifier > 3 || command->qualifier == 1)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3269,34 +3184,7 @@ static enum stk_command_parse_result parse_launch_browser(
 
 	command->destructor = destroy_launch_browser;
 
-	return parse_dataobj(iter,
-				STK_DATA_OBJECT_TYPE_BROWSER_ID, 0,
-				&obj->browser_id,
-				STK_DATA_OBJECT_TYPE_URL,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->url,
-				STK_DATA_OBJECT_TYPE_BEARER, 0,
-				&obj->bearer,
-				STK_DATA_OBJECT_TYPE_PROVISIONING_FILE_REF,
-				DATAOBJ_FLAG_LIST,
-				&obj->prov_file_refs,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_gateway_proxy_id,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_NETWORK_ACCESS_NAME, 0,
-				&obj->network_name,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_usr,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_passwd,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_open_channel(struct stk_command *command)
@@ -3311,6 +3199,24 @@ static enum stk_command_parse_result parse_open_channel(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, open_channel.alpha_id),
+		DATAOBJ(ICON_ID, 0, open_channel.icon_id),
+		DATAOBJ(BEARER_DESCRIPTION,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			open_channel.bearer_desc),
+		DATAOBJ(BUFFER_SIZE,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			open_channel.buf_size),
+		DATAOBJ(NETWORK_ACCESS_NAME, 0, open_channel.apn),
+		DATAOBJ(OTHER_ADDRESS, 0, open_channel.local_addr),
+		DATAOBJ(TEXT, 0, open_channel.text_usr),
+		DATAOBJ(TEXT, 0, open_channel.text_passwd),
+		DATAOBJ(UICC_TE_INTERFACE, 0, open_channel.uti),
+		DATAOBJ(OTHER_ADDRESS, 0, open_channel.data_dest_addr),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, open_channel.text_attr),
+		DATAOBJ(FRAME_ID, 0, open_channel.frame_id),
+	};
 	struct stk_command_open_channel *obj = &command->open_channel;
 	enum stk_command_parse_result status;
 
@@ -3329,34 +3235,7 @@ static enum stk_command_parse_result parse_open_channel(
 	 * parse the Open Channel data objects related to packet data service
 	 * bearer
 	 */
-	status = parse_dataobj(iter,
-				STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_BEARER_DESCRIPTION,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->bearer_desc,
-				STK_DATA_OBJECT_TYPE_BUFFER_SIZE,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->buf_size,
-				STK_DATA_OBJECT_TYPE_NETWORK_ACCESS_NAME, 0,
-				&obj->apn,
-				STK_DATA_OBJECT_TYPE_OTHER_ADDRESS, 0,
-				&obj->local_addr,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_usr,
-				STK_DATA_OBJECT_TYPE_TEXT, 0,
-				&obj->text_passwd,
-				STK_DATA_OBJECT_TYPE_UICC_TE_INTERFACE, 0,
-				&obj->uti,
-				STK_DATA_OBJECT_TYPE_OTHER_ADDRESS, 0,
-				&obj->data_dest_addr,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3372,6 +3251,12 @@ static enum stk_command_parse_result parse_close_channel(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, close_channel.alpha_id),
+		DATAOBJ(ICON_ID, 0, close_channel.icon_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, close_channel.text_attr),
+		DATAOBJ(FRAME_ID, 0, close_channel.frame_id),
+	};
 	struct stk_command_close_channel *obj = &command->close_channel;
 	enum stk_command_parse_result status;
 
@@ -3384,15 +3269,7 @@ static enum stk_command_parse_result parse_close_channel(
 
 	command->destructor = destroy_close_channel;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3408,6 +3285,15 @@ static enum stk_command_parse_result parse_receive_data(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, receive_data.alpha_id),
+		DATAOBJ(ICON_ID, 0, receive_data.icon_id),
+		DATAOBJ(CHANNEL_DATA_LENGTH,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			receive_data.data_len),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, receive_data.text_attr),
+		DATAOBJ(FRAME_ID, 0, receive_data.frame_id),
+	};
 	struct stk_command_receive_data *obj = &command->receive_data;
 	enum stk_command_parse_result status;
 
@@ -3420,18 +3306,7 @@ static enum stk_command_parse_result parse_receive_data(
 
 	command->destructor = destroy_receive_data;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_CHANNEL_DATA_LENGTH,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->data_len,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3448,6 +3323,15 @@ static enum stk_command_parse_result parse_send_data(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, send_data.alpha_id),
+		DATAOBJ(ICON_ID, 0, send_data.icon_id),
+		DATAOBJ(CHANNEL_DATA,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			send_data.data),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, send_data.text_attr),
+		DATAOBJ(FRAME_ID, 0, send_data.frame_id),
+	};
 	struct stk_command_send_data *obj = &command->send_data;
 	enum stk_command_parse_result status;
 
@@ -3463,18 +3347,7 @@ static enum stk_command_parse_result parse_send_data(
 
 	command->destructor = destroy_send_data;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_CHANNEL_DATA,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->data,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3505,7 +3378,16 @@ static enum stk_command_parse_result parse_service_search(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_service_search *obj = &command->service_search;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, service_search.alpha_id),
+		DATAOBJ(ICON_ID, 0, service_search.icon_id),
+		DATAOBJ(SERVICE_SEARCH,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			service_search.serv_search),
+		DATAOBJ(DEVICE_FILTER, 0, service_search.dev_filter),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, service_search.text_attr),
+		DATAOBJ(FRAME_ID, 0, service_search.frame_id),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3515,20 +3397,7 @@ static enum stk_command_parse_result parse_service_search(
 
 	command->destructor = destroy_service_search;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_SERVICE_SEARCH,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->serv_search,
-				STK_DATA_OBJECT_TYPE_DEVICE_FILTER, 0,
-				&obj->dev_filter,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_get_service_info(struct stk_command *command)
@@ -3541,7 +3410,15 @@ static enum stk_command_parse_result parse_get_service_info(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_get_service_info *obj = &command->get_service_info;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, get_service_info.alpha_id),
+		DATAOBJ(ICON_ID, 0, get_service_info.icon_id),
+		DATAOBJ(ATTRIBUTE_INFO,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			get_service_info.attr_info),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, get_service_info.text_attr),
+		DATAOBJ(FRAME_ID, 0, get_service_info.frame_id),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3551,18 +3428,7 @@ static enum stk_command_parse_result parse_get_service_info(
 
 	command->destructor = destroy_get_service_info;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_ATTRIBUTE_INFO,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->attr_info,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static void destroy_declare_service(struct stk_command *command)
@@ -3574,7 +3440,12 @@ static enum stk_command_parse_result parse_declare_service(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_declare_service *obj = &command->declare_service;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(SERVICE_RECORD,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			declare_service.serv_rec),
+		DATAOBJ(UICC_TE_INTERFACE, 0, declare_service.intf),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3584,19 +3455,19 @@ static enum stk_command_parse_result parse_declare_service(
 
 	command->destructor = destroy_declare_service;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_SERVICE_RECORD,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->serv_rec,
-				STK_DATA_OBJECT_TYPE_UICC_TE_INTERFACE, 0,
-				&obj->intf,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static enum stk_command_parse_result parse_set_frames(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_set_frames *obj = &command->set_frames;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(FRAME_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					set_frames.frame_id),
+		DATAOBJ(FRAME_LAYOUT, 0, set_frames.frame_layout),
+		DATAOBJ(FRAME_ID, 0, set_frames.frame_id_default),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3604,14 +3475,7 @@ static enum stk_command_parse_result parse_set_frames(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_FRAME_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_FRAME_LAYOUT, 0,
-				&obj->frame_layout,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id_default,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static enum stk_command_parse_result parse_get_frames_status(
@@ -3637,6 +3501,22 @@ static enum stk_command_parse_result parse_retrieve_mms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, retrieve_mms.alpha_id),
+		DATAOBJ(ICON_ID, 0, retrieve_mms.icon_id),
+		DATAOBJ(MMS_REFERENCE,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			retrieve_mms.mms_ref),
+		DATAOBJ(FILE_LIST,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			retrieve_mms.mms_rec_files),
+		DATAOBJ(MMS_CONTENT_ID,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			retrieve_mms.mms_content_id),
+		DATAOBJ(MMS_ID, 0, retrieve_mms.mms_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, retrieve_mms.text_attr),
+		DATAOBJ(FRAME_ID, 0, retrieve_mms.frame_id),
+	};
 	struct stk_command_retrieve_mms *obj = &command->retrieve_mms;
 	enum stk_command_parse_result status;
 
@@ -3648,26 +3528,7 @@ static enum stk_command_parse_result parse_retrieve_mms(
 
 	command->destructor = destroy_retrieve_mms;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_MMS_REFERENCE,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_ref,
-				STK_DATA_OBJECT_TYPE_FILE_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_rec_files,
-				STK_DATA_OBJECT_TYPE_MMS_CONTENT_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_content_id,
-				STK_DATA_OBJECT_TYPE_MMS_ID, 0,
-				&obj->mms_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3684,6 +3545,16 @@ static enum stk_command_parse_result parse_submit_mms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ALPHA_ID, 0, submit_mms.alpha_id),
+		DATAOBJ(ICON_ID, 0, submit_mms.icon_id),
+		DATAOBJ(FILE_LIST,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			submit_mms.mms_subm_files),
+		DATAOBJ(MMS_ID, 0, submit_mms.mms_id),
+		DATAOBJ(TEXT_ATTRIBUTE, 0, submit_mms.text_attr),
+		DATAOBJ(FRAME_ID, 0, submit_mms.frame_id),
+	};
 	struct stk_command_submit_mms *obj = &command->submit_mms;
 	enum stk_command_parse_result status;
 
@@ -3695,20 +3566,7 @@ static enum stk_command_parse_result parse_submit_mms(
 
 	command->destructor = destroy_submit_mms;
 
-	status = parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ALPHA_ID, 0,
-				&obj->alpha_id,
-				STK_DATA_OBJECT_TYPE_ICON_ID, 0,
-				&obj->icon_id,
-				STK_DATA_OBJECT_TYPE_FILE_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_subm_files,
-				STK_DATA_OBJECT_TYPE_MMS_ID, 0,
-				&obj->mms_id,
-				STK_DATA_OBJECT_TYPE_TEXT_ATTRIBUTE, 0,
-				&obj->text_attr,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	status = parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 
 	CHECK_TEXT_AND_ICON(obj->alpha_id, obj->icon_id.id);
 
@@ -3724,7 +3582,15 @@ static enum stk_command_parse_result parse_display_mms(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_display_mms *obj = &command->display_mms;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(FILE_LIST,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			display_mms.mms_subm_files),
+		DATAOBJ(MMS_ID, DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+					display_mms.mms_id),
+		DATAOBJ(IMMEDIATE_RESPONSE, 0, display_mms.imd_resp),
+		DATAOBJ(FRAME_ID, 0, display_mms.frame_id),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3734,24 +3600,18 @@ static enum stk_command_parse_result parse_display_mms(
 
 	command->destructor = destroy_display_mms;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_FILE_LIST,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_subm_files,
-				STK_DATA_OBJECT_TYPE_MMS_ID,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->mms_id,
-				STK_DATA_OBJECT_TYPE_IMMEDIATE_RESPONSE, 0,
-				&obj->imd_resp,
-				STK_DATA_OBJECT_TYPE_FRAME_ID, 0,
-				&obj->frame_id,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static enum stk_command_parse_result parse_activate(
 					struct stk_command *command,
 					struct comprehension_tlv_iter *iter)
 {
-	struct stk_command_activate *obj = &command->activate;
+	static const struct dataobj_desc objs[] = {
+		DATAOBJ(ACTIVATE_DESCRIPTOR,
+			DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
+			activate.actv_desc),
+	};
 
 	if (command->src != STK_DEVICE_IDENTITY_TYPE_UICC)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
@@ -3759,10 +3619,7 @@ static enum stk_command_parse_result parse_activate(
 	if (command->dst != STK_DEVICE_IDENTITY_TYPE_TERMINAL)
 		return STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD;
 
-	return parse_dataobj(iter, STK_DATA_OBJECT_TYPE_ACTIVATE_DESCRIPTOR,
-				DATAOBJ_FLAG_MANDATORY | DATAOBJ_FLAG_MINIMUM,
-				&obj->actv_desc,
-				STK_DATA_OBJECT_TYPE_INVALID);
+	return parse_dataobj(iter, objs, G_N_ELEMENTS(objs), command, NULL);
 }
 
 static enum stk_command_parse_result parse_command_body(
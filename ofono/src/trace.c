@@ -0,0 +1,193 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+#include "ofono.h"
+#include "storage.h"
+
+/*
+ * Binary trace of the raw modem traffic.
+ *
+ * Frames are kept in a fixed size ring and the oldest ones get
+ * overwritten. Recording a frame is a couple of memcpy's, there's
+ * no formatting and no I/O involved. Everything happens on the main
+ * thread so no locking is needed.
+ *
+ * Each record consists of a 16-byte header followed by the frame data.
+ * All header fields are little endian:
+ *
+ *   0: timestamp, microseconds (CLOCK_MONOTONIC), 8 bytes
+ *   8: original frame length, 4 bytes
+ *  12: number of bytes captured, 2 bytes
+ *  14: protocol (enum ofono_trace_proto), 1 byte
+ *  15: direction (1 = from modem, 0 = to modem), 1 byte
+ *
+ * Dump file starts with a 32-byte header followed by the records
+ * in chronological order:
+ *
+ *   0: magic "OFNTRACE", 8 bytes
+ *   8: version (1), 4 bytes
+ *  12: number of overwritten records, 4 bytes
+ *  16: CLOCK_REALTIME at the time of the dump, microseconds, 8 bytes
+ *  24: CLOCK_MONOTONIC at the time of the dump, microseconds, 8 bytes
+ */
+
+#define TRACE_RECORD_HEADER_SIZE (16)
+#define TRACE_FILE_HEADER_SIZE (32)
+#define TRACE_FILE_MAGIC "OFNTRACE"
+#define TRACE_FILE_VERSION (1)
+#define TRACE_FILE_MODE (0600)
+#define TRACE_MAX_CAPTURE (2048)
+
+struct ofono_trace {
+	guint8 *buf;
+	gsize size;
+	gsize head;	/* Where the next record goes */
+	gsize tail;	/* The oldest record */
+	gsize used;
+	guint32 dropped;
+};
+
+static inline void put_le16(guint8 *p, guint16 val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+}
+
+static inline void put_le32(guint8 *p, guint32 val)
+{
+	put_le16(p, val);
+	put_le16(p + 2, val >> 16);
+}
+
+static inline void put_le64(guint8 *p, guint64 val)
+{
+	put_le32(p, val);
+	put_le32(p + 4, val >> 32);
+}
+
+static gsize trace_write(struct ofono_trace *trace, gsize off,
+					const void *data, gsize len)
+{
+	const gsize chunk = MIN(len, trace->size - off);
+
+	memcpy(trace->buf + off, data, chunk);
+	if (chunk < len)
+		memcpy(trace->buf, (const guint8 *) data + chunk, len - chunk);
+
+	return (off + len) % trace->size;
+}
+
+static void trace_read(const struct ofono_trace *trace, gsize off,
+						void *data, gsize len)
+{
+	const gsize chunk = MIN(len, trace->size - off);
+
+	memcpy(data, trace->buf + off, chunk);
+	if (chunk < len)
+		memcpy((guint8 *) data + chunk, trace->buf, len - chunk);
+}
+
+static void trace_drop_oldest(struct ofono_trace *trace)
+{
+	guint8 hdr[TRACE_RECORD_HEADER_SIZE];
+	gsize reclen;
+
+	trace_read(trace, trace->tail, hdr, sizeof(hdr));
+	reclen = TRACE_RECORD_HEADER_SIZE + (hdr[12] | (hdr[13] << 8));
+	trace->tail = (trace->tail + reclen) % trace->size;
+	trace->used -= reclen;
+	trace->dropped++;
+}
+
+struct ofono_trace *__ofono_trace_new(unsigned int size)
+{
+	struct ofono_trace *trace = g_slice_new0(struct ofono_trace);
+
+	/* Must be able to hold at least one maximum size record */
+	trace->size = MAX(size, TRACE_RECORD_HEADER_SIZE + TRACE_MAX_CAPTURE);
+	trace->buf = g_malloc(trace->size);
+	return trace;
+}
+
+void __ofono_trace_free(struct ofono_trace *trace)
+{
+	if (trace) {
+		g_free(trace->buf);
+		g_slice_free(struct ofono_trace, trace);
+	}
+}
+
+void __ofono_trace_record(struct ofono_trace *trace,
+			enum ofono_trace_proto proto, ofono_bool_t in,
+			const void *data, unsigned int len)
+{
+	guint8 hdr[TRACE_RECORD_HEADER_SIZE];
+	const guint caplen = MIN(len, TRACE_MAX_CAPTURE);
+	const gsize reclen = TRACE_RECORD_HEADER_SIZE + caplen;
+
+	if (!trace || !data || !len)
+		return;
+
+	while (trace->size - trace->used < reclen)
+		trace_drop_oldest(trace);
+
+	put_le64(hdr, g_get_monotonic_time());
+	put_le32(hdr + 8, len);
+	put_le16(hdr + 12, caplen);
+	hdr[14] = proto;
+	hdr[15] = in ? 1 : 0;
+
+	trace->head = trace_write(trace, trace->head, hdr, sizeof(hdr));
+	trace->head = trace_write(trace, trace->head, data, caplen);
+	trace->used += reclen;
+}
+
+int __ofono_trace_dump(struct ofono_trace *trace, const char *path)
+{
+	const gsize len = TRACE_FILE_HEADER_SIZE + trace->used;
+	guint8 *buf = g_malloc(len);
+	int ret = 0;
+
+	memcpy(buf, TRACE_FILE_MAGIC, 8);
+	put_le32(buf + 8, TRACE_FILE_VERSION);
+	put_le32(buf + 12, trace->dropped);
+	put_le64(buf + 16, g_get_real_time());
+	put_le64(buf + 24, g_get_monotonic_time());
+	trace_read(trace, trace->tail, buf + TRACE_FILE_HEADER_SIZE,
+								trace->used);
+
+	if (write_file(buf, len, TRACE_FILE_MODE, "%s", path) != (ssize_t)len)
+		ret = -EIO;
+
+	g_free(buf);
+	return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -19,6 +19,8 @@
 #include <errno.h>
 #include <string.h>
 
+#define VOICECALL_FILTER_MAX_SYNC (8)
+
 struct voicecall_filter_request;
 struct voicecall_filter_request_fn {
 	const char *name;
@@ -37,6 +39,8 @@ struct voicecall_filter_request {
 	GSList *filter_link;
 	guint pending_id;
 	guint next_id;
+	GSourceFunc next_fn;
+	gboolean sync;
 	ofono_destroy_func destroy;
 	void* user_data;
 };
@@ -98,6 +102,7 @@ static void voicecall_filter_request_cancel
 		g_source_remove(req->next_id);
 		req->next_id = 0;
 	}
+	req->next_fn = NULL;
 }
 
 static void voicecall_filter_request_dispose
@@ -187,11 +192,35 @@ static void voicecall_filter_request_process
 	voicecall_filter_request_unref(req);
 }
 
+static gboolean voicecall_filter_request_next_cb(gpointer data)
+{
+	struct voicecall_filter_request *req = data;
+	int n;
+
+	/* Take the steps completed synchronously without extra idle hops */
+	req->next_id = 0;
+	voicecall_filter_request_ref(req);
+	for (n = 0; req->next_fn && !req->next_id; n++) {
+		GSourceFunc fn = req->next_fn;
+
+		req->next_fn = NULL;
+		req->sync = (n + 1 < VOICECALL_FILTER_MAX_SYNC);
+		fn(req);
+	}
+	req->sync = FALSE;
+	voicecall_filter_request_unref(req);
+	return G_SOURCE_REMOVE;
+}
+
 static void voicecall_filter_request_next(struct voicecall_filter_request *req,
 							GSourceFunc fn)
 {
 	req->pending_id = 0;
-	req->next_id = g_idle_add(fn, req);
+	req->next_fn = fn;
+	if (!req->sync) {
+		req->next_id = g_idle_add(voicecall_filter_request_next_cb,
+									req);
+	}
 }
 
 static gboolean voicecall_filter_request_continue_cb(gpointer data)
@@ -0,0 +1,716 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+/*
+ * Replays the modem side of a recorded trace (see src/trace.c) into
+ * the AT, QMI or RIL transport stack over a socket and measures what
+ * it costs to process it:
+ *
+ *   cpu_ns_per_msg     process CPU time per replayed message
+ *   allocs_per_msg     number of malloc/calloc/realloc calls per message
+ *   loop_latency_us    how late a 1ms main loop timer fires (avg/max)
+ *   dispatched         number of notifications delivered to handlers
+ *
+ * QMI indications are only delivered to the services that the stack has
+ * created, which takes a CTL exchange that the replay can't answer, so
+ * there's no dispatched count for QMI and it's reported as null.
+ *
+ * The writer side runs on the same main loop, its overhead is small
+ * but is included in the numbers. Results are printed one JSON object
+ * per line so that they can be collected and compared across commits.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/sockios.h>
+
+#include <glib.h>
+
+#define OFONO_API_SUBJECT_TO_CHANGE
+#include <ofono/log.h>
+#include <ofono/trace.h>
+
+#include "gatchat.h"
+#include "gril.h"
+#include "drivers/qmimodem/qmi.h"
+
+/* See src/trace.c for the file format */
+#define TRACE_RECORD_HEADER_SIZE (16)
+#define TRACE_FILE_HEADER_SIZE (32)
+#define TRACE_FILE_MAGIC "OFNTRACE"
+#define TRACE_FILE_VERSION (1)
+
+#define LATENCY_PROBE_MS (1)
+#define DRAIN_CHECK_MS (1)
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static guint64 alloc_count;
+
+void *malloc(size_t size)
+{
+	alloc_count++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	alloc_count++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	alloc_count++;
+	return __libc_realloc(ptr, size);
+}
+#define ALLOC_COUNT() (alloc_count)
+#else
+#define ALLOC_COUNT() ((guint64) 0)
+#endif
+
+struct bench_record {
+	gint64 ts;
+	const guint8 *data;
+	gsize len;
+};
+
+struct bench {
+	enum ofono_trace_proto proto;
+	GArray *records;
+	gdouble speedup;
+	GMainLoop *loop;
+	int fd;
+	GIOChannel *channel;
+	guint source;
+	guint next;
+	gsize offset;
+	gint64 start;
+	guint64 bytes;
+	guint dispatched;
+	gboolean failed;
+
+	/* Main loop latency probe */
+	guint probe;
+	gint64 probe_due;
+	gint64 latency_sum;
+	gint64 latency_max;
+	guint latency_count;
+
+	/* Stack under test */
+	GAtChat *chat;
+	struct qmi_device *qmi;
+	GRil *ril;
+	char *ril_path;
+};
+
+static const char *proto_names[] = {
+	NULL, "at", "qmi", "mbim", "ril", "mux"
+};
+
+static inline guint16 get_le16(const guint8 *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline guint32 get_le32(const guint8 *p)
+{
+	return get_le16(p) | ((guint32) get_le16(p + 2) << 16);
+}
+
+static inline guint64 get_le64(const guint8 *p)
+{
+	return get_le32(p) | ((guint64) get_le32(p + 4) << 32);
+}
+
+static inline guint32 get_be32(const guint8 *p)
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static gint64 cpu_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (gint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static GArray *load_records(const guint8 *buf, gsize len,
+						enum ofono_trace_proto proto)
+{
+	GArray *records = g_array_new(FALSE, FALSE,
+					sizeof(struct bench_record));
+	gsize off = TRACE_FILE_HEADER_SIZE;
+
+	while (off + TRACE_RECORD_HEADER_SIZE <= len) {
+		const guint8 *hdr = buf + off;
+		const guint16 caplen = get_le16(hdr + 12);
+
+		if (off + TRACE_RECORD_HEADER_SIZE + caplen > len)
+			break;
+
+		/* Only replay complete frames coming from the modem */
+		if (hdr[14] == proto && hdr[15] &&
+					get_le32(hdr + 8) == caplen) {
+			struct bench_record rec;
+
+			rec.ts = get_le64(hdr);
+			rec.data = hdr + TRACE_RECORD_HEADER_SIZE;
+			rec.len = caplen;
+			g_array_append_val(records, rec);
+		}
+
+		off += TRACE_RECORD_HEADER_SIZE + caplen;
+	}
+
+	return records;
+}
+
+static void bench_quit(struct bench *b)
+{
+	if (b->source) {
+		g_source_remove(b->source);
+		b->source = 0;
+	}
+
+	g_main_loop_quit(b->loop);
+}
+
+static gboolean bench_probe_cb(gpointer user_data)
+{
+	struct bench *b = user_data;
+	const gint64 now = g_get_monotonic_time();
+	const gint64 late = MAX(now - b->probe_due, 0);
+
+	b->latency_sum += late;
+	b->latency_count++;
+	if (late > b->latency_max)
+		b->latency_max = late;
+
+	b->probe_due = now + LATENCY_PROBE_MS * 1000;
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean bench_drain_cb(gpointer user_data)
+{
+	struct bench *b = user_data;
+	int queued = 0;
+
+	/* Done when the reader has consumed everything we have written */
+	if (ioctl(b->fd, SIOCOUTQ, &queued) < 0 || queued <= 0) {
+		b->source = 0;
+		g_main_loop_quit(b->loop);
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void bench_pump(struct bench *b);
+
+static gboolean bench_pump_cb(gpointer user_data)
+{
+	struct bench *b = user_data;
+
+	b->source = 0;
+	bench_pump(b);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean bench_writable_cb(GIOChannel *channel, GIOCondition cond,
+							gpointer user_data)
+{
+	struct bench *b = user_data;
+
+	b->source = 0;
+
+	if (cond & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) {
+		g_printerr("Connection closed by the reader\n");
+		b->failed = TRUE;
+		bench_quit(b);
+	} else {
+		bench_pump(b);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void bench_pump(struct bench *b)
+{
+	const struct bench_record *first =
+		&g_array_index(b->records, struct bench_record, 0);
+
+	while (b->next < b->records->len) {
+		const struct bench_record *rec =
+			&g_array_index(b->records, struct bench_record, b->next);
+		ssize_t written;
+
+		if (b->speedup > 0 && !b->offset) {
+			const gint64 due = b->start +
+				(gint64) ((rec->ts - first->ts) / b->speedup);
+			const gint64 now = g_get_monotonic_time();
+
+			if (due > now) {
+				b->source = g_timeout_add((due - now + 999)
+							/ 1000, bench_pump_cb, b);
+				return;
+			}
+		}
+
+		written = write(b->fd, rec->data + b->offset,
+						rec->len - b->offset);
+		if (written < 0) {
+			if (errno == EAGAIN || errno == EINTR) {
+				b->source = g_io_add_watch(b->channel,
+					G_IO_OUT | G_IO_ERR | G_IO_HUP,
+					bench_writable_cb, b);
+				return;
+			}
+
+			g_printerr("Write failed: %s\n", g_strerror(errno));
+			b->failed = TRUE;
+			bench_quit(b);
+			return;
+		}
+
+		b->offset += written;
+		if (b->offset < rec->len)
+			continue;
+
+		b->bytes += rec->len;
+		b->offset = 0;
+		b->next++;
+
+		/* Let the reader run between the messages */
+		if (b->speedup <= 0 && b->next < b->records->len) {
+			b->source = g_idle_add(bench_pump_cb, b);
+			return;
+		}
+	}
+
+	b->source = g_timeout_add(DRAIN_CHECK_MS, bench_drain_cb, b);
+}
+
+static void at_notify(GAtResult *result, gpointer user_data)
+{
+	struct bench *b = user_data;
+
+	b->dispatched++;
+}
+
+static void at_register_prefixes(struct bench *b)
+{
+	GHashTable *prefixes = g_hash_table_new_full(g_str_hash, g_str_equal,
+								g_free, NULL);
+	GString *text = g_string_new(NULL);
+	GHashTableIter iter;
+	gpointer key;
+	char **lines;
+	char **line;
+	guint i;
+
+	/* Records are raw reads, lines may be split across them */
+	for (i = 0; i < b->records->len; i++) {
+		const struct bench_record *rec =
+			&g_array_index(b->records, struct bench_record, i);
+
+		g_string_append_len(text, (const char *) rec->data, rec->len);
+	}
+
+	/* Subscribe to every unsolicited result code in the capture */
+	lines = g_strsplit_set(text->str, "\r\n", -1);
+
+	for (line = lines; *line; line++) {
+		const char *colon = strchr(*line, ':');
+
+		if (colon && colon > *line + 1 && strchr("+^%*#", **line))
+			g_hash_table_add(prefixes, g_strndup(*line,
+						colon - *line + 1));
+	}
+
+	g_strfreev(lines);
+	g_string_free(text, TRUE);
+
+	g_hash_table_iter_init(&iter, prefixes);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		g_at_chat_register(b->chat, key, at_notify, FALSE, b, NULL);
+
+	g_hash_table_destroy(prefixes);
+}
+
+static void ril_notify(struct ril_msg *message, gpointer user_data)
+{
+	struct bench *b = user_data;
+
+	b->dispatched++;
+}
+
+static void ril_register_requests(struct bench *b)
+{
+	GHashTable *reqs = g_hash_table_new(g_direct_hash, g_direct_equal);
+	GByteArray *stream = g_byte_array_new();
+	GHashTableIter iter;
+	gpointer key;
+	gsize off = 0;
+	guint i;
+
+	/* Records are raw reads, parcels may be split across them */
+	for (i = 0; i < b->records->len; i++) {
+		const struct bench_record *rec =
+			&g_array_index(b->records, struct bench_record, i);
+
+		g_byte_array_append(stream, rec->data, rec->len);
+	}
+
+	/*
+	 * Parcel: length (BE32), then rild's little endian int32 fields,
+	 * unsolicited flag (non-zero for unsolicited) and request id.
+	 */
+	while (off + 4 <= stream->len) {
+		const guint8 *parcel = stream->data + off + 4;
+		const guint32 plen = get_be32(stream->data + off);
+
+		if (off + 4 + plen > stream->len)
+			break;
+
+		if (plen >= 8 && get_le32(parcel))
+			g_hash_table_add(reqs,
+				GINT_TO_POINTER((gint32) get_le32(parcel + 4)));
+
+		off += 4 + plen;
+	}
+
+	g_hash_table_iter_init(&iter, reqs);
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+		g_ril_register(b->ril, GPOINTER_TO_INT(key), ril_notify, b);
+
+	g_byte_array_free(stream, TRUE);
+	g_hash_table_destroy(reqs);
+}
+
+static gboolean bench_setup_at(struct bench *b)
+{
+	int sv[2];
+	GIOChannel *io;
+	GAtSyntax *syntax;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+		return FALSE;
+
+	io = g_io_channel_unix_new(sv[1]);
+	g_io_channel_set_close_on_unref(io, TRUE);
+	g_io_channel_set_encoding(io, NULL, NULL);
+	g_io_channel_set_buffered(io, FALSE);
+
+	syntax = g_at_syntax_new_gsm_permissive();
+	b->chat = g_at_chat_new(io, syntax);
+	g_at_syntax_unref(syntax);
+	g_io_channel_unref(io);
+
+	b->fd = sv[0];
+	at_register_prefixes(b);
+	return b->chat != NULL;
+}
+
+static gboolean bench_setup_qmi(struct bench *b)
+{
+	int sv[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0)
+		return FALSE;
+
+	b->fd = sv[0];
+	b->qmi = qmi_device_new(sv[1]);
+	if (!b->qmi) {
+		close(sv[1]);
+		return FALSE;
+	}
+
+	qmi_device_set_close_on_unref(b->qmi, true);
+	return TRUE;
+}
+
+static gboolean bench_setup_ril(struct bench *b)
+{
+	struct sockaddr_un addr;
+	int sk;
+
+	b->ril_path = g_strdup_printf("%s/replay-bench-%d",
+					g_get_tmp_dir(), (int) getpid());
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, b->ril_path, sizeof(addr.sun_path) - 1);
+
+	sk = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (sk < 0)
+		return FALSE;
+
+	unlink(b->ril_path);
+	if (bind(sk, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+							listen(sk, 1) < 0) {
+		close(sk);
+		return FALSE;
+	}
+
+	/* gril connects synchronously, the backlog takes care of that */
+	b->ril = g_ril_new(b->ril_path, OFONO_RIL_VENDOR_AOSP);
+	if (b->ril)
+		b->fd = accept(sk, NULL, NULL);
+
+	close(sk);
+	unlink(b->ril_path);
+
+	if (!b->ril || b->fd < 0)
+		return FALSE;
+
+	ril_register_requests(b);
+	return TRUE;
+}
+
+static void bench_teardown(struct bench *b)
+{
+	if (b->probe)
+		g_source_remove(b->probe);
+
+	if (b->source)
+		g_source_remove(b->source);
+
+	if (b->channel)
+		g_io_channel_unref(b->channel);
+
+	if (b->fd >= 0)
+		close(b->fd);
+
+	g_at_chat_unref(b->chat);
+	g_ril_unref(b->ril);
+	if (b->qmi)
+		qmi_device_unref(b->qmi);
+
+	g_free(b->ril_path);
+	g_main_loop_unref(b->loop);
+}
+
+static void print_json_string(const char *str)
+{
+	const char *p;
+
+	g_print("\"");
+
+	for (p = str; *p; p++) {
+		const guchar c = *p;
+
+		if (c == '"' || c == '\\')
+			g_print("\\%c", c);
+		else if (c < 0x20)
+			g_print("\\u%04x", c);
+		else
+			g_print("%c", c);
+	}
+
+	g_print("\"");
+}
+
+static gboolean bench_run(const char *file, enum ofono_trace_proto proto,
+				GArray *records, gdouble speedup)
+{
+	struct bench bench;
+	struct bench *b = &bench;
+	gboolean ok;
+	gint64 cpu;
+	gint64 wall;
+	guint64 allocs;
+	guint n;
+
+	memset(b, 0, sizeof(*b));
+	b->proto = proto;
+	b->records = records;
+	b->speedup = speedup;
+	b->loop = g_main_loop_new(NULL, FALSE);
+	b->fd = -1;
+
+	switch (proto) {
+	case OFONO_TRACE_PROTO_AT:
+		ok = bench_setup_at(b);
+		break;
+	case OFONO_TRACE_PROTO_QMI:
+		ok = bench_setup_qmi(b);
+		break;
+	case OFONO_TRACE_PROTO_RIL:
+		ok = bench_setup_ril(b);
+		break;
+	default:
+		ok = FALSE;
+		break;
+	}
+
+	if (!ok) {
+		g_printerr("Failed to set up %s stack\n", proto_names[proto]);
+		bench_teardown(b);
+		return FALSE;
+	}
+
+	fcntl(b->fd, F_SETFL, fcntl(b->fd, F_GETFL) | O_NONBLOCK);
+	b->channel = g_io_channel_unix_new(b->fd);
+
+	b->probe_due = g_get_monotonic_time() + LATENCY_PROBE_MS * 1000;
+	b->probe = g_timeout_add(LATENCY_PROBE_MS, bench_probe_cb, b);
+
+	allocs = ALLOC_COUNT();
+	cpu = cpu_time_ns();
+	b->start = wall = g_get_monotonic_time();
+
+	bench_pump(b);
+	g_main_loop_run(b->loop);
+
+	cpu = cpu_time_ns() - cpu;
+	wall = g_get_monotonic_time() - wall;
+	allocs = ALLOC_COUNT() - allocs;
+	n = MAX(b->next, 1);
+
+	g_print("{\"file\":");
+	print_json_string(file);
+	g_print(",\"proto\":\"%s\",\"speedup\":%g,"
+		"\"messages\":%u,\"bytes\":%" G_GUINT64_FORMAT ","
+		"\"wall_us\":%" G_GINT64_FORMAT ","
+		"\"cpu_ns_per_msg\":%" G_GINT64_FORMAT ","
+		"\"allocs_per_msg\":%.2f,"
+		"\"loop_latency_us_avg\":%" G_GINT64_FORMAT ","
+		"\"loop_latency_us_max\":%" G_GINT64_FORMAT ",",
+		proto_names[proto], speedup, b->next, b->bytes, wall,
+		cpu / n, (gdouble) allocs / n,
+		b->latency_count ? b->latency_sum / b->latency_count : 0,
+		b->latency_max);
+
+	if (proto == OFONO_TRACE_PROTO_QMI)
+		g_print("\"dispatched\":null,");
+	else
+		g_print("\"dispatched\":%u,", b->dispatched);
+
+	g_print("\"ok\":%s}\n", b->failed ? "false" : "true");
+
+	ok = !b->failed;
+	bench_teardown(b);
+	return ok;
+}
+
+static char *option_proto = NULL;
+static gdouble option_speedup = 0;
+static gint option_iterations = 1;
+
+static GOptionEntry options[] = {
+	{ "proto", 'p', 0, G_OPTION_ARG_STRING, &option_proto,
+		"Only replay this protocol (at, qmi, ril)", "PROTO" },
+	{ "speedup", 's', 0, G_OPTION_ARG_DOUBLE, &option_speedup,
+		"Replay N times faster than recorded, 0 = no delays", "N" },
+	{ "iterations", 'n', 0, G_OPTION_ARG_INT, &option_iterations,
+		"Number of runs per protocol", "N" },
+	{ NULL },
+};
+
+int main(int argc, char **argv)
+{
+	static const enum ofono_trace_proto protos[] = {
+		OFONO_TRACE_PROTO_AT,
+		OFONO_TRACE_PROTO_QMI,
+		OFONO_TRACE_PROTO_RIL
+	};
+	GOptionContext *context;
+	GError *error = NULL;
+	guint8 *buf;
+	gsize len;
+	guint i;
+	int ret = EXIT_SUCCESS;
+
+	context = g_option_context_new("TRACEFILE");
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (argc != 2) {
+		g_printerr("Missing trace file\n");
+		exit(1);
+	}
+
+	if (!g_file_get_contents(argv[1], (char **) &buf, &len, &error)) {
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		exit(1);
+	}
+
+	if (len < TRACE_FILE_HEADER_SIZE ||
+			memcmp(buf, TRACE_FILE_MAGIC, 8) ||
+			get_le32(buf + 8) != TRACE_FILE_VERSION) {
+		g_printerr("%s: not a trace file\n", argv[1]);
+		g_free(buf);
+		exit(1);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS(protos); i++) {
+		const enum ofono_trace_proto proto = protos[i];
+		GArray *records;
+		int n;
+
+		if (option_proto && g_ascii_strcasecmp(option_proto,
+							proto_names[proto]))
+			continue;
+
+		records = load_records(buf, len, proto);
+
+		for (n = 0; n < option_iterations && records->len; n++)
+			if (!bench_run(argv[1], proto, records,
+							option_speedup))
+				ret = EXIT_FAILURE;
+
+		g_array_free(records, TRUE);
+	}
+
+	g_free(option_proto);
+	g_free(buf);
+	return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
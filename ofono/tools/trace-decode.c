@@ -0,0 +1,261 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib.h>
+
+/* See src/trace.c for the file format */
+#define TRACE_RECORD_HEADER_SIZE (16)
+#define TRACE_FILE_HEADER_SIZE (32)
+#define TRACE_FILE_MAGIC "OFNTRACE"
+#define TRACE_FILE_VERSION (1)
+
+/*
+ * Each pcap packet is prefixed with a 2-byte pseudo header carrying
+ * the protocol and the direction.
+ */
+#define PCAP_LINKTYPE_USER0 (147)
+#define PCAP_PSEUDO_HEADER_SIZE (2)
+
+static const char *proto_names[] = {
+	NULL, "AT", "QMI", "MBIM", "RIL", "MUX"
+};
+
+static inline guint16 get_le16(const guint8 *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline guint32 get_le32(const guint8 *p)
+{
+	return get_le16(p) | ((guint32) get_le16(p + 2) << 16);
+}
+
+static inline guint64 get_le64(const guint8 *p)
+{
+	return get_le32(p) | ((guint64) get_le32(p + 4) << 32);
+}
+
+static const char *proto_name(guint8 proto)
+{
+	if (proto < G_N_ELEMENTS(proto_names) && proto_names[proto])
+		return proto_names[proto];
+
+	return "???";
+}
+
+static void print_record(gint64 mono_offset, const guint8 *hdr,
+							const guint8 *data)
+{
+	const gint64 ts = get_le64(hdr) + mono_offset;
+	const guint32 origlen = get_le32(hdr + 8);
+	const guint16 caplen = get_le16(hdr + 12);
+	GDateTime *dt = g_date_time_new_from_unix_local(ts / G_USEC_PER_SEC);
+	char *time = g_date_time_format(dt, "%F %T");
+	guint16 i;
+
+	g_print("%s.%06u %-4s %s %u", time, (guint) (ts % G_USEC_PER_SEC),
+			proto_name(hdr[14]), hdr[15] ? "<" : ">", origlen);
+	if (caplen < origlen)
+		g_print(" (%u captured)", caplen);
+	g_print("\n");
+
+	for (i = 0; i < caplen; i += 16) {
+		guint16 j;
+
+		g_print("  %04x:", i);
+		for (j = i; j < i + 16; j++) {
+			if (j < caplen)
+				g_print(" %02x", data[j]);
+			else
+				g_print("   ");
+		}
+
+		g_print("  ");
+		for (j = i; j < i + 16 && j < caplen; j++)
+			g_print("%c", g_ascii_isprint(data[j]) ? data[j] : '.');
+		g_print("\n");
+	}
+
+	g_free(time);
+	g_date_time_unref(dt);
+}
+
+static void pcap_write_le32(FILE *out, guint32 val)
+{
+	const guint8 buf[4] = { val, val >> 8, val >> 16, val >> 24 };
+
+	fwrite(buf, 1, sizeof(buf), out);
+}
+
+static void pcap_write_le16(FILE *out, guint16 val)
+{
+	const guint8 buf[2] = { val, val >> 8 };
+
+	fwrite(buf, 1, sizeof(buf), out);
+}
+
+static void pcap_write_header(FILE *out)
+{
+	pcap_write_le32(out, 0xa1b2c3d4);
+	pcap_write_le16(out, 2);
+	pcap_write_le16(out, 4);
+	pcap_write_le32(out, 0);
+	pcap_write_le32(out, 0);
+	pcap_write_le32(out, 65535);
+	pcap_write_le32(out, PCAP_LINKTYPE_USER0);
+}
+
+static void pcap_write_record(FILE *out, gint64 mono_offset,
+				const guint8 *hdr, const guint8 *data)
+{
+	const gint64 ts = get_le64(hdr) + mono_offset;
+	const guint32 origlen = get_le32(hdr + 8);
+	const guint16 caplen = get_le16(hdr + 12);
+	const guint8 pseudo[PCAP_PSEUDO_HEADER_SIZE] = { hdr[14], hdr[15] };
+
+	pcap_write_le32(out, ts / G_USEC_PER_SEC);
+	pcap_write_le32(out, ts % G_USEC_PER_SEC);
+	pcap_write_le32(out, caplen + PCAP_PSEUDO_HEADER_SIZE);
+	pcap_write_le32(out, origlen + PCAP_PSEUDO_HEADER_SIZE);
+	fwrite(pseudo, 1, sizeof(pseudo), out);
+	fwrite(data, 1, caplen, out);
+}
+
+static int decode(const char *file, const char *pcap)
+{
+	GError *error = NULL;
+	FILE *out = NULL;
+	guint8 *buf;
+	gsize len;
+	gsize off;
+	gint64 mono_offset;
+	unsigned int count = 0;
+
+	if (!g_file_get_contents(file, (char **) &buf, &len, &error)) {
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		return EXIT_FAILURE;
+	}
+
+	if (len < TRACE_FILE_HEADER_SIZE ||
+			memcmp(buf, TRACE_FILE_MAGIC, 8) ||
+			get_le32(buf + 8) != TRACE_FILE_VERSION) {
+		g_printerr("%s: not a trace file\n", file);
+		g_free(buf);
+		return EXIT_FAILURE;
+	}
+
+	if (pcap) {
+		out = fopen(pcap, "wb");
+		if (!out) {
+			g_printerr("%s: %s\n", pcap, g_strerror(errno));
+			g_free(buf);
+			return EXIT_FAILURE;
+		}
+
+		pcap_write_header(out);
+	}
+
+	/* Record timestamps are monotonic, convert them to wall clock */
+	mono_offset = get_le64(buf + 16) - get_le64(buf + 24);
+
+	if (get_le32(buf + 12))
+		g_printerr("%u older records were overwritten\n",
+							get_le32(buf + 12));
+
+	for (off = TRACE_FILE_HEADER_SIZE;
+			off + TRACE_RECORD_HEADER_SIZE <= len; count++) {
+		const guint8 *hdr = buf + off;
+		const guint16 caplen = get_le16(hdr + 12);
+
+		if (off + TRACE_RECORD_HEADER_SIZE + caplen > len) {
+			g_printerr("%s: truncated record at %lu\n", file,
+							(unsigned long) off);
+			break;
+		}
+
+		if (out)
+			pcap_write_record(out, mono_offset, hdr,
+					hdr + TRACE_RECORD_HEADER_SIZE);
+		else
+			print_record(mono_offset, hdr,
+					hdr + TRACE_RECORD_HEADER_SIZE);
+
+		off += TRACE_RECORD_HEADER_SIZE + caplen;
+	}
+
+	if (out) {
+		fclose(out);
+		g_print("%u records written to %s\n", count, pcap);
+	}
+
+	g_free(buf);
+	return EXIT_SUCCESS;
+}
+
+static char *option_pcap = NULL;
+
+static GOptionEntry options[] = {
+	{ "pcap", 'p', 0, G_OPTION_ARG_FILENAME, &option_pcap,
+				"Write records to a pcap file", "FILE" },
+	{ NULL },
+};
+
+int main(int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	int ret;
+
+	context = g_option_context_new("TRACEFILE");
+	g_option_context_add_main_entries(context, options, NULL);
+
+	if (g_option_context_parse(context, &argc, &argv, &error) == FALSE) {
+		if (error != NULL) {
+			g_printerr("%s\n", error->message);
+			g_error_free(error);
+		} else
+			g_printerr("An unknown error occurred\n");
+		exit(1);
+	}
+
+	g_option_context_free(context);
+
+	if (argc != 2) {
+		g_printerr("Missing trace file\n");
+		exit(1);
+	}
+
+	ret = decode(argv[1], option_pcap);
+	g_free(option_pcap);
+	return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -50,6 +50,8 @@ struct fake_ofono_watch_closure {
 #define SIGNAL_IMSI_CHANGED_NAME        "ofono-watch-imsi-changed"
 #define SIGNAL_SPN_CHANGED_NAME         "ofono-watch-spn-changed"
 #define SIGNAL_NETREG_CHANGED_NAME      "ofono-watch-netreg-changed"
+#define SIGNAL_REG_STATUS_CHANGED_NAME  "ofono-watch-reg-status-changed"
+#define SIGNAL_REG_TECH_CHANGED_NAME    "ofono-watch-reg-tech-changed"
 
 static guint fake_ofono_watch_signals[FAKE_WATCH_SIGNAL_COUNT] = { 0 };
 static GHashTable *fake_ofono_watch_table = NULL;
@@ -314,6 +316,20 @@ unsigned long ofono_watch_add_netreg_changed_handler(struct ofono_watch *watch,
 			FAKE_WATCH_SIGNAL_NETREG_CHANGED, cb, user_data);
 }
 
+unsigned long ofono_watch_add_reg_status_changed_handler
+		(struct ofono_watch *watch, ofono_watch_cb_t cb, void *user_data)
+{
+	return fake_watch_add_signal_handler(watch,
+			FAKE_WATCH_SIGNAL_REG_STATUS_CHANGED, cb, user_data);
+}
+
+unsigned long ofono_watch_add_reg_tech_changed_handler
+		(struct ofono_watch *watch, ofono_watch_cb_t cb, void *user_data)
+{
+	return fake_watch_add_signal_handler(watch,
+			FAKE_WATCH_SIGNAL_REG_TECH_CHANGED, cb, user_data);
+}
+
 void ofono_watch_remove_handler(struct ofono_watch *watch, unsigned long id)
 {
 	if (watch && id) {
@@ -353,6 +369,8 @@ static void fake_ofono_watch_class_init(FakeOfonoWatchClass *klass)
 	NEW_SIGNAL(klass, IMSI);
 	NEW_SIGNAL(klass, SPN);
 	NEW_SIGNAL(klass, NETREG);
+	NEW_SIGNAL(klass, REG_STATUS);
+	NEW_SIGNAL(klass, REG_TECH);
 }
 
 /*
@@ -27,6 +27,8 @@ enum fake_watch_signal {
 	FAKE_WATCH_SIGNAL_IMSI_CHANGED,
 	FAKE_WATCH_SIGNAL_SPN_CHANGED,
 	FAKE_WATCH_SIGNAL_NETREG_CHANGED,
+	FAKE_WATCH_SIGNAL_REG_STATUS_CHANGED,
+	FAKE_WATCH_SIGNAL_REG_TECH_CHANGED,
 	FAKE_WATCH_SIGNAL_COUNT
 };
 
@@ -0,0 +1,590 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <glib.h>
+
+#include "ofono.h"
+
+#include "gatchat.h"
+
+#define TEST_(name) "/atmodem_sms/" name
+
+#define TEST_TIMEOUT_SEC 10
+
+#define TEST_STORE_SIZE 8
+#define TEST_PDU_LEN 8
+#define TEST_BIG_PDU_LEN 180	/* Doesn't fit into the driver's buffer */
+
+/* Message status as in 27.005 */
+#define TEST_REC_UNREAD 0
+#define TEST_REC_READ 1
+#define TEST_STO_UNSENT 2
+
+struct test_sms {
+	gboolean used;
+	int status;
+	int pdu_len;
+};
+
+/* Fake modem with a single SM store, talking to the driver via a socket */
+struct test_modem {
+	GMainLoop *loop;
+	GIOChannel *io;
+	guint read_id;
+	const char *last;	/* Command which ends test_modem_run() */
+	GString *rx;
+	GPtrArray *cmds;
+	struct test_sms store[TEST_STORE_SIZE];
+	gboolean no_delflag;
+	GAtChat *chat;
+	struct ofono_sms *sms;
+	GArray *delivered;	/* Indexes, the last byte of each PDU */
+	gboolean registered;
+};
+
+/* Declarations && Re-implementations of core functions. */
+void at_sms_init(void);
+void at_sms_exit(void);
+
+static const struct ofono_sms_driver *smsdriver;
+
+struct ofono_sms {
+	void *driver_data;
+	struct test_modem *tm;
+};
+
+int ofono_sms_driver_register(const struct ofono_sms_driver *d)
+{
+	if (smsdriver == NULL)
+		smsdriver = d;
+
+	return 0;
+}
+
+void ofono_sms_driver_unregister(const struct ofono_sms_driver *d)
+{
+	smsdriver = NULL;
+}
+
+void ofono_sms_register(struct ofono_sms *sms)
+{
+	sms->tm->registered = TRUE;
+}
+
+void ofono_sms_remove(struct ofono_sms *sms)
+{
+	g_assert_not_reached();
+}
+
+void ofono_sms_set_data(struct ofono_sms *sms, void *data)
+{
+	sms->driver_data = data;
+}
+
+void *ofono_sms_get_data(struct ofono_sms *sms)
+{
+	return sms->driver_data;
+}
+
+void ofono_sms_deliver_notify(struct ofono_sms *sms, const unsigned char *pdu,
+				int len, int tpdu_len)
+{
+	int index = pdu[len - 1];
+
+	g_assert_cmpint(len, ==, TEST_PDU_LEN);
+	g_array_append_val(sms->tm->delivered, index);
+}
+
+void ofono_sms_status_notify(struct ofono_sms *sms, const unsigned char *pdu,
+				int len, int tpdu_len)
+{
+	g_assert_not_reached();
+}
+
+/* ==== fake modem ==== */
+
+static void test_modem_append_pdu(GString *out, int index, int len)
+{
+	int i;
+
+	for (i = 1; i < len; i++)
+		g_string_append(out, "00");
+
+	g_string_append_printf(out, "%02X\r\n", index);
+}
+
+static void test_modem_list(struct test_modem *tm, GString *out, int stat)
+{
+	int i;
+
+	for (i = 0; i < TEST_STORE_SIZE; i++) {
+		struct test_sms *msg = tm->store + i;
+
+		if (!msg->used || (stat != 4 && msg->status != stat))
+			continue;
+
+		g_string_append_printf(out, "\r\n+CMGL: %d,%d,,%d\r\n", i,
+					msg->status, msg->pdu_len - 1);
+		test_modem_append_pdu(out, i, msg->pdu_len);
+
+		if (msg->status == TEST_REC_UNREAD)
+			msg->status = TEST_REC_READ;
+	}
+}
+
+static gboolean test_modem_read(struct test_modem *tm, GString *out,
+				int index)
+{
+	struct test_sms *msg;
+
+	if (index < 0 || index >= TEST_STORE_SIZE || !tm->store[index].used)
+		return FALSE;
+
+	msg = tm->store + index;
+	g_string_append_printf(out, "\r\n+CMGR: %d,,%d\r\n", msg->status,
+					msg->pdu_len - 1);
+	test_modem_append_pdu(out, index, msg->pdu_len);
+
+	if (msg->status == TEST_REC_UNREAD)
+		msg->status = TEST_REC_READ;
+
+	return TRUE;
+}
+
+static gboolean test_modem_delete_read(struct test_modem *tm)
+{
+	int i;
+
+	if (tm->no_delflag)
+		return FALSE;
+
+	for (i = 0; i < TEST_STORE_SIZE; i++)
+		if (tm->store[i].status == TEST_REC_READ)
+			tm->store[i].used = FALSE;
+
+	return TRUE;
+}
+
+static void test_modem_command(struct test_modem *tm, const char *cmd)
+{
+	GString *out = g_string_new(NULL);
+	gboolean ok = TRUE;
+	int index;
+	int flag;
+
+	g_ptr_array_add(tm->cmds, g_strdup(cmd));
+
+	if (!strcmp(cmd, "AT+CSMS=?"))
+		g_string_append(out, "\r\n+CSMS: (0)\r\n");
+	else if (!strcmp(cmd, "AT+CSMS?"))
+		g_string_append(out, "\r\n+CSMS: 0,1,1,1\r\n");
+	else if (g_str_has_prefix(cmd, "AT+CSMS="))
+		g_string_append(out, "\r\n+CSMS: 1,1,1\r\n");
+	else if (!strcmp(cmd, "AT+CMGF=?"))
+		g_string_append(out, "\r\n+CMGF: (0)\r\n");
+	else if (!strcmp(cmd, "AT+CPMS=?"))
+		g_string_append(out, "\r\n+CPMS: (\"SM\"),(\"SM\"),"
+							"(\"SM\")\r\n");
+	else if (!strcmp(cmd, "AT+CNMI=?"))
+		g_string_append(out, "\r\n+CNMI: (0-3),(0-3),(0-3),(0-2),"
+								"(0,1)\r\n");
+	else if (!strcmp(cmd, "AT+CMGL=4"))
+		test_modem_list(tm, out, 4);
+	else if (!strcmp(cmd, "AT+CMGL=0"))
+		test_modem_list(tm, out, TEST_REC_UNREAD);
+	else if (sscanf(cmd, "AT+CMGR=%d", &index) == 1)
+		ok = test_modem_read(tm, out, index);
+	else if (sscanf(cmd, "AT+CMGD=%d,%d", &index, &flag) == 2)
+		ok = (flag == 1) && test_modem_delete_read(tm);
+	else if (sscanf(cmd, "AT+CMGD=%d", &index) == 1 &&
+			index >= 0 && index < TEST_STORE_SIZE)
+		tm->store[index].used = FALSE;
+
+	g_string_append(out, ok ? "\r\nOK\r\n" : "\r\nERROR\r\n");
+	g_assert_cmpint(write(g_io_channel_unix_get_fd(tm->io), out->str,
+					out->len), ==, out->len);
+	g_string_free(out, TRUE);
+
+	if (tm->last && !strcmp(cmd, tm->last)) {
+		tm->last = NULL;
+		g_main_loop_quit(tm->loop);
+	}
+}
+
+static gboolean test_modem_timeout_cb(gpointer user_data)
+{
+	g_error("Timed out waiting for %s", (const char *) user_data);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean test_modem_read_cb(GIOChannel *io, GIOCondition cond,
+							gpointer user_data)
+{
+	struct test_modem *tm = user_data;
+	char buf[512];
+	ssize_t n;
+	char *end;
+
+	n = read(g_io_channel_unix_get_fd(io), buf, sizeof(buf));
+	g_assert(n > 0);
+	g_string_append_len(tm->rx, buf, n);
+
+	/* Commands are terminated with <CR> */
+	while ((end = strchr(tm->rx->str, '\r')) != NULL) {
+		*end = 0;
+		test_modem_command(tm, tm->rx->str);
+		g_string_erase(tm->rx, 0, end - tm->rx->str + 1);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/* Runs the main loop until the last command has been answered */
+static void test_modem_run(struct test_modem *tm, const char *last)
+{
+	guint timeout_id = g_timeout_add_seconds(TEST_TIMEOUT_SEC,
+				test_modem_timeout_cb, (gpointer) last);
+
+	tm->last = last;
+	g_main_loop_run(tm->loop);
+	g_source_remove(timeout_id);
+}
+
+static void test_modem_init(struct test_modem *tm)
+{
+	GAtSyntax *syntax;
+	GIOChannel *io;
+	int sv[2];
+
+	memset(tm, 0, sizeof(*tm));
+	g_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+	io = g_io_channel_unix_new(sv[0]);
+	g_io_channel_set_close_on_unref(io, TRUE);
+	g_io_channel_set_encoding(io, NULL, NULL);
+	g_io_channel_set_buffered(io, FALSE);
+	syntax = g_at_syntax_new_gsm_permissive();
+	tm->chat = g_at_chat_new(io, syntax);
+	g_at_syntax_unref(syntax);
+	g_io_channel_unref(io);
+
+	tm->io = g_io_channel_unix_new(sv[1]);
+	g_io_channel_set_close_on_unref(tm->io, TRUE);
+	tm->read_id = g_io_add_watch(tm->io, G_IO_IN, test_modem_read_cb, tm);
+
+	tm->loop = g_main_loop_new(NULL, FALSE);
+	tm->rx = g_string_new(NULL);
+	tm->cmds = g_ptr_array_new_with_free_func(g_free);
+	tm->delivered = g_array_new(FALSE, FALSE, sizeof(int));
+}
+
+static void test_modem_add(struct test_modem *tm, int index, int status,
+							int pdu_len)
+{
+	g_assert(!tm->store[index].used);
+	tm->store[index].used = TRUE;
+	tm->store[index].status = status;
+	tm->store[index].pdu_len = pdu_len;
+}
+
+/* Probes the driver and lets it go through the startup listing */
+static void test_modem_probe(struct test_modem *tm, const char *last)
+{
+	tm->sms = g_new0(struct ofono_sms, 1);
+	tm->sms->tm = tm;
+
+	g_assert(smsdriver->probe(tm->sms, 0, tm->chat) == 0);
+	test_modem_run(tm, last);
+	g_assert(tm->registered);
+}
+
+/* With an empty store, the listing is the last thing at startup */
+static void test_modem_start(struct test_modem *tm)
+{
+	test_modem_probe(tm, "AT+CMGL=4");
+	g_ptr_array_set_size(tm->cmds, 0);
+}
+
+static void test_modem_cleanup(struct test_modem *tm)
+{
+	if (tm->sms) {
+		smsdriver->remove(tm->sms);
+		g_free(tm->sms);
+	}
+
+	g_at_chat_unref(tm->chat);
+	g_source_remove(tm->read_id);
+	g_io_channel_unref(tm->io);
+	g_main_loop_unref(tm->loop);
+	g_string_free(tm->rx, TRUE);
+	g_ptr_array_free(tm->cmds, TRUE);
+	g_array_free(tm->delivered, TRUE);
+}
+
+/* All announced in one go, like an SMSC flushing its backlog */
+static void test_modem_cmti(struct test_modem *tm, const int *index, int n,
+							const char *last)
+{
+	GString *out = g_string_new(NULL);
+	int i;
+
+	for (i = 0; i < n; i++)
+		g_string_append_printf(out, "\r\n+CMTI: \"SM\",%d\r\n",
+								index[i]);
+
+	g_assert_cmpint(write(g_io_channel_unix_get_fd(tm->io), out->str,
+					out->len), ==, out->len);
+	g_string_free(out, TRUE);
+	test_modem_run(tm, last);
+}
+
+static guint test_modem_count(struct test_modem *tm, const char *prefix)
+{
+	guint i, count = 0;
+
+	for (i = 0; i < tm->cmds->len; i++)
+		if (g_str_has_prefix(tm->cmds->pdata[i], prefix))
+			count++;
+
+	return count;
+}
+
+static gboolean test_modem_sent(struct test_modem *tm, const char *cmd)
+{
+	guint i;
+
+	for (i = 0; i < tm->cmds->len; i++)
+		if (!strcmp(tm->cmds->pdata[i], cmd))
+			return TRUE;
+
+	return FALSE;
+}
+
+static guint test_modem_stored(struct test_modem *tm)
+{
+	guint i, count = 0;
+
+	for (i = 0; i < TEST_STORE_SIZE; i++)
+		if (tm->store[i].used)
+			count++;
+
+	return count;
+}
+
+static void test_assert_delivered(struct test_modem *tm, const int *index,
+									int n)
+{
+	int i;
+
+	g_assert_cmpuint(tm->delivered->len, ==, n);
+
+	for (i = 0; i < n; i++)
+		g_assert_cmpint(g_array_index(tm->delivered, int, i), ==,
+								index[i]);
+}
+
+/* ==== startup_bulk ==== */
+
+static void test_startup_bulk(void)
+{
+	static const int delivered[] = { 1, 2, 3 };
+	struct test_modem tm;
+
+	test_modem_init(&tm);
+	test_modem_add(&tm, 1, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_add(&tm, 2, TEST_REC_READ, TEST_PDU_LEN);
+	test_modem_add(&tm, 3, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_add(&tm, 5, TEST_STO_UNSENT, TEST_PDU_LEN);
+
+	test_modem_probe(&tm, "AT+CMGD=1,1");
+
+	/* Everything read has been delivered, one delete does it all */
+	test_assert_delivered(&tm, delivered, G_N_ELEMENTS(delivered));
+	g_assert(test_modem_sent(&tm, "AT+CMGL=4"));
+	g_assert_cmpuint(test_modem_count(&tm, "AT+CMGD="), ==, 1);
+	g_assert(test_modem_sent(&tm, "AT+CMGD=1,1"));
+
+	/* The MO message is left alone */
+	g_assert_cmpuint(test_modem_stored(&tm), ==, 1);
+	g_assert(tm.store[5].used);
+
+	test_modem_cleanup(&tm);
+}
+
+/* ==== startup_skipped ==== */
+
+static void test_startup_skipped(void)
+{
+	static const int delivered[] = { 1, 3 };
+	struct test_modem tm;
+
+	test_modem_init(&tm);
+	test_modem_add(&tm, 1, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_add(&tm, 2, TEST_REC_UNREAD, TEST_BIG_PDU_LEN);
+	test_modem_add(&tm, 3, TEST_REC_READ, TEST_PDU_LEN);
+	test_modem_probe(&tm, "AT+CMGD=3");
+
+	/* The listing marked the big one as read, it must survive */
+	test_assert_delivered(&tm, delivered, G_N_ELEMENTS(delivered));
+	g_assert_cmpuint(test_modem_stored(&tm), ==, 1);
+	g_assert(tm.store[2].used);
+	g_assert_cmpint(tm.store[2].status, ==, TEST_REC_READ);
+
+	test_modem_cleanup(&tm);
+}
+
+/* ==== startup_no_delflag ==== */
+
+static void test_startup_no_delflag(void)
+{
+	static const int delivered[] = { 1, 2 };
+	struct test_modem tm;
+
+	test_modem_init(&tm);
+	tm.no_delflag = TRUE;
+	test_modem_add(&tm, 1, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_add(&tm, 2, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_probe(&tm, "AT+CMGD=2");
+
+	/* Bulk delete is rejected, falls back to one by one */
+	test_assert_delivered(&tm, delivered, G_N_ELEMENTS(delivered));
+	g_assert(test_modem_sent(&tm, "AT+CMGD=1,1"));
+	g_assert(test_modem_sent(&tm, "AT+CMGD=1"));
+	g_assert(test_modem_sent(&tm, "AT+CMGD=2"));
+	g_assert_cmpuint(test_modem_stored(&tm), ==, 0);
+
+	test_modem_cleanup(&tm);
+}
+
+/* ==== cmti_batch ==== */
+
+static void test_cmti_batch(void)
+{
+	static const int cmti[] = { 2, 3, 4 };
+	struct test_modem tm;
+
+	test_modem_init(&tm);
+	test_modem_start(&tm);
+
+	/* A read message which nobody has told us about */
+	test_modem_add(&tm, 1, TEST_REC_READ, TEST_PDU_LEN);
+	test_modem_add(&tm, 2, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_add(&tm, 3, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_add(&tm, 4, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_cmti(&tm, cmti, G_N_ELEMENTS(cmti), "AT+CMGD=4");
+
+	/* One listing, and only the delivered ones are deleted */
+	test_assert_delivered(&tm, cmti, G_N_ELEMENTS(cmti));
+	g_assert_cmpuint(test_modem_count(&tm, "AT+CMGL=0"), ==, 1);
+	g_assert_cmpuint(test_modem_count(&tm, "AT+CMGR="), ==, 0);
+	g_assert_cmpuint(test_modem_count(&tm, "AT+CMGD="), ==, 3);
+	g_assert(!test_modem_sent(&tm, "AT+CMGD=2,1"));
+	g_assert_cmpuint(test_modem_stored(&tm), ==, 1);
+	g_assert(tm.store[1].used);
+
+	test_modem_cleanup(&tm);
+}
+
+/* ==== cmti_fallback ==== */
+
+static void test_cmti_fallback(void)
+{
+	static const int cmti[] = { 2, 3 };
+	struct test_modem tm;
+
+	test_modem_init(&tm);
+	test_modem_start(&tm);
+
+	/* Already read by the time we get to list it */
+	test_modem_add(&tm, 2, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_add(&tm, 3, TEST_REC_READ, TEST_PDU_LEN);
+
+	/* AT+CMGR=3 and its AT+CMGD are queued ahead of AT+CMGD=2 */
+	test_modem_cmti(&tm, cmti, G_N_ELEMENTS(cmti), "AT+CMGD=2");
+
+	/* The listing misses it, AT+CMGR picks it up */
+	test_assert_delivered(&tm, cmti, G_N_ELEMENTS(cmti));
+	g_assert_cmpuint(test_modem_count(&tm, "AT+CMGL=0"), ==, 1);
+	g_assert(test_modem_sent(&tm, "AT+CMGR=3"));
+	g_assert_cmpuint(test_modem_count(&tm, "AT+CMGR="), ==, 1);
+	g_assert_cmpuint(test_modem_stored(&tm), ==, 0);
+
+	test_modem_cleanup(&tm);
+}
+
+/* ==== cmti_single ==== */
+
+static void test_cmti_single(void)
+{
+	static const int cmti[] = { 2 };
+	struct test_modem tm;
+
+	test_modem_init(&tm);
+	test_modem_start(&tm);
+
+	test_modem_add(&tm, 2, TEST_REC_UNREAD, TEST_PDU_LEN);
+	test_modem_cmti(&tm, cmti, G_N_ELEMENTS(cmti), "AT+CMGD=2");
+
+	/* Not worth a listing */
+	test_assert_delivered(&tm, cmti, G_N_ELEMENTS(cmti));
+	g_assert_cmpuint(test_modem_count(&tm, "AT+CMGL="), ==, 0);
+	g_assert(test_modem_sent(&tm, "AT+CMGR=2"));
+	g_assert(test_modem_sent(&tm, "AT+CMGD=2"));
+	g_assert_cmpuint(test_modem_stored(&tm), ==, 0);
+
+	test_modem_cleanup(&tm);
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+
+	g_test_init(&argc, &argv, NULL);
+
+	__ofono_log_init("test-atmodem-sms",
+				g_test_verbose() ? "*" : NULL,
+				FALSE, FALSE);
+
+	at_sms_init();
+	g_assert(smsdriver);
+
+	g_test_add_func(TEST_("startup_bulk"), test_startup_bulk);
+	g_test_add_func(TEST_("startup_skipped"), test_startup_skipped);
+	g_test_add_func(TEST_("startup_no_delflag"), test_startup_no_delflag);
+	g_test_add_func(TEST_("cmti_batch"), test_cmti_batch);
+	g_test_add_func(TEST_("cmti_fallback"), test_cmti_fallback);
+	g_test_add_func(TEST_("cmti_single"), test_cmti_single);
+
+	ret = g_test_run();
+	at_sms_exit();
+	return ret;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -178,6 +178,169 @@ static void test_update_interval(void)
 	ofono_cell_info_unref(info);
 }
 
+/* ==== backoff ==== */
+
+struct test_backoff_data {
+	GMainLoop *loop;
+	struct ofono_cell_info *info;
+	int interval;
+};
+
+static gboolean test_backoff_check(gpointer user_data)
+{
+	struct test_backoff_data *test = user_data;
+
+	if (fake_cell_info_update_interval(test->info) == test->interval) {
+		g_main_loop_quit(test->loop);
+		return G_SOURCE_REMOVE;
+	}
+	return G_SOURCE_CONTINUE;
+}
+
+static void test_backoff_wait(struct test_backoff_data *test, int interval)
+{
+	test->interval = interval;
+	g_timeout_add(1, test_backoff_check, test);
+	g_main_loop_run(test->loop);
+}
+
+static gboolean test_backoff_timeout(gpointer user_data)
+{
+	struct test_backoff_data *test = user_data;
+
+	g_main_loop_quit(test->loop);
+	return G_SOURCE_REMOVE;
+}
+
+static void test_backoff_run(struct test_backoff_data *test, guint ms)
+{
+	g_timeout_add(ms, test_backoff_timeout, test);
+	g_main_loop_run(test->loop);
+}
+
+static void test_backoff_cell(struct ofono_cell *cell)
+{
+	memset(cell, 0, sizeof(*cell));
+	cell->type = OFONO_CELL_TYPE_LTE;
+	cell->registered = TRUE;
+	cell->info.lte.mcc = 244;
+	cell->info.lte.mnc = 91;
+	cell->info.lte.ci = 1;
+}
+
+static void test_backoff(void)
+{
+	CellInfoControl *ctl = cell_info_control_get("/test");
+	struct test_backoff_data test;
+	struct ofono_cell cell;
+	void* tag = &ctl;
+
+	memset(&test, 0, sizeof(test));
+	test.loop = g_main_loop_new(NULL, FALSE);
+	test.info = fake_cell_info_new();
+
+	test_backoff_cell(&cell);
+	fake_cell_info_add_cell(test.info, &cell);
+
+	cell_info_control_set_cell_info(ctl, test.info);
+	cell_info_control_set_update_interval(ctl, tag, 10);
+	g_assert_cmpint(ctl->update_interval, == ,10);
+
+	/* Nothing happens while disabled */
+	test_backoff_run(&test, 100);
+	g_assert_cmpint(ctl->update_interval, == ,10);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,10);
+	g_assert_cmpuint(ctl->skipped_polls, == ,0);
+	cell_info_control_set_enabled(ctl, tag, TRUE);
+
+	/* Nothing is moving, the interval keeps doubling */
+	test_backoff_wait(&test, 20);
+	test_backoff_wait(&test, 40);
+	g_assert_cmpint(ctl->update_interval, == ,40);
+
+	/* Signal strength doesn't matter */
+	g_assert(fake_cell_info_remove_cell(test.info, &cell));
+	cell.info.lte.rssi = 20;
+	fake_cell_info_add_cell(test.info, &cell);
+	fake_cell_info_cells_changed(test.info);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,40);
+
+	/* But a new cell does */
+	cell.registered = FALSE;
+	cell.info.lte.ci = 2;
+	fake_cell_info_add_cell(test.info, &cell);
+	fake_cell_info_cells_changed(test.info);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,10);
+	g_assert_cmpuint(ctl->skipped_polls, > ,0);
+
+	/* And so does the kick */
+	test_backoff_wait(&test, 20);
+	cell_info_control_kick(ctl);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,10);
+
+	/* So does changing the requested interval */
+	test_backoff_wait(&test, 20);
+	cell_info_control_set_update_interval(ctl, tag, 15);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,15);
+
+	/* Disabling stops the backoff */
+	cell_info_control_set_enabled(ctl, tag, FALSE);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,15);
+
+	cell_info_control_unref(ctl);
+	ofono_cell_info_unref(test.info);
+	g_main_loop_unref(test.loop);
+}
+
+/* ==== backoff_zero ==== */
+
+static void test_backoff_zero(void)
+{
+	CellInfoControl *ctl = cell_info_control_get("/test");
+	struct test_backoff_data test;
+	struct ofono_cell cell;
+	void* tag1 = &ctl;
+	void* tag2 = &test;
+	guint skipped;
+
+	memset(&test, 0, sizeof(test));
+	test.loop = g_main_loop_new(NULL, FALSE);
+	test.info = fake_cell_info_new();
+	test_backoff_cell(&cell);
+	fake_cell_info_add_cell(test.info, &cell);
+
+	cell_info_control_set_cell_info(ctl, test.info);
+	cell_info_control_set_enabled(ctl, tag1, TRUE);
+	cell_info_control_set_update_interval(ctl, tag1, 10);
+	test_backoff_wait(&test, 20);
+
+	/* Zero interval while backed off doesn't crash the count */
+	cell_info_control_set_update_interval(ctl, tag2, 0);
+	g_assert_cmpint(ctl->update_interval, == ,0);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,0);
+	skipped = ctl->skipped_polls;
+
+	/* And there's no backing off from zero */
+	test_backoff_run(&test, 100);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,0);
+	g_assert_cmpuint(ctl->skipped_polls, == ,skipped);
+
+	/* Back to 10 ms, which starts backing off again */
+	cell_info_control_drop_requests(ctl, tag2);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,10);
+	test_backoff_wait(&test, 20);
+
+	/* Dropping the last interval request while backed off */
+	cell_info_control_drop_requests(ctl, tag1);
+	g_assert_cmpint(ctl->update_interval, == ,INT_MAX);
+	g_assert_cmpint(fake_cell_info_update_interval(test.info), == ,
+		INT_MAX);
+
+	cell_info_control_unref(ctl);
+	ofono_cell_info_unref(test.info);
+	g_main_loop_unref(test.loop);
+}
+
 int main(int argc, char *argv[])
 {
 	g_test_init(&argc, &argv, NULL);
@@ -192,6 +355,8 @@ int main(int argc, char *argv[])
 	g_test_add_func(TEST_("basic"), test_basic);
 	g_test_add_func(TEST_("enabled"), test_enabled);
 	g_test_add_func(TEST_("update_interval"), test_update_interval);
+	g_test_add_func(TEST_("backoff"), test_backoff);
+	g_test_add_func(TEST_("backoff_zero"), test_backoff_zero);
 	return g_test_run();
 }
 
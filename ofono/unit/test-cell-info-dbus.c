@@ -34,6 +34,7 @@
 #define CELL_INFO_DBUS_CELLS_ADDED_SIGNAL   "CellsAdded"
 #define CELL_INFO_DBUS_CELLS_REMOVED_SIGNAL "CellsRemoved"
 #define CELL_INFO_DBUS_UNSUBSCRIBED_SIGNAL  "Unsubscribed"
+#define CELL_INFO_DBUS_CELLS_UPDATED_SIGNAL "CellsUpdated"
 
 #define CELL_DBUS_INTERFACE_VERSION         (1)
 #define CELL_DBUS_INTERFACE                 "org.nemomobile.ofono.Cell"
@@ -1145,6 +1146,371 @@ static void test_unsubscribe(void)
 	}
 }
 
+/* ==== SubscribeDelta ==== */
+
+struct test_subscribe_delta_data {
+	struct ofono_modem modem;
+	struct test_dbus_context context;
+	struct cell_info_dbus *dbus;
+	CellInfoControl *ctl;
+};
+
+static guint test_check_subscribe_delta_reply(DBusPendingCall *call,
+							int ncells)
+{
+	DBusMessage *reply = dbus_pending_call_steal_reply(call);
+	DBusMessageIter it, array;
+	dbus_uint32_t seq;
+	int count = 0;
+
+	g_assert(dbus_message_get_type(reply) ==
+					DBUS_MESSAGE_TYPE_METHOD_RETURN);
+	dbus_message_iter_init(reply, &it);
+	g_assert(dbus_message_iter_get_arg_type(&it) == DBUS_TYPE_UINT32);
+	dbus_message_iter_get_basic(&it, &seq);
+	dbus_message_iter_next(&it);
+	g_assert(dbus_message_iter_get_arg_type(&it) == DBUS_TYPE_ARRAY);
+	dbus_message_iter_recurse(&it, &array);
+	while (dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_STRUCT) {
+		dbus_message_iter_next(&array);
+		count++;
+	}
+	g_assert_cmpint(count, ==, ncells);
+	dbus_message_unref(reply);
+	return seq;
+}
+
+static void test_subscribe_delta_reply2(DBusPendingCall *call, void *data)
+{
+	struct test_subscribe_delta_data *test = data;
+	DBusMessage *signal = test_dbus_take_signal(&test->context,
+				test->modem.path, CELL_INFO_DBUS_INTERFACE,
+				CELL_INFO_DBUS_CELLS_UPDATED_SIGNAL);
+	DBusMessageIter it, array, st, dict, entry;
+	dbus_uint32_t seq;
+	const char *name;
+
+	DBG("");
+	g_assert_cmpuint(test_check_subscribe_delta_reply(call, 2), ==, 1);
+	dbus_pending_call_unref(call);
+
+	/* One signal covering the whole update */
+	g_assert(signal);
+	dbus_message_iter_init(signal, &it);
+	dbus_message_iter_get_basic(&it, &seq);
+	dbus_message_iter_next(&it);
+	g_assert_cmpuint(seq, ==, 1);
+
+	/* Nothing removed */
+	g_assert(dbus_message_iter_get_arg_type(&it) == DBUS_TYPE_ARRAY);
+	dbus_message_iter_recurse(&it, &array);
+	dbus_message_iter_next(&it);
+	g_assert(dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_INVALID);
+
+	/* One cell added */
+	dbus_message_iter_recurse(&it, &array);
+	dbus_message_iter_next(&it);
+	g_assert(dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_STRUCT);
+	dbus_message_iter_recurse(&array, &st);
+	g_assert_cmpstr(test_dbus_get_object_path(&st), ==, "/test/cell_1");
+	g_assert_cmpstr(test_dbus_get_string(&st), ==, "gsm");
+	dbus_message_iter_next(&array);
+	g_assert(dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_INVALID);
+
+	/* And one changed, with nothing but the signal strength */
+	dbus_message_iter_recurse(&it, &array);
+	g_assert(dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_STRUCT);
+	dbus_message_iter_recurse(&array, &st);
+	g_assert_cmpstr(test_dbus_get_object_path(&st), ==, "/test/cell_0");
+	dbus_message_iter_recurse(&st, &dict);
+	dbus_message_iter_recurse(&dict, &entry);
+	dbus_message_iter_get_basic(&entry, &name);
+	g_assert_cmpstr(name, ==, "signalStrength");
+	dbus_message_iter_next(&dict);
+	g_assert(dbus_message_iter_get_arg_type(&dict) == DBUS_TYPE_INVALID);
+	dbus_message_iter_next(&array);
+	g_assert(dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_INVALID);
+	dbus_message_unref(signal);
+
+	/* Delta subscribers don't get the individual signals */
+	g_assert(!test_dbus_find_signal(&test->context, test->modem.path,
+		CELL_INFO_DBUS_INTERFACE, CELL_INFO_DBUS_CELLS_ADDED_SIGNAL));
+	g_assert(!test_dbus_find_signal(&test->context, "/test/cell_0",
+		CELL_DBUS_INTERFACE, CELL_DBUS_PROPERTY_CHANGED_SIGNAL));
+
+	test_loop_quit_later(test->context.loop);
+}
+
+static void test_subscribe_delta_reply1(DBusPendingCall *call, void *data)
+{
+	struct test_subscribe_delta_data *test = data;
+	struct ofono_cell_info *info = test->ctl->info;
+	struct ofono_cell cell;
+
+	DBG("");
+	g_assert_cmpuint(test_check_subscribe_delta_reply(call, 1), ==, 0);
+	dbus_pending_call_unref(call);
+
+	/* Add one cell and change the other one */
+	info->cells[0]->info.gsm.signalStrength++;
+	fake_cell_info_add_cell(info, test_cell_init_gsm2(&cell));
+	fake_cell_info_cells_changed(info);
+
+	test_submit_cell_info_call(test->context.client_connection,
+		"SubscribeDelta", test_subscribe_delta_reply2, test);
+}
+
+static void test_subscribe_delta_start(struct test_dbus_context *context)
+{
+	struct ofono_cell cell;
+	struct ofono_cell_info *info = fake_cell_info_new();
+	struct test_subscribe_delta_data *test =
+		G_CAST(context, struct test_subscribe_delta_data, context);
+
+	DBG("");
+	fake_cell_info_add_cell(info, test_cell_init_gsm1(&cell));
+	test->ctl = cell_info_control_get(test->modem.path);
+	cell_info_control_set_cell_info(test->ctl, info);
+
+	test->dbus = cell_info_dbus_new(&test->modem, test->ctl);
+	g_assert(test->dbus);
+	ofono_cell_info_unref(info);
+
+	test_submit_cell_info_call(test->context.client_connection,
+		"SubscribeDelta", test_subscribe_delta_reply1, test);
+}
+
+static void test_subscribe_delta(void)
+{
+	struct test_subscribe_delta_data test;
+	guint timeout = test_setup_timeout();
+
+	memset(&test, 0, sizeof(test));
+	test.modem.path = TEST_MODEM_PATH;
+	test.context.start = test_subscribe_delta_start;
+	test_dbus_setup(&test.context);
+
+	g_main_loop_run(test.context.loop);
+
+	cell_info_control_unref(test.ctl);
+	cell_info_dbus_free(test.dbus);
+	test_dbus_shutdown(&test.context);
+	if (timeout) {
+		g_source_remove(timeout);
+	}
+}
+
+/* ==== ManyCells ==== */
+
+#define TEST_MANY_CELLS_COUNT   (128)
+#define TEST_MANY_CELLS_CHURN   (8)
+#define TEST_MANY_CELLS_ROUNDS  (4)
+
+struct test_many_cells_data {
+	struct ofono_modem modem;
+	struct test_dbus_context context;
+	struct cell_info_dbus *dbus;
+	CellInfoControl *ctl;
+	int round;
+};
+
+static struct ofono_cell *test_many_cells_cell(struct ofono_cell *cell,
+								int id)
+{
+	test_cell_init_lte(cell);
+	cell->registered = !id;
+	cell->info.lte.ci = 1000 + id;
+	cell->info.lte.pci = id % 504;
+	return cell;
+}
+
+static char *test_many_cells_path(int id)
+{
+	return g_strdup_printf("/test/cell_%d", id);
+}
+
+/* Checks that the array contains n consecutive cells starting at id */
+static void test_many_cells_check_paths(DBusMessageIter *it, int id, int n)
+{
+	DBusMessageIter array;
+
+	g_assert(dbus_message_iter_get_arg_type(it) == DBUS_TYPE_ARRAY);
+	dbus_message_iter_recurse(it, &array);
+	while (n-- > 0) {
+		char *path = test_many_cells_path(id++);
+
+		g_assert_cmpstr(test_dbus_get_object_path(&array), ==, path);
+		g_free(path);
+	}
+	g_assert(dbus_message_iter_get_arg_type(&array) == DBUS_TYPE_INVALID);
+}
+
+static void test_many_cells_check_signals(struct test_many_cells_data *test)
+{
+	/* Cells which were replaced by the last update */
+	const int first = (test->round - 1) * TEST_MANY_CELLS_CHURN;
+	const int added = first + TEST_MANY_CELLS_COUNT;
+	DBusMessageIter it;
+	DBusMessage *signal;
+	int id;
+
+	signal = test_dbus_take_signal(&test->context, test->modem.path,
+				CELL_INFO_DBUS_INTERFACE,
+				CELL_INFO_DBUS_CELLS_REMOVED_SIGNAL);
+	g_assert(signal);
+	dbus_message_iter_init(signal, &it);
+	test_many_cells_check_paths(&it, first, TEST_MANY_CELLS_CHURN);
+	dbus_message_unref(signal);
+
+	signal = test_dbus_take_signal(&test->context, test->modem.path,
+				CELL_INFO_DBUS_INTERFACE,
+				CELL_INFO_DBUS_CELLS_ADDED_SIGNAL);
+	g_assert(signal);
+	dbus_message_iter_init(signal, &it);
+	test_many_cells_check_paths(&it, added, TEST_MANY_CELLS_CHURN);
+	dbus_message_unref(signal);
+
+	/* One update per round, no leftovers */
+	g_assert(!test_dbus_find_signal(&test->context, test->modem.path,
+				CELL_INFO_DBUS_INTERFACE,
+				CELL_INFO_DBUS_CELLS_REMOVED_SIGNAL));
+	g_assert(!test_dbus_find_signal(&test->context, test->modem.path,
+				CELL_INFO_DBUS_INTERFACE,
+				CELL_INFO_DBUS_CELLS_ADDED_SIGNAL));
+
+	for (id = first; id < added + TEST_MANY_CELLS_CHURN; id++) {
+		char *path = test_many_cells_path(id);
+
+		signal = test_dbus_take_signal(&test->context, path,
+				CELL_DBUS_INTERFACE,
+				CELL_DBUS_PROPERTY_CHANGED_SIGNAL);
+		if (id < first + TEST_MANY_CELLS_CHURN) {
+			/* Removed cells get "Removed" and nothing else */
+			g_assert(!signal);
+			signal = test_dbus_take_signal(&test->context, path,
+				CELL_DBUS_INTERFACE, CELL_DBUS_REMOVED_SIGNAL);
+			g_assert(signal);
+		} else if (id < added) {
+			/* Cells that stay only report the changed rsrp */
+			g_assert(signal);
+			dbus_message_iter_init(signal, &it);
+			g_assert_cmpstr(test_dbus_get_string(&it), ==, "rsrp");
+			g_assert(!test_dbus_find_signal(&test->context, path,
+				CELL_DBUS_INTERFACE,
+				CELL_DBUS_PROPERTY_CHANGED_SIGNAL));
+		} else {
+			/* New cells have nothing to report */
+			g_assert(!signal);
+		}
+		if (signal) {
+			dbus_message_unref(signal);
+		}
+		g_free(path);
+	}
+}
+
+static void test_many_cells_update(struct test_many_cells_data *test)
+{
+	struct ofono_cell_info *info = test->ctl->info;
+	const int next = test->round * TEST_MANY_CELLS_CHURN +
+						TEST_MANY_CELLS_COUNT;
+	struct ofono_cell cell;
+	int k;
+
+	/*
+	 * Each update replaces a few of the oldest cells and changes
+	 * the signal strength of all others, which is roughly what
+	 * a periodic update in a dense deployment looks like.
+	 */
+	for (k = 0; k < TEST_MANY_CELLS_CHURN; k++) {
+		/* The oldest cell is always the first one */
+		cell = *info->cells[0];
+		g_assert(fake_cell_info_remove_cell(info, &cell));
+		fake_cell_info_add_cell(info,
+				test_many_cells_cell(&cell, next + k));
+	}
+	for (k = 0; k < TEST_MANY_CELLS_COUNT - TEST_MANY_CELLS_CHURN; k++) {
+		info->cells[k]->info.lte.rsrp++;
+	}
+	fake_cell_info_cells_changed(info);
+	test->round++;
+}
+
+static void test_many_cells_reply(DBusPendingCall *call, void *data)
+{
+	struct test_many_cells_data *test = data;
+	DBusMessage *reply = dbus_pending_call_steal_reply(call);
+	DBusMessageIter it;
+
+	DBG("%d", test->round);
+	g_assert(dbus_message_get_type(reply) ==
+					DBUS_MESSAGE_TYPE_METHOD_RETURN);
+
+	/* The oldest cells are gone, the rest are in order of appearance */
+	dbus_message_iter_init(reply, &it);
+	test_many_cells_check_paths(&it, test->round * TEST_MANY_CELLS_CHURN,
+						TEST_MANY_CELLS_COUNT);
+	dbus_message_unref(reply);
+	dbus_pending_call_unref(call);
+
+	if (test->round > 0) {
+		test_many_cells_check_signals(test);
+	}
+
+	if (test->round < TEST_MANY_CELLS_ROUNDS) {
+		test_many_cells_update(test);
+		test_submit_cell_info_call(test->context.client_connection,
+				"GetCells", test_many_cells_reply, test);
+	} else {
+		test_loop_quit_later(test->context.loop);
+	}
+}
+
+static void test_many_cells_start(struct test_dbus_context *context)
+{
+	struct ofono_cell_info *info = fake_cell_info_new();
+	struct test_many_cells_data *test =
+		G_CAST(context, struct test_many_cells_data, context);
+	struct ofono_cell cell;
+	int id;
+
+	DBG("");
+	for (id = 0; id < TEST_MANY_CELLS_COUNT; id++) {
+		fake_cell_info_add_cell(info, test_many_cells_cell(&cell, id));
+	}
+
+	test->ctl = cell_info_control_get(test->modem.path);
+	cell_info_control_set_cell_info(test->ctl, info);
+	test->dbus = cell_info_dbus_new(&test->modem, test->ctl);
+	g_assert(test->dbus);
+	ofono_cell_info_unref(info);
+
+	/* Submit GetCells to enable the signals */
+	test_submit_cell_info_call(test->context.client_connection, "GetCells",
+					test_many_cells_reply, test);
+}
+
+static void test_many_cells(void)
+{
+	struct test_many_cells_data test;
+	guint timeout = test_setup_timeout();
+
+	memset(&test, 0, sizeof(test));
+	test.modem.path = TEST_MODEM_PATH;
+	test.context.start = test_many_cells_start;
+	test_dbus_setup(&test.context);
+
+	g_main_loop_run(test.context.loop);
+	g_assert_cmpint(test.round, ==, TEST_MANY_CELLS_ROUNDS);
+
+	cell_info_control_unref(test.ctl);
+	cell_info_dbus_free(test.dbus);
+	test_dbus_shutdown(&test.context);
+	if (timeout) {
+		g_source_remove(timeout);
+	}
+}
+
 #define TEST_(name) "/cell-info-dbus/" name
 
 int main(int argc, char *argv[])
@@ -1182,6 +1548,8 @@ int main(int argc, char *argv[])
 	g_test_add_func(TEST_("RegisteredChanged"), test_registered_changed);
 	g_test_add_func(TEST_("PropertyChanged"), test_property_changed);
 	g_test_add_func(TEST_("Unsubscribe"), test_unsubscribe);
+	g_test_add_func(TEST_("SubscribeDelta"), test_subscribe_delta);
+	g_test_add_func(TEST_("ManyCells"), test_many_cells);
 
 	return g_test_run();
 }
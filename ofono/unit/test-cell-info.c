@@ -260,6 +260,68 @@ static void test_compare(void)
 	g_assert(!ofono_cell_compare_location(&c1, &c2));
 }
 
+/* ==== hash ==== */
+
+static void test_hash_same(const struct ofono_cell *c1,
+					const struct ofono_cell *c2)
+{
+	/* Cells with the same location have the same hash */
+	g_assert(!ofono_cell_compare_location(c1, c2));
+	g_assert_cmpuint(ofono_cell_hash_location(c1), ==,
+					ofono_cell_hash_location(c2));
+}
+
+static void test_hash_differ(const struct ofono_cell *c1,
+					const struct ofono_cell *c2)
+{
+	g_assert(ofono_cell_compare_location(c1, c2));
+	g_assert_cmpuint(ofono_cell_hash_location(c1), !=,
+					ofono_cell_hash_location(c2));
+}
+
+static void test_hash(void)
+{
+	struct ofono_cell c1, c2;
+
+	memset(&c1, 0, sizeof(c1));
+	g_assert(!ofono_cell_hash_location(NULL));
+
+	c1.type = OFONO_CELL_TYPE_GSM;
+	c1.info.gsm.cid = 1;
+	c2 = c1;
+	c2.info.gsm.signalStrength++;
+	c2.registered = TRUE;
+	test_hash_same(&c1, &c2);
+	c2 = c1;
+	c2.info.gsm.cid++;
+	test_hash_differ(&c1, &c2);
+
+	c1.type = OFONO_CELL_TYPE_WCDMA;
+	c2 = c1;
+	c2.info.wcdma.psc++;
+	test_hash_same(&c1, &c2);
+
+	c1.type = OFONO_CELL_TYPE_LTE;
+	c2 = c1;
+	c2.info.lte.rsrp++;
+	test_hash_same(&c1, &c2);
+	c2 = c1;
+	c2.info.lte.pci++;
+	test_hash_differ(&c1, &c2);
+
+	/* NCI is 36 bits, the upper ones count too */
+	c1.type = OFONO_CELL_TYPE_NR;
+	c1.info.nr.nci = 0x100000000LL;
+	c2 = c1;
+	c2.info.nr.ssRsrp++;
+	test_hash_same(&c1, &c2);
+	c2 = c1;
+	c2.info.nr.nci <<= 1;
+	test_hash_differ(&c1, &c2);
+	g_assert_cmpint(ofono_cell_compare_location(&c1, &c2), <, 0);
+	g_assert_cmpint(ofono_cell_compare_location(&c2, &c1), >, 0);
+}
+
 #define TEST_(name) "/cell-info/" name
 
 int main(int argc, char *argv[])
@@ -275,6 +337,7 @@ int main(int argc, char *argv[])
 
 	g_test_add_func(TEST_("basic"), test_basic);
 	g_test_add_func(TEST_("compare"), test_compare);
+	g_test_add_func(TEST_("hash"), test_hash);
 
 	return g_test_run();
 }
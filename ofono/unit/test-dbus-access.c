@@ -40,6 +40,15 @@ static enum ofono_dbus_access broken_method_access(const char *sender,
 	return (enum ofono_dbus_access)(-1);
 }
 
+static int counting_method_access_count = 0;
+
+static enum ofono_dbus_access counting_method_access(const char *sender,
+	enum ofono_dbus_access_intf intf, int method, const char *arg)
+{
+	counting_method_access_count++;
+	return OFONO_DBUS_ACCESS_DONT_CARE;
+}
+
 struct ofono_dbus_access_plugin access_inval;
 struct ofono_dbus_access_plugin access_dontcare = {
 	.name = "DontCare",
@@ -63,6 +72,12 @@ struct ofono_dbus_access_plugin access_broken = {
 	.method_access = broken_method_access
 };
 
+struct ofono_dbus_access_plugin access_counting = {
+	.name = "Counting",
+	.priority = OFONO_DBUS_ACCESS_PRIORITY_HIGH,
+	.method_access = counting_method_access
+};
+
 /*==========================================================================*
  * Tests
  *==========================================================================*/
@@ -187,6 +202,58 @@ static void test_register()
 	ofono_dbus_access_plugin_unregister(&access_dontcare);
 }
 
+static void test_cache()
+{
+	const enum ofono_dbus_access_intf intf =
+		OFONO_DBUS_ACCESS_INTF_MESSAGEMGR;
+	const int method = OFONO_DBUS_ACCESS_MESSAGEMGR_SEND_MESSAGE;
+
+	counting_method_access_count = 0;
+	g_assert(!ofono_dbus_access_plugin_register(&access_counting));
+
+	/* Second call is served from the cache */
+	g_assert(ofono_dbus_access_method_allowed(":1.0", intf, method, NULL));
+	g_assert(ofono_dbus_access_method_allowed(":1.0", intf, method, NULL));
+	g_assert_cmpint(counting_method_access_count, == ,1);
+
+	/* Different arg, method or sender are evaluated separately */
+	g_assert(ofono_dbus_access_method_allowed(":1.0", intf, method, "x"));
+	g_assert(ofono_dbus_access_method_allowed(":1.0", intf, method, "x"));
+	g_assert(ofono_dbus_access_method_allowed(":1.0", intf, method + 1,
+								NULL));
+	g_assert(ofono_dbus_access_method_allowed(":1.1", intf, method, NULL));
+	g_assert_cmpint(counting_method_access_count, == ,4);
+
+	/* Well-known names and NULL sender are never cached */
+	g_assert(ofono_dbus_access_method_allowed("foo", intf, method, NULL));
+	g_assert(ofono_dbus_access_method_allowed("foo", intf, method, NULL));
+	g_assert(ofono_dbus_access_method_allowed(NULL, intf, method, NULL));
+	g_assert(ofono_dbus_access_method_allowed(NULL, intf, method, NULL));
+	g_assert_cmpint(counting_method_access_count, == ,8);
+
+	/* Sender is gone */
+	__ofono_dbus_access_name_owner_changed(NULL);
+	__ofono_dbus_access_name_owner_changed(":1.2");
+	__ofono_dbus_access_name_owner_changed(":1.0");
+	g_assert(ofono_dbus_access_method_allowed(":1.0", intf, method, NULL));
+	g_assert(ofono_dbus_access_method_allowed(":1.1", intf, method, NULL));
+	g_assert_cmpint(counting_method_access_count, == ,9);
+
+	/* Registering another plugin flushes the cache */
+	g_assert(!ofono_dbus_access_plugin_register(&access_deny));
+	g_assert(!ofono_dbus_access_method_allowed(":1.1", intf, method, NULL));
+	g_assert(!ofono_dbus_access_method_allowed(":1.1", intf, method, NULL));
+	g_assert_cmpint(counting_method_access_count, == ,10);
+
+	/* And so does unregistering */
+	ofono_dbus_access_plugin_unregister(&access_deny);
+	g_assert(ofono_dbus_access_method_allowed(":1.1", intf, method, NULL));
+	g_assert_cmpint(counting_method_access_count, == ,11);
+
+	ofono_dbus_access_plugin_unregister(&access_counting);
+	__ofono_dbus_access_name_owner_changed(":1.1");
+}
+
 #define TEST_(test) "/dbus-access/" test
 
 int main(int argc, char *argv[])
@@ -208,6 +275,7 @@ int main(int argc, char *argv[])
 		g_free(name);
 	}
 	g_test_add_func(TEST_("register"), test_register);
+	g_test_add_func(TEST_("cache"), test_cache);
 	return g_test_run();
 }
 
@@ -0,0 +1,374 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <glib.h>
+
+#include "gatserver.h"
+
+/* Enough info text to spill over several write buffers */
+#define BIG_LINES 5
+#define BIG_LINE_SIZE 2000
+
+struct test_data {
+	GAtServer *server;
+	int fd;				/* Our end of the socket pair */
+	GString *rx;
+	unsigned int commands;
+};
+
+static void test_data_init(struct test_data *td)
+{
+	GIOChannel *io;
+	int sv[2];
+
+	g_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+	g_assert(fcntl(sv[1], F_SETFL, O_NONBLOCK) == 0);
+
+	io = g_io_channel_unix_new(sv[0]);
+	g_io_channel_set_close_on_unref(io, TRUE);
+
+	td->server = g_at_server_new(io);
+	g_assert(td->server);
+	g_at_server_set_echo(td->server, FALSE);
+	g_io_channel_unref(io);
+
+	td->fd = sv[1];
+	td->rx = g_string_new(NULL);
+	td->commands = 0;
+}
+
+static void test_data_cleanup(struct test_data *td)
+{
+	g_at_server_unref(td->server);
+	g_string_free(td->rx, TRUE);
+	close(td->fd);
+}
+
+static void test_send(struct test_data *td, const char *cmd)
+{
+	const size_t len = strlen(cmd);
+
+	g_assert_cmpint(write(td->fd, cmd, len), ==, len);
+}
+
+/* Runs the main loop until the expected output has arrived */
+static void test_expect(struct test_data *td, const char *expect)
+{
+	const size_t len = strlen(expect);
+
+	while (td->rx->len < len) {
+		char buf[512];
+		ssize_t n = read(td->fd, buf, sizeof(buf));
+
+		if (n > 0)
+			g_string_append_len(td->rx, buf, n);
+		else if (n < 0 && errno == EAGAIN)
+			g_main_context_iteration(NULL, TRUE);
+		else
+			g_assert_not_reached();
+	}
+
+	g_assert_cmpstr(td->rx->str, ==, expect);
+	g_string_truncate(td->rx, 0);
+}
+
+static void brsf_cb(GAtServer *server, GAtServerRequestType type,
+					GAtResult *result, gpointer user_data)
+{
+	struct test_data *td = user_data;
+
+	td->commands++;
+	g_assert(type == G_AT_SERVER_REQUEST_TYPE_SET);
+	g_at_server_send_info(server, "+BRSF: 871", TRUE);
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void cind_cb(GAtServer *server, GAtServerRequestType type,
+					GAtResult *result, gpointer user_data)
+{
+	struct test_data *td = user_data;
+
+	td->commands++;
+
+	if (type == G_AT_SERVER_REQUEST_TYPE_SUPPORT)
+		g_at_server_send_info(server, "+CIND: (\"service\",(0,1)),"
+					"(\"call\",(0,1)),(\"callsetup\",(0-3))",
+					TRUE);
+	else
+		g_at_server_send_info(server, "+CIND: 1,0,0", TRUE);
+
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void ok_cb(GAtServer *server, GAtServerRequestType type,
+					GAtResult *result, gpointer user_data)
+{
+	struct test_data *td = user_data;
+
+	td->commands++;
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void test_data_register(struct test_data *td)
+{
+	g_at_server_register(td->server, "+BRSF", brsf_cb, td, NULL);
+	g_at_server_register(td->server, "+CIND", cind_cb, td, NULL);
+	g_at_server_register(td->server, "+CMER", ok_cb, td, NULL);
+	g_at_server_register(td->server, "+CHLD", ok_cb, td, NULL);
+	g_at_server_register(td->server, "+NREC", ok_cb, td, NULL);
+	g_at_server_register(td->server, "A", ok_cb, td, NULL);
+	g_at_server_register(td->server, "&W", ok_cb, td, NULL);
+}
+
+static void test_slc(struct test_data *td)
+{
+	test_send(td, "AT+BRSF=127\r");
+	test_expect(td, "\r\n+BRSF: 871\r\n\r\nOK\r\n");
+	test_send(td, "AT+CIND=?\r");
+	test_expect(td, "\r\n+CIND: (\"service\",(0,1)),(\"call\",(0,1)),"
+				"(\"callsetup\",(0-3))\r\n\r\nOK\r\n");
+	test_send(td, "AT+CIND?\r");
+	test_expect(td, "\r\n+CIND: 1,0,0\r\n\r\nOK\r\n");
+	test_send(td, "AT+CMER=3,0,0,1\r");
+	test_expect(td, "\r\nOK\r\n");
+	test_send(td, "AT+CHLD=?\r");
+	test_expect(td, "\r\nOK\r\n");
+}
+
+static void test_basic(void)
+{
+	struct test_data td;
+
+	test_data_init(&td);
+	test_data_register(&td);
+
+	/* Basic commands, including a chain of them on one line */
+	test_send(&td, "ATA\r");
+	test_expect(&td, "\r\nOK\r\n");
+	test_send(&td, "AT&W\r");
+	test_expect(&td, "\r\nOK\r\n");
+	test_send(&td, "ATE0&C1&D2Q0\r");
+	test_expect(&td, "\r\nOK\r\n");
+	test_send(&td, "ATB\r");
+	test_expect(&td, "\r\nERROR\r\n");
+	g_assert_cmpuint(td.commands, ==, 2);
+
+	/* Unregistering has to take the command out of the fast path */
+	g_assert(g_at_server_unregister(td.server, "A"));
+	g_assert(!g_at_server_unregister(td.server, "A"));
+	test_send(&td, "ATA\r");
+	test_expect(&td, "\r\nERROR\r\n");
+	g_assert_cmpuint(td.commands, ==, 2);
+
+	/* And registering again has to put it back */
+	g_assert(g_at_server_register(td.server, "A", ok_cb, &td, NULL));
+	test_send(&td, "ATA\r");
+	test_expect(&td, "\r\nOK\r\n");
+	g_assert_cmpuint(td.commands, ==, 3);
+
+	/* Repeat the last line */
+	test_send(&td, "A/");
+	test_expect(&td, "\r\nOK\r\n");
+	g_assert_cmpuint(td.commands, ==, 4);
+
+	test_data_cleanup(&td);
+}
+
+static void test_hfp(void)
+{
+	struct test_data td;
+
+	test_data_init(&td);
+	test_data_register(&td);
+	test_slc(&td);
+	g_assert_cmpuint(td.commands, ==, 5);
+
+	/* A longer line after shorter ones, and the other way around */
+	test_send(&td, "AT+NREC=0;+CMER=3,0,0,1;&W;+CHLD=?\r");
+	test_expect(&td, "\r\nOK\r\n");
+	test_send(&td, "ATA\r");
+	test_expect(&td, "\r\nOK\r\n");
+	g_assert_cmpuint(td.commands, ==, 10);
+
+	g_at_server_send_unsolicited(td.server, "+CIEV: 2,1");
+	test_expect(&td, "\r\n+CIEV: 2,1\r\n");
+
+	test_data_cleanup(&td);
+}
+
+struct test_tag {
+	unsigned int calls;
+	unsigned int destroyed;
+};
+
+static void tag_cb(GAtServer *server, GAtServerRequestType type,
+					GAtResult *result, gpointer user_data)
+{
+	struct test_tag *tag = user_data;
+
+	tag->calls++;
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void tag_destroy(gpointer user_data)
+{
+	struct test_tag *tag = user_data;
+
+	tag->destroyed++;
+}
+
+static void test_basic_slot(void)
+{
+	struct test_data td;
+	struct test_tag tag1 = { 0, 0 };
+	struct test_tag tag2 = { 0, 0 };
+	struct test_tag tag3 = { 0, 0 };
+
+	test_data_init(&td);
+
+	g_assert(g_at_server_register(td.server, "H", tag_cb, &tag1,
+							tag_destroy));
+	test_send(&td, "ATH\r");
+	test_expect(&td, "\r\nOK\r\n");
+	g_assert_cmpuint(tag1.calls, ==, 1);
+
+	/* Replacing the command must not leave the old one in its slot */
+	g_assert(g_at_server_register(td.server, "H", tag_cb, &tag2,
+							tag_destroy));
+	g_assert_cmpuint(tag1.destroyed, ==, 1);
+	test_send(&td, "ATH\r");
+	test_expect(&td, "\r\nOK\r\n");
+	g_assert_cmpuint(tag1.calls, ==, 1);
+	g_assert_cmpuint(tag2.calls, ==, 1);
+
+	/* H and &H live in different slots */
+	g_assert(g_at_server_register(td.server, "&H", tag_cb, &tag3,
+							tag_destroy));
+	test_send(&td, "ATH&H\r");
+	test_expect(&td, "\r\nOK\r\n");
+	g_assert_cmpuint(tag2.calls, ==, 2);
+	g_assert_cmpuint(tag3.calls, ==, 1);
+
+	/* Unregistering one of them leaves the other one alone */
+	g_assert(g_at_server_unregister(td.server, "H"));
+	g_assert_cmpuint(tag2.destroyed, ==, 1);
+	test_send(&td, "ATH\r");
+	test_expect(&td, "\r\nERROR\r\n");
+	test_send(&td, "AT&H\r");
+	test_expect(&td, "\r\nOK\r\n");
+	g_assert_cmpuint(tag2.calls, ==, 2);
+	g_assert_cmpuint(tag3.calls, ==, 2);
+
+	/* The slots are cleared together with the command list */
+	test_data_cleanup(&td);
+	g_assert_cmpuint(tag1.destroyed, ==, 1);
+	g_assert_cmpuint(tag2.destroyed, ==, 1);
+	g_assert_cmpuint(tag3.destroyed, ==, 1);
+}
+
+static char *big_line(unsigned int round, unsigned int line)
+{
+	char *text = g_strnfill(BIG_LINE_SIZE, 'a' + (round + line) % 26);
+
+	/* Number the lines so that reordering shows up too */
+	text[0] = '0' + line;
+	return text;
+}
+
+static void big_cb(GAtServer *server, GAtServerRequestType type,
+					GAtResult *result, gpointer user_data)
+{
+	struct test_data *td = user_data;
+	unsigned int i;
+
+	for (i = 0; i < BIG_LINES; i++) {
+		char *text = big_line(td->commands, i);
+
+		g_at_server_send_info(server, text, TRUE);
+		g_free(text);
+	}
+
+	td->commands++;
+	g_at_server_send_final(server, G_AT_SERVER_RESULT_OK);
+}
+
+static void test_write_pool(void)
+{
+	struct test_data td;
+	unsigned int round;
+
+	test_data_init(&td);
+	g_at_server_register(td.server, "+BIG", big_cb, &td, NULL);
+
+	/*
+	 * Each response takes several write buffers. The drained ones
+	 * are recycled for the next response which must still come out
+	 * complete and in order.
+	 */
+	for (round = 0; round < 4; round++) {
+		GString *expect = g_string_new(NULL);
+		unsigned int i;
+
+		for (i = 0; i < BIG_LINES; i++) {
+			char *text = big_line(round, i);
+
+			g_string_append_printf(expect, "\r\n%s\r\n", text);
+			g_free(text);
+		}
+
+		g_string_append(expect, "\r\nOK\r\n");
+
+		test_send(&td, "AT+BIG\r");
+		test_expect(&td, expect->str);
+		g_string_free(expect, TRUE);
+
+		/* Something short in between */
+		g_at_server_send_unsolicited(td.server, "+CIEV: 2,1");
+		test_expect(&td, "\r\n+CIEV: 2,1\r\n");
+	}
+
+	g_assert_cmpuint(td.commands, ==, 4);
+	test_data_cleanup(&td);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/testgatserver/basic", test_basic);
+	g_test_add_func("/testgatserver/hfp", test_hfp);
+	g_test_add_func("/testgatserver/basic_slot", test_basic_slot);
+	g_test_add_func("/testgatserver/write_pool", test_write_pool);
+
+	return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
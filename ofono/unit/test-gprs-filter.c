@@ -1084,6 +1084,199 @@ static void test_priorities2(void)
 	test_common_deinit();
 }
 
+/* ==== sync1 ==== */
+
+#define TEST_SYNC_FILTERS (12)
+
+static unsigned int test_sync_activate(struct ofono_gprs_context *gc,
+			const struct ofono_gprs_primary_context *ctx,
+			ofono_gprs_filter_activate_cb_t cb, void *user_data)
+{
+	struct ofono_gprs_primary_context next = *ctx;
+
+	/* Each filter sees what the previous one has done */
+	g_assert(ctx->cid == (unsigned int) test_filter_activate_count);
+	test_filter_activate_count++;
+	next.cid++;
+	cb(&next, user_data);
+	return 0;
+}
+
+static void test_sync1_cb(const struct ofono_gprs_primary_context *ctx,
+								void *data)
+{
+	g_assert(ctx);
+	g_assert(ctx->cid == TEST_SYNC_FILTERS);
+	g_assert(test_filter_activate_count == TEST_SYNC_FILTERS);
+	(*(int*)data)++;
+	g_main_loop_quit(test_loop);
+}
+
+static void test_sync1(void)
+{
+	static const char *names[TEST_SYNC_FILTERS] = {
+		"sync00", "sync01", "sync02", "sync03", "sync04", "sync05",
+		"sync06", "sync07", "sync08", "sync09", "sync10", "sync11"
+	};
+
+	struct ofono_gprs_filter filters[TEST_SYNC_FILTERS];
+	int i, count = 0;
+	struct ofono_gprs gprs;
+	struct ofono_gprs_context gc;
+	struct ofono_gprs_primary_context *ctx = &gc.ctx;
+
+	test_common_init();
+	test_gprs_init(&gprs, &gc);
+
+	/* More filters than can be run in one go */
+	memset(filters, 0, sizeof(filters));
+	for (i = 0; i < TEST_SYNC_FILTERS; i++) {
+		filters[i].name = names[i];
+		filters[i].api_version = OFONO_GPRS_FILTER_API_VERSION;
+		filters[i].filter_activate = test_sync_activate;
+		g_assert(ofono_gprs_filter_register(filters + i) == 0);
+	}
+
+	g_assert((gprs.chain = __ofono_gprs_filter_chain_new(&gprs)) != NULL);
+	__ofono_gprs_filter_chain_activate(gprs.chain, &gc, ctx,
+					test_sync1_cb, NULL, &count);
+
+	/* Completion is never invoked from under the caller */
+	g_assert(test_filter_activate_count == 1);
+	g_assert(!count);
+
+	g_main_loop_run(test_loop);
+	g_assert(count == 1);
+
+	__ofono_gprs_filter_chain_free(gprs.chain);
+	for (i = 0; i < TEST_SYNC_FILTERS; i++) {
+		ofono_gprs_filter_unregister(filters + i);
+	}
+	test_common_deinit();
+}
+
+/* ==== sync_dispatch ==== */
+
+#define TEST_SYNC_DISPATCH_FILTERS (4)
+
+static void test_sync_dispatch_cb(const struct ofono_gprs_primary_context *ctx,
+								void *data)
+{
+	g_assert(ctx);
+	g_assert(ctx->cid == TEST_SYNC_DISPATCH_FILTERS);
+	(*(int*)data)++;
+}
+
+static void test_sync_dispatch(void)
+{
+	static const char *names[TEST_SYNC_DISPATCH_FILTERS] = {
+		"sync0", "sync1", "sync2", "sync3"
+	};
+
+	struct ofono_gprs_filter filters[TEST_SYNC_DISPATCH_FILTERS];
+	int i, count = 0;
+	struct ofono_gprs gprs;
+	struct ofono_gprs_context gc;
+	struct ofono_gprs_primary_context *ctx = &gc.ctx;
+
+	test_common_init();
+	test_gprs_init(&gprs, &gc);
+
+	/* Few enough filters to be run in one go */
+	memset(filters, 0, sizeof(filters));
+	for (i = 0; i < TEST_SYNC_DISPATCH_FILTERS; i++) {
+		filters[i].name = names[i];
+		filters[i].api_version = OFONO_GPRS_FILTER_API_VERSION;
+		filters[i].filter_activate = test_sync_activate;
+		g_assert(ofono_gprs_filter_register(filters + i) == 0);
+	}
+
+	g_assert((gprs.chain = __ofono_gprs_filter_chain_new(&gprs)) != NULL);
+	__ofono_gprs_filter_chain_activate(gprs.chain, &gc, ctx,
+				test_sync_dispatch_cb, test_inc, &count);
+	g_assert(test_filter_activate_count == 1);
+	g_assert(!count);
+
+	/* The rest of the chain takes a single dispatch, no idle hops */
+	g_assert(g_main_context_iteration(NULL, FALSE));
+	g_assert(test_filter_activate_count == TEST_SYNC_DISPATCH_FILTERS);
+	g_assert(count == 2); /* test_sync_dispatch_cb and test_inc */
+	g_assert(!g_main_context_pending(NULL));
+
+	__ofono_gprs_filter_chain_free(gprs.chain);
+	for (i = 0; i < TEST_SYNC_DISPATCH_FILTERS; i++) {
+		ofono_gprs_filter_unregister(filters + i);
+	}
+	test_common_deinit();
+}
+
+/* ==== sync2 ==== */
+
+static unsigned int test_sync2_activate(struct ofono_gprs_context *gc,
+			const struct ofono_gprs_primary_context *ctx,
+			ofono_gprs_filter_activate_cb_t cb, void *user_data)
+{
+	struct ofono_gprs *gprs = gc->gprs;
+
+	/* The request gets cancelled in the middle of synchronous run */
+	test_filter_cancel_count++;
+	__ofono_gprs_filter_chain_free(gprs->chain);
+	gprs->chain = NULL;
+	g_idle_add(test_quit_cb, NULL);
+	return 0;
+}
+
+static void test_sync2(void)
+{
+	static struct ofono_gprs_filter first = {
+		.name = "first",
+		.api_version = OFONO_GPRS_FILTER_API_VERSION,
+		.priority = OFONO_GPRS_FILTER_PRIORITY_HIGH,
+		.filter_activate = filter_activate_continue
+	};
+
+	static struct ofono_gprs_filter second = {
+		.name = "second",
+		.api_version = OFONO_GPRS_FILTER_API_VERSION,
+		.priority = OFONO_GPRS_FILTER_PRIORITY_DEFAULT,
+		.filter_activate = test_sync2_activate
+	};
+
+	static struct ofono_gprs_filter third = {
+		.name = "third",
+		.api_version = OFONO_GPRS_FILTER_API_VERSION,
+		.priority = OFONO_GPRS_FILTER_PRIORITY_LOW,
+		.filter_activate = filter_activate_continue
+	};
+
+	int count = 0;
+	struct ofono_gprs gprs;
+	struct ofono_gprs_context gc;
+	struct ofono_gprs_primary_context *ctx = &gc.ctx;
+
+	test_common_init();
+	test_gprs_init(&gprs, &gc);
+
+	g_assert(ofono_gprs_filter_register(&first) == 0);
+	g_assert(ofono_gprs_filter_register(&second) == 0);
+	g_assert(ofono_gprs_filter_register(&third) == 0);
+	g_assert((gprs.chain = __ofono_gprs_filter_chain_new(&gprs)) != NULL);
+
+	/* Completion callback is not invoked, only the destroy one */
+	__ofono_gprs_filter_chain_activate(gprs.chain, &gc, ctx,
+				test_activate_expect_allow, test_inc, &count);
+	g_main_loop_run(test_loop);
+	g_assert(!gprs.chain);
+	g_assert(count == 1); /* test_inc */
+	g_assert(test_filter_activate_count == 1);
+	g_assert(test_filter_cancel_count == 1);
+
+	ofono_gprs_filter_unregister(&first);
+	ofono_gprs_filter_unregister(&second);
+	ofono_gprs_filter_unregister(&third);
+	test_common_deinit();
+}
+
 #define TEST_(name) "/gprs-filter/" name
 
 int main(int argc, char *argv[])
@@ -1120,6 +1313,9 @@ int main(int argc, char *argv[])
 	g_test_add_func(TEST_("cancel6"), test_cancel6);
 	g_test_add_func(TEST_("priorities1"), test_priorities1);
 	g_test_add_func(TEST_("priorities2"), test_priorities2);
+	g_test_add_func(TEST_("sync1"), test_sync1);
+	g_test_add_func(TEST_("sync_dispatch"), test_sync_dispatch);
+	g_test_add_func(TEST_("sync2"), test_sync2);
 
 	return g_test_run();
 }
@@ -0,0 +1,286 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+
+#include "ofono.h"
+
+#define TEST_(name) "/log/" name
+
+/* Enough to fill the pipe, the ring and then some */
+#define TEST_MESSAGES 5000
+#define TEST_TIMEOUT_US (10 * G_USEC_PER_SEC)
+#define TEST_LONG_TEXT_SIZE 40000
+
+/*
+ * The sink writes into a FIFO which we read ourselves. Until we start
+ * reading, the log thread gets stuck in write() once the pipe is full,
+ * which lets the ring fill up deterministically.
+ */
+struct test_sink {
+	char *dir;
+	char *fifo;
+	int fd;
+	GString *rx;
+};
+
+static void test_sink_start(struct test_sink *sink)
+{
+	sink->dir = g_dir_make_tmp("test-log-XXXXXX", NULL);
+	g_assert(sink->dir);
+	sink->fifo = g_build_filename(sink->dir, "log", NULL);
+	g_assert(mkfifo(sink->fifo, 0600) == 0);
+
+	/* The reader must be there before the sink opens it for writing */
+	sink->fd = open(sink->fifo, O_RDONLY | O_NONBLOCK);
+	g_assert(sink->fd >= 0);
+	sink->rx = g_string_new(NULL);
+
+	g_assert(__ofono_log_start(sink->fifo) == 0);
+	g_assert(__ofono_log_start(sink->fifo) == -EALREADY);
+}
+
+static void test_sink_stop(struct test_sink *sink)
+{
+	__ofono_log_cleanup(FALSE);
+
+	close(sink->fd);
+	unlink(sink->fifo);
+	rmdir(sink->dir);
+	g_string_free(sink->rx, TRUE);
+	g_free(sink->fifo);
+	g_free(sink->dir);
+}
+
+/* Waits for the next complete line */
+static char *test_sink_line(struct test_sink *sink, gint64 deadline)
+{
+	while (TRUE) {
+		char *end = strchr(sink->rx->str, '\n');
+		char buf[4096];
+		ssize_t n;
+
+		if (end) {
+			char *line = g_strndup(sink->rx->str,
+						end - sink->rx->str);
+
+			g_string_erase(sink->rx, 0, end - sink->rx->str + 1);
+			return line;
+		}
+
+		n = read(sink->fd, buf, sizeof(buf));
+		if (n > 0) {
+			g_string_append_len(sink->rx, buf, n);
+		} else {
+			g_assert(n < 0 && errno == EAGAIN);
+			g_assert(g_get_monotonic_time() < deadline);
+			g_usleep(1000);
+		}
+	}
+}
+
+/* ==== overflow ==== */
+
+static void test_overflow(void)
+{
+	const gint64 deadline = g_get_monotonic_time() + TEST_TIMEOUT_US;
+	struct test_sink sink;
+	int received = 0;
+	int dropped = 0;
+	int last = -1;
+	int i;
+
+	__ofono_log_init("test-log", g_test_verbose() ? "*" : NULL,
+							TRUE, FALSE);
+	test_sink_start(&sink);
+
+	for (i = 0; i < TEST_MESSAGES; i++)
+		ofono_info("Message %d of %d, padded to make the lines a bit "
+			"longer so that the pipe fills up sooner", i,
+			TEST_MESSAGES);
+
+	/* Every message is either written out or counted as dropped */
+	while (received + dropped < TEST_MESSAGES) {
+		char *line = test_sink_line(&sink, deadline);
+		const char *msg = strstr(line, "Message ");
+		const char *drop = strstr(line, " log messages dropped");
+		int n;
+
+		if (msg) {
+			/* In order, with the ring wrapping around */
+			g_assert(sscanf(msg, "Message %d", &n) == 1);
+			g_assert_cmpint(n, >, last);
+			last = n;
+			received++;
+		} else if (drop) {
+			while (drop > line && g_ascii_isdigit(drop[-1]))
+				drop--;
+
+			n = atoi(drop);
+			g_assert_cmpint(n, >, 0);
+			dropped += n;
+		}
+
+		g_free(line);
+	}
+
+	g_assert_cmpint(received + dropped, ==, TEST_MESSAGES);
+	g_assert_cmpint(dropped, >, 0);
+
+	/* The log thread may not get to run before the ring fills up */
+	g_assert_cmpint(received, >=, 256);
+
+	/* Once drained, nothing gets dropped */
+	ofono_info("Done");
+	while (TRUE) {
+		char *line = test_sink_line(&sink, deadline);
+		gboolean done = g_str_has_suffix(line, ": Done");
+
+		g_assert(!strstr(line, "dropped"));
+		g_free(line);
+		if (done)
+			break;
+	}
+
+	test_sink_stop(&sink);
+}
+
+/* ==== long_text ==== */
+
+static void test_long_text(void)
+{
+	const gint64 deadline = g_get_monotonic_time() + TEST_TIMEOUT_US;
+	char *text = g_malloc(TEST_LONG_TEXT_SIZE + 1);
+	struct test_sink sink;
+	char *line;
+
+	memset(text, 'x', TEST_LONG_TEXT_SIZE);
+	text[TEST_LONG_TEXT_SIZE] = 0;
+
+	__ofono_log_init("test-log", "*", TRUE, FALSE);
+	test_sink_start(&sink);
+
+	/* Too long for the write batch, and for a ring slot */
+	DBG("%s", text);
+	ofono_info("%s", text + TEST_LONG_TEXT_SIZE / 2);
+
+	line = test_sink_line(&sink, deadline);
+	g_assert(g_str_has_suffix(line, text));
+	g_free(line);
+
+	line = test_sink_line(&sink, deadline);
+	g_assert(g_str_has_suffix(line, text + TEST_LONG_TEXT_SIZE / 2));
+	g_assert(!g_str_has_suffix(line, text));
+	g_free(line);
+
+	test_sink_stop(&sink);
+	g_free(text);
+}
+
+/* ==== rotate ==== */
+
+/* Waits until the file contains the text */
+static void test_wait_file(const char *path, const char *text,
+							gint64 deadline)
+{
+	while (TRUE) {
+		char *data = NULL;
+		gboolean found = FALSE;
+
+		if (g_file_get_contents(path, &data, NULL, NULL))
+			found = strstr(data, text) != NULL;
+
+		g_free(data);
+		if (found)
+			break;
+
+		g_assert(g_get_monotonic_time() < deadline);
+		g_usleep(1000);
+	}
+}
+
+static void test_rotate(void)
+{
+	const gint64 deadline = g_get_monotonic_time() + TEST_TIMEOUT_US;
+	char *dir = g_dir_make_tmp("test-log-XXXXXX", NULL);
+	char *path = g_build_filename(dir, "log", NULL);
+	char *old = g_build_filename(dir, "log.1", NULL);
+	char *data;
+
+	__ofono_log_init("test-log", NULL, FALSE, FALSE);
+	g_assert(__ofono_log_start(path) == 0);
+
+	ofono_info("Before");
+	test_wait_file(path, ": Before", deadline);
+
+	/* The file gets renamed, the next message goes to a new one */
+	g_assert(rename(path, old) == 0);
+	ofono_info("After");
+	test_wait_file(path, ": After", deadline);
+
+	/* And again, this time it's simply removed */
+	g_assert(unlink(path) == 0);
+	ofono_info("Removed");
+	test_wait_file(path, ": Removed", deadline);
+
+	__ofono_log_cleanup(FALSE);
+
+	g_assert(g_file_get_contents(old, &data, NULL, NULL));
+	g_assert(strstr(data, ": Before"));
+	g_assert(!strstr(data, ": After"));
+	g_free(data);
+
+	g_assert(g_file_get_contents(path, &data, NULL, NULL));
+	g_assert(!strstr(data, ": After"));
+	g_free(data);
+
+	unlink(path);
+	unlink(old);
+	rmdir(dir);
+	g_free(path);
+	g_free(old);
+	g_free(dir);
+}
+
+int main(int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func(TEST_("overflow"), test_overflow);
+	g_test_add_func(TEST_("long_text"), test_long_text);
+	g_test_add_func(TEST_("rotate"), test_rotate);
+
+	return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
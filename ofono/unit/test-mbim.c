@@ -718,6 +718,155 @@ static void parse_ip_configuration_query(const void *data)
 	mbim_message_unref(msg);
 }
 
+static struct mbim_message *assemble_message(
+					struct mbim_message_assembly *assembly,
+					void **segment, const uint8_t *binary,
+					size_t binary_len, size_t frag_size)
+{
+	const size_t body_len = binary_len - 20;
+	const uint32_t n_frags = align_len(body_len, frag_size) / frag_size;
+	struct mbim_message *msg = NULL;
+	uint8_t header[20];
+	uint32_t i;
+
+	for (i = 0; i < n_frags; i++) {
+		size_t len = body_len - i * frag_size;
+
+		if (len > frag_size)
+			len = frag_size;
+
+		memcpy(header, binary, sizeof(header));
+		l_put_le32(sizeof(header) + len, header + 4);
+		l_put_le32(n_frags, header + 12);
+		l_put_le32(i, header + 16);
+		memcpy(*segment, binary + 20 + i * frag_size, len);
+
+		msg = _mbim_message_assembly_add(assembly, header, segment,
+									len);
+		assert(!msg == (i + 1 < n_frags));
+	}
+
+	return msg;
+}
+
+static void assemble_fragments(const void *data)
+{
+	const struct message_data *msg_data = data;
+	struct mbim_buffer_pool *pool = _mbim_buffer_pool_new(64);
+	struct mbim_message_assembly *assembly =
+					_mbim_message_assembly_new(pool);
+	void *segment = _mbim_buffer_pool_get(pool);
+	struct mbim_message *msg;
+
+	msg = assemble_message(assembly, &segment, msg_data->binary,
+						msg_data->binary_len, 16);
+	assert(msg);
+	assert(check_message(msg, msg_data));
+	mbim_message_unref(msg);
+
+	/* Single fragment message takes over the segment buffer */
+	msg = assemble_message(assembly, &segment,
+				message_binary_packet_service_notify,
+				sizeof(message_binary_packet_service_notify), 64);
+	assert(msg);
+	assert(mbim_message_get_cid(msg) == MBIM_CID_PACKET_SERVICE);
+
+	_mbim_message_assembly_free(assembly);
+	_mbim_buffer_pool_put(pool, segment);
+	_mbim_buffer_pool_unref(pool);
+
+	/* The message holds a reference to the pool */
+	mbim_message_unref(msg);
+}
+
+static void assemble_interleaved(const void *data)
+{
+	struct mbim_buffer_pool *pool = _mbim_buffer_pool_new(16);
+	struct mbim_message_assembly *assembly =
+					_mbim_message_assembly_new(pool);
+	void *segment = _mbim_buffer_pool_get(pool);
+	const struct message_data *msg_data = &message_data_device_caps;
+	uint8_t header1[20];
+	uint8_t header2[20];
+	struct mbim_message *msg;
+
+	/* Two transactions hashed into the same bucket */
+	memcpy(header1, msg_data->binary, sizeof(header1));
+	l_put_le32(sizeof(header1) + 16, header1 + 4);
+	l_put_le32(1, header1 + 8);
+	l_put_le32(2, header1 + 12);
+	l_put_le32(0, header1 + 16);
+
+	memcpy(header2, header1, sizeof(header2));
+	l_put_le32(17, header2 + 8);
+
+	memcpy(segment, msg_data->binary + 20, 16);
+	assert(!_mbim_message_assembly_add(assembly, header1, &segment, 16));
+	assert(!_mbim_message_assembly_add(assembly, header2, &segment, 16));
+
+	/* Out of order fragment is ignored */
+	assert(!_mbim_message_assembly_add(assembly, header2, &segment, 16));
+
+	l_put_le32(sizeof(header1) + 12, header2 + 4);
+	l_put_le32(1, header2 + 16);
+	memcpy(segment, msg_data->binary + 36, 12);
+	msg = _mbim_message_assembly_add(assembly, header2, &segment, 12);
+	assert(msg);
+	assert(mbim_message_get_cid(msg) == MBIM_CID_DEVICE_CAPS);
+	mbim_message_unref(msg);
+
+	/* The other one is still there, drop it along with the assembly */
+	_mbim_message_assembly_free(assembly);
+	_mbim_buffer_pool_put(pool, segment);
+	_mbim_buffer_pool_unref(pool);
+}
+
+static void assemble_repeated(const void *data)
+{
+	static const unsigned int n_messages = 100;
+	static const size_t frag_size = 4096 - 20;
+	static const size_t info_len = 16 * 1024;
+	const size_t binary_len = 20 + 24 + info_len;
+	struct mbim_buffer_pool *pool = _mbim_buffer_pool_new(frag_size);
+	struct mbim_message_assembly *assembly =
+					_mbim_message_assembly_new(pool);
+	void *segment = _mbim_buffer_pool_get(pool);
+	uint8_t *binary = l_malloc(binary_len);
+	unsigned int i;
+	size_t j;
+
+	/* Large fragmented indication, e.g. a batch of new SMS */
+	l_put_le32(MBIM_INDICATE_STATUS_MSG, binary);
+	l_put_le32(binary_len, binary + 4);
+	l_put_le32(0, binary + 8);
+	l_put_le32(1, binary + 12);
+	l_put_le32(0, binary + 16);
+	memcpy(binary + 20, mbim_uuid_sms, 16);
+	l_put_le32(MBIM_CID_SMS_READ, binary + 36);
+	l_put_le32(info_len, binary + 40);
+	for (j = 0; j < info_len; j++)
+		binary[44 + j] = j;
+
+	/* The same segments go around through the pool every time */
+	for (i = 0; i < n_messages; i++) {
+		struct mbim_message *msg = assemble_message(assembly, &segment,
+						binary, binary_len, frag_size);
+		size_t n_iov;
+		size_t len;
+		struct iovec *iov = _mbim_message_get_body(msg, &n_iov, &len);
+
+		assert(n_iov == 1);
+		assert(len == info_len);
+		assert(!memcmp(iov[0].iov_base, binary + 20, binary_len - 20));
+		mbim_message_unref(msg);
+	}
+
+	l_free(binary);
+	_mbim_message_assembly_free(assembly);
+	_mbim_buffer_pool_put(pool, segment);
+	_mbim_buffer_pool_unref(pool);
+}
+
 int main(int argc, char *argv[])
 {
 	l_test_init(&argc, &argv);
@@ -762,5 +911,12 @@ int main(int argc, char *argv[])
 				parse_ip_configuration_query,
 				&message_data_ip_configuration_query);
 
+	l_test_add("Fragmented Message (assembly)", assemble_fragments,
+			&message_data_device_caps);
+	l_test_add("Interleaved Transactions (assembly)",
+			assemble_interleaved, NULL);
+	l_test_add("Repeated Fragmented Indication (assembly)",
+			assemble_repeated, NULL);
+
 	return l_test_run();
 }
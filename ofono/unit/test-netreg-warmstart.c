@@ -0,0 +1,173 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <ofono/netreg.h>
+
+#include "netreg-warmstart.h"
+
+#define TEST_(name) "/netreg-warmstart/" name
+
+/* Offsets in the encoded snapshot */
+#define TEST_STATUS 1
+#define TEST_TECH 2
+#define TEST_MCC 3
+#define TEST_NAMELEN (TEST_MCC + OFONO_MAX_MCC_LENGTH + OFONO_MAX_MNC_LENGTH)
+#define TEST_HEADER_SIZE (TEST_NAMELEN + 1)
+
+static void test_init(struct netreg_warmstart *ws, int status, int tech,
+			const char *mcc, const char *mnc, const char *name)
+{
+	memset(ws, 0, sizeof(*ws));
+	ws->status = status;
+	ws->technology = tech;
+	g_strlcpy(ws->mcc, mcc, sizeof(ws->mcc));
+	g_strlcpy(ws->mnc, mnc, sizeof(ws->mnc));
+	g_strlcpy(ws->name, name, sizeof(ws->name));
+}
+
+static void test_assert_equal(const struct netreg_warmstart *a,
+				const struct netreg_warmstart *b)
+{
+	g_assert_cmpint(a->status, ==, b->status);
+	g_assert_cmpint(a->technology, ==, b->technology);
+	g_assert_cmpstr(a->mcc, ==, b->mcc);
+	g_assert_cmpstr(a->mnc, ==, b->mnc);
+	g_assert_cmpstr(a->name, ==, b->name);
+}
+
+/* ==== roundtrip ==== */
+
+static void test_roundtrip(void)
+{
+	unsigned char buf[NETREG_WARMSTART_MAX_SIZE];
+	struct netreg_warmstart ws, out;
+	unsigned int len;
+
+	test_init(&ws, OFONO_NETREG_STATUS_REGISTERED,
+			OFONO_ACCESS_TECHNOLOGY_EUTRAN, "244", "91", "Telia");
+	len = netreg_warmstart_encode(&ws, buf);
+	g_assert_cmpuint(len, ==, TEST_HEADER_SIZE + 5);
+	g_assert(netreg_warmstart_decode(&out, buf, len));
+	test_assert_equal(&ws, &out);
+
+	/* Roaming with a three digit MNC and unknown technology */
+	test_init(&ws, OFONO_NETREG_STATUS_ROAMING, -1, "310", "260",
+								"T-Mobile");
+	len = netreg_warmstart_encode(&ws, buf);
+	g_assert_cmpuint(buf[TEST_TECH], ==, 0xff);
+	g_assert(netreg_warmstart_decode(&out, buf, len));
+	test_assert_equal(&ws, &out);
+
+	/* Empty name */
+	test_init(&ws, OFONO_NETREG_STATUS_REGISTERED, -1, "244", "05", "");
+	len = netreg_warmstart_encode(&ws, buf);
+	g_assert_cmpuint(len, ==, TEST_HEADER_SIZE);
+	g_assert(netreg_warmstart_decode(&out, buf, len));
+	test_assert_equal(&ws, &out);
+}
+
+/* ==== name ==== */
+
+static void test_name(void)
+{
+	unsigned char buf[NETREG_WARMSTART_MAX_SIZE];
+	struct netreg_warmstart ws, out;
+	unsigned int len;
+	char *name;
+
+	/* Name is cut on a character boundary, not in the middle of one */
+	name = g_strnfill(NETREG_WARMSTART_MAX_NAME_LENGTH - 1, 'x');
+	test_init(&ws, OFONO_NETREG_STATUS_REGISTERED, -1, "244", "91", "");
+	strcpy(ws.name, name);
+	strcat(ws.name, "\xc3");	/* First half of "ä" */
+	len = netreg_warmstart_encode(&ws, buf);
+	g_assert_cmpuint(buf[TEST_NAMELEN], ==, strlen(name));
+	g_assert(netreg_warmstart_decode(&out, buf, len));
+	g_assert_cmpstr(out.name, ==, name);
+	g_free(name);
+
+	/* Invalid UTF-8 in the file is dropped */
+	test_init(&ws, OFONO_NETREG_STATUS_REGISTERED, -1, "244", "91",
+								"Elisa");
+	len = netreg_warmstart_encode(&ws, buf);
+	buf[TEST_HEADER_SIZE + 3] = 0xff;
+	g_assert(netreg_warmstart_decode(&out, buf, len));
+	g_assert_cmpstr(out.name, ==, "Eli");
+}
+
+/* ==== invalid ==== */
+
+static void test_invalid(void)
+{
+	unsigned char buf[NETREG_WARMSTART_MAX_SIZE];
+	struct netreg_warmstart ws, out;
+	unsigned int len;
+
+	test_init(&ws, OFONO_NETREG_STATUS_REGISTERED, -1, "244", "91",
+								"Elisa");
+	len = netreg_warmstart_encode(&ws, buf);
+
+	/* Truncated */
+	g_assert(!netreg_warmstart_decode(&out, buf, 0));
+	g_assert(!netreg_warmstart_decode(&out, buf, TEST_HEADER_SIZE - 1));
+	g_assert(!netreg_warmstart_decode(&out, buf, len - 1));
+
+	/* Unknown version */
+	buf[0]++;
+	g_assert(!netreg_warmstart_decode(&out, buf, len));
+	buf[0]--;
+
+	/* Not a registered state */
+	buf[TEST_STATUS] = OFONO_NETREG_STATUS_SEARCHING;
+	g_assert(!netreg_warmstart_decode(&out, buf, len));
+	buf[TEST_STATUS] = OFONO_NETREG_STATUS_REGISTERED;
+
+	/* Garbage in MCC or MNC */
+	buf[TEST_MCC] = 'x';
+	g_assert(!netreg_warmstart_decode(&out, buf, len));
+	buf[TEST_MCC] = '2';
+	buf[TEST_MCC + OFONO_MAX_MCC_LENGTH] = '/';
+	g_assert(!netreg_warmstart_decode(&out, buf, len));
+	buf[TEST_MCC + OFONO_MAX_MCC_LENGTH] = '9';
+
+	/* Back to valid */
+	g_assert(netreg_warmstart_decode(&out, buf, len));
+	test_assert_equal(&ws, &out);
+}
+
+int main(int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func(TEST_("roundtrip"), test_roundtrip);
+	g_test_add_func(TEST_("name"), test_name);
+	g_test_add_func(TEST_("invalid"), test_invalid);
+	return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
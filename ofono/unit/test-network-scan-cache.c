@@ -0,0 +1,153 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "network-scan-cache.h"
+
+#define TEST_(name) "/network-scan-cache/" name
+
+#define TEST_NOW (100 * G_USEC_PER_SEC)
+#define TEST_MAX_AGE 60
+#define TEST_LAC 0x1234
+
+static void test_cache_init(struct network_scan_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->max_age = TEST_MAX_AGE;
+	network_scan_cache_store(cache, TEST_NOW, TEST_LAC, "244", "91");
+}
+
+/* ==== valid ==== */
+
+static void test_valid(void)
+{
+	struct network_scan_cache cache;
+
+	test_cache_init(&cache);
+	g_assert(network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"244", "91"));
+
+	/* Until it gets too old */
+	g_assert(network_scan_cache_valid(&cache,
+				TEST_NOW + TEST_MAX_AGE * G_USEC_PER_SEC - 1,
+				TEST_LAC, "244", "91"));
+	g_assert(!network_scan_cache_valid(&cache,
+				TEST_NOW + TEST_MAX_AGE * G_USEC_PER_SEC,
+				TEST_LAC, "244", "91"));
+}
+
+/* ==== location ==== */
+
+static void test_location(void)
+{
+	struct network_scan_cache cache;
+
+	test_cache_init(&cache);
+
+	/* A different location area, or none at all */
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC + 1,
+							"244", "91"));
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, -1,
+							"244", "91"));
+
+	/* Back in the original one */
+	g_assert(network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"244", "91"));
+
+	/* A scan made without a known location is never reused */
+	network_scan_cache_store(&cache, TEST_NOW, -1, "244", "91");
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, -1,
+							"244", "91"));
+}
+
+/* ==== plmn ==== */
+
+static void test_plmn(void)
+{
+	struct network_scan_cache cache;
+
+	test_cache_init(&cache);
+
+	/* Same location area code, different network */
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"244", "05"));
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"240", "91"));
+
+	/* MCC and MNC are compared separately */
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"24", "491"));
+
+	/* Not registered anywhere */
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							NULL, NULL));
+
+	/* A scan made while not registered is never reused */
+	network_scan_cache_store(&cache, TEST_NOW, TEST_LAC, NULL, NULL);
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							NULL, NULL));
+}
+
+/* ==== disabled ==== */
+
+static void test_disabled(void)
+{
+	struct network_scan_cache cache;
+
+	/* Nothing stored */
+	memset(&cache, 0, sizeof(cache));
+	cache.max_age = TEST_MAX_AGE;
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"244", "91"));
+
+	/* Dropped, e.g. after a failed scan */
+	test_cache_init(&cache);
+	network_scan_cache_drop(&cache);
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"244", "91"));
+
+	/* Turned off, which is the default */
+	test_cache_init(&cache);
+	cache.max_age = 0;
+	g_assert(!network_scan_cache_valid(&cache, TEST_NOW, TEST_LAC,
+							"244", "91"));
+}
+
+int main(int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func(TEST_("valid"), test_valid);
+	g_test_add_func(TEST_("location"), test_location);
+	g_test_add_func(TEST_("plmn"), test_plmn);
+	g_test_add_func(TEST_("disabled"), test_disabled);
+
+	return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
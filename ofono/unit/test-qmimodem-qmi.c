@@ -0,0 +1,640 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <glib.h>
+
+#include "drivers/qmimodem/qmi.h"
+#include "drivers/qmimodem/ctl.h"
+
+#define TEST_TIMEOUT_SEC 10
+#define TEST_NAS_CLIENT 7
+#define TEST_DMS_CLIENT 9
+#define TEST_MSG_A 0x0024
+#define TEST_MSG_B 0x0051
+#define TEST_PARAM_TYPE 0x10
+#define TEST_BIG_TYPE 0x11
+#define TEST_BIG_SIZE 300	/* Too big for the inline request buffer */
+#define TEST_REQUESTS 20	/* More than the request pool holds */
+
+/* The fake modem on the other end of the socket pair */
+struct test_modem {
+	int fd;
+	guint watch;
+	GByteArray *rx;
+	unsigned int client_id_requests;
+	unsigned int release_requests;
+	unsigned int service_requests;
+};
+
+struct test_data {
+	struct qmi_device *device;
+	struct test_modem modem;
+	struct qmi_service *nas;
+	struct qmi_service *dms;
+	unsigned int created;
+	unsigned int responses;
+	unsigned int next_value;
+	unsigned int count_a;
+	unsigned int count_b;
+	unsigned int count_dms;
+	uint16_t id_a;
+	uint16_t id_b;
+};
+
+static void put_le16(unsigned char *p, uint16_t val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+}
+
+static uint16_t get_le16(const unsigned char *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static size_t test_frame(unsigned char *buf, uint8_t service, uint8_t client,
+				uint8_t type, uint16_t tid, uint16_t message,
+				const void *tlvs, uint16_t tlv_len)
+{
+	const size_t hdr = service ? 3 : 2;
+	const size_t len = 6 + hdr + 4 + tlv_len;
+	unsigned char *msg = buf + 6 + hdr;
+
+	buf[0] = 0x01;
+	put_le16(buf + 1, len - 1);
+	buf[3] = 0x80;
+	buf[4] = service;
+	buf[5] = client;
+	buf[6] = type;
+
+	if (service)
+		put_le16(buf + 7, tid);
+	else
+		buf[7] = tid;
+
+	put_le16(msg, message);
+	put_le16(msg + 2, tlv_len);
+	memcpy(msg + 4, tlvs, tlv_len);
+	return len;
+}
+
+static void test_modem_write(struct test_modem *tm, const void *buf,
+								size_t len)
+{
+	g_assert_cmpint(write(tm->fd, buf, len), ==, len);
+}
+
+static void test_modem_send(struct test_modem *tm, uint8_t service,
+				uint8_t client, uint8_t type, uint16_t tid,
+				uint16_t message, const void *tlvs,
+				uint16_t tlv_len)
+{
+	unsigned char buf[512];
+
+	g_assert_cmpuint(tlv_len + 13, <=, sizeof(buf));
+	test_modem_write(tm, buf, test_frame(buf, service, client, type, tid,
+						message, tlvs, tlv_len));
+}
+
+static void test_modem_indicate(struct test_modem *tm, uint8_t service,
+					uint8_t client, uint16_t message)
+{
+	static const unsigned char tlv[] = { 0x01, 0x01, 0x00, 0x2a };
+
+	test_modem_send(tm, service, client, 0x04, 0, message,
+							tlv, sizeof(tlv));
+}
+
+static void test_modem_control(struct test_modem *tm, uint8_t tid,
+				uint16_t message, const unsigned char *tlvs,
+				uint16_t tlv_len)
+{
+	static const unsigned char version_info[] = {
+		0x02, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x01, 0x10, 0x00, 0x03,
+		QMI_SERVICE_CONTROL, 0x01, 0x00, 0x05, 0x00,
+		QMI_SERVICE_DMS, 0x01, 0x00, 0x03, 0x00,
+		QMI_SERVICE_NAS, 0x01, 0x00, 0x19, 0x00
+	};
+	unsigned char reply[14] = {
+		0x02, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x01, 0x02, 0x00
+	};
+
+	switch (message) {
+	case QMI_CTL_GET_VERSION_INFO:
+		test_modem_send(tm, 0, 0, 0x01, tid, message,
+					version_info, sizeof(version_info));
+		break;
+	case QMI_CTL_GET_CLIENT_ID:
+		g_assert_cmpuint(tlv_len, ==, 4);
+		tm->client_id_requests++;
+		reply[10] = tlvs[3];
+		reply[11] = tlvs[3] == QMI_SERVICE_NAS ?
+					TEST_NAS_CLIENT : TEST_DMS_CLIENT;
+		test_modem_send(tm, 0, 0, 0x01, tid, message, reply, 12);
+		break;
+	case QMI_CTL_RELEASE_CLIENT_ID:
+		tm->release_requests++;
+		test_modem_send(tm, 0, 0, 0x01, tid, message, reply, 7);
+		break;
+	default:
+		g_assert_not_reached();
+	}
+}
+
+/* Every service request gets a successful response, echoing the TLVs */
+static void test_modem_request(struct test_modem *tm, uint8_t service,
+				uint8_t client, uint16_t tid, uint16_t message,
+				const unsigned char *tlvs, uint16_t tlv_len)
+{
+	unsigned char reply[400];
+
+	g_assert_cmpuint(tlv_len + 7, <=, sizeof(reply));
+
+	reply[0] = 0x02;
+	put_le16(reply + 1, 4);
+	memset(reply + 3, 0, 4);
+	memcpy(reply + 7, tlvs, tlv_len);
+
+	tm->service_requests++;
+	test_modem_send(tm, service, client, 0x02, tid, message,
+						reply, tlv_len + 7);
+}
+
+static gboolean test_modem_read(GIOChannel *io, GIOCondition cond,
+							gpointer user_data)
+{
+	struct test_modem *tm = user_data;
+	unsigned char buf[1024];
+	ssize_t n = read(tm->fd, buf, sizeof(buf));
+
+	if (n <= 0)
+		return G_SOURCE_CONTINUE;
+
+	g_byte_array_append(tm->rx, buf, n);
+
+	while (tm->rx->len >= 6) {
+		const unsigned char *p = tm->rx->data;
+		const size_t len = get_le16(p + 1) + 1;
+		const size_t hdr = p[4] ? 3 : 2;
+		const unsigned char *msg = p + 6 + hdr;
+
+		if (tm->rx->len < len)
+			break;
+
+		g_assert_cmpuint(p[0], ==, 0x01);
+		g_assert_cmpuint(p[3], ==, 0x00);
+
+		if (p[4] == QMI_SERVICE_CONTROL)
+			test_modem_control(tm, p[7], get_le16(msg),
+						msg + 4, get_le16(msg + 2));
+		else
+			test_modem_request(tm, p[4], p[5], get_le16(p + 7),
+						get_le16(msg), msg + 4,
+						get_le16(msg + 2));
+
+		g_byte_array_remove_range(tm->rx, 0, len);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean test_timeout(gpointer user_data)
+{
+	g_assert_not_reached();
+	return G_SOURCE_REMOVE;
+}
+
+static void test_run_until(unsigned int *counter, unsigned int value)
+{
+	guint timeout = g_timeout_add_seconds(TEST_TIMEOUT_SEC,
+							test_timeout, NULL);
+
+	while (*counter < value)
+		g_main_context_iteration(NULL, TRUE);
+
+	g_source_remove(timeout);
+}
+
+static void test_debug(const char *str, void *user_data)
+{
+	g_test_message("%s", str);
+}
+
+static void test_discover_cb(void *user_data)
+{
+	struct test_data *td = user_data;
+
+	td->created++;
+}
+
+static void test_data_init(struct test_data *td)
+{
+	GIOChannel *io;
+	int sv[2];
+
+	memset(td, 0, sizeof(*td));
+	g_assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+	td->device = qmi_device_new(sv[0]);
+	g_assert(td->device);
+	qmi_device_set_close_on_unref(td->device, true);
+
+	if (g_test_verbose())
+		qmi_device_set_debug(td->device, test_debug, NULL);
+
+	td->modem.fd = sv[1];
+	td->modem.rx = g_byte_array_new();
+	io = g_io_channel_unix_new(sv[1]);
+	td->modem.watch = g_io_add_watch(io, G_IO_IN, test_modem_read,
+								&td->modem);
+	g_io_channel_unref(io);
+
+	g_assert(qmi_device_discover(td->device, test_discover_cb, td, NULL));
+	test_run_until(&td->created, 1);
+	td->created = 0;
+
+	g_assert(qmi_device_has_service(td->device, QMI_SERVICE_NAS));
+	g_assert(qmi_device_has_service(td->device, QMI_SERVICE_DMS));
+}
+
+static void test_data_cleanup(struct test_data *td)
+{
+	unsigned int releases = td->modem.release_requests;
+
+	/* Let the client IDs be released before the device goes away */
+	if (td->nas) {
+		qmi_service_unref(td->nas);
+		releases++;
+	}
+
+	if (td->dms) {
+		qmi_service_unref(td->dms);
+		releases++;
+	}
+
+	test_run_until(&td->modem.release_requests, releases);
+	while (g_main_context_iteration(NULL, FALSE));
+
+	qmi_device_unref(td->device);
+	g_source_remove(td->modem.watch);
+	g_byte_array_unref(td->modem.rx);
+	close(td->modem.fd);
+}
+
+static void test_create_cb(struct qmi_service *service, void *user_data)
+{
+	struct test_data *td = user_data;
+	struct qmi_service **slot;
+
+	g_assert(service);
+	if (!strcmp(qmi_service_get_identifier(service), "NAS"))
+		slot = &td->nas;
+	else
+		slot = &td->dms;
+
+	if (*slot)
+		g_assert(*slot == service);
+	else
+		*slot = qmi_service_ref(service);
+
+	td->created++;
+}
+
+static void test_create_services(struct test_data *td)
+{
+	g_assert(qmi_service_create_shared(td->device, QMI_SERVICE_NAS,
+						test_create_cb, td, NULL));
+	g_assert(qmi_service_create_shared(td->device, QMI_SERVICE_DMS,
+						test_create_cb, td, NULL));
+	test_run_until(&td->created, 2);
+	td->created = 0;
+}
+
+static void test_create_shared(void)
+{
+	struct test_data td;
+
+	test_data_init(&td);
+
+	/* Requests for the same type are answered with one client ID */
+	g_assert(qmi_service_create_shared(td.device, QMI_SERVICE_NAS,
+						test_create_cb, &td, NULL));
+	g_assert(qmi_service_create_shared(td.device, QMI_SERVICE_NAS,
+						test_create_cb, &td, NULL));
+	g_assert(qmi_service_create(td.device, QMI_SERVICE_NAS,
+						test_create_cb, &td, NULL));
+	g_assert(qmi_service_create_shared(td.device, QMI_SERVICE_DMS,
+						test_create_cb, &td, NULL));
+	test_run_until(&td.created, 4);
+	g_assert_cmpuint(td.modem.client_id_requests, ==, 2);
+	g_assert(td.nas && td.dms && td.nas != td.dms);
+
+	/* Once created, the service is simply shared */
+	g_assert(qmi_service_create_shared(td.device, QMI_SERVICE_NAS,
+						test_create_cb, &td, NULL));
+	test_run_until(&td.created, 5);
+	g_assert_cmpuint(td.modem.client_id_requests, ==, 2);
+
+	test_data_cleanup(&td);
+}
+
+static void test_notify_a(struct qmi_result *result, void *user_data)
+{
+	struct test_data *td = user_data;
+	uint8_t value;
+
+	g_assert(qmi_result_get_uint8(result, 0x01, &value));
+	g_assert_cmpuint(value, ==, 0x2a);
+	td->count_a++;
+}
+
+static void test_notify_a_once(struct qmi_result *result, void *user_data)
+{
+	struct test_data *td = user_data;
+
+	td->count_a++;
+	g_assert(qmi_service_unregister(td->nas, td->id_a));
+}
+
+static void test_notify_b(struct qmi_result *result, void *user_data)
+{
+	struct test_data *td = user_data;
+
+	td->count_b++;
+}
+
+static void test_notify_dms(struct qmi_result *result, void *user_data)
+{
+	struct test_data *td = user_data;
+
+	td->count_dms++;
+}
+
+static void test_indication(void)
+{
+	struct test_data td;
+	unsigned char buf[64];
+	size_t len;
+
+	test_data_init(&td);
+	test_create_services(&td);
+
+	g_assert(qmi_service_register(td.nas, TEST_MSG_A, test_notify_a,
+								&td, NULL));
+	g_assert(qmi_service_register(td.nas, TEST_MSG_B, test_notify_b,
+								&td, NULL));
+	g_assert(qmi_service_register(td.dms, TEST_MSG_A, test_notify_dms,
+								&td, NULL));
+
+	/* Addressed to our NAS client */
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, TEST_NAS_CLIENT,
+								TEST_MSG_A);
+	test_run_until(&td.count_a, 1);
+
+	/* Broadcast, DMS has the same message ID but must not see it */
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_A);
+	test_run_until(&td.count_a, 2);
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_B);
+	test_run_until(&td.count_b, 1);
+
+	/* Someone else's client, then one that can be waited for */
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, TEST_NAS_CLIENT + 1,
+								TEST_MSG_A);
+	test_modem_indicate(&td.modem, QMI_SERVICE_DMS, TEST_DMS_CLIENT,
+								TEST_MSG_A);
+	test_run_until(&td.count_dms, 1);
+	g_assert_cmpuint(td.count_a, ==, 2);
+	g_assert_cmpuint(td.count_b, ==, 1);
+
+	/* A frame split across two reads */
+	len = test_frame(buf, QMI_SERVICE_NAS, TEST_NAS_CLIENT, 0x04, 0,
+				TEST_MSG_A, "\x01\x01\x00\x2a", 4);
+	test_modem_write(&td.modem, buf, 5);
+	g_main_context_iteration(NULL, FALSE);
+	test_modem_write(&td.modem, buf + 5, len - 5);
+	test_run_until(&td.count_a, 3);
+
+	/* A callback unregistering itself doesn't hide the others */
+	td.id_a = qmi_service_register(td.nas, TEST_MSG_A,
+					test_notify_a_once, &td, NULL);
+	g_assert(qmi_service_register(td.nas, TEST_MSG_A, test_notify_b,
+								&td, NULL));
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_A);
+	test_run_until(&td.count_b, 2);
+	g_assert_cmpuint(td.count_a, ==, 5);
+
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_A);
+	test_run_until(&td.count_b, 3);
+	g_assert_cmpuint(td.count_a, ==, 6);
+
+	g_assert(qmi_service_unregister_all(td.nas));
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_A);
+	test_modem_indicate(&td.modem, QMI_SERVICE_DMS, 0xff, TEST_MSG_A);
+	test_run_until(&td.count_dms, 2);
+	g_assert_cmpuint(td.count_a, ==, 6);
+	g_assert_cmpuint(td.count_b, ==, 3);
+
+	test_data_cleanup(&td);
+}
+
+static void test_notify_drop_b(struct qmi_result *result,
+							void *user_data)
+{
+	struct test_data *td = user_data;
+
+	td->count_a++;
+	g_assert(qmi_service_unregister(td->nas, td->id_b));
+}
+
+static void test_notify_index(void)
+{
+	struct test_data td;
+
+	test_data_init(&td);
+	test_create_services(&td);
+
+	/* Everyone registered for the same message gets it */
+	g_assert(qmi_service_register(td.nas, TEST_MSG_A, test_notify_a,
+								&td, NULL));
+	td.id_b = qmi_service_register(td.nas, TEST_MSG_A, test_notify_b,
+								&td, NULL);
+	g_assert(td.id_b);
+	g_assert(qmi_service_register(td.dms, TEST_MSG_B, test_notify_dms,
+								&td, NULL));
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, TEST_NAS_CLIENT,
+								TEST_MSG_A);
+	test_run_until(&td.count_b, 1);
+	g_assert_cmpuint(td.count_a, ==, 1);
+
+	/* Only the registered message ID of the given service is looked up */
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_B);
+	test_modem_indicate(&td.modem, QMI_SERVICE_DMS, 0xff, TEST_MSG_B);
+	test_run_until(&td.count_dms, 1);
+	g_assert_cmpuint(td.count_a, ==, 1);
+	g_assert_cmpuint(td.count_b, ==, 1);
+
+	/* An entry removed during dispatch is not called anymore */
+	g_assert(qmi_service_unregister_all(td.nas));
+	g_assert(qmi_service_register(td.nas, TEST_MSG_A, test_notify_drop_b,
+								&td, NULL));
+	td.id_b = qmi_service_register(td.nas, TEST_MSG_A, test_notify_b,
+								&td, NULL);
+	g_assert(qmi_service_register(td.nas, TEST_MSG_A, test_notify_a,
+								&td, NULL));
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_A);
+	test_run_until(&td.count_a, 3);
+	g_assert_cmpuint(td.count_b, ==, 1);
+
+	/* A released service takes its entries out of the index */
+	qmi_service_unref(td.nas);
+	td.nas = NULL;
+	test_run_until(&td.modem.release_requests, 1);
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, 0xff, TEST_MSG_A);
+	test_modem_indicate(&td.modem, QMI_SERVICE_DMS, 0xff, TEST_MSG_B);
+	test_run_until(&td.count_dms, 2);
+	g_assert_cmpuint(td.count_a, ==, 3);
+
+	/* And a new client of the same type starts from scratch */
+	g_assert(qmi_service_create_shared(td.device, QMI_SERVICE_NAS,
+						test_create_cb, &td, NULL));
+	test_run_until(&td.created, 1);
+	g_assert(td.nas);
+	g_assert(qmi_service_register(td.nas, TEST_MSG_A, test_notify_b,
+								&td, NULL));
+	test_modem_indicate(&td.modem, QMI_SERVICE_NAS, TEST_NAS_CLIENT,
+								TEST_MSG_A);
+	test_run_until(&td.count_b, 2);
+	g_assert_cmpuint(td.count_a, ==, 3);
+
+	test_data_cleanup(&td);
+}
+
+static void test_response_cb(struct qmi_result *result, void *user_data)
+{
+	struct test_data *td = user_data;
+	const unsigned char *big;
+	uint16_t value;
+	uint16_t len;
+
+	g_assert(!qmi_result_set_error(result, NULL));
+	g_assert(qmi_result_get_uint16(result, TEST_PARAM_TYPE, &value));
+
+	/* In order, and without the contents of any other request */
+	g_assert_cmpuint(value, >=, td->next_value);
+	td->next_value = value + 1;
+
+	big = qmi_result_get(result, TEST_BIG_TYPE, &len);
+	if (value % 2) {
+		unsigned int i;
+
+		g_assert(big);
+		g_assert_cmpuint(len, ==, TEST_BIG_SIZE);
+		for (i = 0; i < len; i++)
+			g_assert_cmpuint(big[i], ==, (value + i) & 0xff);
+	} else {
+		g_assert(!big);
+	}
+
+	td->responses++;
+}
+
+/* Odd requests don't fit into the inline buffer */
+static uint16_t test_send_value(struct test_data *td, uint16_t value)
+{
+	struct qmi_param *param = qmi_param_new_uint16(TEST_PARAM_TYPE,
+								value);
+	uint16_t id;
+
+	if (value % 2) {
+		unsigned char big[TEST_BIG_SIZE];
+		unsigned int i;
+
+		for (i = 0; i < sizeof(big); i++)
+			big[i] = value + i;
+
+		g_assert(qmi_param_append(param, TEST_BIG_TYPE, sizeof(big),
+									big));
+	}
+
+	id = qmi_service_send(td->nas, TEST_MSG_A, param, test_response_cb,
+								td, NULL);
+	g_assert(id);
+	return id;
+}
+
+static void test_request_pool(void)
+{
+	struct test_data td;
+	unsigned int i;
+
+	test_data_init(&td);
+	test_create_services(&td);
+
+	/* More requests in flight than there are pooled ones */
+	for (i = 0; i < TEST_REQUESTS; i++)
+		test_send_value(&td, i);
+
+	test_run_until(&td.responses, TEST_REQUESTS);
+	g_assert_cmpuint(td.modem.service_requests, ==, TEST_REQUESTS);
+
+	/* Now all of them come from the pool, big and small alike */
+	for (i = 0; i < TEST_REQUESTS; i++) {
+		test_send_value(&td, TEST_REQUESTS + i);
+		test_run_until(&td.responses, TEST_REQUESTS + i + 1);
+	}
+
+	/* Cancelled requests go back to the pool without being sent */
+	test_send_value(&td, 2 * TEST_REQUESTS);
+	g_assert(qmi_service_cancel(td.nas,
+				test_send_value(&td, 2 * TEST_REQUESTS + 1)));
+	g_assert(qmi_service_cancel(td.nas,
+				test_send_value(&td, 2 * TEST_REQUESTS + 2)));
+	test_send_value(&td, 2 * TEST_REQUESTS + 3);
+	test_run_until(&td.responses, 2 * TEST_REQUESTS + 2);
+	g_assert_cmpuint(td.next_value, ==, 2 * TEST_REQUESTS + 4);
+	g_assert_cmpuint(td.modem.service_requests, ==, 2 * TEST_REQUESTS + 2);
+
+	test_data_cleanup(&td);
+}
+
+int main(int argc, char **argv)
+{
+	g_test_init(&argc, &argv, NULL);
+
+	g_test_add_func("/testqmi/create_shared", test_create_shared);
+	g_test_add_func("/testqmi/indication", test_indication);
+	g_test_add_func("/testqmi/notify_index", test_notify_index);
+	g_test_add_func("/testqmi/request_pool", test_request_pool);
+
+	return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -56,6 +56,13 @@
 #define SM_STORE_ENABLED_SLOTS      "EnabledSlots"
 #define SM_STORE_DEFAULT_VOICE_SIM  "DefaultVoiceSim"
 #define SM_STORE_DEFAULT_DATA_SIM   "DefaultDataSim"
+#define SM_STORE_SYNC_DELAY_MS      (500)
+
+#define TEST_MANY_SLOTS (16)
+#define TEST_MANY_PATH "/test_%02d"
+#define TEST_MANY_IMEI "2222222222222%02d"
+#define TEST_MANY_IMSI "2441200000000%02d"
+#define TEST_MANY_IMSI_UNKNOWN "244129999999999"
 
 static GMainLoop *test_loop = NULL;
 static GSList *test_drivers = NULL;
@@ -334,6 +341,22 @@ static gboolean test_done_when_zero(gpointer user_data)
 	}
 }
 
+static gboolean test_quit_nested_loop(gpointer loop)
+{
+	g_main_loop_quit(loop);
+	return G_SOURCE_REMOVE;
+}
+
+/* Settings are written with a delay, give it enough time */
+static void test_wait_storage_sync(void)
+{
+	GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+
+	g_timeout_add(2 * SM_STORE_SYNC_DELAY_MS, test_quit_nested_loop, loop);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+}
+
 static gboolean test_unregister_later(void *unused)
 {
 	ofono_slot_driver_unregister(test_driver_reg);
@@ -1655,6 +1678,148 @@ static void test_multisim(void)
 	test_common_deinit();
 }
 
+/* ==== many_slots ==== */
+
+static void test_many_slots_set_imsi(int i, const char *imsi)
+{
+	char *path = g_strdup_printf(TEST_MANY_PATH, i);
+	struct ofono_watch *w = ofono_watch_new(path);
+
+	fake_watch_set_ofono_imsi(w, imsi);
+	fake_watch_emit_queued_signals(w);
+	ofono_watch_unref(w);
+	g_free(path);
+}
+
+static gboolean test_many_slots_run(gpointer user_data)
+{
+	TestDriverData *dd = user_data;
+	struct ofono_slot_manager *m = fake_slot_manager_dbus.m;
+	char *storage_file = g_build_filename(STORAGEDIR, SM_STORE, NULL);
+	struct ofono_slot *slot[TEST_MANY_SLOTS];
+	char *path[TEST_MANY_SLOTS];
+	char *imsi[TEST_MANY_SLOTS];
+	GKeyFile *storage;
+	char *val;
+	int i;
+
+	DBG("");
+
+	/* Add the slots in reverse order, SIM presence is not known yet */
+	for (i = TEST_MANY_SLOTS - 1; i >= 0; i--) {
+		char *imei = g_strdup_printf(TEST_MANY_IMEI, i);
+		TestSlotData *sd;
+
+		path[i] = g_strdup_printf(TEST_MANY_PATH, i);
+		imsi[i] = g_strdup_printf(TEST_MANY_IMSI, i);
+		sd = test_slot_data_new(dd, path[i], imei, TEST_IMEISV);
+		g_assert(sd);
+		slot[i] = sd->slot;
+		g_free(imei);
+	}
+
+	/* Not ready until every slot knows its SIM presence */
+	ofono_slot_driver_started(test_driver_reg);
+	for (i = 0; i < TEST_MANY_SLOTS; i++) {
+		g_assert(!m->ready);
+		g_assert(m->slots[i] == slot[i]);
+		ofono_slot_set_sim_presence(slot[i], OFONO_SLOT_SIM_PRESENT);
+	}
+	g_assert(m->ready);
+
+	/* SIMs show up in random order */
+	for (i = 0; i < TEST_MANY_SLOTS; i++) {
+		const int k = (i * 7) % TEST_MANY_SLOTS;
+
+		test_many_slots_set_imsi(k, imsi[k]);
+	}
+
+	/* The first slot with a SIM gets voice by default */
+	g_assert(!m->default_voice_imsi);
+	g_assert_cmpstr(m->default_voice_path, == ,path[0]);
+
+	/* Pick a SIM by IMSI */
+	fake_slot_manager_dbus.cb.set_default_voice_imsi(m, imsi[11]);
+	g_assert_cmpstr(m->default_voice_path, == ,path[11]);
+	g_assert(fake_slot_manager_dbus.cb.set_mms_imsi(m, imsi[5]));
+	g_assert_cmpstr(m->mms_path, == ,path[5]);
+	g_assert(!fake_slot_manager_dbus.cb.set_mms_imsi(m,
+		TEST_MANY_IMSI_UNKNOWN));
+	g_assert_cmpstr(m->mms_path, == ,path[5]);
+	g_assert(fake_slot_manager_dbus.cb.set_mms_imsi(m, NULL));
+	g_assert(!m->mms_path);
+
+	/* Move the voice SIM to another slot, any SIM will do meanwhile */
+	test_many_slots_set_imsi(11, NULL);
+	g_assert_cmpstr(m->default_voice_path, == ,path[0]);
+	test_many_slots_set_imsi(3, imsi[11]);
+	g_assert_cmpstr(m->default_voice_path, == ,path[3]);
+
+	/* Same IMSI in two slots, the first one wins */
+	test_many_slots_set_imsi(14, imsi[11]);
+	g_assert_cmpstr(m->default_voice_path, == ,path[3]);
+	test_many_slots_set_imsi(1, imsi[11]);
+	g_assert_cmpstr(m->default_voice_path, == ,path[1]);
+	test_many_slots_set_imsi(1, imsi[1]);
+	g_assert_cmpstr(m->default_voice_path, == ,path[3]);
+	test_many_slots_set_imsi(3, NULL);
+	g_assert_cmpstr(m->default_voice_path, == ,path[14]);
+
+	/* A burst of changes gets written out once, after a delay */
+	for (i = 0; i < TEST_MANY_SLOTS; i++) {
+		fake_slot_manager_dbus.cb.set_default_voice_imsi(m, imsi[i]);
+	}
+	g_assert_cmpstr(m->default_voice_path, == ,path[TEST_MANY_SLOTS - 1]);
+	storage = g_key_file_new();
+	g_assert(!g_key_file_load_from_file(storage, storage_file, 0, NULL));
+	test_wait_storage_sync();
+	g_assert(g_key_file_load_from_file(storage, storage_file, 0, NULL));
+	val = g_key_file_get_string(storage, SM_STORE_GROUP,
+		SM_STORE_DEFAULT_VOICE_SIM, NULL);
+	g_assert_cmpstr(val, == ,imsi[TEST_MANY_SLOTS - 1]);
+	g_free(val);
+	g_key_file_free(storage);
+
+	for (i = 0; i < TEST_MANY_SLOTS; i++) {
+		test_many_slots_set_imsi(i, NULL);
+		g_free(path[i]);
+		g_free(imsi[i]);
+	}
+
+	g_assert(!m->default_voice_path);
+	g_free(storage_file);
+	g_main_loop_quit(test_loop);
+	return G_SOURCE_REMOVE;
+}
+
+static guint test_many_slots_start(TestDriverData *dd)
+{
+	return g_idle_add(test_many_slots_run, dd);
+}
+
+static void test_many_slots(void)
+{
+	static const struct ofono_slot_driver test_many_slots_driver = {
+		.name = "many_slots",
+		.api_version = OFONO_SLOT_API_VERSION,
+		.init = test_driver_init,
+		.start = test_many_slots_start,
+		.cancel = test_driver_cancel_source,
+		.cleanup = test_driver_cleanup
+	};
+
+	test_common_init();
+	test_driver_reg = ofono_slot_driver_register(&test_many_slots_driver);
+	g_assert(test_driver_reg);
+
+	g_main_loop_run(test_loop);
+	g_assert(test_timeout_id);
+
+	ofono_slot_driver_unregister(test_driver_reg);
+	test_driver_reg = NULL;
+	test_common_deinit();
+}
+
 /* ==== config_storage ==== */
 
 static gboolean test_config_storage_run(gpointer user_data)
@@ -1697,6 +1862,10 @@ static gboolean test_config_storage_run(gpointer user_data)
 	g_assert(m->slots[0]->enabled);
 	g_assert(!m->slots[1]->enabled);
 
+	/* Nothing is written right away */
+	g_assert(!g_key_file_load_from_file(storage, storage_file, 0, NULL));
+	test_wait_storage_sync();
+
 	/* Check the config file */
 	g_assert(g_key_file_load_from_file(storage, storage_file, 0, NULL));
 	val = g_key_file_get_string(storage, SM_STORE_GROUP,
@@ -1711,6 +1880,7 @@ static gboolean test_config_storage_run(gpointer user_data)
 	g_assert(m->slots[0]->enabled);
 	g_assert(m->slots[1]->enabled);
 	g_strfreev(slots);
+	test_wait_storage_sync();
 
 	/* There's no [EnabledSlots] there because it's the default config */
 	storage = g_key_file_new();
@@ -1927,6 +2097,7 @@ int main(int argc, char *argv[])
 	g_test_add_data_func(TEST_("auto_data_sim_once"), "once",
 						test_auto_data_sim);
 	g_test_add_func(TEST_("multisim"), test_multisim);
+	g_test_add_func(TEST_("many_slots"), test_many_slots);
 	g_test_add_func(TEST_("config_storage"), test_config_storage);
 	g_test_add_func(TEST_("storage"), test_storage);
 	return g_test_run();
@@ -324,6 +324,261 @@ static void test_send_message_free(void)
 	test_common_deinit();
 }
 
+/* ==== send_message_sync ==== */
+
+#define TEST_SYNC_FILTERS (12)
+
+static unsigned int test_send_message_sync_filter(struct ofono_modem *modem,
+		const struct ofono_sms_address *addr, const char *text,
+		ofono_sms_filter_send_text_cb_t cb, void *data)
+{
+	char *text2 = g_strconcat(text, "x", NULL);
+
+	/* Each filter sees what the previous one has done */
+	g_assert(strlen(text) == 4 + (unsigned int) modem->filter_msg_count);
+	modem->filter_msg_count++;
+	DBG("%d", modem->filter_msg_count);
+	cb(OFONO_SMS_FILTER_CONTINUE, addr, text2, data);
+	g_free(text2);
+	return 0;
+}
+
+static void test_send_message_sync_handler(struct ofono_sms *sms,
+		const struct sms_address *addr, const char *text, void *data)
+{
+	g_assert(strlen(text) == 4 + TEST_SYNC_FILTERS);
+	sms->msg_count++;
+	g_main_loop_quit(test_loop);
+}
+
+static void test_send_message_sync(void)
+{
+	static const char *names[TEST_SYNC_FILTERS] = {
+		"sync00", "sync01", "sync02", "sync03", "sync04", "sync05",
+		"sync06", "sync07", "sync08", "sync09", "sync10", "sync11"
+	};
+
+	struct ofono_sms_filter filters[TEST_SYNC_FILTERS];
+	struct test_send_message_data test;
+	struct sms_address addr;
+	int i;
+
+	test_common_init();
+	memset(&test, 0, sizeof(test));
+	memset(&addr, 0, sizeof(addr));
+
+	/* More filters than can be run in one go */
+	memset(filters, 0, sizeof(filters));
+	for (i = 0; i < TEST_SYNC_FILTERS; i++) {
+		filters[i].name = names[i];
+		filters[i].filter_send_text = test_send_message_sync_filter;
+		g_assert(ofono_sms_filter_register(filters + i) == 0);
+	}
+
+	test.chain = __ofono_sms_filter_chain_new(&test.sms, &test.modem);
+	__ofono_sms_filter_chain_send_text(test.chain, &addr, "test",
+				test_send_message_sync_handler,
+				test_send_message_destroy, &test);
+
+	/* The message is never sent from under the caller */
+	g_assert(test.modem.filter_msg_count == 1);
+	g_assert(!test.sms.msg_count);
+
+	g_main_loop_run(test_loop);
+
+	g_assert(test.destroy_count == 1);
+	g_assert(test.sms.msg_count == 1);
+	g_assert(test.modem.filter_msg_count == TEST_SYNC_FILTERS);
+	__ofono_sms_filter_chain_free(test.chain);
+	for (i = 0; i < TEST_SYNC_FILTERS; i++) {
+		ofono_sms_filter_unregister(filters + i);
+	}
+	test_common_deinit();
+}
+
+/* ==== send_message_sync_dispatch ==== */
+
+#define TEST_SYNC_DISPATCH_FILTERS (4)
+
+static void test_send_message_sync_dispatch_handler(struct ofono_sms *sms,
+		const struct sms_address *addr, const char *text, void *data)
+{
+	g_assert(strlen(text) == 4 + TEST_SYNC_DISPATCH_FILTERS);
+	sms->msg_count++;
+}
+
+static void test_send_message_sync_dispatch(void)
+{
+	static const char *names[TEST_SYNC_DISPATCH_FILTERS] = {
+		"sync0", "sync1", "sync2", "sync3"
+	};
+
+	struct ofono_sms_filter filters[TEST_SYNC_DISPATCH_FILTERS];
+	struct test_send_message_data test;
+	struct sms_address addr;
+	int i;
+
+	test_common_init();
+	memset(&test, 0, sizeof(test));
+	memset(&addr, 0, sizeof(addr));
+
+	/* Few enough filters to be run in one go */
+	memset(filters, 0, sizeof(filters));
+	for (i = 0; i < TEST_SYNC_DISPATCH_FILTERS; i++) {
+		filters[i].name = names[i];
+		filters[i].filter_send_text = test_send_message_sync_filter;
+		g_assert(ofono_sms_filter_register(filters + i) == 0);
+	}
+
+	test.chain = __ofono_sms_filter_chain_new(&test.sms, &test.modem);
+	__ofono_sms_filter_chain_send_text(test.chain, &addr, "test",
+				test_send_message_sync_dispatch_handler,
+				test_send_message_destroy, &test);
+	g_assert(test.modem.filter_msg_count == 1);
+	g_assert(!test.sms.msg_count);
+
+	/* The rest of the chain takes a single dispatch, no idle hops */
+	g_assert(g_main_context_iteration(NULL, FALSE));
+	g_assert(test.modem.filter_msg_count == TEST_SYNC_DISPATCH_FILTERS);
+	g_assert(test.sms.msg_count == 1);
+	g_assert(test.destroy_count == 1);
+	g_assert(!g_main_context_pending(NULL));
+
+	__ofono_sms_filter_chain_free(test.chain);
+	for (i = 0; i < TEST_SYNC_DISPATCH_FILTERS; i++) {
+		ofono_sms_filter_unregister(filters + i);
+	}
+	test_common_deinit();
+}
+
+/* ==== send_message_sync_drop ==== */
+
+static unsigned int test_send_message_drop_filter(struct ofono_modem *modem,
+		const struct ofono_sms_address *addr, const char *text,
+		ofono_sms_filter_send_text_cb_t cb, void *data)
+{
+	modem->filter_msg_count++;
+	DBG("%d", modem->filter_msg_count);
+	cb(OFONO_SMS_FILTER_DROP, addr, text, data);
+	return 0;
+}
+
+static void test_send_message_sync_drop(void)
+{
+	static struct ofono_sms_filter first = {
+		.name = "first",
+		.priority = 3,
+		.filter_send_text = test_send_message_filter
+	};
+
+	static struct ofono_sms_filter drop = {
+		.name = "drop",
+		.priority = 2,
+		.filter_send_text = test_send_message_drop_filter
+	};
+
+	static struct ofono_sms_filter last = {
+		.name = "last",
+		.priority = 1,
+		.filter_send_text = test_send_message_filter
+	};
+
+	struct test_send_message_data test;
+	struct sms_address addr;
+
+	test_common_init();
+	memset(&test, 0, sizeof(test));
+	memset(&addr, 0, sizeof(addr));
+	g_assert(ofono_sms_filter_register(&first) == 0);
+	g_assert(ofono_sms_filter_register(&drop) == 0);
+	g_assert(ofono_sms_filter_register(&last) == 0);
+	test.chain = __ofono_sms_filter_chain_new(&test.sms, &test.modem);
+
+	/* Destroy callback terminates the loop */
+	__ofono_sms_filter_chain_send_text(test.chain, &addr, "test",
+				test_default_send_message,
+				test_send_message_destroy_quit, &test);
+	g_main_loop_run(test_loop);
+
+	/* The last filter never sees the message */
+	g_assert(test.destroy_count == 1);
+	g_assert(!test.sms.msg_count);
+	g_assert(test.modem.filter_msg_count == 2);
+	__ofono_sms_filter_chain_free(test.chain);
+	ofono_sms_filter_unregister(&first);
+	ofono_sms_filter_unregister(&drop);
+	ofono_sms_filter_unregister(&last);
+	test_common_deinit();
+}
+
+/* ==== send_message_sync_cancel ==== */
+
+static struct test_send_message_data *test_send_message_sync_cancel_data;
+
+static unsigned int test_send_message_cancel_filter(struct ofono_modem *modem,
+		const struct ofono_sms_address *addr, const char *text,
+		ofono_sms_filter_send_text_cb_t cb, void *data)
+{
+	struct test_send_message_data *test =
+		test_send_message_sync_cancel_data;
+
+	/* The chain goes away in the middle of the synchronous run */
+	modem->filter_msg_count++;
+	DBG("%d", modem->filter_msg_count);
+	__ofono_sms_filter_chain_free(test->chain);
+	test->chain = NULL;
+	g_idle_add(test_quit_cb, NULL);
+	return 0;
+}
+
+static void test_send_message_sync_cancel(void)
+{
+	static struct ofono_sms_filter first = {
+		.name = "first",
+		.priority = 3,
+		.filter_send_text = test_send_message_filter
+	};
+
+	static struct ofono_sms_filter cancel = {
+		.name = "cancel",
+		.priority = 2,
+		.filter_send_text = test_send_message_cancel_filter
+	};
+
+	static struct ofono_sms_filter last = {
+		.name = "last",
+		.priority = 1,
+		.filter_send_text = test_send_message_filter
+	};
+
+	struct test_send_message_data test;
+	struct sms_address addr;
+
+	test_common_init();
+	memset(&test, 0, sizeof(test));
+	memset(&addr, 0, sizeof(addr));
+	test_send_message_sync_cancel_data = &test;
+	g_assert(ofono_sms_filter_register(&first) == 0);
+	g_assert(ofono_sms_filter_register(&cancel) == 0);
+	g_assert(ofono_sms_filter_register(&last) == 0);
+	test.chain = __ofono_sms_filter_chain_new(&test.sms, &test.modem);
+
+	__ofono_sms_filter_chain_send_text(test.chain, &addr, "test",
+				test_default_send_message,
+				test_send_message_destroy, &test);
+	g_main_loop_run(test_loop);
+
+	g_assert(!test.chain);
+	g_assert(test.destroy_count == 1);
+	g_assert(!test.sms.msg_count);
+	g_assert(test.modem.filter_msg_count == 2);
+	ofono_sms_filter_unregister(&first);
+	ofono_sms_filter_unregister(&cancel);
+	ofono_sms_filter_unregister(&last);
+	test_send_message_sync_cancel_data = NULL;
+	test_common_deinit();
+}
+
 /* ==== send_message_nd ==== */
 
 static gboolean test_send_message_nd_start(gpointer data)
@@ -1155,6 +1410,13 @@ int main(int argc, char *argv[])
 	g_test_add_func(TEST_("no_default"), test_no_default);
 	g_test_add_func(TEST_("send_message"), test_send_message);
 	g_test_add_func(TEST_("send_message_free"), test_send_message_free);
+	g_test_add_func(TEST_("send_message_sync"), test_send_message_sync);
+	g_test_add_func(TEST_("send_message_sync_dispatch"),
+					test_send_message_sync_dispatch);
+	g_test_add_func(TEST_("send_message_sync_drop"),
+					test_send_message_sync_drop);
+	g_test_add_func(TEST_("send_message_sync_cancel"),
+					test_send_message_sync_cancel);
 	g_test_add_func(TEST_("send_message_nd"), test_send_message_nd);
 	g_test_add_func(TEST_("recv_datagram_nd"), test_recv_datagram_nd);
 	g_test_add_func(TEST_("recv_datagram_nc"), test_recv_datagram_nc);
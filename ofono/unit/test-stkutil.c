@@ -22275,6 +22275,138 @@ static void test_img_to_xpm(gconstpointer data)
 	g_free(xpm);
 }
 
+/* Send SMS 1.1.1 without the SC address */
+static unsigned char send_sms_no_addr[] = { 0xD0, 0x2C, 0x81, 0x03, 0x01,
+						0x13, 0x00, 0x82, 0x02, 0x81,
+						0x83, 0x85, 0x07, 0x53, 0x65,
+						0x6E, 0x64, 0x20, 0x53, 0x4D,
+						0x8B, 0x18, 0x01, 0x00, 0x09,
+						0x91, 0x10, 0x32, 0x54, 0x76,
+						0xF8, 0x40, 0xF4, 0x0C, 0x54,
+						0x65, 0x73, 0x74, 0x20, 0x4D,
+						0x65, 0x73, 0x73, 0x61, 0x67,
+						0x65 };
+
+/* Send SMS 1.1.1 without the TPDU */
+static unsigned char send_sms_no_tpdu[] = { 0xD0, 0x1D, 0x81, 0x03, 0x01,
+						0x13, 0x00, 0x82, 0x02, 0x81,
+						0x83, 0x85, 0x07, 0x53, 0x65,
+						0x6E, 0x64, 0x20, 0x53, 0x4D,
+						0x86, 0x09, 0x91, 0x11, 0x22,
+						0x33, 0x44, 0x55, 0x66, 0x77,
+						0xF8 };
+
+/* Send SMS 1.1.1 with a 22 digit SC address */
+static unsigned char send_sms_long_addr[] = { 0xD0, 0x3A, 0x81, 0x03, 0x01,
+						0x13, 0x00, 0x82, 0x02, 0x81,
+						0x83, 0x85, 0x07, 0x53, 0x65,
+						0x6E, 0x64, 0x20, 0x53, 0x4D,
+						0x86, 0x0C, 0x91, 0x11, 0x22,
+						0x33, 0x44, 0x55, 0x66, 0x77,
+						0x88, 0x99, 0x00, 0x11, 0x8B,
+						0x18, 0x01, 0x00, 0x09, 0x91,
+						0x10, 0x32, 0x54, 0x76, 0xF8,
+						0x40, 0xF4, 0x0C, 0x54, 0x65,
+						0x73, 0x74, 0x20, 0x4D, 0x65,
+						0x73, 0x73, 0x61, 0x67, 0x65 };
+
+static void test_send_sms_scratch(void)
+{
+	struct stk_command *command;
+
+	/* The SC address and TPDU end up in the decoded message */
+	command = stk_command_new_from_pdu(send_sms_111, sizeof(send_sms_111));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_OK);
+	check_alpha_id(command->send_sms.alpha_id, "Send SM");
+	check_gsm_sms(&command->send_sms.gsm_sms, &send_sms_data_111.gsm_sms);
+	stk_command_free(command);
+
+	/* Nothing is left over from the previous command */
+	command = stk_command_new_from_pdu(send_sms_no_addr,
+						sizeof(send_sms_no_addr));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_OK);
+	check_alpha_id(command->send_sms.alpha_id, "Send SM");
+	g_assert_cmpstr(command->send_sms.gsm_sms.sc_addr.address, ==, "");
+	g_assert(command->send_sms.gsm_sms.type == SMS_TYPE_SUBMIT);
+	g_assert_cmpstr(command->send_sms.gsm_sms.submit.daddr.address, ==,
+								"012345678");
+	stk_command_free(command);
+
+	/* A TPDU is required */
+	command = stk_command_new_from_pdu(send_sms_no_tpdu,
+						sizeof(send_sms_no_tpdu));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD);
+	stk_command_free(command);
+
+	/* And the SC address has to fit into struct sms_address */
+	command = stk_command_new_from_pdu(send_sms_long_addr,
+						sizeof(send_sms_long_addr));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_DATA_NOT_UNDERSTOOD);
+	stk_command_free(command);
+}
+
+/* Start, without the timer value */
+static unsigned char timer_mgmt_start_no_value[] = { 0xD0, 0x0C, 0x81, 0x03,
+						0x01, 0x27, 0x00, 0x82, 0x02,
+						0x81, 0x82, 0xA4, 0x01, 0x01 };
+
+/* Deactivate, with a timer value */
+static unsigned char timer_mgmt_stop_value[] = { 0xD0, 0x11, 0x81, 0x03,
+						0x01, 0x27, 0x01, 0x82, 0x02,
+						0x81, 0x82, 0xA4, 0x01, 0x01,
+						0xA5, 0x03, 0x00, 0x50, 0x00 };
+
+/* Start, without the timer identifier */
+static unsigned char timer_mgmt_start_no_id[] = { 0xD0, 0x0E, 0x81, 0x03,
+						0x01, 0x27, 0x00, 0x82, 0x02,
+						0x81, 0x82, 0xA5, 0x03, 0x00,
+						0x50, 0x00 };
+
+/* Get current value, without the timer identifier */
+static unsigned char timer_mgmt_get_no_id[] = { 0xD0, 0x09, 0x81, 0x03,
+						0x01, 0x27, 0x02, 0x82, 0x02,
+						0x81, 0x82 };
+
+static void test_timer_mgmt_tables(void)
+{
+	struct stk_command *command;
+
+	/* Starting a timer needs the value */
+	command = stk_command_new_from_pdu(timer_mgmt_start_no_value,
+					sizeof(timer_mgmt_start_no_value));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_MISSING_VALUE);
+	stk_command_free(command);
+
+	/* Other operations take it as optional */
+	command = stk_command_new_from_pdu(timer_mgmt_stop_value,
+					sizeof(timer_mgmt_stop_value));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_OK);
+	g_assert(command->type == STK_COMMAND_TYPE_TIMER_MANAGEMENT);
+	g_assert(command->timer_mgmt.timer_id == 1);
+	g_assert(command->timer_mgmt.timer_value.has_value);
+	g_assert(command->timer_mgmt.timer_value.minute == 5);
+	stk_command_free(command);
+
+	/* The identifier is always required */
+	command = stk_command_new_from_pdu(timer_mgmt_start_no_id,
+					sizeof(timer_mgmt_start_no_id));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_MISSING_VALUE);
+	stk_command_free(command);
+
+	command = stk_command_new_from_pdu(timer_mgmt_get_no_id,
+					sizeof(timer_mgmt_get_no_id));
+	g_assert(command);
+	g_assert(command->status == STK_PARSE_RESULT_MISSING_VALUE);
+	stk_command_free(command);
+}
+
 int main(int argc, char **argv)
 {
 	g_test_init(&argc, &argv, NULL);
@@ -24387,5 +24519,9 @@ int main(int argc, char **argv)
 	g_test_add_data_func("/teststk/IMG to XPM Test 6",
 				&xpm_test_6, test_img_to_xpm);
 
+	g_test_add_func("/teststk/Send SMS scratch", test_send_sms_scratch);
+	g_test_add_func("/teststk/Timer Management tables",
+						test_timer_mgmt_tables);
+
 	return g_test_run();
 }
@@ -0,0 +1,310 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 Jolla Ltd.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+
+#include <glib.h>
+
+#include "ofono.h"
+
+#define TEST_(name) "/trace/" name
+
+#define TEST_FILE_HEADER_SIZE 32
+#define TEST_RECORD_HEADER_SIZE 16
+#define TEST_MAX_CAPTURE 2048
+#define TEST_MIN_SIZE (TEST_RECORD_HEADER_SIZE + TEST_MAX_CAPTURE)
+
+struct test_record {
+	guint64 time;
+	guint len;
+	guint caplen;
+	enum ofono_trace_proto proto;
+	gboolean in;
+	const guint8 *data;
+};
+
+struct test_dump {
+	char *dir;
+	char *path;
+	guint8 *buf;
+	gsize size;
+	gsize off;
+	guint dropped;
+	guint64 monotonic;
+};
+
+static guint16 test_le16(const guint8 *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static guint32 test_le32(const guint8 *p)
+{
+	return test_le16(p) | ((guint32) test_le16(p + 2) << 16);
+}
+
+static guint64 test_le64(const guint8 *p)
+{
+	return test_le32(p) | ((guint64) test_le32(p + 4) << 32);
+}
+
+/* Dumps the trace and checks the file header */
+static void test_dump_init(struct test_dump *dump, struct ofono_trace *trace)
+{
+	memset(dump, 0, sizeof(*dump));
+	dump->dir = g_dir_make_tmp("test-trace-XXXXXX", NULL);
+	g_assert(dump->dir);
+	dump->path = g_build_filename(dump->dir, "modem.trace", NULL);
+
+	g_assert(__ofono_trace_dump(trace, dump->path) == 0);
+	g_assert(g_file_get_contents(dump->path, (char **) &dump->buf,
+						&dump->size, NULL));
+	g_assert(dump->size >= TEST_FILE_HEADER_SIZE);
+	g_assert(!memcmp(dump->buf, "OFNTRACE", 8));
+	g_assert(test_le32(dump->buf + 8) == 1);
+	dump->dropped = test_le32(dump->buf + 12);
+	dump->monotonic = test_le64(dump->buf + 24);
+	dump->off = TEST_FILE_HEADER_SIZE;
+}
+
+static gboolean test_dump_next(struct test_dump *dump,
+					struct test_record *rec)
+{
+	const guint8 *hdr = dump->buf + dump->off;
+
+	if (dump->off == dump->size)
+		return FALSE;
+
+	g_assert(dump->off + TEST_RECORD_HEADER_SIZE <= dump->size);
+	rec->time = test_le64(hdr);
+	rec->len = test_le32(hdr + 8);
+	rec->caplen = test_le16(hdr + 12);
+	rec->proto = hdr[14];
+	rec->in = hdr[15];
+	rec->data = hdr + TEST_RECORD_HEADER_SIZE;
+
+	g_assert(hdr[15] == 0 || hdr[15] == 1);
+	g_assert(rec->caplen == MIN(rec->len, TEST_MAX_CAPTURE));
+	g_assert(rec->time <= dump->monotonic);
+
+	dump->off += TEST_RECORD_HEADER_SIZE + rec->caplen;
+	g_assert(dump->off <= dump->size);
+	return TRUE;
+}
+
+static void test_dump_destroy(struct test_dump *dump)
+{
+	unlink(dump->path);
+	rmdir(dump->dir);
+	g_free(dump->path);
+	g_free(dump->dir);
+	g_free(dump->buf);
+}
+
+/* ==== null ==== */
+
+static void test_null(void)
+{
+	struct ofono_trace *trace = __ofono_trace_new(0);
+	struct test_dump dump;
+	struct test_record rec;
+
+	__ofono_trace_record(NULL, OFONO_TRACE_PROTO_AT, FALSE, "AT", 2);
+	__ofono_trace_record(trace, OFONO_TRACE_PROTO_AT, FALSE, NULL, 2);
+	__ofono_trace_record(trace, OFONO_TRACE_PROTO_AT, FALSE, "AT", 0);
+	__ofono_trace_free(NULL);
+
+	/* An empty trace is just the file header */
+	test_dump_init(&dump, trace);
+	g_assert(dump.size == TEST_FILE_HEADER_SIZE);
+	g_assert(!dump.dropped);
+	g_assert(!test_dump_next(&dump, &rec));
+	test_dump_destroy(&dump);
+
+	__ofono_trace_free(trace);
+}
+
+/* ==== record ==== */
+
+static void test_record(void)
+{
+	static const guint8 qmi[] = { 0x01, 0x0c, 0x00, 0x80, 0x02 };
+	struct ofono_trace *trace = __ofono_trace_new(0);
+	struct test_dump dump;
+	struct test_record rec;
+	guint64 time;
+
+	__ofono_trace_record(trace, OFONO_TRACE_PROTO_AT, FALSE, "AT\r", 3);
+	__ofono_trace_record(trace, OFONO_TRACE_PROTO_QMI, TRUE,
+						qmi, sizeof(qmi));
+
+	test_dump_init(&dump, trace);
+	g_assert(!dump.dropped);
+
+	g_assert(test_dump_next(&dump, &rec));
+	g_assert(rec.proto == OFONO_TRACE_PROTO_AT);
+	g_assert(!rec.in);
+	g_assert(rec.len == 3);
+	g_assert(!memcmp(rec.data, "AT\r", 3));
+	time = rec.time;
+
+	g_assert(test_dump_next(&dump, &rec));
+	g_assert(rec.proto == OFONO_TRACE_PROTO_QMI);
+	g_assert(rec.in);
+	g_assert(rec.len == sizeof(qmi));
+	g_assert(!memcmp(rec.data, qmi, sizeof(qmi)));
+	g_assert(rec.time >= time);
+
+	g_assert(!test_dump_next(&dump, &rec));
+	test_dump_destroy(&dump);
+
+	__ofono_trace_free(trace);
+}
+
+/* ==== truncate ==== */
+
+static void test_truncate(void)
+{
+	const guint len = TEST_MAX_CAPTURE + 1000;
+	guint8 *frame = g_malloc(len);
+	struct ofono_trace *trace = __ofono_trace_new(0);
+	struct test_dump dump;
+	struct test_record rec;
+	guint i;
+
+	for (i = 0; i < len; i++)
+		frame[i] = i;
+
+	/* Only the beginning of a large frame is kept */
+	__ofono_trace_record(trace, OFONO_TRACE_PROTO_MBIM, TRUE, frame, len);
+
+	test_dump_init(&dump, trace);
+	g_assert(test_dump_next(&dump, &rec));
+	g_assert(rec.proto == OFONO_TRACE_PROTO_MBIM);
+	g_assert(rec.len == len);
+	g_assert(rec.caplen == TEST_MAX_CAPTURE);
+	g_assert(!memcmp(rec.data, frame, TEST_MAX_CAPTURE));
+	g_assert(!test_dump_next(&dump, &rec));
+	test_dump_destroy(&dump);
+
+	__ofono_trace_free(trace);
+	g_free(frame);
+}
+
+/* ==== overwrite ==== */
+
+static void test_overwrite(void)
+{
+	const guint len = 100;
+	const guint fit = TEST_MIN_SIZE / (TEST_RECORD_HEADER_SIZE + len);
+	const guint total = 3 * fit + 1;
+	guint8 *frame = g_malloc(len);
+	struct ofono_trace *trace = __ofono_trace_new(0);
+	struct test_dump dump;
+	struct test_record rec;
+	guint i;
+
+	/* Wraps around the ring a few times, the oldest ones get dropped */
+	for (i = 0; i < total; i++) {
+		memset(frame, i, len);
+		__ofono_trace_record(trace, OFONO_TRACE_PROTO_AT, i & 1,
+								frame, len);
+	}
+
+	test_dump_init(&dump, trace);
+	g_assert_cmpuint(dump.dropped, ==, total - fit);
+
+	for (i = total - fit; i < total; i++) {
+		memset(frame, i, len);
+		g_assert(test_dump_next(&dump, &rec));
+		g_assert(rec.len == len);
+		g_assert(rec.in == (i & 1));
+		g_assert(!memcmp(rec.data, frame, len));
+	}
+
+	g_assert(!test_dump_next(&dump, &rec));
+	test_dump_destroy(&dump);
+
+	__ofono_trace_free(trace);
+	g_free(frame);
+}
+
+/* ==== mixed ==== */
+
+static void test_mixed(void)
+{
+	const guint total = 200;
+	guint8 frame[300];
+	struct ofono_trace *trace = __ofono_trace_new(4096);
+	struct test_dump dump;
+	struct test_record rec;
+	guint i, count = 0, next;
+
+	/* Records of different sizes wrap at arbitrary offsets */
+	for (i = 0; i < total; i++) {
+		const guint len = 1 + (i * 37) % sizeof(frame);
+
+		memset(frame, i, len);
+		__ofono_trace_record(trace, OFONO_TRACE_PROTO_RIL, TRUE,
+								frame, len);
+	}
+
+	test_dump_init(&dump, trace);
+	g_assert(dump.dropped > 0);
+	g_assert(dump.size - TEST_FILE_HEADER_SIZE <= 4096);
+
+	/* What's left is the newest records, in order */
+	next = dump.dropped;
+	while (test_dump_next(&dump, &rec)) {
+		const guint len = 1 + (next * 37) % sizeof(frame);
+
+		memset(frame, next, len);
+		g_assert(rec.proto == OFONO_TRACE_PROTO_RIL);
+		g_assert(rec.len == len);
+		g_assert(!memcmp(rec.data, frame, len));
+		next++;
+		count++;
+	}
+
+	g_assert(next == total);
+	g_assert(count > 0);
+	test_dump_destroy(&dump);
+
+	__ofono_trace_free(trace);
+}
+
+int main(int argc, char *argv[])
+{
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func(TEST_("null"), test_null);
+	g_test_add_func(TEST_("record"), test_record);
+	g_test_add_func(TEST_("truncate"), test_truncate);
+	g_test_add_func(TEST_("overwrite"), test_overwrite);
+	g_test_add_func(TEST_("mixed"), test_mixed);
+	return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 8
+ * indent-tabs-mode: t
+ * End:
+ */
@@ -1163,6 +1163,55 @@ static void test_cancel6(void)
 	test_common_deinit();
 }
 
+/* ==== dial_sync_dispatch ==== */
+
+#define TEST_SYNC_DISPATCH_FILTERS (4)
+
+static void test_dial_sync_dispatch(void)
+{
+	static const char *names[TEST_SYNC_DISPATCH_FILTERS] = {
+		"sync0", "sync1", "sync2", "sync3"
+	};
+
+	struct ofono_voicecall_filter filters[TEST_SYNC_DISPATCH_FILTERS];
+	struct ofono_voicecall vc;
+	struct ofono_phone_number number;
+	int i, count = 0;
+
+	test_common_init();
+	test_voicecall_init(&vc);
+	string_to_phone_number("112", &number);
+
+	/* Few enough filters to be run in one go */
+	memset(filters, 0, sizeof(filters));
+	for (i = 0; i < TEST_SYNC_DISPATCH_FILTERS; i++) {
+		filters[i].name = names[i];
+		filters[i].api_version = OFONO_VOICECALL_FILTER_API_VERSION;
+		filters[i].filter_dial = filter_dial_continue;
+		g_assert(ofono_voicecall_filter_register(filters + i) == 0);
+	}
+
+	g_assert((vc.chain = __ofono_voicecall_filter_chain_new(&vc)) != NULL);
+	__ofono_voicecall_filter_chain_dial(vc.chain, &number,
+			OFONO_CLIR_OPTION_DEFAULT,
+			test_dial_expect_continue_inc,
+			test_inc, &count);
+	g_assert(test_filter_dial_count == 1);
+	g_assert(!count);
+
+	/* The rest of the chain takes a single dispatch, no idle hops */
+	g_assert(g_main_context_iteration(NULL, FALSE));
+	g_assert(test_filter_dial_count == TEST_SYNC_DISPATCH_FILTERS);
+	g_assert(count == 2); /* Completion and destroy callbacks */
+	g_assert(!g_main_context_pending(NULL));
+
+	__ofono_voicecall_filter_chain_free(vc.chain);
+	for (i = 0; i < TEST_SYNC_DISPATCH_FILTERS; i++) {
+		ofono_voicecall_filter_unregister(filters + i);
+	}
+	test_common_deinit();
+}
+
 #define TEST_(name) "/voicecall-filter/" name
 
 int main(int argc, char *argv[])
@@ -1197,6 +1246,7 @@ int main(int argc, char *argv[])
 	g_test_add_func(TEST_("cancel4"), test_cancel4);
 	g_test_add_func(TEST_("cancel5"), test_cancel5);
 	g_test_add_func(TEST_("cancel6"), test_cancel6);
+	g_test_add_func(TEST_("dial_sync_dispatch"), test_dial_sync_dispatch);
 
 	return g_test_run();
 }